@@ -0,0 +1,33 @@
+@echo off
+
+mkdir build
+
+:: set enviroment vars and requred stuff for the msvc compiler
+call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvarsall.bat" x64
+
+:: Benchmarks are plain console programs, no window. The headless one renders through renderer.lib, build it with run.bat first
+set INCLUDE_DIRS=/I..\external\inc\ /I..\inc\
+set LIBRARY_DIRS=/LIBPATH:..\external\lib\
+set LIBRARIES=opengl32.lib glfw3.lib assimp-vc143-mt.lib user32.lib gdi32.lib shell32.lib kernel32.lib
+set C_FLAGS=/O2 /EHsc /W4 /MD /nologo /std:c++17
+
+set ENTITIES_SRC=..\bench\entities_bench.cpp ..\src\Entities.cpp ..\src\SceneGraph.cpp ..\src\Culling.cpp ..\src\Jobs.cpp
+set JOBS_SRC=..\bench\jobs_bench.cpp ..\src\Jobs.cpp ..\src\Culling.cpp ..\src\SceneGraph.cpp
+set ANIMATION_SRC=..\bench\animation_bench.cpp ..\src\Animation.cpp ..\src\Jobs.cpp ..\src\Culling.cpp
+
+pushd .\build
+cl  %C_FLAGS% %INCLUDE_DIRS% %ENTITIES_SRC% /Fe:entities_bench.exe
+.\entities_bench.exe --json entities_bench.json
+
+cl  %C_FLAGS% %INCLUDE_DIRS% %JOBS_SRC% /Fe:jobs_bench.exe
+.\jobs_bench.exe --json jobs_bench.json
+
+cl  %C_FLAGS% %INCLUDE_DIRS% %ANIMATION_SRC% /Fe:animation_bench.exe
+.\animation_bench.exe --json animation_bench.json
+
+cl  %C_FLAGS% /DPROFILER_ENABLED=1 %INCLUDE_DIRS% ..\bench\headless_bench.cpp /Fe:headless_bench.exe /link %LIBRARY_DIRS% renderer.lib %LIBRARIES%
+.\headless_bench.exe --frames 600 --csv headless_bench.csv --json headless_bench.json
+
+cl  %C_FLAGS% /DPROFILER_ENABLED=1 %INCLUDE_DIRS% ..\bench\micro_bench.cpp /Fe:micro_bench.exe /link %LIBRARY_DIRS% renderer.lib %LIBRARIES%
+.\micro_bench.exe --json micro_bench.json
+popd
@@ -0,0 +1,452 @@
+/*
+    Throughput of skeletal pose evaluation (Animator::evaluate), 1 to N characters on 1 to
+    N workers.
+
+    Every character has the same 64 joint humanoid-like skeleton (a spine with arms, legs
+    and a head chain, a bone per joint) and plays one of 8 clips at its own time, so the
+    frames sampled are spread over the clips like in a crowd. A run is one evaluate of
+    every character: sampling the clip, local matrices, the hierarchy and the palette.
+
+    sample      blendPoses only, one character, the SIMD keyframe interpolation alone
+    pose        evaluatePose of one character
+    crowd       Animator::evaluate over --characters characters with 1, 2, 4, ... workers
+
+    sample-c, pose-c and crowd-c are the same on the CompressedClips of the same clips
+    (sampleClip instead of blendPoses). Before the runs the compression is reported: the
+    bytes of the clips as assimp keys, resampled and compressed, and the largest error of
+    the compressed clips against the resampled ones, at the frames and halfway between them.
+    The errors include a root motion clip, the hips running 20 units in x and 30 in z,
+    whose translations don't fit the 16 bit quantization within the error bound.
+
+    usage: animation_bench [--characters N] [--max-workers N] [--runs N] [--json file]
+*/
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <Animation.hpp>
+#include <Jobs.hpp>
+
+struct Result
+{
+    std::string workload;
+    size_t      characters;
+    unsigned    workers;
+    double      ms;         // median of one evaluate
+    double      speedup;    // against 1 worker
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+static double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+static float randomFloat(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static int32_t addChain(Skeleton& skeleton, int32_t parent, const char *name, int count, const glm::vec3& offset)
+{
+    for (int i = 0; i < count; i++)
+    {
+        parent = skeleton.addJoint(parent, std::string(name) + std::to_string(i), offset,
+                                   glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec3(1.0f));
+    }
+    return parent;
+}
+
+// 64 joints: hips, a spine of 8, two arms of 12 (with fingers as one chain), two legs of 8,
+// a neck and head of 6, the rest as a tail of the spine. Depth first like an imported one
+static void buildSkeleton(Skeleton& skeleton)
+{
+    int32_t hips = skeleton.addJoint(-1, "hips", glm::vec3(0.0f, 1.0f, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec3(1.0f));
+
+    int32_t chest = addChain(skeleton, hips, "spine", 8, glm::vec3(0.0f, 0.08f, 0.0f));
+    addChain(skeleton, chest, "armL", 12, glm::vec3(0.06f, 0.0f, 0.0f));
+    addChain(skeleton, chest, "armR", 12, glm::vec3(-0.06f, 0.0f, 0.0f));
+    addChain(skeleton, chest, "head", 6, glm::vec3(0.0f, 0.05f, 0.0f));
+    addChain(skeleton, hips, "legL", 8, glm::vec3(0.0f, -0.12f, 0.0f));
+    addChain(skeleton, hips, "legR", 8, glm::vec3(0.0f, -0.12f, 0.0f));
+    addChain(skeleton, hips, "tail", 64 - (int)skeleton.jointCount(), glm::vec3(0.0f, 0.0f, -0.05f));
+
+    // bind pose matrices inverted, what an importer reads from aiBone::mOffsetMatrix
+    std::vector<BoneMatrix> palette(skeleton.boneCount());
+    std::vector<glm::mat4>  world(skeleton.jointCount());
+    for (uint32_t j = 0; j < skeleton.jointCount(); j++)
+    {
+        uint32_t  n     = skeleton.stride();
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(skeleton.bindPose[POSE_TX * n + j],
+                                                                    skeleton.bindPose[POSE_TY * n + j],
+                                                                    skeleton.bindPose[POSE_TZ * n + j]));
+        world[j] = skeleton.parent[j] >= 0 ? world[skeleton.parent[j]] * local : local;
+    }
+    for (uint32_t j = 0; j < skeleton.jointCount(); j++)
+        skeleton.addBone((int32_t)j, skeleton.names[j], glm::inverse(world[j]));
+}
+
+// every joint swings around its own axis with its own phase, 2 seconds at 30 frames. Like in
+// a captured clip only the hips move and nothing scales, the tail is still half of the time
+static void buildClip(const Skeleton& skeleton, AnimationClip& clip)
+{
+    clip.resize(skeleton, 2.0f, 30.0f);
+
+    std::vector<glm::vec3> axis(skeleton.jointCount());
+    std::vector<float>     phase(skeleton.jointCount());
+    for (uint32_t j = 0; j < skeleton.jointCount(); j++)
+    {
+        axis[j]  = glm::normalize(glm::vec3(randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), randomFloat(0.1f, 1.0f)));
+        phase[j] = randomFloat(0.0f, 6.28f);
+    }
+
+    uint32_t n = clip.stride;
+    for (uint32_t f = 0; f < clip.frameCount; f++)
+    {
+        float *pose = clip.frame(f);
+        std::copy(skeleton.bindPose.begin(), skeleton.bindPose.end(), pose);
+
+        float t = (float)f / clip.sampleRate;
+        pose[POSE_TY * n] += 0.05f * std::sin(6.28318f * t);
+        pose[POSE_TZ * n] += 0.4f * t;
+
+        for (uint32_t j = 0; j < skeleton.jointCount(); j++)
+        {
+            float angle = 0.6f * std::sin(3.14159f * t + phase[j]);
+            if (skeleton.names[j].compare(0, 4, "tail") == 0)
+                angle = std::max(angle, 0.0f);
+
+            glm::quat q = glm::angleAxis(angle, axis[j]);
+            pose[POSE_QX * n + j] = q.x;
+            pose[POSE_QY * n + j] = q.y;
+            pose[POSE_QZ * n + j] = q.z;
+            pose[POSE_QW * n + j] = q.w;
+        }
+    }
+    clip.alignRotations();
+
+    // what the same clip would take as assimp keys, a key per frame and channel
+    clip.sourceBytes = (size_t)skeleton.jointCount() * clip.frameCount * (2 * sizeof(aiVectorKey) + sizeof(aiQuatKey));
+}
+
+// the hips walk off over a long range, the rest holds the bind pose
+static void buildRootMotionClip(const Skeleton& skeleton, AnimationClip& clip)
+{
+    clip.resize(skeleton, 2.0f, 30.0f);
+
+    uint32_t n = clip.stride;
+    for (uint32_t f = 0; f < clip.frameCount; f++)
+    {
+        float *pose = clip.frame(f);
+        std::copy(skeleton.bindPose.begin(), skeleton.bindPose.end(), pose);
+
+        float t = (float)f / clip.sampleRate;
+        pose[POSE_TX * n] += 10.0f * t;
+        pose[POSE_TY * n] += 0.05f * std::sin(6.28318f * t * 2.0f);
+        pose[POSE_TZ * n] += 15.0f * t + 0.3f * std::sin(3.14159f * t);
+    }
+    clip.alignRotations();
+    clip.sourceBytes = (size_t)skeleton.jointCount() * clip.frameCount * (2 * sizeof(aiVectorKey) + sizeof(aiQuatKey));
+}
+
+struct CompressionReport
+{
+    size_t sourceBytes     = 0;
+    size_t resampledBytes  = 0;
+    size_t compressedBytes = 0;
+    float  rotationError   = 0.0f;  // radians
+    float  vectorError     = 0.0f;  // translations and scales, per component
+    float  translationError = 0.0f; // length, what CompressionSettings::translationError bounds
+};
+
+// the compressed clips against the resampled ones, lerped the same way blendPoses does
+static void measureErrors(const Skeleton& skeleton, const AnimationClip& clip, const CompressedClip& compressed,
+                          CompressionReport& report)
+{
+    uint32_t           n = clip.stride;
+    std::vector<float> expected((size_t)POSE_CHANNELS * n), sampled((size_t)POSE_CHANNELS * n);
+
+    for (uint32_t f = 0; f + 1 < clip.frameCount; f++)
+    {
+        for (float t : { 0.0f, 0.5f })
+        {
+            blendPoses(clip.frame(f), clip.frame(f + 1), t, n, expected.data());
+            sampleClip(compressed, ((float)f + t) / clip.sampleRate, sampled.data());
+
+            for (uint32_t j = 0; j < skeleton.jointCount(); j++)
+            {
+                // from the chord between them, like the compression measures it
+                float minus = 0.0f, plus = 0.0f;
+                for (int c = POSE_QX; c <= POSE_QW; c++)
+                {
+                    minus += (expected[c * n + j] - sampled[c * n + j]) * (expected[c * n + j] - sampled[c * n + j]);
+                    plus  += (expected[c * n + j] + sampled[c * n + j]) * (expected[c * n + j] + sampled[c * n + j]);
+                }
+                float angle = 4.0f * std::asin(std::min(std::sqrt(std::min(minus, plus)) * 0.5f, 1.0f));
+                report.rotationError = std::max(report.rotationError, angle);
+
+                for (int c : { POSE_TX, POSE_TY, POSE_TZ, POSE_SX, POSE_SY, POSE_SZ })
+                    report.vectorError = std::max(report.vectorError, std::abs(expected[c * n + j] - sampled[c * n + j]));
+
+                glm::vec3 d(expected[POSE_TX * n + j] - sampled[POSE_TX * n + j], expected[POSE_TY * n + j] - sampled[POSE_TY * n + j],
+                            expected[POSE_TZ * n + j] - sampled[POSE_TZ * n + j]);
+                report.translationError = std::max(report.translationError, glm::length(d));
+            }
+        }
+    }
+}
+
+template<typename Fn>
+static double measure(int runs, Fn&& fn)
+{
+    // the first run warms caches and wakes the workers, it is not counted
+    fn();
+
+    std::vector<double> times;
+    for (int r = 0; r < runs; r++)
+    {
+        Clock::time_point t0 = Clock::now();
+        fn();
+        times.push_back(elapsedMs(t0, Clock::now()));
+    }
+    return median(times);
+}
+
+static void writeJson(const std::string& path, const std::vector<Result>& results, uint32_t bones,
+                      const CompressionReport& compression)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+
+    out << "{\n  \"benchmark\": \"animation\",\n  \"backend\": \"" << animationBackendName()
+        << "\",\n  \"bones_per_character\": " << bones
+        << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+        << ",\n  \"compression\": {\"source_bytes\": " << compression.sourceBytes
+        << ", \"resampled_bytes\": " << compression.resampledBytes
+        << ", \"compressed_bytes\": " << compression.compressedBytes
+        << ", \"ratio_to_resampled\": " << (double)compression.resampledBytes / compression.compressedBytes
+        << ", \"ratio_to_source\": " << (double)compression.sourceBytes / compression.compressedBytes
+        << ", \"max_rotation_error\": " << compression.rotationError
+        << ", \"max_vector_error\": " << compression.vectorError
+        << ", \"max_translation_error\": " << compression.translationError << "},\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        out << "    {\"workload\": \"" << r.workload << "\""
+            << ", \"characters\": " << r.characters
+            << ", \"workers\": " << r.workers
+            << ", \"ms\": " << r.ms
+            << ", \"characters_per_ms\": " << (double)r.characters / r.ms
+            << ", \"bones_per_second\": " << (double)r.characters * bones * 1000.0 / r.ms
+            << ", \"speedup\": " << r.speedup
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    size_t      maxCharacters = 1000;
+    unsigned    maxWorkers    = std::max(1u, std::thread::hardware_concurrency());
+    int         runs          = 31;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--characters" && i + 1 < argc)
+            maxCharacters = (size_t)std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-workers" && i + 1 < argc)
+            maxWorkers = (unsigned)std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--characters N] [--max-workers N] [--runs N] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    srand(1234);
+
+    Skeleton skeleton;
+    buildSkeleton(skeleton);
+
+    std::vector<AnimationClip> clips(8);
+    for (AnimationClip& clip : clips)
+        buildClip(skeleton, clip);
+
+    CompressionReport           report;
+    std::vector<CompressedClip> compressed(clips.size());
+    for (size_t i = 0; i < clips.size(); i++)
+    {
+        compressClip(skeleton, clips[i], compressed[i]);
+        measureErrors(skeleton, clips[i], compressed[i], report);
+
+        report.sourceBytes     += clips[i].sourceBytes;
+        report.resampledBytes  += clips[i].samples.size() * sizeof(float);
+        report.compressedBytes += compressed[i].bytes();
+    }
+
+    // only for the errors, the characters play the clips above
+    {
+        AnimationClip  rootMotion;
+        CompressedClip packed;
+        buildRootMotionClip(skeleton, rootMotion);
+        compressClip(skeleton, rootMotion, packed);
+        measureErrors(skeleton, rootMotion, packed, report);
+    }
+
+    uint32_t bones = skeleton.boneCount();
+    std::printf("%u joints, %u bones per character, %s, median ms of %d runs\n\n",
+                skeleton.jointCount(), bones, animationBackendName(), runs);
+    std::printf("%zu clips: %zu bytes as keys, %zu resampled, %zu compressed (%.1fx, %.1fx against the keys)\n"
+                "largest error %.6f rad, %.6f units (%.6f translation, bound %.6f)\n\n",
+                clips.size(), report.sourceBytes, report.resampledBytes, report.compressedBytes,
+                (double)report.resampledBytes / report.compressedBytes, (double)report.sourceBytes / report.compressedBytes,
+                report.rotationError, report.vectorError, report.translationError, CompressionSettings().translationError);
+
+    std::vector<Result> results;
+
+    // one character on the calling thread, the kernels alone
+    {
+        std::vector<float>      pose((size_t)POSE_CHANNELS * skeleton.stride());
+        std::vector<BoneMatrix> palette(bones);
+        AnimationInstance       instance;
+        instance.skeleton = &skeleton;
+        instance.clip     = &clips[0];
+
+        AnimationInstance packed;
+        packed.skeleton   = &skeleton;
+        packed.compressed = &compressed[0];
+
+        // a batch per run, one pose is well below the clock's resolution
+        const int BATCH = 1000;
+        float     t     = 0.0f;
+        double sample = measure(runs, [&]()
+        {
+            for (int i = 0; i < BATCH; i++)
+                blendPoses(clips[0].frame(i % 59), clips[0].frame(i % 59 + 1), 0.37f, clips[0].stride, pose.data());
+        });
+        double single = measure(runs, [&]()
+        {
+            for (int i = 0; i < BATCH; i++)
+            {
+                t = std::fmod(t + 0.0137f, clips[0].duration);
+                instance.time = t;
+                evaluatePose(instance, palette.data());
+            }
+        });
+        double sampleCompressed = measure(runs, [&]()
+        {
+            for (int i = 0; i < BATCH; i++)
+                sampleClip(compressed[0], ((float)(i % 59) + 0.37f) / compressed[0].sampleRate, pose.data());
+        });
+        double singleCompressed = measure(runs, [&]()
+        {
+            for (int i = 0; i < BATCH; i++)
+            {
+                t = std::fmod(t + 0.0137f, compressed[0].duration);
+                packed.time = t;
+                evaluatePose(packed, palette.data());
+            }
+        });
+
+        results.push_back({ "sample", 1, 1, sample / BATCH, 1.0 });
+        results.push_back({ "pose", 1, 1, single / BATCH, 1.0 });
+        results.push_back({ "sample-c", 1, 1, sampleCompressed / BATCH, 1.0 });
+        results.push_back({ "pose-c", 1, 1, singleCompressed / BATCH, 1.0 });
+    }
+
+    std::vector<size_t> characterCounts;
+    for (size_t c = 1; c < maxCharacters; c *= 10)
+        characterCounts.push_back(c);
+    characterCounts.push_back(maxCharacters);
+
+    std::vector<unsigned> workerCounts;
+    for (unsigned w = 1; w < maxWorkers; w *= 2)
+        workerCounts.push_back(w);
+    workerCounts.push_back(maxWorkers);
+
+    for (unsigned w : workerCounts)
+    {
+        jobs.start(w);
+
+        for (size_t count : characterCounts)
+        {
+            Animator animator, packed;
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t index = animator.add(&skeleton, &clips[i % clips.size()]);
+                animator.instances[index].time  = randomFloat(0.0f, 2.0f);
+                animator.instances[index].speed = randomFloat(0.8f, 1.2f);
+
+                packed.add(&skeleton, &compressed[i % compressed.size()]);
+                packed.instances[index].time  = animator.instances[index].time;
+                packed.instances[index].speed = animator.instances[index].speed;
+            }
+
+            double ms = measure(runs, [&]()
+            {
+                animator.advance(1.0f / 60.0f);
+                animator.evaluate();
+            });
+            double msCompressed = measure(runs, [&]()
+            {
+                packed.advance(1.0f / 60.0f);
+                packed.evaluate();
+            });
+            results.push_back({ "crowd", count, w, ms, 1.0 });
+            results.push_back({ "crowd-c", count, w, msCompressed, 1.0 });
+        }
+
+        jobs.stop();
+    }
+
+    // speedups against the single worker run of the same count
+    for (Result& r : results)
+    {
+        for (const Result& base : results)
+        {
+            if (base.workers == 1 && base.workload == r.workload && base.characters == r.characters)
+                r.speedup = base.ms / r.ms;
+        }
+    }
+
+    std::printf("%9s %11s %8s %11s %14s %13s %9s\n", "workload", "characters", "workers", "ms", "characters/ms",
+                "Mbones/s", "speedup");
+    for (const Result& r : results)
+    {
+        std::printf("%9s %11zu %8u %11.4f %14.1f %13.1f %9.2f\n", r.workload.c_str(), r.characters, r.workers, r.ms,
+                    (double)r.characters / r.ms, (double)r.characters * bones / r.ms / 1000.0, r.speedup);
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, results, bones, report);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+    Scaling benchmark of the entity store systems, 10 to 1M entities.
+
+    Every entity has a transform, bounds and a renderable, one in 16 is also a point light.
+    All transforms change every frame, so the numbers are the cost of a fully animated scene.
+
+    usage: entities_bench [--max N] [--json file]
+*/
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <Entities.hpp>
+#include <Jobs.hpp>
+
+struct Timings
+{
+    size_t entities;
+    int    frames;
+    // median ms per frame of each system
+    double animate;
+    double writeTransforms;
+    double graphUpdate;
+    double updateBounds;
+    double cull;
+    double resolve;
+    double gatherLights;
+    size_t visible;
+
+    double total() const
+    {
+        return animate + writeTransforms + graphUpdate + updateBounds + cull + resolve + gatherLights;
+    }
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+static double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+static float randomFloat(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static Timings run(size_t count)
+{
+    SceneGraph  graph;
+    EntityStore store;
+
+    store.reserve(count);
+
+    // roughly constant density, so the visible fraction stays about the same at every size
+    float extent = std::cbrt((float)count) * 2.0f;
+    AABB  unitCube(glm::vec3(-0.5f), glm::vec3(0.5f));
+
+    std::vector<Entity> spinning;
+    spinning.reserve(count);
+
+    srand(1234);
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 pos(randomFloat(-extent, extent), randomFloat(-extent, extent), randomFloat(-extent, extent));
+
+        Entity  e    = store.create(1);
+        int32_t node = graph.addNode(-1, glm::mat4(1.0f), unitCube);
+
+        store.addTransform(e, node, pos);
+        store.addRenderable(e, node, 0, (uint32_t)(i & 7), false);
+        store.addBounds(e, node, unitCube);
+        if ((i & 15) == 0)
+            store.addLight(e, LightType::POINT, node);
+
+        spinning.push_back(e);
+    }
+
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 4.0f * extent);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 2.0f * extent), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum   frustum;
+    frustum.extract(proj * view);
+
+    // enough frames for a stable median without the big sizes taking forever
+    int frames = (int)std::min<size_t>(200, std::max<size_t>(5, 2000000 / count));
+
+    std::vector<double> animate, write, update, bounds, cull, resolve, gather;
+    std::vector<uint32_t> lightSlots;
+
+    Timings t = {};
+    t.entities = count;
+    t.frames   = frames;
+
+    // the first frame computes everything from scratch, it is not counted
+    for (int f = -1; f < frames; f++)
+    {
+        glm::quat q = glm::angleAxis(0.01f * (float)(f + 2), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < spinning.size(); i++)
+            store.setRotation(spinning[i], q);
+        Clock::time_point t1 = Clock::now();
+        store.writeTransforms(graph);
+        Clock::time_point t2 = Clock::now();
+        graph.update();
+        Clock::time_point t3 = Clock::now();
+        store.updateBounds(graph);
+        Clock::time_point t4 = Clock::now();
+        t.visible = store.cull(frustum, 1);
+        Clock::time_point t5 = Clock::now();
+        store.resolveVisibility(1);
+        Clock::time_point t6 = Clock::now();
+        store.updateLights(graph);
+        store.gatherLights(LightType::POINT, 1, lightSlots);
+        Clock::time_point t7 = Clock::now();
+
+        if (f < 0)
+            continue;
+
+        animate.push_back(elapsedMs(t0, t1));
+        write.push_back(elapsedMs(t1, t2));
+        update.push_back(elapsedMs(t2, t3));
+        bounds.push_back(elapsedMs(t3, t4));
+        cull.push_back(elapsedMs(t4, t5));
+        resolve.push_back(elapsedMs(t5, t6));
+        gather.push_back(elapsedMs(t6, t7));
+    }
+
+    t.animate         = median(animate);
+    t.writeTransforms = median(write);
+    t.graphUpdate     = median(update);
+    t.updateBounds    = median(bounds);
+    t.cull            = median(cull);
+    t.resolve         = median(resolve);
+    t.gatherLights    = median(gather);
+    return t;
+}
+
+static void writeJson(const std::string& path, const std::vector<Timings>& results)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+
+    out << "{\n  \"benchmark\": \"entities\",\n  \"cull_backend\": \"" << cullBackendName() << "\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Timings& t = results[i];
+        out << "    {\"entities\": " << t.entities
+            << ", \"frames\": " << t.frames
+            << ", \"visible\": " << t.visible
+            << ", \"animate_ms\": " << t.animate
+            << ", \"write_transforms_ms\": " << t.writeTransforms
+            << ", \"graph_update_ms\": " << t.graphUpdate
+            << ", \"update_bounds_ms\": " << t.updateBounds
+            << ", \"cull_ms\": " << t.cull
+            << ", \"resolve_visibility_ms\": " << t.resolve
+            << ", \"gather_lights_ms\": " << t.gatherLights
+            << ", \"total_ms\": " << t.total()
+            << ", \"ns_per_entity\": " << t.total() * 1e6 / (double)t.entities
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    size_t      maxCount = 1000000;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--max" && i + 1 < argc)
+            maxCount = (size_t)std::atoll(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--max N] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    // graph, bounds and cull run on all cores, like in the renderer
+    jobs.start();
+
+    std::printf("cull backend: %s, %u workers, median ms per frame\n\n", cullBackendName(), jobs.workerCount());
+    std::printf("%9s %9s %9s %9s %9s %9s %9s %9s %9s %9s\n",
+                "entities", "animate", "write", "graph", "bounds", "cull", "resolve", "lights", "total", "ns/ent");
+
+    std::vector<Timings> results;
+    for (size_t count = 10; count <= maxCount; count *= 10)
+    {
+        Timings t = run(count);
+        results.push_back(t);
+
+        std::printf("%9zu %9.4f %9.4f %9.4f %9.4f %9.4f %9.4f %9.4f %9.4f %9.2f\n",
+                    t.entities, t.animate, t.writeTransforms, t.graphUpdate, t.updateBounds,
+                    t.cull, t.resolve, t.gatherLights, t.total(), t.total() * 1e6 / (double)t.entities);
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, results);
+
+    return 0;
+}
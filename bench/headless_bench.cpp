@@ -0,0 +1,380 @@
+/*
+    Headless rendering benchmark.
+
+    Creates a GL 3.3 core context without a window, on Linux through EGL (a surfaceless
+    context when the driver has EGL_MESA_platform_surfaceless, llvmpipe does, a pbuffer
+    otherwise), on Windows through a hidden GLFW window. renderScene draws into an FBO,
+    nothing is ever presented so vsync plays no part.
+
+    The camera follows a scripted path through the scene, a looping Catmull-Rom spline
+    through a few poses, and the animation runs on a fixed 60Hz clock, so two runs of the
+    same build render exactly the same frames. --replay renders a recording made in the app
+    instead (see Recording.hpp), one frame per recorded frame, with the settings it was
+    recorded with. Every frame records the CPU time of
+    renderScene and the GPU time of everything it submitted (GL_TIME_ELAPSED, read back
+    after the last frame so the queries never stall the pipeline).
+
+    usage: headless_bench [--frames N] [--warmup N] [--size WxH] [--scene cubes|spheres|model]
+                          [--model file] [--deferred] [--prepass] [--no-culling]
+                          [--replay file] [--csv file] [--json file]
+
+    Linux, from build/ : compile this file with every source in ../src, ../external/src/glad.c and
+    the ImGui sources, -I../external/inc -I../external/inc/IMGUI -I../inc, and link
+    -lglfw -lassimp -lEGL -lpthread. On Windows bench.bat builds it against renderer.lib.
+    LIBGL_ALWAYS_SOFTWARE=1 (or EGL_PLATFORM=surfaceless) pins Mesa to llvmpipe.
+*/
+#include <GLAD/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <GLM/glm.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+#include <Renderer.hpp>
+
+#include "headless_context.hpp"
+
+struct Pose
+{
+    glm::vec3 pos;
+    float     yaw;
+    float     pitch;
+};
+
+// a loop around the origin, where all three scenes sit
+static const Pose path[] = {
+    { glm::vec3( 0.0f,  0.0f,  6.0f), -90.0f,   0.0f },
+    { glm::vec3( 5.0f,  1.5f,  4.0f), -140.0f, -10.0f },
+    { glm::vec3( 6.0f,  3.0f, -3.0f), -210.0f, -20.0f },
+    { glm::vec3( 0.0f,  1.0f, -7.0f), -270.0f,  -5.0f },
+    { glm::vec3(-6.0f, -1.0f, -2.0f), -340.0f,   8.0f },
+    { glm::vec3(-4.0f,  0.5f,  4.0f), -400.0f,   0.0f },
+};
+static const int PATH_POSES = sizeof(path) / sizeof(path[0]);
+
+template<typename T>
+static T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t)
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+// t in [0, 1) goes once around the loop, the yaws keep turning the same way so the last pose wraps by a full turn
+static Pose cameraPath(float t)
+{
+    float s = t * (float)PATH_POSES;
+    int   i = (int)s;
+    float f = s - (float)i;
+
+    Pose  p[4];
+    float turn[4];
+    for (int k = 0; k < 4; k++)
+    {
+        int j   = i - 1 + k;
+        int w   = ((j % PATH_POSES) + PATH_POSES) % PATH_POSES;
+        p[k]    = path[w];
+        turn[k] = (float)((j - w) / PATH_POSES) * -360.0f;
+    }
+
+    Pose out;
+    out.pos   = catmullRom(p[0].pos, p[1].pos, p[2].pos, p[3].pos, f);
+    out.yaw   = catmullRom(p[0].yaw + turn[0], p[1].yaw + turn[1], p[2].yaw + turn[2], p[3].yaw + turn[3], f);
+    out.pitch = catmullRom(p[0].pitch, p[1].pitch, p[2].pitch, p[3].pitch, f);
+    return out;
+}
+
+/*
+    Render target, same formats as the window the app renders into
+*/
+struct Target
+{
+    GLuint fbo   = 0;
+    GLuint color = 0;
+    GLuint depth = 0;
+
+    bool create(int width, int height)
+    {
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+        glGenRenderbuffers(1, &color);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+
+        // the deferred path blits its depth/stencil in here
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!complete)
+            std::cerr << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return complete;
+    }
+
+    void destroy()
+    {
+        glDeleteRenderbuffers(1, &color);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteFramebuffers(1, &fbo);
+    }
+};
+
+struct FrameTime
+{
+    double cpu;     // ms in renderScene
+    double gpu;     // ms of the commands it submitted
+};
+
+struct Summary
+{
+    double mean, p50, p95, p99, max;
+};
+
+static Summary summarize(std::vector<double> v)
+{
+    Summary s = {};
+    if (v.empty())
+        return s;
+
+    std::sort(v.begin(), v.end());
+
+    double sum = 0.0;
+    for (size_t i = 0; i < v.size(); i++)
+        sum += v[i];
+
+    auto rank = [&](double p) { return v[std::min(v.size() - 1, (size_t)(p * (double)v.size()))]; };
+
+    s.mean = sum / (double)v.size();
+    s.p50  = rank(0.50);
+    s.p95  = rank(0.95);
+    s.p99  = rank(0.99);
+    s.max  = v.back();
+    return s;
+}
+
+static void writeCsv(const std::string& path, const std::vector<FrameTime>& frames)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::HEADLESS::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+
+    out << "frame,cpu_ms,gpu_ms\n";
+    for (size_t i = 0; i < frames.size(); i++)
+        out << i << "," << frames[i].cpu << "," << frames[i].gpu << "\n";
+
+    std::cout << "Wrote " << path << std::endl;
+}
+
+static void writeSummary(std::ofstream& out, const char *name, const Summary& s)
+{
+    out << "  \"" << name << "\": {\"mean_ms\": " << s.mean
+        << ", \"p50_ms\": " << s.p50
+        << ", \"p95_ms\": " << s.p95
+        << ", \"p99_ms\": " << s.p99
+        << ", \"max_ms\": " << s.max << "},\n";
+}
+
+static void writeJson(const std::string& path, const std::string& scene, int width, int height,
+                      const std::vector<FrameTime>& frames, const Summary& cpu, const Summary& gpu)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::HEADLESS::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+
+    out << "{\n  \"build\": \"" << __DATE__ << " " << __TIME__ << "\",\n";
+    out << "  \"renderer\": \"" << (const char*)glGetString(GL_RENDERER) << "\",\n";
+    out << "  \"scene\": \"" << scene << "\",\n";
+    out << "  \"width\": " << width << ", \"height\": " << height << ",\n";
+    out << "  \"deferred\": " << (gc.deferred ? "true" : "false")
+        << ", \"depth_prepass\": " << (gc.depthPrepass ? "true" : "false")
+        << ", \"culling\": " << (gc.culling ? "true" : "false") << ",\n";
+    out << "  \"gpu_memory_bytes\": " << memoryTracker.heaps[0].peak
+        << ", \"cpu_memory_bytes\": " << memoryTracker.heaps[1].peak << ",\n";
+    writeSummary(out, "cpu", cpu);
+    writeSummary(out, "gpu", gpu);
+
+    out << "  \"frames\": [\n";
+    for (size_t i = 0; i < frames.size(); i++)
+        out << "    {\"cpu_ms\": " << frames[i].cpu << ", \"gpu_ms\": " << frames[i].gpu << "}" << (i + 1 < frames.size() ? "," : "") << "\n";
+    out << "  ]\n}\n";
+
+    std::cout << "Wrote " << path << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int         frameCount = 600;
+    int         warmup     = 60;
+    std::string scene      = "cubes";
+    std::string csvPath;
+    std::string jsonPath;
+    std::string replayPath;
+
+    RendererOptions options;
+    options.width  = 1280;
+    options.height = 720;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc)
+            frameCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && i + 1 < argc)
+            warmup = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--size" && i + 1 < argc && std::sscanf(argv[i + 1], "%dx%d", &options.width, &options.height) == 2)
+            i++;
+        else if (arg == "--scene" && i + 1 < argc)
+            scene = argv[++i];
+        else if (arg == "--model" && i + 1 < argc)
+            options.modelPath = argv[++i];
+        else if (arg == "--deferred")
+            gc.deferred = true;
+        else if (arg == "--prepass")
+            gc.depthPrepass = true;
+        else if (arg == "--no-culling")
+            gc.culling = false;
+        else if (arg == "--replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (arg == "--csv" && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--frames N] [--warmup N] [--size WxH] [--scene cubes|spheres|model]"
+                      << " [--model file] [--deferred] [--prepass] [--no-culling] [--replay file] [--csv file] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    gc.model  = scene == "model";
+    gc.sphere = scene == "spheres";
+
+    // the recording decides the length of the run
+    if (!replayPath.empty())
+    {
+        InputRecording recording;
+        if (!recording.load(replayPath) || recording.frames.empty())
+            return 1;
+        frameCount = (int)recording.frames.size();
+        scene      = "replay";
+    }
+
+    if (!createContext(options.width, options.height))
+        return 1;
+
+    std::cout << "GL_RENDERER : " << glGetString(GL_RENDERER) << std::endl;
+
+    Target target;
+    if (!target.create(options.width, options.height))
+        return 1;
+
+    initRenderer(options);
+    gc.framebuffer = target.fbo;
+
+    std::vector<GLuint> queries(frameCount);
+    glGenQueries(frameCount, queries.data());
+
+    std::vector<FrameTime> frames(frameCount);
+
+    typedef std::chrono::steady_clock Clock;
+    const float step = 1.0f / 60.0f;
+
+    int total = warmup + frameCount;
+    for (int i = 0; i < total; i++)
+    {
+        bool measured = i >= warmup;
+        int  frame    = i - warmup;
+
+        if (!replayPath.empty() && i == warmup)
+            startReplay(replayPath, InputReplay::FIXED_STEP);
+
+        if (activeReplay())
+        {
+            processInput(nullptr);
+        }
+        else
+        {
+            // the path is walked once over the measured frames, the warmup sits at its start
+            Pose pose = cameraPath(measured ? (float)frame / (float)frameCount : 0.0f);
+            setCameraPose(pose.pos, pose.yaw, pose.pitch);
+            beginFrame((float)i * step);
+        }
+
+        if (measured)
+            glBeginQuery(GL_TIME_ELAPSED, queries[frame]);
+
+        Clock::time_point start = Clock::now();
+        renderScene();
+        Clock::time_point end = Clock::now();
+
+        if (measured)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            frames[frame].cpu = std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        // nothing is presented, keep the driver from queueing up unbounded work instead
+        if (i % 4 == 3)
+            glFlush();
+    }
+
+    glFinish();
+
+    for (int i = 0; i < frameCount; i++)
+    {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+        frames[i].gpu = (double)ns * 1e-6;
+    }
+    glDeleteQueries(frameCount, queries.data());
+
+    std::vector<double> cpuTimes(frameCount), gpuTimes(frameCount);
+    for (int i = 0; i < frameCount; i++)
+    {
+        cpuTimes[i] = frames[i].cpu;
+        gpuTimes[i] = frames[i].gpu;
+    }
+    Summary cpu = summarize(cpuTimes);
+    Summary gpu = summarize(gpuTimes);
+
+    std::printf("%-8s %5dx%-5d %6d frames%s%s\n", scene.c_str(), options.width, options.height, frameCount,
+                gc.deferred ? ", deferred" : "", gc.depthPrepass ? ", depth pre-pass" : "");
+    std::printf("%-8s %10s %10s %10s %10s %10s\n", "", "mean", "p50", "p95", "p99", "max");
+    std::printf("%-8s %10.3f %10.3f %10.3f %10.3f %10.3f\n", "cpu ms", cpu.mean, cpu.p50, cpu.p95, cpu.p99, cpu.max);
+    std::printf("%-8s %10.3f %10.3f %10.3f %10.3f %10.3f\n", "gpu ms", gpu.mean, gpu.p50, gpu.p95, gpu.p99, gpu.max);
+    std::printf("memory   gpu %.2f MB (peak %.2f), cpu %.2f MB (peak %.2f)\n",
+                memoryTracker.heaps[0].live / (1024.0 * 1024.0), memoryTracker.heaps[0].peak / (1024.0 * 1024.0),
+                memoryTracker.heaps[1].live / (1024.0 * 1024.0), memoryTracker.heaps[1].peak / (1024.0 * 1024.0));
+
+    if (!csvPath.empty())
+        writeCsv(csvPath, frames);
+    if (!jsonPath.empty())
+        writeJson(jsonPath, scene, options.width, options.height, frames, cpu, gpu);
+
+    shutdownRenderer();
+    target.destroy();
+    destroyContext();
+
+    return 0;
+}
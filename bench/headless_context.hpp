@@ -0,0 +1,174 @@
+#pragma once
+
+/*
+    A GL 3.3 core context without a window for the benchmarks. On Linux through EGL, a
+    surfaceless context when the driver has EGL_MESA_platform_surfaceless (llvmpipe does)
+    and a pbuffer otherwise, on Windows through a hidden GLFW window. Either way vsync is
+    off and nothing is presented, draw into an FBO.
+
+    Include once per program, the functions and the handles are file statics.
+*/
+#include <GLAD/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <cstring>
+
+#ifndef _WIN32
+    #define EGL_NO_X11
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#endif
+
+#ifdef _WIN32
+
+static GLFWwindow *window = nullptr;
+
+static bool createContext(int width, int height)
+{
+    if (!glfwInit())
+    {
+        std::cerr << "ERROR::HEADLESS::GLFW_INIT" << std::endl;
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    window = glfwCreateWindow(width, height, "headless_bench", NULL, NULL);
+    if (!window)
+    {
+        std::cerr << "ERROR::HEADLESS::CREATE_WINDOW" << std::endl;
+        return false;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+}
+
+static void destroyContext()
+{
+    glfwTerminate();
+}
+
+#else
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static EGLSurface surface = EGL_NO_SURFACE;
+
+static bool hasExtension(const char *extensions, const char *name)
+{
+    if (!extensions)
+        return false;
+
+    size_t      length = std::strlen(name);
+    const char *at     = extensions;
+    while ((at = std::strstr(at, name)) != nullptr)
+    {
+        if ((at == extensions || at[-1] == ' ') && (at[length] == ' ' || at[length] == '\0'))
+            return true;
+        at += length;
+    }
+    return false;
+}
+
+static bool createContext(int width, int height)
+{
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        std::cerr << "ERROR::HEADLESS::EGL_INIT" << std::endl;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "ERROR::HEADLESS::EGL_BIND_API" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_ALPHA_SIZE,      8,
+        EGL_DEPTH_SIZE,      24,
+        EGL_STENCIL_SIZE,    8,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint    configs = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configs) || configs == 0)
+    {
+        std::cerr << "ERROR::HEADLESS::EGL_CONFIG" << std::endl;
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION,       3,
+        EGL_CONTEXT_MINOR_VERSION,       3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT)
+    {
+        std::cerr << "ERROR::HEADLESS::EGL_CONTEXT" << std::endl;
+        return false;
+    }
+
+    // everything is drawn into an FBO, the surface only exists for drivers that insist on one
+    if (!hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+    {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+        if (surface == EGL_NO_SURFACE)
+        {
+            std::cerr << "ERROR::HEADLESS::EGL_PBUFFER" << std::endl;
+            return false;
+        }
+    }
+
+    if (!eglMakeCurrent(display, surface, surface, context))
+    {
+        std::cerr << "ERROR::HEADLESS::EGL_MAKE_CURRENT" << std::endl;
+        return false;
+    }
+
+    if (surface != EGL_NO_SURFACE)
+        eglSwapInterval(display, 0);
+
+    std::cout << "EGL " << major << "." << minor << (surface == EGL_NO_SURFACE ? ", surfaceless" : ", pbuffer") << std::endl;
+
+    return gladLoadGLLoader((GLADloadproc)eglGetProcAddress) != 0;
+}
+
+static void destroyContext()
+{
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, surface);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
+
+#endif
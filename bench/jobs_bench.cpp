@@ -0,0 +1,287 @@
+/*
+    Scaling benchmark of the job system, 1 to N workers.
+
+    empty       100k jobs that do nothing, submitted from the main thread: the cost of one job
+    compute     parallelFor over 4M items of pure arithmetic, the best case for scaling
+    cull        cullAABBs over 1M boxes, memory bound
+    graph       SceneGraph::update of 1000 roots with 255 children each, all moving
+    nested      fork/join recursion (fib 32 with invoke), jobs inside jobs
+    deep        fib 38 the same way: tens of thousands of jobs are submitted while the
+                first ones still wait at the top of the deques, the result is checked
+
+    Every workload runs with 1, 2, 4, ... workers and the hardware thread count, the
+    speedup is against the 1 worker run.
+
+    usage: jobs_bench [--max-workers N] [--runs N] [--json file]
+*/
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <Jobs.hpp>
+#include <Culling.hpp>
+#include <SceneGraph.hpp>
+
+struct Result
+{
+    std::string workload;
+    unsigned    workers;
+    double      ms;         // median
+    double      speedup;    // against 1 worker
+    uint64_t    stolen;     // jobs stolen during all runs
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+static double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+static float randomFloat(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+// keeps the compiler from dropping work whose result is never used
+static std::atomic<uint64_t> sink(0);
+
+static void emptyJobs()
+{
+    const int COUNT = 100000;
+
+    JobCounter counter;
+    Job job;
+    job.function = [](void *, size_t, size_t) {};
+    job.counter  = &counter;
+
+    // past JobDeque::CAPACITY queued jobs the submits run inline
+    for (int i = 0; i < COUNT; i++)
+        jobs.submit(job);
+    jobs.wait(counter);
+}
+
+static void compute()
+{
+    const size_t COUNT = 4 * 1024 * 1024;
+
+    jobs.parallelFor(COUNT, 1024, [](size_t begin, size_t end)
+    {
+        float sum = 0.0f;
+        for (size_t i = begin; i < end; i++)
+        {
+            float x = (float)i * 0.001f;
+            sum += std::sin(x) * std::cos(x * 0.5f) + std::sqrt(x);
+        }
+        sink.fetch_add((uint64_t)sum, std::memory_order_relaxed);
+    });
+}
+
+static long fib(int n)
+{
+    // small ones in a loop, a job per call would only measure the overhead
+    if (n < 16)
+    {
+        long a = 0, b = 1;
+        for (int i = 0; i < n; i++)
+        {
+            long t = a + b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    long x = 0, y = 0;
+    jobs.invoke([&]() { x = fib(n - 1); }, [&]() { y = fib(n - 2); });
+    return x + y;
+}
+
+static void nested()
+{
+    sink.fetch_add((uint64_t)fib(32), std::memory_order_relaxed);
+}
+
+static void deep()
+{
+    long result = fib(38);
+    if (result != 39088169)
+    {
+        std::cerr << "ERROR::BENCH::DEEP fib(38) = " << result << ", expected 39088169" << std::endl;
+        std::exit(1);
+    }
+    sink.fetch_add((uint64_t)result, std::memory_order_relaxed);
+}
+
+template<typename Fn>
+static Result measure(const char *workload, unsigned workers, int runs, Fn&& fn)
+{
+    uint64_t stolen = jobs.stats().stolen.load();
+
+    // the first run warms caches and wakes the workers, it is not counted
+    fn();
+
+    std::vector<double> times;
+    for (int r = 0; r < runs; r++)
+    {
+        Clock::time_point t0 = Clock::now();
+        fn();
+        times.push_back(elapsedMs(t0, Clock::now()));
+    }
+
+    Result result;
+    result.workload = workload;
+    result.workers  = workers;
+    result.ms       = median(times);
+    result.speedup  = 1.0;
+    result.stolen   = jobs.stats().stolen.load() - stolen;
+    return result;
+}
+
+static void writeJson(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+
+    out << "{\n  \"benchmark\": \"jobs\",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+        << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        out << "    {\"workload\": \"" << r.workload << "\""
+            << ", \"workers\": " << r.workers
+            << ", \"ms\": " << r.ms
+            << ", \"speedup\": " << r.speedup
+            << ", \"efficiency\": " << r.speedup / (double)r.workers
+            << ", \"stolen\": " << r.stolen
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    unsigned    maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+    int         runs       = 15;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--max-workers" && i + 1 < argc)
+            maxWorkers = (unsigned)std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--max-workers N] [--runs N] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    srand(1234);
+
+    // 1M boxes spread around the camera, roughly a third of them in the frustum
+    CullBatch boxes;
+    boxes.reserve(1000000);
+    for (int i = 0; i < 1000000; i++)
+    {
+        glm::vec3 c(randomFloat(-100.0f, 100.0f), randomFloat(-100.0f, 100.0f), randomFloat(-100.0f, 100.0f));
+        boxes.addAABB(AABB(c - glm::vec3(0.5f), c + glm::vec3(0.5f)));
+    }
+    Frustum frustum;
+    frustum.extract(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f) *
+                    glm::lookAt(glm::vec3(0.0f, 0.0f, 100.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    // a forest of small hierarchies, the roots move every run
+    SceneGraph graph;
+    std::vector<int32_t> roots;
+    AABB unitCube(glm::vec3(-0.5f), glm::vec3(0.5f));
+    for (int r = 0; r < 1000; r++)
+    {
+        int32_t root = graph.addNode(-1);
+        roots.push_back(root);
+        for (int c = 0; c < 255; c++)
+            graph.addNode(root, glm::translate(glm::mat4(1.0f), glm::vec3((float)c, 0.0f, 0.0f)), unitCube);
+    }
+    graph.update();
+    float angle = 0.0f;
+
+    std::vector<unsigned> counts;
+    for (unsigned w = 1; w < maxWorkers; w *= 2)
+        counts.push_back(w);
+    counts.push_back(maxWorkers);
+
+    std::printf("hardware threads: %u, median ms of %d runs\n\n", std::thread::hardware_concurrency(), runs);
+    std::printf("%9s %8s %10s %9s %11s %9s\n", "workload", "workers", "ms", "speedup", "efficiency", "stolen");
+
+    std::vector<Result> results;
+    for (unsigned w : counts)
+    {
+        jobs.start(w);
+
+        results.push_back(measure("empty", w, runs, emptyJobs));
+        results.push_back(measure("compute", w, runs, compute));
+        results.push_back(measure("cull", w, runs, [&]() { cullAABBs(frustum, boxes); }));
+        results.push_back(measure("graph", w, runs, [&]()
+        {
+            angle += 0.01f;
+            glm::mat4 m = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+            for (int32_t root : roots)
+                graph.setLocal(root, m);
+            graph.update();
+        }));
+        results.push_back(measure("nested", w, runs, nested));
+        results.push_back(measure("deep", w, runs, deep));
+
+        jobs.stop();
+    }
+
+    // speedups against the single worker run of the same workload
+    for (Result& r : results)
+    {
+        for (const Result& base : results)
+        {
+            if (base.workers == 1 && base.workload == r.workload)
+                r.speedup = base.ms / r.ms;
+        }
+    }
+
+    std::sort(results.begin(), results.end(), [](const Result& a, const Result& b)
+    {
+        return a.workload != b.workload ? a.workload < b.workload : a.workers < b.workers;
+    });
+    for (const Result& r : results)
+    {
+        std::printf("%9s %8u %10.3f %9.2f %10.0f%% %9llu\n", r.workload.c_str(), r.workers, r.ms,
+                    r.speedup, 100.0 * r.speedup / (double)r.workers, (unsigned long long)r.stolen);
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, results);
+
+    return 0;
+}
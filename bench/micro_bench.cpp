@@ -0,0 +1,486 @@
+/*
+    Micro-benchmarks of the renderer's CPU hot paths.
+
+    processMesh     vertex and index conversion of an assimp mesh (convertMesh)
+    generateSphere  at a few sector/stack counts
+    findTexture     the loaded texture lookup of Model::loadMaterialTextures
+    Camera          updateVectors and updateViewMatrix
+    positionCube    the cube scene's per frame transform work: the animated rotations are
+                    written into the scene graph, world matrices rebuilt and read back
+    uniforms        the setX helpers of Shaders.cpp, each looks the name up every call, next
+                    to glUniform with a cached location for comparison
+
+    Everything but the uniforms runs without GL. Those need a context, the same headless
+    one headless_bench uses, and are skipped (--no-gl, or when it cannot be created).
+
+    Each benchmark is calibrated to run for about --min-time ms and repeated 5 times, the
+    median is reported. --json writes the results in Google Benchmark's JSON layout, so the
+    usual tools for comparing two runs read it.
+
+    usage: micro_bench [--filter text] [--min-time ms] [--no-gl] [--json file]
+*/
+#include <GLAD/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include <assimp/mesh.h>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+
+#include <Renderer.hpp>
+#include <Camera.hpp>
+#include <Geometry.hpp>
+#include <Shaders.hpp>
+#include <Entities.hpp>
+#include <SceneGraph.hpp>
+
+#include "headless_context.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+static const int REPETITIONS = 5;
+
+struct Result
+{
+    std::string name;
+    uint64_t    iterations;
+    double      ns;         // median per iteration
+    double      items;      // per iteration, 0 if it does not apply
+};
+
+static std::vector<Result> results;
+static std::string         filter;
+static double              minTimeMs = 50.0;
+
+// results are folded into this so the optimizer cannot drop the work
+static volatile uint64_t sink = 0;
+
+template<typename T>
+static void keep(const T& value)
+{
+    sink = sink + (uint64_t)value;
+}
+
+// body(n) runs the benchmarked operation n times
+template<typename F>
+static void run(const std::string& name, double items, F body)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+
+    // double the count until one batch takes long enough to time reliably
+    uint64_t n = 1;
+    for (;;)
+    {
+        Clock::time_point t0 = Clock::now();
+        body(n);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        if (ms >= minTimeMs / 10.0 || n >= (1ull << 40))
+        {
+            n = std::max<uint64_t>(1, (uint64_t)((double)n * minTimeMs / std::max(ms, 1e-3)));
+            break;
+        }
+        n *= 2;
+    }
+
+    std::vector<double> ns;
+    for (int r = 0; r < REPETITIONS; r++)
+    {
+        Clock::time_point t0 = Clock::now();
+        body(n);
+        ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (double)n);
+    }
+    std::sort(ns.begin(), ns.end());
+
+    Result result = { name, n, ns[REPETITIONS / 2], items };
+    results.push_back(result);
+
+    if (items > 0.0)
+        std::printf("%-36s %14.1f ns %12llu it %12.2f M items/s\n", name.c_str(), result.ns, (unsigned long long)n, items / result.ns * 1e3);
+    else
+        std::printf("%-36s %14.1f ns %12llu it\n", name.c_str(), result.ns, (unsigned long long)n);
+}
+
+/*
+    CPU
+*/
+
+// a bent grid with everything processMesh reads: normals, one uv set, tangents
+static aiMesh *makeMesh(unsigned int side)
+{
+    aiMesh *mesh = new aiMesh();
+
+    unsigned int count = side * side;
+    mesh->mNumVertices     = count;
+    mesh->mVertices        = new aiVector3D[count];
+    mesh->mNormals         = new aiVector3D[count];
+    mesh->mTangents        = new aiVector3D[count];
+    mesh->mBitangents      = new aiVector3D[count];
+    mesh->mTextureCoords[0] = new aiVector3D[count];
+    mesh->mNumUVComponents[0] = 2;
+
+    for (unsigned int y = 0; y < side; y++)
+    {
+        for (unsigned int x = 0; x < side; x++)
+        {
+            unsigned int i = y * side + x;
+            float u = (float)x / (float)(side - 1);
+            float v = (float)y / (float)(side - 1);
+
+            mesh->mVertices[i]         = aiVector3D(u, std::sin(u * 6.0f) * 0.1f, v);
+            mesh->mNormals[i]          = aiVector3D(0.0f, 1.0f, 0.0f);
+            mesh->mTangents[i]         = aiVector3D(1.0f, 0.0f, 0.0f);
+            mesh->mBitangents[i]       = aiVector3D(0.0f, 0.0f, 1.0f);
+            mesh->mTextureCoords[0][i] = aiVector3D(u, v, 0.0f);
+        }
+    }
+
+    unsigned int quads = (side - 1) * (side - 1);
+    mesh->mNumFaces = quads * 2;
+    mesh->mFaces    = new aiFace[mesh->mNumFaces];
+    for (unsigned int y = 0, f = 0; y + 1 < side; y++)
+    {
+        for (unsigned int x = 0; x + 1 < side; x++)
+        {
+            unsigned int i = y * side + x;
+            unsigned int tris[2][3] = { { i, i + side, i + 1 }, { i + 1, i + side, i + side + 1 } };
+            for (int t = 0; t < 2; t++, f++)
+            {
+                mesh->mFaces[f].mNumIndices = 3;
+                mesh->mFaces[f].mIndices    = new unsigned int[3];
+                std::copy(tris[t], tris[t] + 3, mesh->mFaces[f].mIndices);
+            }
+        }
+    }
+
+    return mesh;
+}
+
+static void benchProcessMesh()
+{
+    const unsigned int sides[] = { 32, 100, 317 };     // about 1k, 10k and 100k vertices
+    for (unsigned int side : sides)
+    {
+        aiMesh *mesh = makeMesh(side);
+
+        // fresh vectors every time, like processMesh
+        run("processMesh/" + std::to_string(mesh->mNumVertices), (double)mesh->mNumVertices, [&](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                std::vector<Vertex>       vertices;
+                std::vector<unsigned int> indices;
+                AABB                      bounds;
+                convertMesh(mesh, vertices, indices, bounds);
+                keep(vertices.size() + indices.size());
+            }
+        });
+
+        delete mesh;
+    }
+}
+
+static void benchGenerateSphere()
+{
+    const int counts[][2] = { { 16, 8 }, { 36, 18 }, { 72, 36 }, { 144, 72 }, { 288, 144 } };
+    for (const int *c : counts)
+    {
+        double vertices = (double)((c[0] + 1) * (c[1] + 1));
+        run("generateSphere/" + std::to_string(c[0]) + "x" + std::to_string(c[1]), vertices, [&](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                std::vector<float>        vertices;
+                std::vector<unsigned int> indices;
+                generateSphere(vertices, indices, 1.0f, c[0], c[1]);
+                keep(vertices.size() + indices.size());
+            }
+        });
+    }
+}
+
+struct LoadedTexture
+{
+    std::string path;
+};
+
+static void benchFindTexture()
+{
+    const int counts[] = { 16, 64, 256, 1024 };
+    for (int count : counts)
+    {
+        // same prefix everywhere, the way exported models name their textures
+        std::vector<LoadedTexture> loaded(count);
+        std::vector<std::string>   queries(count);
+        for (int i = 0; i < count; i++)
+        {
+            char path[64];
+            std::snprintf(path, sizeof(path), "textures/material_%04d_diffuse.png", i);
+            loaded[i].path = path;
+            queries[i]     = path;
+        }
+        std::shuffle(queries.begin(), queries.end(), std::mt19937(1234));
+
+        // every texture is looked up once per material that uses it, hits everywhere in the list
+        run("findTexture/" + std::to_string(count), 0.0, [&](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+                keep(findTexture(loaded, queries[i % (uint64_t)count].c_str()));
+        });
+
+        run("findTexture/" + std::to_string(count) + "/miss", 0.0, [&](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+                keep(findTexture(loaded, "textures/material_new_diffuse.png") + 1);
+        });
+    }
+}
+
+static void benchCamera()
+{
+    Camera camera;
+
+    run("Camera/updateVectors", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            camera.yaw = (float)(i & 1023) * 0.35f;
+            camera.updateVectors();
+            keep(camera.view[0][0] > 0.0f);
+        }
+    });
+
+    run("Camera/updateViewMatrix", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            camera.pos.x = (float)(i & 1023) * 0.01f;
+            camera.updateViewMatrix();
+            keep(camera.view[3][0] > 0.0f);
+        }
+    });
+}
+
+static void benchPositionCube()
+{
+    // the cube scene: ten cubes under a root node, all spinning
+    const glm::vec3 positions[10] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f), glm::vec3( 2.0f,  5.0f, -15.0f), glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f), glm::vec3( 2.4f, -0.4f, -3.5f), glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f), glm::vec3( 1.5f,  2.0f, -2.5f), glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+
+    SceneGraph          graph;
+    EntityStore         store;
+    std::vector<Entity> cubes;
+
+    AABB    box(glm::vec3(-0.5f), glm::vec3(0.5f));
+    int32_t root = graph.addNode(-1);
+    for (int i = 0; i < 10; i++)
+    {
+        int32_t node = graph.addNode(root, glm::translate(glm::mat4(1.0f), positions[i]), box);
+        Entity  e    = store.create(1);
+        store.addTransform(e, node, positions[i]);
+        store.addBounds(e, node, box);
+        cubes.push_back(e);
+    }
+
+    run("positionCube/10", 10.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            glm::quat q = glm::angleAxis(std::sin((float)i * 0.01f), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+            for (size_t c = 0; c < cubes.size(); c++)
+                store.setRotation(cubes[c], q);
+
+            store.writeTransforms(graph);
+            graph.update();
+
+            for (size_t c = 0; c < cubes.size(); c++)
+            {
+                const glm::mat4& model = graph.world[store.transforms.node[store.transformSlot[cubes[c]]]];
+                keep(model[3][2] < 0.0f);
+            }
+        }
+    });
+}
+
+/*
+    GL
+*/
+static const char *uniformVs =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "uniform mat4 model;\n"
+    "uniform vec2 scale;\n"
+    "void main() { gl_Position = model * vec4(aPos.xy * scale, aPos.z, 1.0); }\n";
+
+static const char *uniformFs =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "uniform bool  enabled;\n"
+    "uniform int   mode;\n"
+    "uniform float shininess;\n"
+    "uniform vec3  material_diffuse;\n"
+    "void main() { FragColor = enabled ? vec4(material_diffuse * shininess * float(mode), 1.0) : vec4(0.0); }\n";
+
+static void benchUniforms()
+{
+    GLuint program = createShaderProgram(uniformVs, uniformFs);
+    glUseProgram(program);
+
+    glm::vec3 color(0.2f, 0.4f, 0.6f);
+    glm::mat4 model(1.0f);
+
+    run("uniforms/setBool", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+            setBool(program, "enabled", (i & 1) != 0);
+    });
+    run("uniforms/setInt", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+            setInt(program, "mode", (int)(i & 3));
+    });
+    run("uniforms/setFloat", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+            setFloat(program, "shininess", (float)(i & 63));
+    });
+    run("uniforms/setFloat2", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+            setFloat2(program, "scale", 1.0f, (float)(i & 63));
+    });
+    run("uniforms/setVec3", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            color.x = (float)(i & 63);
+            setVec3(program, "material_diffuse", color);
+        }
+    });
+    run("uniforms/setMat4", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            model[3][0] = (float)(i & 63);
+            setMat4(program, "model", model);
+        }
+    });
+
+    // what the helpers would cost without the name lookup
+    GLint loc = glGetUniformLocation(program, "material_diffuse");
+    run("uniforms/glUniform3fv cached", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            color.x = (float)(i & 63);
+            glUniform3fv(loc, 1, &color[0]);
+        }
+    });
+    run("uniforms/glGetUniformLocation", 0.0, [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; i++)
+            keep(glGetUniformLocation(program, "material_diffuse") + 1);
+    });
+
+    glFinish();
+    glUseProgram(0);
+    glDeleteProgram(program);
+}
+
+static void writeJson(const std::string& path, const char *renderer)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::BENCH::CANNOT_WRITE " << path << std::endl;
+        return;
+    }
+
+    // the layout of --benchmark_out_format=json, cpu_time is wall time here
+    out << "{\n  \"context\": {\n    \"date\": \"" << __DATE__ << " " << __TIME__ << "\",\n"
+        << "    \"executable\": \"micro_bench\",\n"
+        << "    \"library_build_type\": \"release\",\n"
+        << "    \"gl_renderer\": \"" << renderer << "\"\n  },\n  \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"run_type\": \"iteration\", \"repetitions\": " << REPETITIONS
+            << ", \"iterations\": " << r.iterations
+            << ", \"real_time\": " << r.ns << ", \"cpu_time\": " << r.ns << ", \"time_unit\": \"ns\"";
+        if (r.items > 0.0)
+            out << ", \"items_per_second\": " << r.items / r.ns * 1e9;
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+
+    std::cout << "Wrote " << path << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    bool        useGL = true;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc)
+            minTimeMs = std::max(1.0, std::atof(argv[++i]));
+        else if (arg == "--no-gl")
+            useGL = false;
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--filter text] [--min-time ms] [--no-gl] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    srand(1234);
+
+    benchProcessMesh();
+    benchGenerateSphere();
+    benchFindTexture();
+    benchCamera();
+    benchPositionCube();
+
+    std::string renderer = "none";
+    if (useGL && createContext(64, 64))
+    {
+        renderer = (const char*)glGetString(GL_RENDERER);
+        std::cout << "GL_RENDERER : " << renderer << std::endl;
+
+        benchUniforms();
+        destroyContext();
+    }
+    else if (useGL)
+    {
+        std::cerr << "No GL context, skipping the uniform benchmarks" << std::endl;
+    }
+
+    if (!jsonPath.empty())
+        writeJson(jsonPath, renderer.c_str());
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <assimp/scene.h>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <Culling.hpp>
+
+struct Vertex;
+
+/*
+    Skeletal animation, the CPU side: skeletons and clips imported from assimp, and the
+    evaluation of poses into bone palettes the vertex shaders skin with.
+
+    A pose is stored as structure of arrays, one stream per channel (translation xyz,
+    rotation xyzw, scale xyz) with one float per joint, padded to a multiple of 4 joints.
+    Clips are resampled at import to a fixed rate, so every joint of a clip has its keys
+    at the same times: sampling a clip is one lerp between two whole frames with the same
+    weight for all joints, 4 joints per SSE instruction, instead of a key search per
+    channel. Quaternions are flipped at import so neighbouring frames are in the same
+    hemisphere and the blend needs no per joint sign test.
+
+    The joints are in depth first order, a parent always comes before its children, so
+    the hierarchy is one pass over the joints. Poses of different instances don't depend
+    on each other, evaluatePoses() runs them as jobs.
+
+    What is kept after import are CompressedClips, see below. The resampled AnimationClip
+    is the input of the compression (and the reference the benchmark compares against).
+*/
+
+// the channels of a pose, in the order the streams are stored
+enum PoseChannel
+{
+    POSE_TX, POSE_TY, POSE_TZ,
+    POSE_QX, POSE_QY, POSE_QZ, POSE_QW,
+    POSE_SX, POSE_SY, POSE_SZ,
+    POSE_CHANNELS
+};
+
+// rows of an affine transform, what a bone takes in the palette (3 RGBA32F texels)
+struct BoneMatrix
+{
+    glm::vec4 rows[3];
+};
+
+static const int BONE_TEXELS = 3;
+
+struct Skeleton
+{
+    std::vector<int32_t>     parent;        // per joint, -1 for the root
+    std::vector<std::string> names;         // per joint, the aiNode's name
+    std::vector<float>       bindPose;      // POSE_CHANNELS streams of stride floats, the nodes' own transforms
+
+    std::vector<int32_t>     boneJoint;     // per bone, the joint that moves it
+    std::vector<BoneMatrix>  inverseBind;   // per bone, mesh space to bone space (aiBone::mOffsetMatrix)
+    std::vector<std::string> boneNames;
+
+    uint32_t jointCount() const { return (uint32_t)parent.size(); }
+    uint32_t boneCount() const  { return (uint32_t)boneJoint.size(); }
+
+    // floats per stream, the joint count rounded up to 4
+    uint32_t stride() const { return (jointCount() + 3) & ~3u; }
+
+    // -1 if there is none by that name
+    int32_t findJoint(const char *name) const;
+    int32_t findBone(const char *name) const;
+
+    // appends a joint below parent (the last one whose subtree is still open), with its bind transform
+    int32_t addJoint(int32_t parent, const std::string& name, const glm::vec3& t, const glm::vec4& q, const glm::vec3& s);
+    int32_t addBone(int32_t joint, const std::string& name, const glm::mat4& inverseBind);
+};
+
+struct AnimationClip
+{
+    std::string        name;
+    float              duration   = 0.0f;   // seconds
+    float              sampleRate = 30.0f;  // frames per second
+    uint32_t           frameCount = 0;      // frames include both ends, frameCount >= 2
+    uint32_t           stride     = 0;      // of the skeleton it was made for
+
+    // frameCount poses, each POSE_CHANNELS streams of stride floats
+    std::vector<float> samples;
+
+    // what the keys took in the file (aiNodeAnim keys), 0 if it didn't come from one
+    size_t             sourceBytes = 0;
+
+    const float *frame(uint32_t f) const { return &samples[(size_t)f * POSE_CHANNELS * stride]; }
+    float       *frame(uint32_t f)       { return &samples[(size_t)f * POSE_CHANNELS * stride]; }
+
+    // sizes samples for the skeleton, fills nothing
+    void resize(const Skeleton& skeleton, float duration, float sampleRate);
+
+    // makes every rotation the one of the two equivalent ones closest to the frame before
+    void alignRotations();
+};
+
+/*
+    A clip compressed for keeping and sampling.
+
+    Every track (translation, rotation or scale of one joint) that doesn't move by more
+    than the error bound over the whole clip is stored once as a constant. The others are
+    quantized: rotations to 48 bits with smallest-three (the largest component is left out
+    and rebuilt from the unit length, the other three get 15 bits each), translations and
+    scales to 16 bits per component within the track's range. A track the quantization
+    alone would move by more than half its error bound (a translation over a long range,
+    root motion) keeps its keys as floats instead. Then each animated track
+    drops every key that linear interpolation between its neighbours reproduces within the
+    error bound, measured against the original frames after quantization.
+
+    The frames are cut into segments of SEGMENT_FRAMES, each segment holds the keys of
+    all animated tracks in joint order (a bit mask of the frames that are keys, their
+    frame offsets, then values), both of its ends are always keys. Sampling a time finds
+    the segment by division and sweeps through it and the track headers once, front to
+    back, the key of a track is found by counting bits of its mask, not by a search.
+*/
+struct CompressionSettings
+{
+    float translationError = 0.0001f;   // model units
+    float rotationError    = 0.0005f;   // radians
+    float scaleError       = 0.0001f;
+};
+
+enum TrackKind : uint8_t
+{
+    TRACK_TRANSLATION,
+    TRACK_ROTATION,
+    TRACK_SCALE,
+    TRACK_KINDS
+};
+
+enum TrackMode : uint8_t
+{
+    TRACK_CONSTANT,
+    TRACK_ANIMATED,
+    TRACK_RAW           // animated, keys are floats
+};
+
+struct CompressedClip
+{
+    static const uint32_t SEGMENT_FRAMES = 16;
+
+    std::string           name;
+    float                 duration   = 0.0f;
+    float                 sampleRate = 30.0f;
+    uint32_t              frameCount = 0;
+    uint32_t              jointCount = 0;
+    uint32_t              stride     = 0;
+
+    // per track, joint * TRACK_KINDS + kind
+    std::vector<uint8_t>  trackModes;
+    // for every track in order: constants (3 floats, 4 for rotations), or the quantization
+    // range of animated translations and scales (min xyz, step xyz). Animated rotations and raw tracks have none
+    std::vector<float>    trackData;
+
+    std::vector<uint32_t> segments;     // byte offset of every segment into keys
+    std::vector<uint8_t>  keys;
+
+    size_t                sourceBytes = 0;  // see AnimationClip
+
+    size_t bytes() const
+    {
+        return trackModes.size() + trackData.size() * sizeof(float) + segments.size() * sizeof(uint32_t) + keys.size();
+    }
+
+    uint32_t segmentCount() const { return (uint32_t)segments.size(); }
+};
+
+// the clip's frames have to be in the skeleton's layout
+void compressClip(const Skeleton& skeleton, const AnimationClip& clip, CompressedClip& out,
+                  const CompressionSettings& settings = CompressionSettings());
+
+// the pose at time (seconds, clamped to the clip) as streams of clip.stride floats, rotations normalized
+void sampleClip(const CompressedClip& clip, float time, float *pose);
+
+// one animated character, its palette starts paletteOffset bones into the Animator's
+struct AnimationInstance
+{
+    const Skeleton       *skeleton   = nullptr;
+    const CompressedClip *compressed = nullptr; // what the models play
+    const AnimationClip  *clip       = nullptr; // uncompressed, if there is no compressed one
+    float                 time       = 0.0f;    // seconds into the clip, neither clip holds the bind pose
+    float                 speed      = 1.0f;
+    bool                  loop       = true;
+    uint32_t              paletteOffset = 0;
+
+    float duration() const { return compressed ? compressed->duration : clip ? clip->duration : 0.0f; }
+};
+
+/*
+    The animated instances of a scene and the bone palettes of all of them in one array,
+    which is what the renderer uploads into its texture buffer.
+*/
+struct Animator
+{
+    std::vector<AnimationInstance> instances;
+    std::vector<BoneMatrix>        palette;
+
+    // stats of the last evaluate
+    uint32_t                       bonesEvaluated = 0;
+    double                         evaluateTime   = 0.0;    // ms
+
+    // returns the instance index, the palette grows by the skeleton's bones
+    uint32_t add(const Skeleton *skeleton, const AnimationClip *clip = nullptr);
+    uint32_t add(const Skeleton *skeleton, const CompressedClip *clip);
+
+    // moves every instance along its clip
+    void advance(float deltaTime);
+
+    // true while any instance is moving, its palette changes every frame then
+    bool playing() const;
+
+    // poses and palettes of every instance, in parallel
+    void evaluate();
+};
+
+// bone palette of one instance at its time: palette[b] = joint world * inverse bind
+void evaluatePose(const AnimationInstance& instance, BoneMatrix *palette);
+
+// the same for many, one job per few instances
+void evaluatePoses(const AnimationInstance *instances, size_t count, BoneMatrix *palette);
+
+// bone palette of a pose given as streams, for bind poses and tests
+void poseToPalette(const Skeleton& skeleton, const float *pose, BoneMatrix *palette);
+
+// lerps two frames of streams (rotations normalized) into out, n is the stride
+void blendPoses(const float *a, const float *b, float t, uint32_t n, float *out);
+
+// which kernel blendPoses and the matrix code use on this cpu ("SSE", "scalar")
+const char *animationBackendName();
+
+/*
+    Import from assimp. The skeleton holds the nodes the bones of all meshes hang off plus
+    everything above them, clips are resampled to its joints at sampleRate.
+*/
+bool importSkeleton(const aiScene *scene, Skeleton& skeleton);
+void importClip(const aiAnimation *animation, const Skeleton& skeleton, AnimationClip& clip, float sampleRate = 30.0f);
+
+// fills the bone ids and weights of the vertices convertMesh made of mesh, the 4 biggest
+// influences are kept and normalized
+void convertBoneWeights(const aiMesh *mesh, const Skeleton& skeleton, Vertex *vertices);
+
+// bounds of a bind pose box over every frame of the clip, for culling skinned meshes in model space.
+// Only the bones flagged in usedBones count, nullptr uses all of them
+AABB animatedBounds(const Skeleton& skeleton, const AnimationClip *clip, const AABB& bindBounds, const uint8_t *usedBones);
+AABB animatedBounds(const Skeleton& skeleton, const CompressedClip *clip, const AABB& bindBounds, const uint8_t *usedBones);
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <memory_resource>
+#include <iosfwd>
+#include <cstdint>
+
+#include <Culling.hpp>
+
+/*
+    Triangle BVH used for ray queries (mouse picking).
+
+    Built as a binary tree with binned SAH, then collapsed into 4-wide nodes
+    whose child boxes are stored as SoA so one SSE slab test checks all 4 children.
+*/
+
+// 128 bytes, two cache lines
+struct BVHNode4
+{
+    float    minX[4], minY[4], minZ[4];
+    float    maxX[4], maxY[4], maxZ[4];
+    // inner child: node index and count == 0
+    // leaf child : first triangle and count > 0
+    // empty slot : child == -1, count == 0
+    int32_t  child[4];
+    uint32_t count[4];
+};
+
+// precomputed for Moller-Trumbore, stored in traversal order
+struct BVHTriangle
+{
+    glm::vec3 v0;
+    glm::vec3 e1;
+    glm::vec3 e2;
+    uint32_t  id;   // index of the triangle in the source index buffer (indices[id*3])
+};
+
+struct RayHit
+{
+    float    t        = 1e30f;
+    uint32_t triangle = UINT32_MAX;
+    // barycentrics of the hit, weight of v0 is 1 - u - v
+    float    u        = 0.0f;
+    float    v        = 0.0f;
+
+    bool hit() const { return triangle != UINT32_MAX; }
+};
+
+struct BVH
+{
+    std::vector<BVHNode4>    nodes;
+    std::vector<BVHTriangle> triangles;
+    AABB                     bounds;
+
+    // levels of wide nodes below the root, sizes the traversal stack of intersect
+    uint32_t                 depth = 0;
+
+    // hash of the source geometry, used to reject stale caches
+    uint64_t                 sourceHash = 0;
+
+    // the temporary arrays of the build come from scratch, see scratchBytes
+    void build(const glm::vec3 *positions, size_t positionStride,
+               const uint32_t *indices, size_t indexCount,
+               std::pmr::memory_resource *scratch = std::pmr::get_default_resource());
+
+    // scratch a build of indexCount indices takes, except for what the parallel part allocates itself
+    static size_t scratchBytes(size_t indexCount);
+
+    // returns true if something was hit closer than hit.t, updates hit
+    bool intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const;
+
+    bool empty() const { return nodes.empty(); }
+
+    size_t memoryUsage() const
+    {
+        return nodes.size() * sizeof(BVHNode4) + triangles.size() * sizeof(BVHTriangle);
+    }
+
+    bool write(std::ostream& out) const;
+    bool read(std::istream& in);
+};
+
+// FNV-1a over positions and indices so a cache can tell when the asset changed
+uint64_t hashGeometry(const glm::vec3 *positions, size_t positionStride, size_t vertexCount,
+                      const uint32_t *indices, size_t indexCount);
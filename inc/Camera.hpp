@@ -0,0 +1,308 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+#include <Renderer.hpp>
+#include <Recording.hpp>
+
+/*
+    Fly camera, yaw/pitch in degrees. The projection follows the size in gc.
+*/
+struct Camera
+{
+    glm::vec3   pos;
+    glm::vec3   front;
+    glm::vec3   up;
+    glm::vec3   right;
+    glm::vec3   world_up;
+
+    glm::mat4   view;
+    glm::mat4   projection;
+
+    float zNear = 0.1f;
+    float zFar  = 100.0f;
+
+    // Euler angles
+    float       yaw     = -90.0f;
+    float       pitch   = 0.0f;
+
+    // Options
+    float       speed       = 2.5f;
+    float       sensitivity = 0.1f;
+    float       zoom        = 45.0f;
+
+    Camera(glm::vec3 p  = glm::vec3(0.0f, 0.0f, 3.0f),
+           glm::vec3 fr = glm::vec3(0.0f, 0.0f, -1.0f),
+           glm::vec3 u  = glm::vec3(0.0f, 1.0f, 0.0f))
+        : pos(p), front(fr), up(u), world_up(u) 
+    {
+        updateViewMatrix();
+        updateProjectionMatrix();
+
+        updateVectors();
+    };
+
+    /*  
+        glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
+        glm::vec3 cameraDirection = glm::normalize(cameraPos - cameraTarget);
+        glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 cameraRight = glm::normalize(glm::cross(up, cameraDirection));
+        glm::vec3 cameraUp = glm::cross(cameraDirection, cameraRight);
+    */    
+    void updateViewMatrix() 
+    {
+        view = glm::lookAt(pos, pos + front, up);
+    }
+
+    void updateProjectionMatrix()
+    {
+        projection = glm::perspective(glm::radians(zoom), (float)gc.width / (float)gc.height, zNear, zFar);
+    }
+
+    glm::mat4 getViewMatrix()
+    {
+        return view;
+    } 
+
+    glm::mat4 getProjectionMatrix()
+    {
+        return projection;
+    } 
+
+    void updateVectors()
+    {
+        glm::vec3 direction;
+        direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+        direction.y = sin(glm::radians(pitch));
+        direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+
+        front = glm::normalize(direction);
+
+        right = glm::normalize(glm::cross(front, world_up));
+        up = glm::normalize(glm::cross(right, front));
+
+        updateViewMatrix();
+    }
+
+    void updateAngle(float xoffs, float yoffs)
+    {
+        xoffs *= sensitivity;
+        yoffs *= sensitivity;
+
+        yaw   += xoffs;
+        pitch += yoffs;
+
+        if(pitch > 89.0f)
+            pitch =  89.0f;
+        if(pitch < -89.0f)
+            pitch = -89.0f;
+
+        updateVectors();
+    }
+
+    void snapToXYPlane()
+    {
+        yaw = -90.0f;  // Face along the negative Z-axis
+        pitch = 0.0f;  // No tilt up or down
+        pos = glm::vec3(0.0f, 0.0f, 10.0f); // Position the camera along the Z-axis
+
+        updateVectors();
+    }
+
+    void snapToYZPlane()
+    {
+        yaw = 0.0f;    // Face along the negative X-axis
+        pitch = 0.0f;  // No tilt up or down
+        pos = glm::vec3(-10.0f, 0.0f, 0.0f); // Position the camera along the X-axis
+
+        updateVectors();
+    }
+
+    void snapToXZPlane()
+    {
+        yaw = -90.0f;  // Face along the negative Z-axis
+        pitch = 90.0f; // Look straight down along the Y-axis
+        pos = glm::vec3(0.0f, -10.0f, 0.0f); // Position the camera along the Y-axis;
+
+        updateVectors();
+    }
+
+    void snapToIsometricView()
+    {
+        yaw = -45.0f;  // Diagonal view
+        pitch = -45.0f; // Tilt down slightly
+        pos = glm::vec3(-10.0f, -10.0f, 10.0f); // Position the camera diagonally
+
+        updateVectors();
+    }
+
+    void snapToTopDownView()
+    {
+        yaw = -90.0f;  // Face along the negative Z-axis
+        pitch = -89.9f; // Look straight down (slightly less than 90 to avoid gimbal lock)
+        pos = glm::vec3(0.0f, -10.0f, 0.0f); // Position the camera above the scene
+
+        updateVectors();
+    }
+
+    void snapToFrontView()
+    {
+        yaw = -90.0f;  // Face along the negative Z-axis
+        pitch = 0.0f;  // No tilt
+        pos = glm::vec3(0.0f, 0.0f, 10.0f); // Position the camera in front of the scene
+
+        updateVectors();
+    }
+
+    void snapToSideView()
+    {
+        yaw = 0.0f;    // Face along the negative X-axis
+        pitch = 0.0f;  // No tilt
+        pos = glm::vec3(-10.0f, 0.0f, 0.0f); // Position the camera to the side of the scene
+
+        updateVectors();
+    }
+
+    void moveForward()
+    {
+        pos += speed * front;
+
+        updateViewMatrix();
+    }
+
+    void moveBackward()
+    {
+        pos -= speed * front;
+
+        updateViewMatrix();
+    }
+
+    void moveLeft()
+    {
+        // pos -= glm::normalize(glm::cross(front, up)) * speed;
+        pos -= right * speed;
+
+        updateViewMatrix(); 
+    }
+
+    void moveRight()
+    {
+        // pos += glm::normalize(glm::cross(front, up)) * speed;
+        pos += right * speed;
+
+        updateViewMatrix(); 
+    }
+
+    void tiltUp()
+    {
+        updateAngle(0.0f, 10.0f);
+    }
+
+    void tiltDown()
+    {
+        updateAngle(0.0f, -10.0f);
+    } 
+
+    void tiltRight()
+    {
+        updateAngle(10.0f, 0.0f);
+    }
+        
+    void tiltLeft()
+    {
+        updateAngle(-10.0f, 0.0f);
+    }
+
+    void Zoom(float yoffs)
+    {
+        zoom -= yoffs;
+        if (zoom < 1.0f)
+            zoom = 1.0f;
+        if (zoom > 45.0f)
+            zoom = 45.0f;
+
+        updateProjectionMatrix();
+    }
+
+    // keys is a mask of InputKey bits, see pollKeys
+    void inputPoll(uint32_t keys)
+    {
+        speed  = 2.5f * gc.deltaTime;
+
+        if (keys & KEY_FORWARD)
+            moveForward();
+        if (keys & KEY_BACKWARD)
+            moveBackward();
+        if (keys & KEY_LEFT)
+            moveLeft();
+        if (keys & KEY_RIGHT)
+            moveRight();
+        if (keys & KEY_TILT_UP)
+            tiltUp();
+        if (keys & KEY_TILT_DOWN)
+            tiltDown();
+        if (keys & KEY_TILT_LEFT)
+            tiltLeft();
+        if (keys & KEY_TILT_RIGHT)
+            tiltRight();
+        if (keys & KEY_VIEW_XY)
+            snapToXYPlane();
+        if (keys & KEY_VIEW_YZ)
+            snapToYZPlane();
+        if (keys & KEY_VIEW_XZ)
+            snapToXZPlane();
+        if (keys & KEY_VIEW_ISOMETRIC)
+            snapToIsometricView();
+        if (keys & KEY_VIEW_TOP)
+            snapToTopDownView();
+        if (keys & KEY_VIEW_FRONT)
+            snapToFrontView();
+        if (keys & KEY_VIEW_SIDE)
+            snapToSideView();
+    }
+
+    CameraState state() const
+    {
+        CameraState c;
+        c.pos   = pos;
+        c.yaw   = yaw;
+        c.pitch = pitch;
+        c.zoom  = zoom;
+        return c;
+    }
+
+    void setState(const CameraState& c)
+    {
+        pos   = c.pos;
+        yaw   = c.yaw;
+        pitch = c.pitch;
+        zoom  = c.zoom;
+
+        updateVectors();
+        updateProjectionMatrix();
+    }
+
+    // world space ray through a window pixel (origin at the near plane)
+    void screenRay(float x, float y, glm::vec3& origin, glm::vec3& dir)
+    {
+        float ndcX = 2.0f * x / (float)gc.width - 1.0f;
+        float ndcY = 1.0f - 2.0f * y / (float)gc.height;
+
+        glm::mat4 invViewProj = glm::inverse(projection * view);
+        glm::vec4 nearPoint   = invViewProj * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+        glm::vec4 farPoint    = invViewProj * glm::vec4(ndcX, ndcY,  1.0f, 1.0f);
+
+        origin = glm::vec3(nearPoint) / nearPoint.w;
+        dir    = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+    }
+
+    void updateOrbitPosition(float time, float radius) 
+    {
+        pos.x = sin(time) * radius;
+        pos.z = cos(time) * radius;
+        pos.y = 0.0;
+    }    
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+    Clustered light assignment.
+
+    The view frustum is split into a grid of froxels: TILES_X x TILES_Y screen tiles times
+    SLICES depth slices that grow exponentially with distance. Every light sphere is tested
+    against the tile planes and the slice depths, and its index is appended to the list of
+    each cluster it touches. The fragment shader finds its cluster from gl_FragCoord and
+    view depth and only walks that list.
+
+    build() runs on the update thread, which is job worker 0: the light ranges and the depth
+    slices are split over the workers with parallelFor, each worker owns whole slices so
+    nothing is shared while the lists are written.
+*/
+struct ClusterGrid
+{
+    static const int TILES_X = 16;
+    static const int TILES_Y = 9;
+    static const int SLICES  = 24;
+    static const int COUNT   = TILES_X * TILES_Y * SLICES;
+
+    // per cluster: offset into indices and number of lights, cluster id is x + y*TILES_X + z*TILES_X*TILES_Y
+    std::vector<uint32_t> grid;         // 2 * COUNT
+    std::vector<uint32_t> indices;
+
+    // stats of the last build
+    uint32_t              lightCount       = 0;
+    uint32_t              maxPerCluster    = 0;
+    double                buildTime        = 0.0;   // ms
+
+    float                 zNear;
+    float                 zFar;
+
+    ClusterGrid();
+
+    // positions and radii are in world space, proj has to be a symmetric perspective projection
+    void build(const glm::mat4& view, const glm::mat4& proj, float zNear, float zFar,
+               const glm::vec3 *positions, const float *radii, size_t count);
+
+    // slice = log(depth) * sliceScale - sliceBias, what the shader uses to find its slice
+    float sliceScale() const;
+    float sliceBias() const;
+
+private:
+    struct Range
+    {
+        int16_t x0, x1, y0, y1, z0, z1;     // inclusive, x0 > x1 if the light is off screen
+    };
+
+    std::vector<Range>                 ranges;
+    std::vector<std::vector<uint32_t>> sliceIndices;
+    std::vector<uint32_t>              cellOffsets;     // COUNT, counts first, then offsets inside the slice
+};
+
+// distance where the attenuation 1 / (c + l*d + q*d^2) of a light with the given intensity
+// drops below threshold, infinite when neither linear nor quadratic attenuation is set
+float lightRadius(float constant, float linear, float quadratic, float intensity, float threshold = 5.0f / 256.0f);
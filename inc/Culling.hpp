@@ -0,0 +1,82 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cfloat>
+
+struct AABB
+{
+    glm::vec3 min = glm::vec3( FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    AABB() = default;
+    AABB(const glm::vec3& mn, const glm::vec3& mx) : min(mn), max(mx) {}
+
+    bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+    glm::vec3 center()  const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3& p)
+    {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void expand(const AABB& b)
+    {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+
+    // world space box of a transformed box (Arvo), no need to transform all 8 corners
+    AABB transformed(const glm::mat4& m) const;
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float     radius = 0.0f;
+};
+
+BoundingSphere sphereFromAABB(const AABB& box);
+
+struct Frustum
+{
+    // left, right, bottom, top, near, far (xyz = normal pointing inwards, w = distance)
+    glm::vec4 planes[6];
+
+    // Gribb/Hartmann plane extraction from projection * view
+    void extract(const glm::mat4& viewProj);
+
+    bool testAABB(const AABB& box) const;
+    bool testSphere(const glm::vec3& center, float radius) const;
+};
+
+/*
+    Bounds are stored as separate arrays so the kernels can load 8 (AVX2) or 4 (SSE)
+    objects per instruction, the result is one visibility byte per object.
+*/
+struct CullBatch
+{
+    // boxes as center/extent, spheres keep their radius in ex
+    std::vector<float>   cx, cy, cz;
+    std::vector<float>   ex, ey, ez;
+    std::vector<uint8_t> visible;
+
+    void clear();
+    void reserve(size_t n);
+    size_t size() const { return cx.size(); }
+
+    size_t addAABB(const AABB& box);
+    size_t addSphere(const glm::vec3& center, float radius);
+};
+
+// both return the number of visible objects and fill batch.visible
+size_t cullAABBs(const Frustum& frustum, CullBatch& batch);
+size_t cullSpheres(const Frustum& frustum, CullBatch& batch);
+
+// which kernel the cull functions dispatch to on this cpu ("AVX2", "SSE", "scalar")
+const char *cullBackendName();
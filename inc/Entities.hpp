@@ -0,0 +1,166 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include <Culling.hpp>
+#include <SceneGraph.hpp>
+
+/*
+    Entity/component store.
+
+    An entity is just an index, every component type lives in its own table whose columns
+    are separate arrays (SoA) packed without holes, so a system only streams through the
+    columns it actually reads. entity -> slot lookups go through the *Slot arrays.
+
+    Tables that are iterated on their own (renderables, bounds, lights) keep a copy of the
+    scene graph node they read instead of going through the transform table.
+*/
+typedef uint32_t Entity;
+
+static const Entity   NULL_ENTITY = UINT32_MAX;
+static const uint32_t NO_SLOT     = UINT32_MAX;
+
+enum class LightType : uint8_t
+{
+    DIRECTIONAL,
+    POINT,
+    SPOT
+};
+
+struct TransformComponents
+{
+    std::vector<Entity>    entity;
+    std::vector<int32_t>   node;        // scene graph node the TRS is written to
+    std::vector<glm::vec3> position;
+    std::vector<glm::quat> rotation;
+    std::vector<glm::vec3> scale;
+    std::vector<uint8_t>   changed;     // TRS differs from what the node has
+
+    size_t size() const { return entity.size(); }
+};
+
+struct RenderableComponents
+{
+    std::vector<Entity>    entity;
+    std::vector<int32_t>   node;        // world matrix is the model matrix
+    std::vector<uint32_t>  mesh;        // handle, its meaning is up to the renderer
+    std::vector<uint32_t>  material;
+    std::vector<uint8_t>   occluder;    // rasterized into the CPU occlusion buffer
+    std::vector<uint8_t>   visible;     // written by resolveVisibility()
+
+    size_t size() const { return entity.size(); }
+};
+
+struct LightComponents
+{
+    std::vector<Entity>    entity;
+    std::vector<int32_t>   node;        // -1 for lights without a transform (directional, camera attached)
+    std::vector<LightType> type;
+    std::vector<glm::vec3> position;    // refreshed from the node by updateLights()
+    std::vector<glm::vec3> direction;
+    std::vector<glm::vec3> color;
+    std::vector<glm::vec3> ambient;
+    std::vector<glm::vec3> diffuse;
+    std::vector<glm::vec3> specular;
+    std::vector<float>     constant;
+    std::vector<float>     linear;
+    std::vector<float>     quadratic;
+    std::vector<float>     cutoff;      // cosines of the spot cone
+    std::vector<float>     outerCutoff;
+
+    size_t size() const { return entity.size(); }
+};
+
+struct BoundsComponents
+{
+    std::vector<Entity>    entity;
+    std::vector<int32_t>   node;
+    std::vector<AABB>      local;
+    std::vector<uint8_t>   stale;       // world box not computed yet
+    CullBatch              world;       // world space boxes, visible = result of the last cull
+
+    size_t size() const { return entity.size(); }
+};
+
+struct EntityStore
+{
+    // per entity
+    std::vector<uint8_t>   alive;
+    std::vector<uint32_t>  layer;       // application defined bits, systems can be restricted to some layers
+
+    std::vector<uint32_t>  transformSlot;
+    std::vector<uint32_t>  renderableSlot;
+    std::vector<uint32_t>  lightSlot;
+    std::vector<uint32_t>  boundsSlot;
+
+    TransformComponents    transforms;
+    RenderableComponents   renderables;
+    LightComponents        lights;
+    BoundsComponents       bounds;
+
+    Entity create(uint32_t layer = 1);
+    // scene graph nodes the entity used are not reclaimed, the graph is append only
+    void   destroy(Entity e);
+    void   clear();
+    void   reserve(size_t n);
+
+    size_t count() const { return alive.size() - freeList.size(); }
+
+    void addTransform(Entity e, int32_t node, const glm::vec3& position,
+                      const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                      const glm::vec3& scale = glm::vec3(1.0f));
+    void addRenderable(Entity e, int32_t node, uint32_t mesh, uint32_t material, bool occluder = false);
+    void addLight(Entity e, LightType type, int32_t node = -1);
+    void addBounds(Entity e, int32_t node, const AABB& local);
+
+    void setPosition(Entity e, const glm::vec3& p);
+    void setRotation(Entity e, const glm::quat& q);
+    void setScale(Entity e, const glm::vec3& s);
+
+    // diffuse and ambient follow the color like they always did in this viewer
+    void setLightColor(Entity e, const glm::vec3& color);
+
+    /*
+        Systems, in the order they run each frame.
+    */
+
+    // hands changed TRS to the scene graph, call graph.update() afterwards
+    void writeTransforms(SceneGraph& graph);
+
+    // world boxes of everything whose node moved
+    void updateBounds(const SceneGraph& graph);
+
+    // light positions from their nodes
+    void updateLights(const SceneGraph& graph);
+
+    // frustum test of every box in the given layers, nodeVisible (optional) rejects entries
+    // whose node was already culled hierarchically. returns the number of visible boxes
+    size_t cull(const Frustum& frustum, uint32_t layers, const std::vector<uint8_t> *nodeVisible = nullptr);
+
+    // marks every box in the given layers visible, used when culling is off
+    size_t markVisible(uint32_t layers);
+
+    // copies box visibility to the renderables, renderables outside the layers are hidden
+    // and renderables without bounds are always visible
+    void resolveVisibility(uint32_t layers);
+
+    // light slots of the given type in the given layers
+    size_t gatherLights(LightType type, uint32_t layers, std::vector<uint32_t>& slots) const;
+
+    // what drawing reads (slots, transforms, renderables with their visibility, lights) into
+    // another store, the frame snapshot of the render thread. Bounds and the cull scratch stay
+    // behind. Vectors of to keep their storage, copying into the same store every frame
+    // stops allocating once it saw the largest scene
+    void copyDrawState(EntityStore& to) const;
+
+private:
+    std::vector<Entity>    freeList;
+
+    // scratch for cull()
+    std::vector<uint32_t>  candidates;
+    CullBatch              batch;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+/*
+    Frame pacing: when the next frame starts, and how evenly they do.
+
+    Time comes from FrameClock, 64 bit nanoseconds of the monotonic clock. Seconds as a
+    double still resolve nanoseconds after months, a float seconds counter (what
+    glfwGetTime() was cast to) is down to quarter millisecond steps after an hour and
+    whole milliseconds after a few.
+
+    The modes:
+
+    VSYNC       swap interval 1, the swap blocks until the vertical blank
+    UNCAPPED    swap interval 0 and no waiting, for benchmarks
+    CAPPED      swap interval 0, pace() holds every frame back to 1 / targetFps. It sleeps
+                until spinMargin before the deadline and yields the rest: sleeps wake up
+                late by up to a scheduler tick, the spin is what makes it precise. The
+                margin grows to how late the sleeps have actually been waking up
+    ADAPTIVE    swap interval -1, vsync while the frames make it and tearing instead of
+                waiting a whole refresh when one is late. Needs the swap_control_tear
+                extension, without it this is VSYNC
+
+    pace() is called by the app once at the start of every frame. It measures the
+    intervals between frames against the target (the cap, or the refresh rate with vsync),
+    the jitter is their standard deviation over the last WINDOW frames.
+
+    On demand (onDemand) a frame is only drawn when something asks for one, any mode
+    paces the frames that are drawn:
+
+    markDirty()         a one-off change: input, a resize, the scene or the camera moved.
+                        Draws SETTLE_FRAMES frames, the Ui takes a few to finish reacting
+                        (hover states, numbers that show up a frame late)
+    redraw sources      things that change every frame on their own, a clip playing or the
+                        cubes spinning, draw every frame while they are active
+
+    With neither idle() is true and the app blocks on its events instead of drawing the
+    same picture again. The first frame after that is not counted as an interval.
+*/
+
+enum PacingMode
+{
+    PACING_VSYNC,
+    PACING_UNCAPPED,
+    PACING_CAPPED,
+    PACING_ADAPTIVE,
+    PACING_MODES
+};
+
+const char *pacingModeName(PacingMode mode);
+
+struct FrameClock
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point epoch = Clock::now();
+
+    // nanoseconds since the clock was made, wraps after ~292 years
+    int64_t now() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count(); }
+    double  seconds() const { return (double)now() * 1e-9; }
+};
+
+/*
+    A fixed timestep for the simulation: every frame adds its time, advance() says how many
+    steps of step seconds fit, what is left carries over to the next frame. Behind by more
+    than maxSteps (a stall, a breakpoint) the rest is dropped instead of catching up.
+*/
+struct FixedTimestep
+{
+    bool     enabled     = false;
+    double   step        = 1.0 / 60.0;
+    int      maxSteps    = 8;
+
+    double   accumulator = 0.0;
+    uint64_t steps       = 0;       // run so far
+    uint64_t dropped     = 0;       // steps given up on
+
+    // returns how many steps to run this frame
+    int advance(double deltaTime);
+
+    // how far into the next step the frame is, 0..1, to interpolate between the last two states
+    float alpha() const { return (float)(accumulator / step); }
+};
+
+struct FramePacer
+{
+    static const int WINDOW = 240;
+
+    struct Stats
+    {
+        double   targetMs = 0.0;     // 0 when there is none (uncapped, or the refresh rate is unknown)
+        double   meanMs   = 0.0;     // frame interval
+        double   jitterMs = 0.0;     // standard deviation of the interval
+        double   worstMs  = 0.0;     // furthest interval from the target (or the mean without one)
+        double   lateMs   = 0.0;     // CAPPED: mean of how far past the deadline pace() returned
+        uint64_t frames   = 0;
+    };
+
+    PacingMode    mode        = PACING_VSYNC;
+    double        targetFps   = 60.0;       // CAPPED
+    double        spinMargin  = 0.002;      // seconds before the deadline pace() stops sleeping
+
+    // set by the renderer from the window, 0 if unknown
+    int           refreshRate = 0;
+    bool          tearControl = false;      // the swap_control_tear extension is there
+
+    FrameClock    clock;
+    FixedTimestep simulation;
+
+    static const int SETTLE_FRAMES = 3;
+
+    bool          onDemand    = false;
+    double        idleTimeout = 0.5;        // seconds the app waits for events at most before checking again
+    bool          resumed     = false;      // the frame pace() let through is the first after idling
+    uint64_t      idleWaits   = 0;
+
+    // waits for the frame's turn if the mode says so, returns its time in seconds
+    double pace();
+
+    // any thread, the app still has to be woken up if it is waiting for events
+    void markDirty() { pendingFrames.store(SETTLE_FRAMES, std::memory_order_relaxed); }
+
+    // returns the id of a continuous redraw source, inactive until setRedrawSource() turns it on
+    int  addRedrawSource(const char *name);
+    void setRedrawSource(int source, bool active);
+
+    size_t      redrawSources() const              { return sources.size(); }
+    const char *redrawSourceName(size_t i) const   { return sources[i].name; }
+    bool        redrawSourceActive(size_t i) const { return sources[i].active; }
+
+    // true when on demand and nothing asks for a frame, counts as a wait
+    bool idle();
+
+    // what glfwSwapInterval should be set to for the mode
+    int swapInterval() const;
+
+    // a copy, pace() runs on the main thread and the Ui may read from another
+    Stats stats() const;
+
+private:
+    int64_t            deadline  = 0;       // CAPPED, ns
+    int64_t            lastFrame = -1;      // ns
+    double             sleepSlack = 0.0;    // seconds, how late sleeps have been waking up
+    double             intervals[WINDOW] = {};
+    double             lateness[WINDOW]  = {};
+    uint64_t           count     = 0;
+    mutable std::mutex mutex;
+
+    struct RedrawSource
+    {
+        const char *name;
+        bool        active;
+    };
+
+    std::vector<RedrawSource> sources;
+    int                       activeSources = 0;
+    std::atomic<int>          pendingFrames { SETTLE_FRAMES };
+    bool                      wasIdle = false;
+
+    void wait(int64_t until);
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <cstdint>
+
+/*
+    Frame time statistics.
+
+    The last WINDOW frame times are kept in a ring for the graph and the exact window
+    percentiles, the whole session goes into a histogram of BIN_MS wide bins so its
+    percentiles cost nothing to keep around.
+
+    Sections (FrameSection) time parts of the frame on the CPU. A frame slower than
+    hitchFactor times the window median is a hitch, its section breakdown is kept in a
+    ring of the last MAX_HITCHES so the Ui and the exports can show where the time went.
+
+    frame() and everything that reads the results belong to one thread, sections can be
+    added from others (the render thread). They count towards the frame that is open
+    when they end.
+*/
+struct FrameStats
+{
+    static const int        WINDOW         = 1024;
+    static const int        MAX_SECTIONS   = 32;
+    static const int        MAX_HITCHES    = 64;
+    static const int        HISTOGRAM_BINS = 1000;
+    static constexpr float  BIN_MS         = 0.1f;      // the last bin takes everything above 100 ms
+    static const int        WARMUP         = 30;        // frames before hitches are detected
+
+    struct Section
+    {
+        const char *name;
+        float       ms;     // summed over every time the section ran in the frame
+    };
+
+    struct Hitch
+    {
+        uint64_t             frame;
+        float                ms;
+        float                median;    // of the window when it happened
+        std::vector<Section> sections;
+    };
+
+    struct Summary
+    {
+        uint64_t frames = 0;
+        float    mean   = 0.0f;
+        float    p50    = 0.0f;
+        float    p95    = 0.0f;
+        float    p99    = 0.0f;
+        float    max    = 0.0f;
+    };
+
+    float                hitchFactor = 2.0f;    // k, a frame above k * median is a hitch
+
+    // filled by frame()
+    Summary              window;
+    Summary              session;
+    std::vector<Section> lastSections;          // of the frame that just ended
+    std::vector<Hitch>   hitches;               // ring, see hitchCount
+    uint64_t             hitchCount = 0;
+
+    FrameStats();
+
+    // call once at the start of every frame, closes the previous one
+    void frame();
+
+    // drops the open frame without counting it, for when the app sat idle since it began
+    void resume();
+
+    // adds time to a section of the current frame, name has to be a string literal. Any thread
+    void addSection(const char *name, float ms);
+
+    // window frame times, oldest first
+    void history(std::vector<float>& out) const;
+
+    // window frame times binned between 0 and range ms
+    void histogram(std::vector<float>& out, int bins, float range) const;
+
+    // the most recent hitch is the last one
+    const Hitch& hitch(uint64_t i) const { return hitches[i % MAX_HITCHES]; }
+
+    bool exportCsv(const std::string& path) const;
+    bool exportJson(const std::string& path) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point     frameStart;
+    bool                  started = false;
+
+    float                 times[WINDOW];
+    uint64_t              frames = 0;
+
+    std::vector<Section>  sections;             // of the current frame
+    std::mutex            sectionMutex;         // sections and the swap into lastSections
+    std::vector<uint32_t> bins;                 // session histogram
+    double                sessionSum = 0.0;
+
+    std::vector<float>    sorted;               // scratch
+
+    void  updateWindow();
+    void  updateSession(float ms);
+    float sessionPercentile(double p) const;
+};
+
+// adds the time until the end of the scope to a section of the current frame
+struct FrameSection
+{
+    FrameStats&                           stats;
+    const char                           *name;
+    std::chrono::steady_clock::time_point start;
+
+    FrameSection(FrameStats& s, const char *n) : stats(s), name(n), start(std::chrono::steady_clock::now()) {}
+    ~FrameSection()
+    {
+        stats.addSection(name, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    FrameSection(const FrameSection&) = delete;
+    FrameSection& operator=(const FrameSection&) = delete;
+};
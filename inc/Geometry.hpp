@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <assimp/mesh.h>
+
+#include <vector>
+#include <cstring>
+
+#include <Culling.hpp>
+
+/*
+    The CPU side of building meshes, kept apart from the GL objects so it can run (and be
+    benchmarked) without a context.
+*/
+
+#define MAX_BONE_INFLUENCE 4
+struct Vertex
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+
+    //bone indexes which will influence this vertex
+    int m_BoneIDs[MAX_BONE_INFLUENCE];
+    //weights from each bone
+    float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// appends the vertices and indices of an assimp mesh, bounds grows to fit the vertices
+void convertMesh(const aiMesh *mesh, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, AABB& bounds);
+
+// interleaved position, normal, uv (8 floats per vertex), CCW triangles
+void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, int sectorCount, int stackCount);
+
+// index of the texture loaded from path, -1 if there is none. T needs a std::string path
+template<typename T>
+int findTexture(const std::vector<T>& loaded, const char *path)
+{
+    for(size_t j = 0; j < loaded.size(); j++)
+    {
+        if(std::strcmp(loaded[j].path.data(), path) == 0)
+            return (int)j;
+    }
+    return -1;
+}
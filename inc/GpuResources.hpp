@@ -0,0 +1,124 @@
+#pragma once
+
+#include <GLAD/glad.h>
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+/*
+    GL object pools.
+
+    Buffers, textures and vertex arrays are handed out as 32 bit handles, 20 bits
+    of slot index and 12 bits of generation. Destroying a handle bumps the generation of
+    its slot, so every copy of it that is still around resolves to 0 instead of to whatever
+    object ends up in the slot next. That is what lets one object draw with another's
+    buffers (the light gizmos use the cube's) without dangling names.
+
+    The GL objects themselves are not deleted right away. Everything destroyed during a
+    frame waits behind a fence inserted by endFrame() and is only deleted (or, for buffers,
+    stripped of its storage and kept for reuse) once the GPU passed that fence, so nothing
+    is freed while a draw in flight still reads it.
+
+    retire() puts a raw GL name on the same deferred path, for objects that are not
+    created through the pools, the shader programs from createShaderProgram.
+*/
+
+enum class GpuResource : uint8_t
+{
+    BUFFER,
+    TEXTURE,
+    VERTEX_ARRAY,
+    PROGRAM,        // retire() only, programs are not pooled
+    COUNT
+};
+
+template<GpuResource TYPE>
+struct GpuHandle
+{
+    uint32_t value = 0;     // 0 is never handed out
+
+    explicit operator bool() const { return value != 0; }
+
+    bool operator==(GpuHandle other) const { return value == other.value; }
+    bool operator!=(GpuHandle other) const { return value != other.value; }
+};
+
+typedef GpuHandle<GpuResource::BUFFER>       BufferHandle;
+typedef GpuHandle<GpuResource::TEXTURE>      TextureHandle;
+typedef GpuHandle<GpuResource::VERTEX_ARRAY> VertexArrayHandle;
+
+struct GpuResources
+{
+    static const int      INDEX_BITS  = 20;
+    static const uint32_t INDEX_MASK  = (1u << INDEX_BITS) - 1;
+    static const uint32_t MAX_SPARES  = 256;    // stripped buffer names kept around for reuse
+
+    struct Stats
+    {
+        uint32_t live[(int)GpuResource::COUNT] = {};
+        uint32_t pending = 0;       // destroyed, waiting for their fence
+        uint32_t spares  = 0;       // buffer names ready to be handed out again
+        uint64_t reused  = 0;       // buffers that got a recycled name
+    };
+
+    BufferHandle      createBuffer();
+    TextureHandle     createTexture();
+    VertexArrayHandle createVertexArray();
+
+    // 0 once the handle was destroyed
+    template<GpuResource TYPE>
+    GLuint get(GpuHandle<TYPE> handle) const { return lookup(TYPE, handle.value); }
+
+    template<GpuResource TYPE>
+    bool valid(GpuHandle<TYPE> handle) const { return lookup(TYPE, handle.value) != 0; }
+
+    // invalidates every copy of the handle and resets this one, the object goes once the GPU is done with it
+    template<GpuResource TYPE>
+    void destroy(GpuHandle<TYPE>& handle)
+    {
+        release(TYPE, handle.value);
+        handle.value = 0;
+    }
+
+    void retire(GpuResource type, GLuint name);
+
+    // fences what was destroyed this frame and deletes what earlier fences cleared
+    void endFrame();
+
+    // waits for the GPU and deletes everything, pooled objects included
+    void shutdown();
+
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Pool
+    {
+        std::vector<GLuint>   names;
+        std::vector<uint16_t> generations;
+        std::vector<uint32_t> freeSlots;
+    };
+
+    struct Retired
+    {
+        GpuResource type;
+        GLuint      name;
+    };
+
+    struct Batch
+    {
+        GLsync               fence;
+        std::vector<Retired> objects;
+    };
+
+    Pool                 pools[(int)GpuResource::COUNT];
+    std::vector<Retired> pending;       // this frame's, not fenced yet
+    std::deque<Batch>    batches;       // oldest first
+    std::vector<GLuint>  spareBuffers;
+    Stats                counters;
+
+    uint32_t allocate(GpuResource type, GLuint name);
+    GLuint   lookup(GpuResource type, uint32_t handle) const;
+    void     release(GpuResource type, uint32_t handle);
+    void     free(const Retired& object);
+};
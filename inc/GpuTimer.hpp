@@ -0,0 +1,92 @@
+#pragma once
+
+#include <GLAD/glad.h>
+
+#include <vector>
+#include <cstdint>
+
+/*
+    GPU timing zones.
+
+    Every zone writes a GL_TIMESTAMP query at its start and at its end, so zones can nest
+    unlike GL_TIME_ELAPSED queries. The queries of a frame go into one slot of a ring of
+    FRAMES slots and are only read when the ring comes back around to that slot, by then
+    the GPU finished them long ago and reading never stalls. A slot that still is not
+    done is dropped instead of waited on.
+
+    Without timer query support (no GL_TIMESTAMP counter bits) every call is a no-op and
+    available() returns false.
+*/
+struct GpuTimers
+{
+    static const int FRAMES    = 4;     // frames between issuing a query and reading it
+    static const int MAX_ZONES = 64;    // per frame
+    static const int HISTORY   = 120;   // frames in the rolling average
+
+    struct Stats
+    {
+        const char *name;
+        double      last    = 0.0;      // ms, summed over every time the zone ran in the frame
+        double      average = 0.0;      // ms over the last HISTORY samples
+        double      max     = 0.0;      // ms over the last HISTORY samples
+        int         depth   = 0;        // nesting level when it was last recorded
+
+        double      history[HISTORY] = {};
+        int         samples = 0;
+        int         next    = 0;
+    };
+
+    std::vector<Stats> stats;           // in the order zones were first seen
+    uint64_t           dropped = 0;     // frames whose queries were not ready in time
+
+    // needs a current context
+    void init();
+    void shutdown();
+
+    bool available() const { return supported; }
+
+    // reads the frame issued FRAMES frames ago and starts recording this one
+    void beginFrame();
+
+    // name has to outlive the timers, string literals are what this is made for
+    int  begin(const char *name);
+    void end(int zone);
+
+private:
+    struct Zone
+    {
+        int    stat;
+        int    depth;
+        GLuint queries[2];
+    };
+
+    struct Frame
+    {
+        GLuint            queries[2 * MAX_ZONES];
+        std::vector<Zone> zones;
+        GLuint            last = 0;     // query of the most recent end()
+    };
+
+    bool     supported = false;
+    Frame    frames[FRAMES];
+    uint64_t frameIndex = 0;
+    int      depth      = 0;
+
+    std::vector<double> frameTotals;    // scratch for resolve()
+
+    int  findStats(const char *name);
+    void resolve(Frame& frame);
+};
+
+// times everything until the end of the scope
+struct GpuZone
+{
+    GpuTimers& timers;
+    int        zone;
+
+    GpuZone(GpuTimers& t, const char *name) : timers(t), zone(t.begin(name)) {}
+    ~GpuZone() { timers.end(zone); }
+
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+};
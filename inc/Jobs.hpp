@@ -0,0 +1,257 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include <Profiler.hpp>
+
+/*
+    Work stealing job system.
+
+    One worker per hardware thread, the thread that calls start() (the main thread) is
+    worker 0 and only runs jobs while it waits for some. Every worker owns a Chase-Lev
+    deque: it pushes and pops its own jobs at the bottom, LIFO, and idle workers steal
+    from the top of someone else's, so what gets stolen is the oldest and usually the
+    biggest piece of work.
+
+    Jobs are fork/join. Whoever submits jobs hands in a JobCounter and waits on it before
+    the data the jobs use goes out of scope. Waiting doesn't block, the waiting thread
+    runs jobs (its own first, then stolen ones) until the counter is down to zero, so a
+    job can submit and wait for jobs of its own; parallelFor inside parallelFor is fine.
+
+    parallelFor splits its range in halves until the pieces are down to the grain, the
+    half that is not worked on right away goes onto the deque for others to steal. The
+    grain is picked from the count and the number of workers (about 8 pieces per worker)
+    and never goes below the minimum the caller passes, which is how a caller says how
+    much work one item is.
+
+    GL calls can only be made on the main thread. Jobs hand them over with runOnMain(),
+    the main thread runs them in runMainJobs() once per frame and whenever it waits, so a
+    loader can wait on decode jobs that queue their own uploads. The main thread is the
+    one that called start() until another one takes over with setMainThread(), which is
+    what the render thread does when the GL context moves to it. Only workers can split
+    work, parallelFor on a thread that isn't one (the render thread) runs inline.
+
+    Before start() and on threads that are not workers everything runs inline.
+*/
+
+struct JobCounter
+{
+    std::atomic<int32_t> pending{0};
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct Job
+{
+    void      (*function)(void *data, size_t begin, size_t end) = nullptr;
+    void       *data    = nullptr;
+    size_t      begin   = 0;
+    size_t      end     = 0;
+    JobCounter *counter = nullptr;
+};
+
+/*
+    Fixed size Chase-Lev deque of jobs, with the memory orders of "Correct and Efficient
+    Work-Stealing for Weak Memory Models" (Le et al. 2013). push() and pop() are for the
+    owning worker only, steal() for everyone else.
+
+    The jobs are stored by value, a slot belongs to the deque from push() until pop() or
+    steal() copied it out, however many jobs were pushed since. Each field is a relaxed
+    atomic: a thief that read a slot the owner was already reusing fails its exchange on
+    top and throws the copy away.
+*/
+class JobDeque
+{
+public:
+    static const int64_t CAPACITY = 4096;   // power of two
+
+    // false when full, the caller runs the job itself
+    bool push(const Job& job);
+    bool pop(Job& out);
+    bool steal(Job& out);
+
+private:
+    struct Slot
+    {
+        std::atomic<void (*)(void *, size_t, size_t)> function{nullptr};
+        std::atomic<void*>       data{nullptr};
+        std::atomic<size_t>      begin{0};
+        std::atomic<size_t>      end{0};
+        std::atomic<JobCounter*> counter{nullptr};
+
+        void store(const Job& job);
+        void load(Job& job) const;
+    };
+
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    std::unique_ptr<Slot[]>          jobs{new Slot[CAPACITY]};
+};
+
+struct JobSystem
+{
+    struct Stats
+    {
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+    };
+
+    JobSystem() = default;
+    JobSystem(const JobSystem&)            = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    ~JobSystem() { stop(); }
+
+    // the calling thread becomes worker 0 and the main thread, 0 threads is one per core
+    void start(unsigned threads = 0);
+
+    // waits for the workers to finish what they are running, queued jobs are dropped
+    void stop();
+
+    bool     running() const { return !workers.empty(); }
+    unsigned workerCount() const { return running() ? (unsigned)workers.size() : 1; }
+
+    // -1 on threads that are not workers
+    int  currentWorker() const;
+
+    // the thread runOnMain() work goes to, the GL thread
+    bool isMainThread() const { return mainThread.load(std::memory_order_relaxed) == std::this_thread::get_id(); }
+    void setMainThread() { mainThread.store(std::this_thread::get_id(), std::memory_order_relaxed); }
+
+    // counts the job into its counter and queues it on the calling worker, inline
+    // everywhere else. The counter may be null for jobs nobody waits for
+    void submit(const Job& job);
+
+    // runs jobs until the counter is down to zero
+    void wait(JobCounter& counter);
+
+    // GL work, runs on the main thread. The counter (if any) only drops once it ran
+    void runOnMain(std::function<void()> fn, JobCounter *counter = nullptr);
+    void runMainJobs();
+
+    // about 8 pieces per worker, at least minGrain items each
+    size_t grainFor(size_t count, size_t minGrain) const
+    {
+        size_t pieces = (size_t)workerCount() * 8;
+        return std::max(std::max<size_t>(minGrain, 1), (count + pieces - 1) / pieces);
+    }
+
+    // fn(begin, end) over pieces of [0, count), returns once all of them ran
+    template<typename Fn>
+    void parallelFor(size_t count, size_t minGrain, Fn&& fn)
+    {
+        if (count == 0)
+            return;
+
+        size_t grain = grainFor(count, minGrain);
+        if (count <= grain || currentWorker() < 0)
+        {
+            fn((size_t)0, count);
+            return;
+        }
+
+        struct Range
+        {
+            typename std::remove_reference<Fn>::type *fn;
+            JobSystem  *system;
+            JobCounter *counter;
+            size_t      grain;
+
+            static void run(void *data, size_t begin, size_t end)
+            {
+                Range *r = (Range *)data;
+
+                // keep the first half, hand out the second, until what is left is one grain
+                while (end - begin > r->grain)
+                {
+                    size_t mid = begin + (end - begin) / 2;
+
+                    Job job;
+                    job.function = &Range::run;
+                    job.data     = r;
+                    job.begin    = mid;
+                    job.end      = end;
+                    job.counter  = r->counter;
+                    r->system->submit(job);
+
+                    end = mid;
+                }
+                (*r->fn)(begin, end);
+            }
+        };
+
+        JobCounter counter;
+        Range      range = { &fn, this, &counter, grain };
+        Range::run(&range, 0, count);
+        wait(counter);
+    }
+
+    // runs a on the calling thread and b as a job, returns when both are done
+    template<typename A, typename B>
+    void invoke(A&& a, B&& b)
+    {
+        if (currentWorker() < 0)
+        {
+            a();
+            b();
+            return;
+        }
+
+        struct Call
+        {
+            static void run(void *data, size_t, size_t)
+            {
+                (*(typename std::remove_reference<B>::type *)data)();
+            }
+        };
+
+        JobCounter counter;
+        Job job;
+        job.function = &Call::run;
+        job.data     = (void *)&b;
+        job.counter  = &counter;
+        submit(job);
+
+        a();
+        wait(counter);
+    }
+
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Worker
+    {
+        JobDeque               deque;
+        std::thread            thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool>                    quit{false};
+
+    // idle workers sleep until something is queued
+    std::atomic<int32_t>     queued{0};
+    std::atomic<int32_t>     sleeping{0};
+    std::mutex               sleepMutex;
+    std::condition_variable  wake;
+
+    std::mutex                      mainMutex;
+    std::vector<std::pair<std::function<void()>, JobCounter*>> mainJobs;
+    std::atomic<std::thread::id>    mainThread{std::this_thread::get_id()};
+
+    Stats                    counters;
+
+    bool find(int self, Job& out);
+    void execute(const Job& job);
+    void workerLoop(int index);
+};
+
+extern JobSystem jobs;
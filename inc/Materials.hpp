@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include <GpuResources.hpp>
+#include <TextureAtlas.hpp>
+
+/*
+    Material table of a model.
+
+    Materials are interned while the model loads. Every mesh keeps the index of its
+    material in the table, and meshes whose materials sample the same textures with the
+    same parameters share one entry. The table goes into a uniform buffer once, laid out
+    as GpuMaterial (std140), bound to MATERIAL_BINDING. The shaders index it with the
+    materialIndex uniform, so a draw sets one int instead of the texture rects, pages
+    and shininess of its material, and draws of different materials need no other state
+    change between them.
+
+    GL 3.3 only guarantees 16 KB per uniform block, MAX_MATERIALS entries is what fits.
+    Materials past that fall back to entry 0.
+*/
+
+enum MaterialFlags : uint32_t
+{
+    MATERIAL_DIFFUSE_MAP  = 1 << SLOT_DIFFUSE,
+    MATERIAL_NORMAL_MAP   = 1 << SLOT_NORMAL,
+    MATERIAL_SPECULAR_MAP = 1 << SLOT_SPECULAR,
+};
+
+struct Material
+{
+    MaterialTextures textures;
+    float            shininess = 32.0f;
+    uint32_t         flags     = 0;         // MaterialFlags, set by intern() from the textures
+};
+
+// one entry of the Materials block in model_fs.glsl / gbuffer_model_fs.glsl
+struct GpuMaterial
+{
+    glm::vec4  rect[TEXTURE_SLOTS];         // offset xy, scale zw of every slot in its page
+    glm::ivec4 page;                        // layer * 4 + array of every slot, w flags
+    glm::vec4  params;                      // x shininess
+};
+
+struct MaterialTable
+{
+    static const uint32_t MAX_MATERIALS    = 192;   // * 80 bytes, under 16 KB
+    static const GLuint   MATERIAL_BINDING = 0;
+
+    std::vector<Material> materials;
+    BufferHandle          buffer;
+
+    MaterialTable() = default;
+    MaterialTable(const MaterialTable&)            = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+    ~MaterialTable() { release(); }
+
+    // index of an equal material already in the table, or of the one just added. The
+    // textures have to be resolved already
+    uint32_t intern(const Material& material);
+
+    // writes the table into the uniform buffer, needs a current context
+    void upload(const char *asset);
+
+    void bind() const;
+
+    // points the Materials block of a program at MATERIAL_BINDING, once after linking
+    static void bindBlock(GLuint program);
+
+    void release();
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <GLAD/glad.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    Memory accounting.
+
+    Every GL buffer, texture and renderbuffer the renderer allocates is reported here right
+    after the call that gives it storage, with the subsystem it belongs to and the asset it
+    was made for, and released next to the glDelete. CPU side copies worth knowing about
+    (the vertices and indices a Mesh keeps after the upload) are reported the same way
+    under HOST with an id of the owner's choosing.
+
+    GPU sizes are what the data needs in the format it was given, drivers add alignment
+    and padding on top so the real footprint is somewhat larger. Three channel formats are
+    counted as four, no driver stores them packed.
+
+    Tracking the same id again replaces its size, which is what glBufferData on a live
+    buffer or a resized render target does.
+*/
+
+enum class MemoryTag : uint8_t
+{
+    MESH,
+    TEXTURE,
+    RENDER_TARGET,
+    LIGHTING,
+    UI,
+    DEBUG,
+    COUNT
+};
+
+enum class MemoryKind : uint8_t
+{
+    BUFFER,
+    TEXTURE,
+    RENDERBUFFER,
+    HOST,
+    COUNT
+};
+
+const char *memoryTagName(MemoryTag tag);
+
+// bytes per texel of a sized or unsized internal format
+size_t texelBytes(GLenum internalFormat);
+
+// level 0, plus every level down to 1x1 when mipmapped
+size_t textureBytes(GLenum internalFormat, int width, int height, bool mipmapped);
+
+/*
+    Counts the operator new calls made while it is open, for one piece of work like a model
+    load. Every thread counts, the job workers running the work's jobs included, so it is
+    meant for work that has the program to itself (the load at startup). Outside of a scope
+    the replacement operator new in MemoryTracker.cpp only checks a flag, inside one every
+    thread adds to a counter on a cache line of its own. Allocations inside DLLs (assimp)
+    go through their own operator new and don't show up.
+*/
+class AllocationScope
+{
+public:
+    AllocationScope();
+    ~AllocationScope();
+    AllocationScope(const AllocationScope&)            = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    uint64_t allocations() const;
+
+private:
+    uint64_t start;
+};
+
+struct MemoryTracker
+{
+    static const int TAGS  = (int)MemoryTag::COUNT;
+    static const int HEAPS = 2;                     // 0 GPU, 1 CPU (HOST)
+
+    struct Totals
+    {
+        uint64_t live  = 0;
+        uint64_t peak  = 0;
+        uint32_t count = 0;                         // live allocations
+    };
+
+    struct Asset
+    {
+        std::string name;
+        MemoryTag   tag;
+        uint64_t    bytes[HEAPS];
+        uint32_t    allocations;
+    };
+
+    // track, release and breakdown lock it. GL objects are tracked on the render thread,
+    // the Ui reads the totals and sets the budgets under it from the update thread
+    mutable std::mutex mutex;
+
+    Totals   tags[HEAPS][TAGS];
+    Totals   heaps[HEAPS];
+    uint64_t budget[HEAPS] = { 0, 0 };              // bytes, 0 turns the warning off
+
+    void track(MemoryKind kind, uint64_t id, size_t bytes, MemoryTag tag, const std::string& asset);
+    void release(MemoryKind kind, uint64_t id);
+
+    bool overBudget(int heap) const { return budget[heap] > 0 && heaps[heap].live > budget[heap]; }
+
+    // live allocations summed per asset, largest first
+    void breakdown(std::vector<Asset>& out) const;
+
+private:
+    struct Allocation
+    {
+        uint64_t    bytes;
+        MemoryTag   tag;
+        std::string asset;
+    };
+
+    std::unordered_map<uint64_t, Allocation> live[(int)MemoryKind::COUNT];
+    bool                                     warned[HEAPS] = { false, false };
+
+    void add(int heap, MemoryTag tag, uint64_t bytes);
+    void remove(int heap, MemoryTag tag, uint64_t bytes);
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include <Culling.hpp>
+
+/*
+    CPU occlusion culling.
+
+    Big occluders are rasterized into a small depth buffer (no GPU involved), then a min/max
+    depth pyramid is built from it and candidate boxes are tested against the pyramid level
+    where they cover only a couple of texels.
+
+    depth is z/w remapped to [0, 1], 0 is the near plane, the buffer is cleared to 1 (far)
+*/
+struct OcclusionBuffer
+{
+    static const int WIDTH       = 256;
+    static const int HEIGHT      = 128;
+    static const int TILE_WIDTH  = 32;
+    static const int TILE_HEIGHT = 32;
+    static const int TILES_X     = WIDTH / TILE_WIDTH;
+    static const int TILES_Y     = HEIGHT / TILE_HEIGHT;
+
+    struct ScreenTriangle
+    {
+        // x, y in pixels, z in [0, 1]
+        glm::vec3 v[3];
+    };
+
+    struct Level
+    {
+        int                width;
+        int                height;
+        std::vector<float> minDepth;    // nearest occluder in the texel
+        std::vector<float> maxDepth;    // farthest occluder in the texel, used to reject boxes
+    };
+
+    glm::mat4                          viewProj;
+
+    std::vector<float>                 depth;      // WIDTH * HEIGHT, row major, row 0 at the bottom
+    std::vector<Level>                 pyramid;    // level 0 is a copy of depth
+
+    std::vector<ScreenTriangle>        triangles;  // clipped occluder triangles of this frame
+    std::vector<std::vector<uint32_t>> bins;       // triangle indices per tile
+
+    // stats of the last frame
+    uint32_t                           occluderTriangles = 0;
+    double                             rasterTime        = 0.0;   // ms, transform + bin + raster + pyramid
+
+    OcclusionBuffer();
+
+    void beginFrame(const glm::mat4& viewProj);
+
+    // queues the triangles of an occluder mesh, they are transformed and clipped here
+    void addOccluder(const glm::vec3 *positions, size_t positionStride,
+                     const uint32_t *indices, size_t indexCount, const glm::mat4& model);
+
+    // bins the queued triangles into tiles, rasterizes the tiles in parallel and builds the pyramid
+    void rasterize();
+
+    // true if any part of the world space box might be visible
+    bool testAABB(const AABB& box) const;
+
+private:
+    void clipAndAdd(const glm::vec4 clip[3]);
+    void rasterizeTile(int tile);
+    void buildPyramid();
+};
+
+// which kernel the tile rasterizer uses on this cpu ("AVX2", "SSE", "scalar")
+const char *occlusionBackendName();
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Jobs.hpp>
+
+// the helpers the modules used before the job system existed, now on top of it (see Jobs.hpp)
+
+// number of threads the parallel helpers will use (including the calling thread)
+inline unsigned workerCount()
+{
+    return jobs.workerCount();
+}
+
+// calls fn(begin, end) on pieces of [0, count) of at least `grain` items, the job system
+// picks bigger pieces when there is enough work
+template<typename Fn>
+void parallelFor(size_t count, size_t grain, Fn&& fn)
+{
+    jobs.parallelFor(count, grain, fn);
+}
+
+// runs a on the calling thread and b as a job, returns when both are done
+template<typename A, typename B>
+void parallelInvoke(A&& a, B&& b)
+{
+    jobs.invoke(a, b);
+}
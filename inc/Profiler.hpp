@@ -0,0 +1,99 @@
+#pragma once
+
+/*
+    CPU instrumentation.
+
+    PROFILE_ZONE("name") times the rest of the scope, PROFILE_FUNCTION() does the same with
+    the function's name. Each thread appends finished zones to a buffer of its own, a
+    fixed size ring with a single writer, so recording never takes a lock or allocates.
+    Timestamps come from rdtsc on x86 (assumes an invariant TSC, true for anything recent)
+    and steady_clock everywhere else.
+
+    The main thread calls PROFILE_FRAME() once per frame. Traces are written in the Chrome
+    trace event format that chrome://tracing and ui.perfetto.dev open, either on demand or
+    automatically for the last few frames when a frame takes longer than hitchThreshold.
+
+    Everything compiles to nothing unless PROFILER_ENABLED is 1, zone names have to be
+    string literals (or anything else that lives as long as the program).
+*/
+
+#ifndef PROFILER_ENABLED
+    #define PROFILER_ENABLED 0
+#endif
+
+#if PROFILER_ENABLED
+
+#include <cstdint>
+#include <string>
+
+#include <Simd.hpp>
+
+#if SIMD_X86 && !defined(_MSC_VER)
+    #include <x86intrin.h>
+#endif
+#if !SIMD_X86
+    #include <chrono>
+#endif
+
+namespace Profiler
+{
+    inline uint64_t now()
+    {
+#if SIMD_X86
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // appends a finished zone to the calling thread's buffer
+    void record(const char *name, uint64_t begin, uint64_t end);
+
+    // shows up as the track name of the calling thread
+    void setThreadName(const char *name);
+
+    // marks the start of a new frame, main thread only
+    void frame();
+
+    // everything still in the buffers
+    bool exportTrace(const std::string& path);
+
+    // only the last `frames` frames, the current one included
+    bool exportFrames(const std::string& path, int frames);
+
+    // frames slower than this are written to hitch_<frame>.json, 0 turns it off
+    extern float hitchThreshold;    // ms
+    extern int   hitchFrames;
+    extern int   hitchCaptures;     // traces written so far
+
+    float lastFrameTime();          // ms
+}
+
+struct ProfileScope
+{
+    const char *name;
+    uint64_t    begin;
+
+    explicit ProfileScope(const char *n) : name(n), begin(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(name, begin, Profiler::now()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_(a, b)       a##b
+#define PROFILE_CONCAT(a, b)        PROFILE_CONCAT_(a, b)
+
+#define PROFILE_ZONE(name)          ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION()          PROFILE_ZONE(__func__)
+#define PROFILE_FRAME()             Profiler::frame()
+#define PROFILE_THREAD_NAME(name)   Profiler::setThreadName(name)
+
+#else
+
+#define PROFILE_ZONE(name)          ((void)0)
+#define PROFILE_FUNCTION()          ((void)0)
+#define PROFILE_FRAME()             ((void)0)
+#define PROFILE_THREAD_NAME(name)   ((void)0)
+
+#endif
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/*
+    Input recording and replay.
+
+    A recording is the start state and, per frame, everything processInput consumed: the
+    frame time and the deltaTime the frame ran with, the keys held down, scroll and click events, and the render settings
+    whenever they changed. Replaying feeds those back in place of the window, so the
+    camera goes through the same states bit for bit. Every KEYFRAME_INTERVAL frames the
+    camera that came out is stored as well, replays compare against it and snap back to
+    it, a replay built with another compiler still follows the same path.
+
+    The file is little endian, a fixed header and then one variable sized record per
+    frame: a flags byte, the time (a double, like gc.currentTime), the deltaTime, and only
+    the fields the flags say are there. A frame where nothing but the time changed is 13
+    bytes. The deltaTime is stored rather than taken from the difference of the times so a
+    replay moves by exactly what the recorded frame did, frames after an idle wait or a
+    replay included.
+
+    Not recorded: edits made in the Ui other than the settings bits (light colors and
+    positions), a replay shows them as they are when it starts.
+*/
+
+// bits of InputFrame::keys
+enum InputKey : uint32_t
+{
+    KEY_FORWARD         = 1u << 0,
+    KEY_BACKWARD        = 1u << 1,
+    KEY_LEFT            = 1u << 2,
+    KEY_RIGHT           = 1u << 3,
+    KEY_TILT_UP         = 1u << 4,
+    KEY_TILT_DOWN       = 1u << 5,
+    KEY_TILT_LEFT       = 1u << 6,
+    KEY_TILT_RIGHT      = 1u << 7,
+    KEY_VIEW_XY         = 1u << 8,
+    KEY_VIEW_YZ         = 1u << 9,
+    KEY_VIEW_XZ         = 1u << 10,
+    KEY_VIEW_ISOMETRIC  = 1u << 11,
+    KEY_VIEW_TOP        = 1u << 12,
+    KEY_VIEW_FRONT      = 1u << 13,
+    KEY_VIEW_SIDE       = 1u << 14,
+    KEY_RELOAD_SHADERS  = 1u << 15,
+};
+
+struct CameraState
+{
+    glm::vec3 pos   = glm::vec3(0.0f);
+    float     yaw   = 0.0f;
+    float     pitch = 0.0f;
+    float     zoom  = 0.0f;
+};
+
+struct InputFrame
+{
+    double      time      = 0.0;    // gc.currentTime
+    float       deltaTime = 0.0f;   // gc.deltaTime
+    uint32_t    keys     = 0;       // InputKey bits held down
+    uint32_t    settings = 0;       // opaque to the recording, the renderer packs its toggles in here
+    float       scroll   = 0.0f;    // summed over the frame
+    bool        click    = false;   // left button pressed, at clickX/clickY in window pixels
+    float       clickX   = 0.0f;
+    float       clickY   = 0.0f;
+    bool        keyframe = false;   // camera holds the state after this frame
+    CameraState camera;
+};
+
+struct InputRecording
+{
+    static const uint32_t VERSION           = 2;
+    static const int      KEYFRAME_INTERVAL = 60;
+
+    int                     width     = 0;
+    int                     height    = 0;
+    double                  lastFrame = 0.0;    // time of the frame before the first, where the clock resumes from
+    CameraState             start;
+    std::vector<InputFrame> frames;             // settings of frame 0 are the start settings
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // seconds from the first to the last frame
+    double duration() const { return frames.empty() ? 0.0 : frames.back().time - frames.front().time; }
+};
+
+/*
+    Walks a recording. FIXED_STEP hands out one recorded frame per rendered frame no
+    matter how long it took, that is the mode for benchmarks and offscreen runs. REAL_TIME
+    hands out every recorded frame whose time the wall clock has passed, rendering only
+    the last, so it plays at the speed it was recorded while the camera still goes
+    through every recorded step.
+*/
+struct InputReplay
+{
+    enum Mode
+    {
+        FIXED_STEP,
+        REAL_TIME
+    };
+
+    InputRecording recording;
+    Mode           mode       = FIXED_STEP;
+    size_t         cursor     = 0;
+    double         clockStart = -1.0;
+
+    // camera drift against the keyframes, see InputRecording
+    float          maxDrift   = 0.0f;
+    int            resyncs    = 0;
+
+    bool start(const std::string& path, Mode m);
+    bool finished() const { return cursor >= recording.frames.size(); }
+
+    // frames [first, first + count) are due at wall time now (seconds)
+    size_t advance(double now, size_t& first);
+};
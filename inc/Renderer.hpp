@@ -0,0 +1,121 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <GLM/glm.hpp>
+
+#include <string>
+
+#include <GpuTimer.hpp>
+#include <FrameStats.hpp>
+#include <Recording.hpp>
+#include <MemoryTracker.hpp>
+#include <GpuResources.hpp>
+#include <FramePacing.hpp>
+
+/*
+    The viewer as a library, everything except the window lives in src/Renderer.cpp.
+
+    The app (main.cpp) opens a GLFW window and hands it over, that brings the Ui and the
+    mouse/keyboard input along. Without a window the renderer runs headless: no Ui, the
+    caller owns the GL context and tells it which framebuffer to draw into, see
+    bench/headless_bench.cpp.
+*/
+
+struct global_context
+{
+    int         width           = 800;
+    int         height          = 600;
+    double      currentTime     = 0.0;      // seconds, see FramePacing.hpp for why not float
+    float       deltaTime       = 0.0f;
+    double      lastFrame       = 0.0;
+
+    bool        debug           = false;
+    bool        wireframe       = false;
+    bool        sphere          = false;
+    bool        model           = false;
+    bool        culling         = true;
+    bool        occlusion       = true;
+    bool        deferred        = false;
+    bool        depthPrepass    = false;
+    bool        overdraw        = false;
+
+    bool        firstMouse      = true;
+    float       mouseX          = 0;
+    float       mouseY          = 0;
+    float       mouseLastX      = 400;
+    float       mouseLastY      = 300;
+
+    GLFWwindow  *window         = nullptr;
+    GLuint      framebuffer     = 0;        // what the frame is drawn into, 0 is the window
+};
+
+extern global_context gc;
+extern GpuTimers      gpuTimers;
+extern FrameStats     frameStats;
+extern MemoryTracker  memoryTracker;
+extern GpuResources   gpuResources;
+extern FramePacer     framePacer;
+
+struct RendererOptions
+{
+    std::string  modelPath;
+    std::string  assetDir   = "../assets/";
+    int          width      = 800;
+    int          height     = 600;
+
+    // gets the Ui and the input callbacks, nullptr runs headless
+    GLFWwindow  *window     = nullptr;
+
+    // job system workers including the calling thread, 0 is one per core (see Jobs.hpp)
+    unsigned     workers    = 0;
+};
+
+// the GL context has to be current and its functions loaded. The calling thread becomes
+// the main thread of the job system, every GL call stays on it
+void initRenderer(const RendererOptions& options);
+void shutdownRenderer();
+
+void resizeRenderer(int width, int height);
+
+// time in seconds, drives the animation and deltaTime. With a window it comes from
+// framePacer.pace(), which also owns the swap interval
+void beginFrame(double time);
+// any thread, asks for a frame when on demand rendering is waiting for events (framePacer.onDemand)
+void requestRedraw();
+// window may be nullptr, headless there is no live input
+void processInput(GLFWwindow *window);
+
+// updates the scene and draws it on the calling thread, into gc.framebuffer
+void renderScene();
+
+/*
+    With a window the drawing can run on a thread of its own. startRenderThread() moves the
+    GL context over to it, from then on the main thread calls updateScene() every frame
+    instead of renderScene(): it publishes a snapshot of the scene and the render thread
+    draws and swaps it while the next one is updated. stopRenderThread() hands the context
+    back to the calling thread, before shutdownRenderer().
+*/
+void updateScene();
+void startRenderThread();
+void stopRenderThread();
+bool renderThreadRunning();
+
+// yaw and pitch in degrees, like the mouse look
+void setCameraPose(const glm::vec3& position, float yaw, float pitch);
+
+/*
+    Input recording, see Recording.hpp. A recording starts with the next processInput and
+    is written out when it stops. While a replay runs, beginFrame is ignored and
+    processInput takes the time, the input and the settings from the recording, the
+    window can be nullptr then.
+*/
+void startRecording();
+bool stopRecording(const std::string& path);
+bool startReplay(const std::string& path, InputReplay::Mode mode);
+void stopReplay();
+
+// nullptr when nothing is being recorded / replayed
+const InputRecording *activeRecording();
+const InputReplay    *activeReplay();
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include <Culling.hpp>
+
+/*
+    Transform hierarchy stored as flat arrays in depth first order: a parent always comes
+    before its children and the subtree of node i is the range [i, subtreeEnd[i]).
+
+    Only nodes whose local transform changed (and their descendants) are recomputed by
+    update(), so a static scene costs one branch per frame.
+
+    The world matrices are computed in parallel: runs of whole subtrees of up to
+    UPDATE_GRAIN nodes are one job each, the few nodes above them whose subtrees are
+    bigger go first on the calling thread.
+*/
+struct SceneGraph
+{
+    static const uint32_t UPDATE_GRAIN = 1024;
+
+    std::vector<int32_t>   parent;        // -1 for roots
+    std::vector<uint32_t>  subtreeEnd;
+    std::vector<glm::mat4> local;
+    std::vector<glm::mat4> world;
+    std::vector<uint8_t>   dirty;         // local changed since the last update
+    std::vector<AABB>      localBounds;   // object space bounds of what is attached to the node
+    std::vector<AABB>      worldBounds;   // world space bounds of the node's whole subtree
+
+    std::vector<uint8_t>   changed;       // world matrix was recomputed by the last update
+
+    // stats of the last update
+    uint32_t               updatedNodes = 0;
+
+    // nodes have to be added depth first, i.e. parent must be the last node whose subtree is still open
+    int32_t addNode(int32_t parent, const glm::mat4& local = glm::mat4(1.0f), const AABB& bounds = AABB());
+
+    void setLocal(int32_t node, const glm::mat4& m);
+    void setLocalBounds(int32_t node, const AABB& bounds);
+
+    // recomputes world transforms and subtree bounds of everything that changed
+    void update();
+
+    // hierarchical frustum test, a subtree outside the frustum is skipped as a whole.
+    // visible[i] is 1 if the subtree of node i may be visible
+    void cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+
+    size_t size() const { return parent.size(); }
+
+private:
+    std::vector<uint8_t>   boundsDirty;
+    std::vector<AABB>      childBounds;
+    uint32_t               dirtyCount = 0;
+
+    // how update() splits the nodes, redone whenever nodes were added
+    std::vector<uint32_t>  spine;         // nodes with a subtree bigger than UPDATE_GRAIN, in order
+    std::vector<uint32_t>  runs;          // begin, end of every run of small subtrees
+    size_t                 plannedNodes = 0;
+
+    void planUpdate();
+    bool updateNode(size_t i);
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+// Small portability layer for the SSE/AVX2 kernels.
+// x64 always has SSE2, AVX2 is picked at runtime so the exe still runs on older cpus.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SIMD_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#else
+    #define SIMD_X86 0
+#endif
+
+// MSVC lets us use AVX2 intrinsics anywhere, gcc/clang need the function to opt in
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+    #define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define SIMD_TARGET_AVX2
+#endif
+
+inline bool cpuHasAVX2()
+{
+#if SIMD_X86 && defined(_MSC_VER)
+    static const bool has = []()
+    {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx     = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+
+        // make sure the OS saves the ymm registers
+        if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return has;
+#elif SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+#else
+    return false;
+#endif
+}
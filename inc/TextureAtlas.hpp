@@ -0,0 +1,108 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include <GpuResources.hpp>
+
+/*
+    Material textures of a model, packed into a few GL_TEXTURE_2D_ARRAYs so the whole model
+    draws with one set of texture bindings.
+
+    Textures bigger than MAX_ATLAS_ITEM get a layer of their own in a layer array, one
+    array per size (the longer side) so a 2048 map next to a 4096 one doesn't take a 4096
+    layer. The shaders have LAYER_ARRAYS samplers for them: with more sizes than that, the
+    size whose textures cost the least to grow is merged into the next bigger one until
+    they fit. A texture smaller than its layer sits in the corner with its edges stretched
+    over the rest, wastedBytes is what that costs. Everything smaller is packed with stb_rect_pack into the
+    pages of the atlas array, each surrounded by PADDING texels of its own edge so bilinear
+    filtering and the first few mips don't pull in the neighbours. The atlas has no mips
+    below ATLAS_MAX_LEVEL, deeper ones would mix textures anyway.
+
+    A texture ends up as a page (array and layer) and a rect in uv units. The shaders wrap
+    the mesh uv into the rect themselves (fract), see sampleMaterial in model_fs.glsl, so
+    textures keep repeating like they did with GL_REPEAT.
+
+    Everything is stored as RGBA8.
+*/
+
+enum TextureSlot
+{
+    SLOT_DIFFUSE,
+    SLOT_NORMAL,
+    SLOT_SPECULAR,
+    TEXTURE_SLOTS
+};
+
+// what one mesh samples in each slot
+struct MaterialTextures
+{
+    int32_t    texture[TEXTURE_SLOTS] = { -1, -1, -1 };     // into the model's textures
+    glm::vec4  rect[TEXTURE_SLOTS];                          // offset xy, scale zw
+    glm::ivec2 page[TEXTURE_SLOTS];                          // array (TextureArrays::ATLAS, LAYERS + n, -1 none), layer
+};
+
+struct TexturePlacement
+{
+    int     array  = -1;    // TextureArrays::ATLAS, LAYERS + n, -1 nothing to show (failed to load)
+    int     layer  = 0;
+    int     x      = 0;     // texels, without the padding
+    int     y      = 0;
+    int     width  = 0;
+    int     height = 0;
+
+    glm::vec4 rect(int pageSize) const
+    {
+        return glm::vec4(x, y, width, height) / (float)pageSize;
+    }
+};
+
+struct TextureArrays
+{
+    static const int MAX_ATLAS_ITEM  = 1024;
+    static const int MAX_ATLAS_SIZE  = 2048;
+    static const int PADDING         = 8;
+    static const int ATLAS_MAX_LEVEL = 3;       // PADDING texels shrink to 1 at this level
+    static const int LAYER_ARRAYS    = 3;       // textureLayers[] in the shaders
+
+    // the array is the low 2 bits of a page in the material table, see Materials.hpp
+    enum { ATLAS, LAYERS, ARRAYS = LAYERS + LAYER_ARRAYS };
+
+    TextureHandle                 handles[ARRAYS];
+    int                           pageSize[ARRAYS]  = {};
+    int                           pageCount[ARRAYS] = {};
+    std::vector<TexturePlacement> placements;   // one per packed size, in order
+    size_t                        wastedBytes = 0;  // layer texels (and their mips) no texture covers
+
+    TextureArrays() = default;
+    TextureArrays(const TextureArrays&)            = delete;
+    TextureArrays& operator=(const TextureArrays&) = delete;
+    ~TextureArrays() { release(); }
+
+    // decides where every texture goes, sizes of 0 (failed to load) are left out. No GL
+    void pack(const std::vector<glm::ivec2>& sizes);
+
+    // allocates the arrays for what pack() decided, needs a current context
+    void create(const char *asset);
+
+    // copies one texture (RGBA8, width x height as packed) into its place, with its padding
+    void upload(size_t index, const unsigned char *pixels);
+
+    // once everything is uploaded
+    void generateMipmaps();
+
+    // slot of a mesh pointing at texture index
+    void resolve(MaterialTextures& material) const;
+
+    // the atlas on firstUnit, the layer arrays on the units after it. The samplers of the
+    // shaders (textureAtlas, textureLayers[]) are pointed at the units once, see Model::initShaders
+    void bind(int firstUnit) const;
+
+    void release();
+
+private:
+    std::vector<unsigned char> scratch;         // padded copy of the texture being uploaded
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+    Lock-free single producer, single consumer triple buffer.
+
+    Of the three slots the producer owns one (write()), the consumer owns one (read())
+    and the third sits in the middle as the latest published one. publish() swaps the
+    producer's slot into the middle, acquire() swaps the consumer's out of it, both with
+    one atomic exchange, so neither side ever waits for the other. A slot published twice
+    before the consumer got to it is replaced, the consumer always gets the newest one.
+
+    The slots are reused round robin, a producer that fills a slot with assignments to
+    vectors stops allocating once every slot has seen the biggest frame.
+*/
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&)            = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // producer side
+    T&   write() { return slots[writeIndex]; }
+    void publish()
+    {
+        uint32_t previous = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+        if (previous & FRESH)
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        writeIndex = previous & INDEX;
+    }
+
+    // consumer side, false (and read() unchanged) when nothing was published since the last call
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    T&   read() { return slots[readIndex]; }
+
+    // published and not acquired yet, either side may ask
+    bool pending() const { return (middle.load(std::memory_order_acquire) & FRESH) != 0; }
+
+    // slots replaced before the consumer saw them
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    static const uint32_t INDEX = 3;
+    static const uint32_t FRESH = 4;
+
+    T                     slots[3];
+    uint32_t              writeIndex = 0;
+    uint32_t              readIndex  = 1;
+    std::atomic<uint32_t> middle{2};
+    std::atomic<uint64_t> dropped{0};
+};
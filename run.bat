@@ -10,11 +10,16 @@ call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build
 set INCLUDE_DIRS=/I..\external\inc\ /I..\external\inc\IMGUI\ /I..\inc\
 set LIBRARY_DIRS=/LIBPATH:..\external\lib\
 set LIBRARIES=opengl32.lib glfw3.lib glew32.lib assimp-vc143-mt.lib user32.lib gdi32.lib shell32.lib kernel32.lib
-set SRC_FILES=..\main.cpp ..\external\src\glad.c ..\external\src\IMGUI\*.cpp ..\src\Shaders.cpp
-set C_FLAGS=/Zi /EHsc /W4 /MD /nologo /std:c++17 
+set RENDERER_SRC=..\src\Renderer.cpp ..\external\src\glad.c ..\external\src\IMGUI\*.cpp ..\src\Shaders.cpp ..\src\Culling.cpp ..\src\BVH.cpp ..\src\Occlusion.cpp ..\src\SceneGraph.cpp ..\src\Entities.cpp ..\src\Clusters.cpp ..\src\GpuTimer.cpp ..\src\Profiler.cpp ..\src\FrameStats.cpp ..\src\Recording.cpp ..\src\Geometry.cpp ..\src\MemoryTracker.cpp ..\src\GpuResources.cpp ..\src\TextureAtlas.cpp ..\src\Materials.cpp ..\src\Jobs.cpp ..\src\Animation.cpp ..\src\FramePacing.cpp
+set SRC_FILES=..\main.cpp
+set C_FLAGS=/Zi /EHsc /W4 /MD /nologo /std:c++17 /DPROFILER_ENABLED=1 
 set L_FLAGS=/SUBSYSTEM:WINDOWS
 
 pushd .\build
-cl  %C_FLAGS% %INCLUDE_DIRS% %SRC_FILES% /link %LIBRARY_DIRS% %LIBRARIES% %LFLAGS%
+:: the renderer is a static library, the app and the benchmarks link it
+cl  /c %C_FLAGS% %INCLUDE_DIRS% %RENDERER_SRC%
+lib /nologo /OUT:renderer.lib *.obj
+del *.obj
+cl  %C_FLAGS% %INCLUDE_DIRS% %SRC_FILES% /link %LIBRARY_DIRS% renderer.lib %LIBRARIES% %LFLAGS%
 .\main.exe
 popd
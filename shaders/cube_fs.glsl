@@ -66,8 +66,45 @@ struct PointLight {
     vec3 diffuse;
     vec3 specular;
 };  
-#define NR_POINT_LIGHTS 4  
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+
+// Clustered point lights, see Clusters.hpp
+// 4 texels per light: position/radius, diffuse/constant, specular/linear, ambient/quadratic
+uniform samplerBuffer  clusterLights;
+uniform usamplerBuffer clusterGrid;         // offset and count of every cluster
+uniform usamplerBuffer clusterIndices;
+uniform ivec3 clusterDims;
+uniform float clusterScale;                 // slice = log(depth) * clusterScale - clusterBias
+uniform float clusterBias;
+uniform mat4  view;
+
+PointLight fetchPointLight(int i)
+{
+    vec4 t0 = texelFetch(clusterLights, 4 * i);
+    vec4 t1 = texelFetch(clusterLights, 4 * i + 1);
+    vec4 t2 = texelFetch(clusterLights, 4 * i + 2);
+    vec4 t3 = texelFetch(clusterLights, 4 * i + 3);
+
+    PointLight light;
+    light.position  = t0.xyz;
+    light.diffuse   = t1.rgb;
+    light.constant  = t1.a;
+    light.specular  = t2.rgb;
+    light.linear    = t2.a;
+    light.ambient   = t3.rgb;
+    light.quadratic = t3.a;
+    return light;
+}
+
+// offset and count of the lights of the cluster this fragment is in
+uvec2 fetchCluster(vec3 fragPos)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    ivec3 cell  = ivec3(ivec2(gl_FragCoord.xy / iResolution * vec2(clusterDims.xy)),
+                        int(floor(log(max(depth, 1e-4)) * clusterScale - clusterBias)));
+    cell = clamp(cell, ivec3(0), clusterDims - 1);
+
+    return texelFetch(clusterGrid, cell.x + clusterDims.x * (cell.y + clusterDims.y * cell.z)).rg;
+}
 
 vec3 CalcPointLight(PointLight light, vec3 norm, vec3 fragPos, vec3 viewDir)
 {
@@ -161,9 +198,13 @@ void mainImage(out vec4 fragColor, in vec2 fragCoord)
     // Directional lighting
     vec3 result = CalcDirLight(dirLight, norm, viewDir);
 
-    // Point lights
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    // Point lights, only the ones whose range touches this fragment's cluster
+    uvec2 cluster = fetchCluster(FragPos);
+    for(uint i = 0u; i < cluster.y; i++)
+    {
+        int index = int(texelFetch(clusterIndices, int(cluster.x + i)).r);
+        result += CalcPointLight(fetchPointLight(index), norm, FragPos, viewDir);
+    }
 
     // Spot light
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
@@ -13,6 +13,9 @@ out vec3 FragPos;
 
 uniform mat4 transform;
 
+// has to match depth_vs.glsl exactly for the GL_EQUAL test after the pre-pass
+invariant gl_Position;
+
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
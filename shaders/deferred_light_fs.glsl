@@ -0,0 +1,100 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// G-buffer, see Deferred in main.cpp
+uniform sampler2D gAlbedoSpec;     // rgb albedo, a specular intensity
+uniform sampler2D gNormal;         // xyz world normal, w shininess / 256
+uniform sampler2D gDepth;
+
+uniform mat4 invViewProj;
+uniform vec2 iResolution;
+uniform vec3 viewPos;
+
+// 0 directional, 1 point, 2 spot
+uniform int lightType;
+uniform bool fullscreen;
+
+struct Light 
+{
+    vec3 position;
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    float cutoff;
+    float outerCutoff;
+};
+uniform Light light;
+
+void main()
+{
+    vec2  uv    = gl_FragCoord.xy / iResolution;
+    float depth = texture(gDepth, uv).r;
+
+    // nothing was drawn here, leave the background alone. volumes add nothing instead of
+    // discarding, a discarded fragment would not clear its stencil for the next light
+    if(depth == 1.0)
+    {
+        if(fullscreen)
+            discard;
+        FragColor = vec4(0.0);
+        return;
+    }
+
+    vec4  albedoSpec = texture(gAlbedoSpec, uv);
+    vec4  normalShin = texture(gNormal, uv);
+    vec3  albedo     = albedoSpec.rgb;
+    vec3  norm       = normalize(normalShin.xyz);
+    float shininess  = normalShin.w * 256.0;
+
+    // world position from the depth buffer
+    vec4 world   = invViewProj * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec3  lightDir;
+    float attenuation = 1.0;
+    float intensity   = 1.0;
+
+    if(lightType == 0)
+    {
+        lightDir = normalize(-light.direction);
+    }
+    else
+    {
+        float distance = length(light.position - fragPos);
+        lightDir       = normalize(light.position - fragPos);
+        attenuation    = 1.0 / (light.constant + light.linear * distance + 
+                         light.quadratic * (distance * distance)); 
+
+        if(lightType == 2)
+        {
+            float theta   = dot(lightDir, normalize(-light.direction));
+            float epsilon = (light.cutoff - light.outerCutoff);
+            intensity     = smoothstep(0.0, 1.0, (theta - light.outerCutoff) / epsilon);
+        }
+    }
+
+    // ambient
+    vec3 ambient = light.ambient * albedo;
+
+    // diffuse
+    float diff   = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * (diff * albedo);
+
+    // specular
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec      = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular   = light.specular * (spec * albedoSpec.a);
+
+    vec3 result = (ambient + (diffuse + specular) * intensity) * attenuation;
+
+    FragColor = vec4(result, 1.0);
+}
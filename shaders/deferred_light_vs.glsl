@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// directional lights cover the whole screen, point and spot lights draw their volume
+uniform bool fullscreen;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    if(fullscreen)
+    {
+        // one triangle over the whole screen, no vertex buffer needed
+        vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+        gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+    }
+    else
+    {
+        gl_Position = projection * view * model * vec4(aPos, 1.0);
+    }
+}
@@ -0,0 +1,39 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in ivec4 aBoneIDs;
+layout (location = 6) in vec4 aWeights;
+
+// the depth pre-pass only works if this matches the main pass bit for bit, every
+// vertex shader used after a pre-pass declares gl_Position invariant as well
+invariant gl_Position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// same skinning as model_vs.glsl, the other meshes leave skinned false
+uniform samplerBuffer bonePalette;
+uniform bool skinned;
+uniform int  boneOffset;
+
+mat4 skinMatrix()
+{
+    vec4 r0 = vec4(0.0), r1 = vec4(0.0), r2 = vec4(0.0);
+    for(int i = 0; i < 4; i++)
+    {
+        int texel = (boneOffset + aBoneIDs[i]) * 3;
+        r0 += aWeights[i] * texelFetch(bonePalette, texel);
+        r1 += aWeights[i] * texelFetch(bonePalette, texel + 1);
+        r2 += aWeights[i] * texelFetch(bonePalette, texel + 2);
+    }
+    if(aWeights.x + aWeights.y + aWeights.z + aWeights.w == 0.0)
+        return mat4(1.0);
+    return transpose(mat4(r0, r1, r2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+void main()
+{
+    vec4 position = skinned ? skinMatrix() * vec4(aPos, 1.0) : vec4(aPos, 1.0);
+
+    gl_Position = projection * view * model * position;
+}
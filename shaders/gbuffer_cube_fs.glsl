@@ -0,0 +1,28 @@
+#version 330 core
+
+// G-buffer layout, see Deferred in main.cpp
+layout (location = 0) out vec4 gAlbedoSpec;    // rgb albedo, a specular intensity
+layout (location = 1) out vec4 gNormal;        // xyz world normal, w shininess / 256
+
+// Passed from the vertex shader
+in vec2 TexCoords;
+in vec3 ourColor;
+in vec3 Normal;
+in vec3 FragPos;   
+
+struct Material 
+{
+    sampler2D diffuse;
+    sampler2D specular;
+    sampler2D emission;
+    vec3      ambient;
+    float     shininess;
+}; 
+  
+uniform Material material;
+
+void main()
+{
+    gAlbedoSpec = vec4(texture(material.diffuse, TexCoords).rgb, texture(material.specular, TexCoords).r);
+    gNormal     = vec4(normalize(Normal), material.shininess / 256.0);
+}
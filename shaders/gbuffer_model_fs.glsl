@@ -0,0 +1,67 @@
+#version 330 core
+
+// G-buffer layout, see Deferred in main.cpp
+layout (location = 0) out vec4 gAlbedoSpec;    // rgb albedo, a specular intensity
+layout (location = 1) out vec4 gNormal;        // xyz world normal, w shininess / 256
+
+// Passed from the vertex shader
+in vec2 TexCoords;
+in vec3 FragPos;
+in mat3 TBN;
+
+// Material textures, packed into an atlas array and up to 3 layer arrays (one per size
+// of the big ones), see TextureAtlas.hpp
+const int SLOT_DIFFUSE  = 0;
+const int SLOT_NORMAL   = 1;
+const int SLOT_SPECULAR = 2;
+
+// what a slot without a texture reads: white, flat normal, no specular
+const vec4 slotDefaults[3] = vec4[3](vec4(1.0), vec4(0.5, 0.5, 1.0, 1.0), vec4(0.0));
+
+uniform sampler2DArray textureAtlas;
+uniform sampler2DArray textureLayers[3];    // TextureArrays::LAYER_ARRAYS, one per size
+
+// Material table of the model, see Materials.hpp
+struct MaterialEntry
+{
+    vec4  rects[3];                         // offset xy, scale zw of every slot in its page
+    ivec4 pages;                            // layer * 4 + array (0 atlas, 1-3 layers) of every slot, w flags
+    vec4  params;                           // x shininess
+};
+
+layout(std140) uniform Materials
+{
+    MaterialEntry materials[192];           // MaterialTable::MAX_MATERIALS
+};
+uniform int materialIndex;
+
+// wraps uv into the slot's rect, the gradients of the unwrapped uv keep the mip selection
+// from jumping at the seams fract() makes
+vec4 sampleMaterial(int slot, vec2 uv)
+{
+    if((materials[materialIndex].pages.w & (1 << slot)) == 0)
+        return slotDefaults[slot];
+
+    int  page  = materials[materialIndex].pages[slot];
+    vec4 rect  = materials[materialIndex].rects[slot];
+    vec3 coord = vec3(rect.xy + fract(uv) * rect.zw, float(page >> 2));
+    vec2 dx    = dFdx(uv) * rect.zw;
+    vec2 dy    = dFdy(uv) * rect.zw;
+
+    // GLSL 3.30 only indexes sampler arrays with constants
+    switch(page & 3)
+    {
+        case 0:  return textureGrad(textureAtlas,     coord, dx, dy);
+        case 1:  return textureGrad(textureLayers[0], coord, dx, dy);
+        case 2:  return textureGrad(textureLayers[1], coord, dx, dy);
+        default: return textureGrad(textureLayers[2], coord, dx, dy);
+    }
+}
+
+void main()
+{
+    vec3 tangentNormal = sampleMaterial(SLOT_NORMAL, TexCoords).xyz * 2.0 - 1.0;
+
+    gAlbedoSpec = vec4(sampleMaterial(SLOT_DIFFUSE, TexCoords).rgb, sampleMaterial(SLOT_SPECULAR, TexCoords).r);
+    gNormal     = vec4(normalize(TBN * tangentNormal), materials[materialIndex].params.x / 256.0);
+}
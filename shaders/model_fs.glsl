@@ -12,16 +12,59 @@ uniform vec2 iResolution;
 
 uniform vec3 viewPos;
 
-struct Material 
+// Material textures, packed into an atlas array and up to 3 layer arrays (one per size
+// of the big ones), see TextureAtlas.hpp
+const int SLOT_DIFFUSE  = 0;
+const int SLOT_NORMAL   = 1;
+const int SLOT_SPECULAR = 2;
+
+// what a slot without a texture reads: white, flat normal, no specular
+const vec4 slotDefaults[3] = vec4[3](vec4(1.0), vec4(0.5, 0.5, 1.0, 1.0), vec4(0.0));
+
+uniform sampler2DArray textureAtlas;
+uniform sampler2DArray textureLayers[3];    // TextureArrays::LAYER_ARRAYS, one per size
+
+// Material table of the model, see Materials.hpp
+struct MaterialEntry
 {
-    float shininess;
-    vec3  ambient;
-}; 
-  
-uniform Material material;
-uniform sampler2D texture_diffuse1;
-uniform sampler2D texture_normal1;
-uniform sampler2D texture_specular1;
+    vec4  rects[3];                         // offset xy, scale zw of every slot in its page
+    ivec4 pages;                            // layer * 4 + array (0 atlas, 1-3 layers) of every slot, w flags
+    vec4  params;                           // x shininess
+};
+
+layout(std140) uniform Materials
+{
+    MaterialEntry materials[192];           // MaterialTable::MAX_MATERIALS
+};
+uniform int materialIndex;
+
+// wraps uv into the slot's rect, the gradients of the unwrapped uv keep the mip selection
+// from jumping at the seams fract() makes
+vec4 sampleMaterial(int slot, vec2 uv)
+{
+    if((materials[materialIndex].pages.w & (1 << slot)) == 0)
+        return slotDefaults[slot];
+
+    int  page  = materials[materialIndex].pages[slot];
+    vec4 rect  = materials[materialIndex].rects[slot];
+    vec3 coord = vec3(rect.xy + fract(uv) * rect.zw, float(page >> 2));
+    vec2 dx    = dFdx(uv) * rect.zw;
+    vec2 dy    = dFdy(uv) * rect.zw;
+
+    // GLSL 3.30 only indexes sampler arrays with constants
+    switch(page & 3)
+    {
+        case 0:  return textureGrad(textureAtlas,     coord, dx, dy);
+        case 1:  return textureGrad(textureLayers[0], coord, dx, dy);
+        case 2:  return textureGrad(textureLayers[1], coord, dx, dy);
+        default: return textureGrad(textureLayers[2], coord, dx, dy);
+    }
+}
+
+// sampled once at the top of mainImage, every light reads them
+vec3  albedo;
+vec3  specularColor;
+float shininess;
 
 struct DirLight {
     vec3 direction;
@@ -34,7 +77,7 @@ uniform DirLight dirLight;
 
 vec3 calcNormalFromMap()
 {
-    vec3 tangentNormal = texture(texture_normal1, TexCoords).xyz * 2.0 - 1.0;
+    vec3 tangentNormal = sampleMaterial(SLOT_NORMAL, TexCoords).xyz * 2.0 - 1.0;
     
     return normalize(TBN * tangentNormal);
 }
@@ -42,17 +85,17 @@ vec3 calcNormalFromMap()
 vec3 CalcDirLight(DirLight light, vec3 norm, vec3 viewDir)
 {
     // ambient
-    vec3 ambient = light.ambient * vec3(texture(texture_diffuse1, TexCoords));
+    vec3 ambient = light.ambient * albedo;
 
     // diffuse
     vec3 lightDir = normalize(-light.direction); 
     float diff    = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse  = light.diffuse * (diff * vec3(texture(texture_diffuse1, TexCoords)));
+    vec3 diffuse  = light.diffuse * (diff * albedo);
 
     // specular
     vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * vec3(texture(texture_specular1, TexCoords)));  
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * (spec * specularColor);  
     
     vec3 result = (ambient + diffuse + specular);
 
@@ -70,8 +113,45 @@ struct PointLight {
     vec3 diffuse;
     vec3 specular;
 };  
-#define NR_POINT_LIGHTS 4  
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+
+// Clustered point lights, see Clusters.hpp
+// 4 texels per light: position/radius, diffuse/constant, specular/linear, ambient/quadratic
+uniform samplerBuffer  clusterLights;
+uniform usamplerBuffer clusterGrid;         // offset and count of every cluster
+uniform usamplerBuffer clusterIndices;
+uniform ivec3 clusterDims;
+uniform float clusterScale;                 // slice = log(depth) * clusterScale - clusterBias
+uniform float clusterBias;
+uniform mat4  view;
+
+PointLight fetchPointLight(int i)
+{
+    vec4 t0 = texelFetch(clusterLights, 4 * i);
+    vec4 t1 = texelFetch(clusterLights, 4 * i + 1);
+    vec4 t2 = texelFetch(clusterLights, 4 * i + 2);
+    vec4 t3 = texelFetch(clusterLights, 4 * i + 3);
+
+    PointLight light;
+    light.position  = t0.xyz;
+    light.diffuse   = t1.rgb;
+    light.constant  = t1.a;
+    light.specular  = t2.rgb;
+    light.linear    = t2.a;
+    light.ambient   = t3.rgb;
+    light.quadratic = t3.a;
+    return light;
+}
+
+// offset and count of the lights of the cluster this fragment is in
+uvec2 fetchCluster(vec3 fragPos)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    ivec3 cell  = ivec3(ivec2(gl_FragCoord.xy / iResolution * vec2(clusterDims.xy)),
+                        int(floor(log(max(depth, 1e-4)) * clusterScale - clusterBias)));
+    cell = clamp(cell, ivec3(0), clusterDims - 1);
+
+    return texelFetch(clusterGrid, cell.x + clusterDims.x * (cell.y + clusterDims.y * cell.z)).rg;
+}
 
 vec3 CalcPointLight(PointLight light, vec3 norm, vec3 fragPos, vec3 viewDir)
 {
@@ -80,19 +160,19 @@ vec3 CalcPointLight(PointLight light, vec3 norm, vec3 fragPos, vec3 viewDir)
                         light.quadratic * (distance * distance)); 
 
     // ambient
-    vec3 ambient = light.ambient * vec3(texture(texture_diffuse1, TexCoords));
+    vec3 ambient = light.ambient * albedo;
     ambient  *= attenuation; 
 
     // diffuse
     vec3 lightDir = normalize(light.position - fragPos); 
     float diff    = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse  = light.diffuse * (diff * vec3(texture(texture_diffuse1, TexCoords)));
+    vec3 diffuse  = light.diffuse * (diff * albedo);
     diffuse  *= attenuation;
 
     // specular
     vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * vec3(texture(texture_specular1, TexCoords)));  
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * (spec * specularColor);  
     specular *= attenuation;   
 
     vec3 result = (ambient + diffuse + specular);
@@ -125,19 +205,19 @@ vec3 CalcSpotLight(SpotLight light, vec3 norm, vec3 fragPos, vec3 viewDir)
                         light.quadratic * (distance * distance)); 
 
     // ambient
-    vec3 ambient = light.ambient * vec3(texture(texture_diffuse1, TexCoords));
+    vec3 ambient = light.ambient * albedo;
     ambient  *= attenuation; 
 
     // diffuse
     vec3 lightDir = normalize(light.position - fragPos); 
     float diff    = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse  = light.diffuse * (diff * vec3(texture(texture_diffuse1, TexCoords)));
+    vec3 diffuse  = light.diffuse * (diff * albedo);
     diffuse  *= attenuation;
 
     // specular
     vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * vec3(texture(texture_specular1, TexCoords)));  
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * (spec * specularColor);  
     specular *= attenuation;   
     
     float theta = dot(lightDir, normalize(-light.direction));
@@ -154,15 +234,23 @@ vec3 CalcSpotLight(SpotLight light, vec3 norm, vec3 fragPos, vec3 viewDir)
 
 void mainImage(out vec4 fragColor, in vec2 fragCoord)
 {
+    albedo        = sampleMaterial(SLOT_DIFFUSE, TexCoords).rgb;
+    specularColor = sampleMaterial(SLOT_SPECULAR, TexCoords).rgb;
+    shininess     = materials[materialIndex].params.x;
+
     vec3 norm = calcNormalFromMap();
     vec3 viewDir = normalize(viewPos - FragPos);
 
     // Directional lighting
     vec3 result = CalcDirLight(dirLight, norm, viewDir);
 
-    // Point lights
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    // Point lights, only the ones whose range touches this fragment's cluster
+    uvec2 cluster = fetchCluster(FragPos);
+    for(uint i = 0u; i < cluster.y; i++)
+    {
+        int index = int(texelFetch(clusterIndices, int(cluster.x + i)).r);
+        result += CalcPointLight(fetchPointLight(index), norm, FragPos, viewDir);
+    }
 
     // Spot light
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
@@ -4,23 +4,53 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
+layout (location = 5) in ivec4 aBoneIDs;
+layout (location = 6) in vec4 aWeights;
 
 out vec2 TexCoords;
 out vec3 FragPos;
 out mat3 TBN; 
 
+// has to match depth_vs.glsl exactly for the GL_EQUAL test after the pre-pass
+invariant gl_Position;
+
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// bone palettes of every animated instance, 3 texels (the rows of an affine matrix) per bone
+uniform samplerBuffer bonePalette;
+uniform bool skinned;
+uniform int  boneOffset;    // first bone of the instance being drawn
+
+mat4 skinMatrix()
+{
+    vec4 r0 = vec4(0.0), r1 = vec4(0.0), r2 = vec4(0.0);
+    for(int i = 0; i < 4; i++)
+    {
+        int texel = (boneOffset + aBoneIDs[i]) * 3;
+        r0 += aWeights[i] * texelFetch(bonePalette, texel);
+        r1 += aWeights[i] * texelFetch(bonePalette, texel + 1);
+        r2 += aWeights[i] * texelFetch(bonePalette, texel + 2);
+    }
+    // vertices no bone moves stay where they are
+    if(aWeights.x + aWeights.y + aWeights.z + aWeights.w == 0.0)
+        return mat4(1.0);
+    return transpose(mat4(r0, r1, r2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    mat4 skin     = skinned ? skinMatrix() : mat4(1.0);
+    vec4 position = skinned ? skin * vec4(aPos, 1.0) : vec4(aPos, 1.0);
+
+    gl_Position = projection * view * model * position;
     TexCoords = aTexCoords;    
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(model * position);
     // Calculate TBN matrix for normal mapping
-    vec3 T = normalize(vec3(model * vec4(aTangent, 0.0)));
-    vec3 B = normalize(vec3(model * vec4(aBitangent, 0.0)));
-    vec3 N = normalize(vec3(model * vec4(aNormal, 0.0)));
+    mat4 skinnedModel = model * skin;
+    vec3 T = normalize(vec3(skinnedModel * vec4(aTangent, 0.0)));
+    vec3 B = normalize(vec3(skinnedModel * vec4(aBitangent, 0.0)));
+    vec3 N = normalize(vec3(skinnedModel * vec4(aNormal, 0.0)));
     TBN = mat3(T, B, N);
 }
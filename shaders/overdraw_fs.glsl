@@ -0,0 +1,9 @@
+#version 330 core
+
+// every fragment that gets shaded adds one, see OverdrawView in main.cpp
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0, 0.0, 0.0, 0.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// fragments shaded per pixel
+uniform sampler2D counter;
+uniform float     maxCount;
+
+vec3 heat(float t)
+{
+    // blue -> green -> yellow -> red
+    return clamp(vec3(1.5 * t - 0.25, 2.0 - abs(3.0 * t - 1.5) * 1.5, 1.0 - 2.0 * t), 0.0, 1.0);
+}
+
+void main()
+{
+    float count = texelFetch(counter, ivec2(gl_FragCoord.xy), 0).r;
+    if(count < 0.5)
+        discard;
+
+    // 1 fragment is the cold end, maxCount and above the hot one
+    float t = clamp((count - 1.0) / max(maxCount - 1.0, 1.0), 0.0, 1.0);
+    FragColor = vec4(heat(t), 1.0);
+}
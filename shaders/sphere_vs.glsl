@@ -11,6 +11,9 @@ out vec3 ourColor;
 out vec3 Normal;
 out vec3 FragPos;
 
+// has to match depth_vs.glsl exactly for the GL_EQUAL test after the pre-pass
+invariant gl_Position;
+
 // Uniforms for transformation matrices
 uniform mat4 model;
 uniform mat4 view;
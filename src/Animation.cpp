@@ -0,0 +1,1322 @@
+#include <Animation.hpp>
+#include <Geometry.hpp>
+#include <Simd.hpp>
+#include <Parallel.hpp>
+
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+#include <chrono>
+#include <algorithm>
+
+namespace
+{
+    BoneMatrix toRows(const glm::mat4& m)
+    {
+        BoneMatrix r;
+        for (int i = 0; i < 3; i++)
+            r.rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        return r;
+    }
+
+    glm::mat4 toMat4(const BoneMatrix& r)
+    {
+        glm::mat4 m(1.0f);
+        for (int i = 0; i < 3; i++)
+        {
+            m[0][i] = r.rows[i].x;
+            m[1][i] = r.rows[i].y;
+            m[2][i] = r.rows[i].z;
+            m[3][i] = r.rows[i].w;
+        }
+        return m;
+    }
+
+    // the identity in every channel, what the padding joints hold
+    const float IDENTITY[POSE_CHANNELS] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+    void fillIdentity(float *pose, uint32_t stride, uint32_t begin)
+    {
+        for (int c = 0; c < POSE_CHANNELS; c++)
+            for (uint32_t j = begin; j < stride; j++)
+                pose[c * stride + j] = IDENTITY[c];
+    }
+
+    // per thread, the jobs of evaluatePoses reuse them
+    thread_local std::vector<float>      scratchPose;
+    thread_local std::vector<BoneMatrix> scratchJoints;
+    thread_local std::vector<float>      scratchKeys;       // the two keys around the time, for sampleClip
+    thread_local std::vector<float>      scratchWeights;
+    thread_local std::vector<int32_t>    scratchPacked;
+}
+
+/*---------------------------------------- Skeleton ----------------------------------------*/
+
+int32_t Skeleton::findJoint(const char *name) const
+{
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        if (names[i] == name)
+            return (int32_t)i;
+    }
+    return -1;
+}
+
+int32_t Skeleton::findBone(const char *name) const
+{
+    for (size_t i = 0; i < boneNames.size(); i++)
+    {
+        if (boneNames[i] == name)
+            return (int32_t)i;
+    }
+    return -1;
+}
+
+int32_t Skeleton::addJoint(int32_t parentJoint, const std::string& name, const glm::vec3& t, const glm::vec4& q, const glm::vec3& s)
+{
+    uint32_t oldStride = stride();
+    int32_t  joint     = (int32_t)parent.size();
+    parent.push_back(parentJoint);
+    names.push_back(name);
+
+    // the streams are interleaved by stride, a new multiple of 4 moves all of them
+    uint32_t newStride = stride();
+    if (newStride != oldStride)
+    {
+        std::vector<float> moved((size_t)POSE_CHANNELS * newStride);
+        for (int c = 0; c < POSE_CHANNELS; c++)
+            std::copy(bindPose.begin() + c * oldStride, bindPose.begin() + (c + 1) * oldStride, moved.begin() + c * newStride);
+        fillIdentity(moved.data(), newStride, oldStride);
+        bindPose.swap(moved);
+    }
+
+    float values[POSE_CHANNELS] = { t.x, t.y, t.z, q.x, q.y, q.z, q.w, s.x, s.y, s.z };
+    for (int c = 0; c < POSE_CHANNELS; c++)
+        bindPose[c * newStride + joint] = values[c];
+
+    return joint;
+}
+
+int32_t Skeleton::addBone(int32_t joint, const std::string& name, const glm::mat4& offset)
+{
+    boneJoint.push_back(joint);
+    boneNames.push_back(name);
+    inverseBind.push_back(toRows(offset));
+    return (int32_t)boneJoint.size() - 1;
+}
+
+/*------------------------------------------ Clip ------------------------------------------*/
+
+void AnimationClip::resize(const Skeleton& skeleton, float seconds, float rate)
+{
+    duration   = std::max(seconds, 0.0f);
+    frameCount = std::max(2u, (uint32_t)std::ceil(duration * rate) + 1);
+    // the last frame lands exactly on the end, a looping clip wraps without a seam
+    sampleRate = duration > 0.0f ? (float)(frameCount - 1) / duration : rate;
+    stride     = skeleton.stride();
+    samples.assign((size_t)frameCount * POSE_CHANNELS * stride, 0.0f);
+}
+
+void AnimationClip::alignRotations()
+{
+    for (uint32_t f = 1; f < frameCount; f++)
+    {
+        const float *prev = frame(f - 1);
+        float       *cur  = frame(f);
+        for (uint32_t j = 0; j < stride; j++)
+        {
+            float d = 0.0f;
+            for (int c = POSE_QX; c <= POSE_QW; c++)
+                d += prev[c * stride + j] * cur[c * stride + j];
+            if (d < 0.0f)
+            {
+                for (int c = POSE_QX; c <= POSE_QW; c++)
+                    cur[c * stride + j] = -cur[c * stride + j];
+            }
+        }
+    }
+}
+
+#if !SIMD_X86
+
+/*----------------------------------------- scalar -----------------------------------------*/
+
+static void normalizeRotationsScalar(float *out, uint32_t n)
+{
+    float *qx = out + POSE_QX * n, *qy = out + POSE_QY * n, *qz = out + POSE_QZ * n, *qw = out + POSE_QW * n;
+    for (uint32_t j = 0; j < n; j++)
+    {
+        float inv = 1.0f / std::sqrt(qx[j] * qx[j] + qy[j] * qy[j] + qz[j] * qz[j] + qw[j] * qw[j]);
+        qx[j] *= inv;
+        qy[j] *= inv;
+        qz[j] *= inv;
+        qw[j] *= inv;
+    }
+}
+
+static void blendPosesScalar(const float *a, const float *b, float t, uint32_t n, float *out)
+{
+    for (uint32_t i = 0; i < POSE_CHANNELS * n; i++)
+        out[i] = a[i] + (b[i] - a[i]) * t;
+    normalizeRotationsScalar(out, n);
+}
+
+// local transforms of the joints as matrix rows, T * R * S
+static void localMatricesScalar(const float *pose, uint32_t n, BoneMatrix *out)
+{
+    for (uint32_t j = 0; j < n; j++)
+    {
+        float x = pose[POSE_QX * n + j], y = pose[POSE_QY * n + j], z = pose[POSE_QZ * n + j], w = pose[POSE_QW * n + j];
+        float sx = pose[POSE_SX * n + j], sy = pose[POSE_SY * n + j], sz = pose[POSE_SZ * n + j];
+
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+
+        out[j].rows[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * sx, 2.0f * (xy - wz) * sy, 2.0f * (xz + wy) * sz, pose[POSE_TX * n + j]);
+        out[j].rows[1] = glm::vec4(2.0f * (xy + wz) * sx, (1.0f - 2.0f * (xx + zz)) * sy, 2.0f * (yz - wx) * sz, pose[POSE_TY * n + j]);
+        out[j].rows[2] = glm::vec4(2.0f * (xz - wy) * sx, 2.0f * (yz + wx) * sy, (1.0f - 2.0f * (xx + yy)) * sz, pose[POSE_TZ * n + j]);
+    }
+}
+
+static void mulAffineScalar(const BoneMatrix& a, const BoneMatrix& b, BoneMatrix& out)
+{
+    BoneMatrix r;
+    for (int i = 0; i < 3; i++)
+    {
+        r.rows[i] = a.rows[i].x * b.rows[0] + a.rows[i].y * b.rows[1] + a.rows[i].z * b.rows[2];
+        r.rows[i].w += a.rows[i].w;
+    }
+    out = r;
+}
+
+#else
+
+/*------------------------------------- SSE (4 wide) -------------------------------------*/
+
+// nlerp, the rotations are in one hemisphere already
+static void normalizeRotationsSSE(float *out, uint32_t n)
+{
+    float *qx = out + POSE_QX * n, *qy = out + POSE_QY * n, *qz = out + POSE_QZ * n, *qw = out + POSE_QW * n;
+    __m128 one = _mm_set1_ps(1.0f);
+    for (uint32_t j = 0; j < n; j += 4)
+    {
+        __m128 x = _mm_loadu_ps(qx + j), y = _mm_loadu_ps(qy + j), z = _mm_loadu_ps(qz + j), w = _mm_loadu_ps(qw + j);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+        __m128 inv  = _mm_div_ps(one, _mm_sqrt_ps(len2));
+        _mm_storeu_ps(qx + j, _mm_mul_ps(x, inv));
+        _mm_storeu_ps(qy + j, _mm_mul_ps(y, inv));
+        _mm_storeu_ps(qz + j, _mm_mul_ps(z, inv));
+        _mm_storeu_ps(qw + j, _mm_mul_ps(w, inv));
+    }
+}
+
+static void blendPosesSSE(const float *a, const float *b, float t, uint32_t n, float *out)
+{
+    __m128 vt = _mm_set1_ps(t);
+    for (uint32_t i = 0; i < POSE_CHANNELS * n; i += 4)
+    {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vt)));
+    }
+    normalizeRotationsSSE(out, n);
+}
+
+static void localMatricesSSE(const float *pose, uint32_t n, BoneMatrix *out)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    for (uint32_t j = 0; j < n; j += 4)
+    {
+        __m128 x  = _mm_loadu_ps(pose + POSE_QX * n + j);
+        __m128 y  = _mm_loadu_ps(pose + POSE_QY * n + j);
+        __m128 z  = _mm_loadu_ps(pose + POSE_QZ * n + j);
+        __m128 w  = _mm_loadu_ps(pose + POSE_QW * n + j);
+        __m128 sx = _mm_loadu_ps(pose + POSE_SX * n + j);
+        __m128 sy = _mm_loadu_ps(pose + POSE_SY * n + j);
+        __m128 sz = _mm_loadu_ps(pose + POSE_SZ * n + j);
+
+        __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+        __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+        // one register per matrix entry, 4 joints each
+        __m128 r0[4] = { _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx), _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+                         _mm_mul_ps(_mm_add_ps(xz, wy), sz), _mm_loadu_ps(pose + POSE_TX * n + j) };
+        __m128 r1[4] = { _mm_mul_ps(_mm_add_ps(xy, wz), sx), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+                         _mm_mul_ps(_mm_sub_ps(yz, wx), sz), _mm_loadu_ps(pose + POSE_TY * n + j) };
+        __m128 r2[4] = { _mm_mul_ps(_mm_sub_ps(xz, wy), sx), _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz), _mm_loadu_ps(pose + POSE_TZ * n + j) };
+
+        // transposed, register k is then the row of joint j + k
+        _MM_TRANSPOSE4_PS(r0[0], r0[1], r0[2], r0[3]);
+        _MM_TRANSPOSE4_PS(r1[0], r1[1], r1[2], r1[3]);
+        _MM_TRANSPOSE4_PS(r2[0], r2[1], r2[2], r2[3]);
+
+        for (int k = 0; k < 4; k++)
+        {
+            _mm_storeu_ps(&out[j + k].rows[0].x, r0[k]);
+            _mm_storeu_ps(&out[j + k].rows[1].x, r1[k]);
+            _mm_storeu_ps(&out[j + k].rows[2].x, r2[k]);
+        }
+    }
+}
+
+static inline void mulAffineSSE(const BoneMatrix& a, const BoneMatrix& b, BoneMatrix& out)
+{
+    __m128 b0 = _mm_loadu_ps(&b.rows[0].x);
+    __m128 b1 = _mm_loadu_ps(&b.rows[1].x);
+    __m128 b2 = _mm_loadu_ps(&b.rows[2].x);
+    // the implicit last row, (0, 0, 0, 1)
+    __m128 b3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    __m128 r[3];
+    for (int i = 0; i < 3; i++)
+    {
+        __m128 row = _mm_loadu_ps(&a.rows[i].x);
+        r[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0),
+                                     _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1)),
+                          _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2),
+                                     _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3)));
+    }
+    // a and out may be the same
+    for (int i = 0; i < 3; i++)
+        _mm_storeu_ps(&out.rows[i].x, r[i]);
+}
+
+#endif // SIMD_X86
+
+void blendPoses(const float *a, const float *b, float t, uint32_t n, float *out)
+{
+#if SIMD_X86
+    blendPosesSSE(a, b, t, n, out);
+#else
+    blendPosesScalar(a, b, t, n, out);
+#endif
+}
+
+static void localMatrices(const float *pose, uint32_t n, BoneMatrix *out)
+{
+#if SIMD_X86
+    localMatricesSSE(pose, n, out);
+#else
+    localMatricesScalar(pose, n, out);
+#endif
+}
+
+static inline void mulAffine(const BoneMatrix& a, const BoneMatrix& b, BoneMatrix& out)
+{
+#if SIMD_X86
+    mulAffineSSE(a, b, out);
+#else
+    mulAffineScalar(a, b, out);
+#endif
+}
+
+const char *animationBackendName()
+{
+#if SIMD_X86
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
+
+/*------------------------------------------ poses -----------------------------------------*/
+
+void poseToPalette(const Skeleton& skeleton, const float *pose, BoneMatrix *palette)
+{
+    uint32_t n = skeleton.stride();
+    scratchJoints.resize(n);
+    BoneMatrix *joints = scratchJoints.data();
+
+    localMatrices(pose, n, joints);
+
+    // parents come first, joints[] turns from local into model space in place
+    const int32_t *parent = skeleton.parent.data();
+    for (uint32_t j = 0; j < skeleton.jointCount(); j++)
+    {
+        if (parent[j] >= 0)
+            mulAffine(joints[parent[j]], joints[j], joints[j]);
+    }
+
+    for (uint32_t b = 0; b < skeleton.boneCount(); b++)
+        mulAffine(joints[skeleton.boneJoint[b]], skeleton.inverseBind[b], palette[b]);
+}
+
+void evaluatePose(const AnimationInstance& instance, BoneMatrix *palette)
+{
+    const Skeleton&      skeleton = *instance.skeleton;
+    const AnimationClip *clip     = instance.clip;
+
+    if (instance.compressed && instance.compressed->stride == skeleton.stride())
+    {
+        scratchPose.resize((size_t)POSE_CHANNELS * skeleton.stride());
+        sampleClip(*instance.compressed, instance.time, scratchPose.data());
+        poseToPalette(skeleton, scratchPose.data(), palette);
+        return;
+    }
+
+    if (!clip || clip->stride != skeleton.stride())
+    {
+        poseToPalette(skeleton, skeleton.bindPose.data(), palette);
+        return;
+    }
+
+    float    position = std::max(instance.time, 0.0f) * clip->sampleRate;
+    uint32_t f        = std::min((uint32_t)position, clip->frameCount - 2);
+    float    t        = std::min(position - (float)f, 1.0f);
+
+    scratchPose.resize((size_t)POSE_CHANNELS * clip->stride);
+    blendPoses(clip->frame(f), clip->frame(f + 1), t, clip->stride, scratchPose.data());
+    poseToPalette(skeleton, scratchPose.data(), palette);
+}
+
+// a character is a couple of microseconds, a job needs a few of them to be worth it
+static const size_t POSE_GRAIN = 4;
+
+void evaluatePoses(const AnimationInstance *instances, size_t count, BoneMatrix *palette)
+{
+    parallelFor(count, POSE_GRAIN, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+            evaluatePose(instances[i], palette + instances[i].paletteOffset);
+    });
+}
+
+/*----------------------------------------- Animator ----------------------------------------*/
+
+uint32_t Animator::add(const Skeleton *skeleton, const AnimationClip *clip)
+{
+    AnimationInstance instance;
+    instance.skeleton      = skeleton;
+    instance.clip          = clip;
+    instance.paletteOffset = (uint32_t)palette.size();
+
+    palette.resize(palette.size() + skeleton->boneCount());
+    instances.push_back(instance);
+    return (uint32_t)instances.size() - 1;
+}
+
+uint32_t Animator::add(const Skeleton *skeleton, const CompressedClip *clip)
+{
+    uint32_t index = add(skeleton, (const AnimationClip *)nullptr);
+    instances[index].compressed = clip;
+    return index;
+}
+
+void Animator::advance(float deltaTime)
+{
+    for (AnimationInstance& instance : instances)
+    {
+        float duration = instance.duration();
+        if (duration <= 0.0f)
+        {
+            instance.time = 0.0f;
+            continue;
+        }
+
+        instance.time += deltaTime * instance.speed;
+        if (instance.loop)
+        {
+            instance.time = std::fmod(instance.time, duration);
+            if (instance.time < 0.0f)
+                instance.time += duration;
+        }
+        else
+        {
+            instance.time = std::min(std::max(instance.time, 0.0f), duration);
+        }
+    }
+}
+
+bool Animator::playing() const
+{
+    for (const AnimationInstance& instance : instances)
+    {
+        float duration = instance.duration();
+        if (duration <= 0.0f || instance.speed == 0.0f)
+            continue;
+
+        // a clip that doesn't loop stops at the end it is playing towards
+        if (instance.loop || (instance.speed > 0.0f ? instance.time < duration : instance.time > 0.0f))
+            return true;
+    }
+    return false;
+}
+
+void Animator::evaluate()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    evaluatePoses(instances.data(), instances.size(), palette.data());
+
+    bonesEvaluated = (uint32_t)palette.size();
+    evaluateTime   = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+/*------------------------------------------ import ----------------------------------------*/
+
+static glm::mat4 toGlm(const aiMatrix4x4& m)
+{
+    // aiMatrix4x4 is row major
+    return glm::mat4(m.a1, m.b1, m.c1, m.d1,
+                     m.a2, m.b2, m.c2, m.d2,
+                     m.a3, m.b3, m.c3, m.d3,
+                     m.a4, m.b4, m.c4, m.d4);
+}
+
+// true if the subtree of node holds a bone, those and everything above them become joints
+static bool markJoints(const aiNode *node, const std::vector<std::string>& bones, std::vector<const aiNode*>& needed)
+{
+    bool any = std::find(bones.begin(), bones.end(), node->mName.C_Str()) != bones.end();
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        any = markJoints(node->mChildren[i], bones, needed) || any;
+
+    if (any)
+        needed.push_back(node);
+    return any;
+}
+
+static void addJoints(const aiNode *node, int32_t parent, const std::vector<const aiNode*>& needed, Skeleton& skeleton)
+{
+    if (std::find(needed.begin(), needed.end(), node) == needed.end())
+        return;
+
+    aiVector3D   s, t;
+    aiQuaternion q;
+    node->mTransformation.Decompose(s, q, t);
+
+    int32_t joint = skeleton.addJoint(parent, node->mName.C_Str(), glm::vec3(t.x, t.y, t.z),
+                                      glm::vec4(q.x, q.y, q.z, q.w), glm::vec3(s.x, s.y, s.z));
+
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        addJoints(node->mChildren[i], joint, needed, skeleton);
+}
+
+bool importSkeleton(const aiScene *scene, Skeleton& skeleton)
+{
+    std::vector<std::string> bones;
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+    {
+        const aiMesh *mesh = scene->mMeshes[m];
+        for (unsigned int b = 0; b < mesh->mNumBones; b++)
+        {
+            const char *name = mesh->mBones[b]->mName.C_Str();
+            if (std::find(bones.begin(), bones.end(), name) == bones.end())
+                bones.push_back(name);
+        }
+    }
+    if (bones.empty())
+        return false;
+
+    std::vector<const aiNode*> needed;
+    markJoints(scene->mRootNode, bones, needed);
+    addJoints(scene->mRootNode, -1, needed, skeleton);
+
+    // the same bone can be in several meshes, with the same offset
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+    {
+        const aiMesh *mesh = scene->mMeshes[m];
+        for (unsigned int b = 0; b < mesh->mNumBones; b++)
+        {
+            const aiBone *bone = mesh->mBones[b];
+            if (skeleton.findBone(bone->mName.C_Str()) >= 0)
+                continue;
+
+            int32_t joint = skeleton.findJoint(bone->mName.C_Str());
+            if (joint < 0)
+            {
+                std::cerr << "ERROR::ANIMATION::BONE_WITHOUT_NODE " << bone->mName.C_Str() << std::endl;
+                joint = 0;
+            }
+            skeleton.addBone(joint, bone->mName.C_Str(), toGlm(bone->mOffsetMatrix));
+        }
+    }
+    return true;
+}
+
+// value of a key track at a time in ticks, cursor remembers where the last lookup ended
+template<typename Key, typename Fn>
+static auto sampleKeys(const Key *keys, unsigned int count, double time, unsigned int& cursor, Fn&& interpolate)
+    -> decltype(keys[0].mValue)
+{
+    if (count == 1 || time <= keys[0].mTime)
+        return keys[0].mValue;
+    if (time >= keys[count - 1].mTime)
+        return keys[count - 1].mValue;
+
+    while (cursor + 1 < count && keys[cursor + 1].mTime <= time)
+        cursor++;
+
+    const Key& a = keys[cursor];
+    const Key& b = keys[cursor + 1];
+    float t = (float)((time - a.mTime) / (b.mTime - a.mTime));
+    return interpolate(a.mValue, b.mValue, t);
+}
+
+void importClip(const aiAnimation *animation, const Skeleton& skeleton, AnimationClip& clip, float sampleRate)
+{
+    // files that don't say usually mean 25
+    double ticksPerSecond = animation->mTicksPerSecond != 0.0 ? animation->mTicksPerSecond : 25.0;
+
+    clip.name = animation->mName.C_Str();
+    clip.resize(skeleton, (float)(animation->mDuration / ticksPerSecond), sampleRate);
+
+    clip.sourceBytes = 0;
+    for (unsigned int c = 0; c < animation->mNumChannels; c++)
+    {
+        const aiNodeAnim *channel = animation->mChannels[c];
+        clip.sourceBytes += channel->mNumPositionKeys * sizeof(aiVectorKey) + channel->mNumRotationKeys * sizeof(aiQuatKey) +
+                            channel->mNumScalingKeys * sizeof(aiVectorKey);
+    }
+
+    uint32_t n = clip.stride;
+    for (uint32_t f = 0; f < clip.frameCount; f++)
+        std::memcpy(clip.frame(f), skeleton.bindPose.data(), sizeof(float) * POSE_CHANNELS * n);
+
+    auto lerp3 = [](const aiVector3D& a, const aiVector3D& b, float t) { return a + (b - a) * t; };
+    auto slerp = [](const aiQuaternion& a, const aiQuaternion& b, float t)
+    {
+        aiQuaternion q;
+        aiQuaternion::Interpolate(q, a, b, t);
+        return q.Normalize();
+    };
+
+    for (unsigned int c = 0; c < animation->mNumChannels; c++)
+    {
+        const aiNodeAnim *channel = animation->mChannels[c];
+        int32_t           joint   = skeleton.findJoint(channel->mNodeName.C_Str());
+        if (joint < 0)
+            continue;   // moves a node no bone hangs below
+
+        unsigned int position = 0, rotation = 0, scaling = 0;
+        for (uint32_t f = 0; f < clip.frameCount; f++)
+        {
+            double ticks = std::min((double)f / clip.sampleRate * ticksPerSecond, animation->mDuration);
+            float *pose  = clip.frame(f);
+
+            if (channel->mNumPositionKeys)
+            {
+                aiVector3D t = sampleKeys(channel->mPositionKeys, channel->mNumPositionKeys, ticks, position, lerp3);
+                pose[POSE_TX * n + joint] = t.x;
+                pose[POSE_TY * n + joint] = t.y;
+                pose[POSE_TZ * n + joint] = t.z;
+            }
+            if (channel->mNumRotationKeys)
+            {
+                aiQuaternion q = sampleKeys(channel->mRotationKeys, channel->mNumRotationKeys, ticks, rotation, slerp);
+                pose[POSE_QX * n + joint] = q.x;
+                pose[POSE_QY * n + joint] = q.y;
+                pose[POSE_QZ * n + joint] = q.z;
+                pose[POSE_QW * n + joint] = q.w;
+            }
+            if (channel->mNumScalingKeys)
+            {
+                aiVector3D s = sampleKeys(channel->mScalingKeys, channel->mNumScalingKeys, ticks, scaling, lerp3);
+                pose[POSE_SX * n + joint] = s.x;
+                pose[POSE_SY * n + joint] = s.y;
+                pose[POSE_SZ * n + joint] = s.z;
+            }
+        }
+    }
+
+    clip.alignRotations();
+}
+
+void convertBoneWeights(const aiMesh *mesh, const Skeleton& skeleton, Vertex *vertices)
+{
+    for (unsigned int b = 0; b < mesh->mNumBones; b++)
+    {
+        const aiBone *bone = mesh->mBones[b];
+        int32_t       id   = skeleton.findBone(bone->mName.C_Str());
+        if (id < 0)
+            continue;
+
+        for (unsigned int w = 0; w < bone->mNumWeights; w++)
+        {
+            const aiVertexWeight& weight = bone->mWeights[w];
+            if (weight.mVertexId >= mesh->mNumVertices || weight.mWeight <= 0.0f)
+                continue;
+
+            // a free slot, or else the smallest influence if this one is bigger
+            Vertex& v        = vertices[weight.mVertexId];
+            int     smallest = 0;
+            for (int k = 1; k < MAX_BONE_INFLUENCE; k++)
+            {
+                if (v.m_Weights[k] < v.m_Weights[smallest])
+                    smallest = k;
+            }
+            if (weight.mWeight > v.m_Weights[smallest])
+            {
+                v.m_BoneIDs[smallest] = id;
+                v.m_Weights[smallest] = weight.mWeight;
+            }
+        }
+    }
+
+    // what was dropped is spread over the rest
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    {
+        Vertex& v   = vertices[i];
+        float   sum = 0.0f;
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+            sum += v.m_Weights[k];
+        if (sum > 0.0f)
+        {
+            for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                v.m_Weights[k] /= sum;
+        }
+    }
+}
+
+// pose(f, streams) fills the streams of frame f
+template<typename Fn>
+static AABB boundsOverFrames(const Skeleton& skeleton, uint32_t frames, const AABB& bindBounds, const uint8_t *usedBones, Fn&& pose)
+{
+    std::vector<float>      streams((size_t)POSE_CHANNELS * skeleton.stride());
+    std::vector<BoneMatrix> palette(skeleton.boneCount());
+    AABB                    bounds;
+
+    // a skinned vertex is a weighted average of the bones' transforms of it, it stays
+    // inside the union of the bind box moved by every bone it could be weighted to
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        pose(f, streams.data());
+        poseToPalette(skeleton, streams.data(), palette.data());
+        for (uint32_t b = 0; b < skeleton.boneCount(); b++)
+        {
+            if (!usedBones || usedBones[b])
+                bounds.expand(bindBounds.transformed(toMat4(palette[b])));
+        }
+    }
+    return bounds;
+}
+
+AABB animatedBounds(const Skeleton& skeleton, const AnimationClip *clip, const AABB& bindBounds, const uint8_t *usedBones)
+{
+    return boundsOverFrames(skeleton, clip ? clip->frameCount : 1, bindBounds, usedBones, [&](uint32_t f, float *pose)
+    {
+        const float *from = clip ? clip->frame(f) : skeleton.bindPose.data();
+        std::copy(from, from + POSE_CHANNELS * skeleton.stride(), pose);
+    });
+}
+
+AABB animatedBounds(const Skeleton& skeleton, const CompressedClip *clip, const AABB& bindBounds, const uint8_t *usedBones)
+{
+    return boundsOverFrames(skeleton, clip ? clip->frameCount : 1, bindBounds, usedBones, [&](uint32_t f, float *pose)
+    {
+        if (clip)
+            sampleClip(*clip, (float)f / clip->sampleRate, pose);
+        else
+            std::copy(skeleton.bindPose.begin(), skeleton.bindPose.end(), pose);
+    });
+}
+
+/*--------------------------------------- compression --------------------------------------*/
+
+namespace
+{
+    const float SQRT2   = 1.41421356f;
+    const float SQRT1_2 = 0.70710678f;
+
+    // 3 x 16 bits, see CompressedClip
+    struct PackedKey
+    {
+        uint16_t v[3];
+    };
+
+    const size_t PACKED_BYTES = sizeof(uint16_t) * 3;
+
+    // smallest-three: the index of the left out component goes into the top bits of the first two
+    PackedKey packRotation(glm::vec4 q)
+    {
+        int largest = 0;
+        for (int i = 1; i < 4; i++)
+        {
+            if (std::abs(q[i]) > std::abs(q[largest]))
+                largest = i;
+        }
+        // q and -q are the same rotation, the left out one is rebuilt as positive
+        if (q[largest] < 0.0f)
+            q = -q;
+
+        PackedKey key;
+        int       k = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if (i == largest)
+                continue;
+            // the others are within +-1/sqrt(2)
+            float    u    = std::min(std::max(q[i] * SQRT1_2 + 0.5f, 0.0f), 1.0f);
+            uint16_t bits = (uint16_t)std::lround(u * 32767.0f);
+            if (k < 2)
+                bits |= (uint16_t)(((largest >> k) & 1) << 15);
+            key.v[k++] = bits;
+        }
+        return key;
+    }
+
+    // where the three stored components go, by the index of the left out one
+    const uint8_t SMALLEST_THREE[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+
+    glm::vec4 unpackRotation(const uint16_t *v)
+    {
+        int   largest = (v[0] >> 15) | ((v[1] >> 15) << 1);
+        float a       = ((float)(v[0] & 0x7FFF) * (1.0f / 32767.0f) - 0.5f) * SQRT2;
+        float b       = ((float)(v[1] & 0x7FFF) * (1.0f / 32767.0f) - 0.5f) * SQRT2;
+        float c       = ((float)(v[2] & 0x7FFF) * (1.0f / 32767.0f) - 0.5f) * SQRT2;
+
+        // stores instead of a switch, which component is left out is different from joint to joint
+        glm::vec4 q;
+        q[largest]                    = std::sqrt(std::max(0.0f, 1.0f - a * a - b * b - c * c));
+        q[SMALLEST_THREE[largest][0]] = a;
+        q[SMALLEST_THREE[largest][1]] = b;
+        q[SMALLEST_THREE[largest][2]] = c;
+        return q;
+    }
+
+    PackedKey packVector(const glm::vec4& v, const glm::vec3& min, const glm::vec3& step)
+    {
+        PackedKey key;
+        for (int i = 0; i < 3; i++)
+        {
+            float q  = step[i] > 0.0f ? (v[i] - min[i]) / step[i] : 0.0f;
+            key.v[i] = (uint16_t)std::min(std::max(std::lround(q), 0L), 65535L);
+        }
+        return key;
+    }
+
+    glm::vec4 unpackVector(const uint16_t *v, const float *range)
+    {
+        // range is min xyz, step xyz
+        return glm::vec4(range[0] + (float)v[0] * range[3],
+                         range[1] + (float)v[1] * range[4],
+                         range[2] + (float)v[2] * range[5], 0.0f);
+    }
+
+    glm::vec4 blendRotations(const glm::vec4& a, glm::vec4 b, float t)
+    {
+        // decoded keys are each in the hemisphere of their largest component, not of their neighbour
+        if (glm::dot(a, b) < 0.0f)
+            b = -b;
+        glm::vec4 q = a + (b - a) * t;
+        return q * (1.0f / std::sqrt(glm::dot(q, q)));
+    }
+
+    float trackError(TrackKind kind, const glm::vec4& a, const glm::vec4& b)
+    {
+        if (kind == TRACK_ROTATION)
+        {
+            // the angle between them from the chord, acos(dot) drowns in the rounding of near equal ones
+            float chord = std::min(glm::length(a - b), glm::length(a + b));
+            return 4.0f * std::asin(std::min(chord * 0.5f, 1.0f));
+        }
+        if (kind == TRACK_TRANSLATION)
+            return glm::length(glm::vec3(a) - glm::vec3(b));
+
+        glm::vec3 d = glm::abs(glm::vec3(a) - glm::vec3(b));
+        return std::max(d.x, std::max(d.y, d.z));
+    }
+
+    uint32_t countBits(uint32_t v)
+    {
+        v = v - ((v >> 1) & 0x55555555u);
+        v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+        return (((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+    }
+
+    // 1 / the frames between two keys, a division per track is most of what finding its keys costs
+    const float RECIPROCALS[CompressedClip::SEGMENT_FRAMES + 1] =
+    {
+        0.0f, 1.0f, 1.0f / 2, 1.0f / 3, 1.0f / 4, 1.0f / 5, 1.0f / 6, 1.0f / 7, 1.0f / 8,
+        1.0f / 9, 1.0f / 10, 1.0f / 11, 1.0f / 12, 1.0f / 13, 1.0f / 14, 1.0f / 15, 1.0f / 16
+    };
+
+    const int TRACK_FLOATS[TRACK_KINDS] = { 3, 4, 3 };
+    const int FIRST_CHANNEL[TRACK_KINDS] = { POSE_TX, POSE_QX, POSE_SX };
+
+    struct AnimatedTrack
+    {
+        TrackKind              kind;
+        float                  tolerance;
+        bool                   raw = false;     // TRACK_RAW, decoded is original
+        std::vector<glm::vec4> original;
+        std::vector<glm::vec4> decoded;
+        std::vector<PackedKey> packed;
+
+        glm::vec4 interpolate(uint32_t a, uint32_t b, uint32_t f) const
+        {
+            float t = (float)(f - a) / (float)(b - a);
+            if (kind == TRACK_ROTATION)
+                return blendRotations(decoded[a], decoded[b], t);
+            return decoded[a] + (decoded[b] - decoded[a]) * t;
+        }
+
+        // every frame between keys a and b within the tolerance of the line between them
+        bool fits(uint32_t a, uint32_t b) const
+        {
+            for (uint32_t f = a + 1; f < b; f++)
+            {
+                if (trackError(kind, interpolate(a, b, f), original[f]) > tolerance)
+                    return false;
+            }
+            return true;
+        }
+    };
+}
+
+void compressClip(const Skeleton& skeleton, const AnimationClip& clip, CompressedClip& out, const CompressionSettings& settings)
+{
+    out.name        = clip.name;
+    out.duration    = clip.duration;
+    out.sampleRate  = clip.sampleRate;
+    out.frameCount  = clip.frameCount;
+    out.jointCount  = skeleton.jointCount();
+    out.stride      = clip.stride;
+    out.sourceBytes = clip.sourceBytes;
+    out.trackModes.clear();
+    out.trackData.clear();
+    out.segments.clear();
+    out.keys.clear();
+
+    const float tolerance[TRACK_KINDS] = { settings.translationError, settings.rotationError, settings.scaleError };
+
+    uint32_t n      = clip.stride;
+    uint32_t frames = clip.frameCount;
+
+    std::vector<AnimatedTrack> animated;
+    for (uint32_t j = 0; j < out.jointCount; j++)
+    {
+        for (int k = 0; k < TRACK_KINDS; k++)
+        {
+            AnimatedTrack track;
+            track.kind      = (TrackKind)k;
+            track.tolerance = tolerance[k];
+            track.original.resize(frames);
+            for (uint32_t f = 0; f < frames; f++)
+            {
+                const float *pose = clip.frame(f);
+                for (int c = 0; c < TRACK_FLOATS[k]; c++)
+                    track.original[f][c] = pose[(FIRST_CHANNEL[k] + c) * n + j];
+            }
+
+            bool constant = true;
+            for (uint32_t f = 1; f < frames && constant; f++)
+                constant = trackError(track.kind, track.original[f], track.original[0]) <= track.tolerance;
+
+            if (constant)
+            {
+                out.trackModes.push_back(TRACK_CONSTANT);
+                for (int c = 0; c < TRACK_FLOATS[k]; c++)
+                    out.trackData.push_back(track.original[0][c]);
+                continue;
+            }
+            track.packed.resize(frames);
+            track.decoded.resize(frames);
+            float range[6] = {};
+            if (track.kind == TRACK_ROTATION)
+            {
+                for (uint32_t f = 0; f < frames; f++)
+                {
+                    track.packed[f]  = packRotation(track.original[f]);
+                    track.decoded[f] = unpackRotation(track.packed[f].v);
+                }
+            }
+            else
+            {
+                glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+                for (uint32_t f = 0; f < frames; f++)
+                {
+                    lo = glm::min(lo, glm::vec3(track.original[f]));
+                    hi = glm::max(hi, glm::vec3(track.original[f]));
+                }
+                glm::vec3 step = (hi - lo) / 65535.0f;
+
+                range[0] = lo.x;   range[1] = lo.y;   range[2] = lo.z;
+                range[3] = step.x; range[4] = step.y; range[5] = step.z;
+
+                for (uint32_t f = 0; f < frames; f++)
+                {
+                    track.packed[f]  = packVector(track.original[f], lo, step);
+                    track.decoded[f] = unpackVector(track.packed[f].v, range);
+                }
+            }
+
+            // the keys themselves may be off by half the bound at most, the rest is left to the
+            // reduction. A wide range doesn't fit in 16 bits, those keep their floats
+            float quantization = 0.0f;
+            for (uint32_t f = 0; f < frames; f++)
+                quantization = std::max(quantization, trackError(track.kind, track.decoded[f], track.original[f]));
+
+            if (quantization > track.tolerance * 0.5f)
+            {
+                track.raw     = true;
+                track.decoded = track.original;
+                out.trackModes.push_back(TRACK_RAW);
+            }
+            else
+            {
+                out.trackModes.push_back(TRACK_ANIMATED);
+                if (track.kind != TRACK_ROTATION)
+                    out.trackData.insert(out.trackData.end(), range, range + 6);
+            }
+            animated.push_back(std::move(track));
+        }
+    }
+
+    const uint32_t SEGMENT = CompressedClip::SEGMENT_FRAMES;
+    uint32_t segmentCount  = (frames - 1 + SEGMENT - 1) / SEGMENT;
+
+    std::vector<uint32_t> kept;
+    for (uint32_t s = 0; s < segmentCount; s++)
+    {
+        uint32_t first = s * SEGMENT;
+        uint32_t last  = std::min(first + SEGMENT, frames - 1);
+        out.segments.push_back((uint32_t)out.keys.size());
+
+        for (const AnimatedTrack& track : animated)
+        {
+            // greedy: from every key on, the furthest frame the line to it still fits
+            kept.assign(1, first);
+            uint32_t key = first;
+            while (key < last)
+            {
+                uint32_t end = key + 1;
+                while (end < last && track.fits(key, end + 1))
+                    end++;
+                kept.push_back(end);
+                key = end;
+            }
+
+            // mask of the frames that are keys, their offsets in the segment, padding to 2 bytes, the values
+            uint32_t mask = 0;
+            for (uint32_t f : kept)
+                mask |= 1u << (f - first);
+            size_t at = out.keys.size();
+            out.keys.resize(at + sizeof(mask));
+            std::memcpy(&out.keys[at], &mask, sizeof(mask));
+
+            for (uint32_t f : kept)
+                out.keys.push_back((uint8_t)(f - first));
+            if (out.keys.size() & 1)
+                out.keys.push_back(0);
+
+            for (uint32_t f : kept)
+            {
+                size_t at = out.keys.size();
+                if (track.raw)
+                {
+                    size_t bytes = TRACK_FLOATS[track.kind] * sizeof(float);
+                    out.keys.resize(at + bytes);
+                    std::memcpy(&out.keys[at], &track.original[f][0], bytes);
+                }
+                else
+                {
+                    out.keys.resize(at + PACKED_BYTES);
+                    std::memcpy(&out.keys[at], track.packed[f].v, PACKED_BYTES);
+                }
+            }
+        }
+    }
+}
+
+#if !SIMD_X86
+
+static void decodeRotationsScalar(const int32_t *packed, float *q, uint32_t n)
+{
+    for (uint32_t j = 0; j < n; j++)
+    {
+        if (packed[j] < 0)
+            continue;
+
+        uint16_t  v[3] = { (uint16_t)packed[j], (uint16_t)packed[n + j], (uint16_t)packed[2 * n + j] };
+        glm::vec4 r    = unpackRotation(v);
+        for (int c = 0; c < 4; c++)
+            q[c * n + j] = r[c];
+    }
+}
+
+static void blendTracksScalar(const float *a, const float *b, const float *weights, uint32_t n, float *out)
+{
+    for (int c = POSE_TX; c <= POSE_TZ; c++)
+    {
+        for (uint32_t j = 0; j < n; j++)
+            out[c * n + j] = a[c * n + j] + (b[c * n + j] - a[c * n + j]) * weights[TRACK_TRANSLATION * n + j];
+    }
+    for (int c = POSE_SX; c <= POSE_SZ; c++)
+    {
+        for (uint32_t j = 0; j < n; j++)
+            out[c * n + j] = a[c * n + j] + (b[c * n + j] - a[c * n + j]) * weights[TRACK_SCALE * n + j];
+    }
+    for (uint32_t j = 0; j < n; j++)
+    {
+        float dot = 0.0f;
+        for (int c = POSE_QX; c <= POSE_QW; c++)
+            dot += a[c * n + j] * b[c * n + j];
+        float sign = dot < 0.0f ? -1.0f : 1.0f;
+
+        for (int c = POSE_QX; c <= POSE_QW; c++)
+            out[c * n + j] = a[c * n + j] + (b[c * n + j] * sign - a[c * n + j]) * weights[TRACK_ROTATION * n + j];
+    }
+    normalizeRotationsScalar(out, n);
+}
+
+#else
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// unpackRotation 4 joints at a time: the left out component differs from joint to joint,
+// it is put in place with masks instead of a branch per joint
+static void decodeRotationsSSE(const int32_t *packed, float *q, uint32_t n)
+{
+    const __m128i low   = _mm_set1_epi32(0x7FFF);
+    const __m128i bit   = _mm_set1_epi32(1);
+    const __m128  scale = _mm_set1_ps(SQRT2 / 32767.0f);
+    const __m128  bias  = _mm_set1_ps(SQRT1_2);
+    const __m128  one   = _mm_set1_ps(1.0f);
+    const __m128  zero  = _mm_setzero_ps();
+
+    for (uint32_t j = 0; j < n; j += 4)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(packed + j));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(packed + n + j));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(packed + 2 * n + j));
+
+        __m128i largest = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v0, 15), bit),
+                                       _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v1, 15), bit), 1));
+        __m128 a = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v0, low)), scale), bias);
+        __m128 b = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v1, low)), scale), bias);
+        __m128 c = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v2, low)), scale), bias);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(c, c));
+        __m128 d    = _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(one, len2)));
+
+        __m128 is0 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_setzero_si128()));
+        __m128 is1 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, bit));
+        __m128 is2 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(2)));
+        __m128 is3 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(3)));
+
+        // constant tracks are marked negative, their rotation is in q already
+        __m128 keep = _mm_castsi128_ps(_mm_cmplt_epi32(v0, _mm_setzero_si128()));
+
+        float *x = q + j, *y = q + n + j, *z = q + 2 * n + j, *w = q + 3 * n + j;
+        _mm_storeu_ps(x, select(keep, _mm_loadu_ps(x), select(is0, d, a)));
+        _mm_storeu_ps(y, select(keep, _mm_loadu_ps(y), select(is0, a, select(is1, d, b))));
+        _mm_storeu_ps(z, select(keep, _mm_loadu_ps(z), select(is3, c, select(is2, d, b))));
+        _mm_storeu_ps(w, select(keep, _mm_loadu_ps(w), select(is3, d, c)));
+    }
+}
+
+static void blendTracksSSE(const float *a, const float *b, const float *weights, uint32_t n, float *out)
+{
+    for (uint32_t j = 0; j < n; j += 4)
+    {
+        __m128 wt = _mm_loadu_ps(weights + TRACK_TRANSLATION * n + j);
+        __m128 wr = _mm_loadu_ps(weights + TRACK_ROTATION * n + j);
+        __m128 ws = _mm_loadu_ps(weights + TRACK_SCALE * n + j);
+
+        for (int c = POSE_TX; c <= POSE_SZ; c++)
+        {
+            __m128 w  = c < POSE_QX ? wt : c < POSE_SX ? wr : ws;
+            __m128 va = _mm_loadu_ps(a + c * n + j);
+            __m128 vb = _mm_loadu_ps(b + c * n + j);
+            if (c == POSE_QX)
+            {
+                // keys decoded apart are each in the hemisphere of their largest component
+                __m128 dot = _mm_setzero_ps();
+                for (int r = POSE_QX; r <= POSE_QW; r++)
+                    dot = _mm_add_ps(dot, _mm_mul_ps(_mm_loadu_ps(a + r * n + j), _mm_loadu_ps(b + r * n + j)));
+                __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+                for (int r = POSE_QX; r <= POSE_QW; r++)
+                {
+                    __m128 ra = _mm_loadu_ps(a + r * n + j);
+                    __m128 rb = _mm_xor_ps(_mm_loadu_ps(b + r * n + j), flip);
+                    _mm_storeu_ps(out + r * n + j, _mm_add_ps(ra, _mm_mul_ps(_mm_sub_ps(rb, ra), wr)));
+                }
+                c = POSE_QW;
+                continue;
+            }
+            _mm_storeu_ps(out + c * n + j, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), w)));
+        }
+    }
+    normalizeRotationsSSE(out, n);
+}
+
+#endif // SIMD_X86
+
+// the rotation streams of q from smallest-three keys, packed holds their 3 words as 3 streams of n.
+// Joints whose first word is negative are skipped
+static void decodeRotations(const int32_t *packed, float *q, uint32_t n)
+{
+#if SIMD_X86
+    decodeRotationsSSE(packed, q, n);
+#else
+    decodeRotationsScalar(packed, q, n);
+#endif
+}
+
+// blendPoses with a weight per joint and track, weights holds TRACK_KINDS streams of n
+static void blendTracks(const float *a, const float *b, const float *weights, uint32_t n, float *out)
+{
+#if SIMD_X86
+    blendTracksSSE(a, b, weights, n, out);
+#else
+    blendTracksScalar(a, b, weights, n, out);
+#endif
+}
+
+namespace
+{
+    // where sampleClip is in the track headers and the keys of a segment
+    struct TrackCursor
+    {
+        const uint8_t *mode;
+        const float   *data;
+        const uint8_t *keys;
+        float          local;   // frames into the segment
+
+        // the two keys around local of the next track if it is animated, returns its mode. A
+        // constant one has its floats at data, a raw one has rawBytes of floats per key
+        uint8_t locate(const uint8_t *&a, const uint8_t *&b, float& weight, size_t rawBytes)
+        {
+            uint8_t trackMode = *mode++;
+            if (trackMode == TRACK_CONSTANT)
+                return trackMode;
+
+            size_t   keyBytes = trackMode == TRACK_RAW ? rawBytes : PACKED_BYTES;
+            uint32_t mask;
+            std::memcpy(&mask, keys, sizeof(mask));
+            uint32_t       count   = countBits(mask);
+            const uint8_t *offsets = keys + sizeof(mask);
+            const uint8_t *values  = offsets + ((count + 1) & ~1u);
+            keys = values + count * keyBytes;
+
+            // the last key at or before local is the number of keys up to it, a search would
+            // stop somewhere else for every track and miss the branch predictor every time
+            uint32_t frame = std::min((uint32_t)local, (uint32_t)offsets[count - 1] - 1);
+            uint32_t i     = countBits(mask & ((2u << frame) - 1)) - 1;
+            float    t     = (local - (float)offsets[i]) * RECIPROCALS[offsets[i + 1] - offsets[i]];
+
+            weight = std::min(t, 1.0f);
+            a      = values + i * keyBytes;
+            b      = a + keyBytes;
+            return trackMode;
+        }
+
+        // translation or scale into 3 streams of stride n
+        void vector(float *from, float *to, float& weight, uint32_t n)
+        {
+            const uint8_t *a, *b;
+            uint8_t trackMode = locate(a, b, weight, 3 * sizeof(float));
+            if (trackMode == TRACK_CONSTANT)
+            {
+                for (int c = 0; c < 3; c++)
+                    from[c * n] = to[c * n] = data[c];
+                data += 3;
+                return;
+            }
+            if (trackMode == TRACK_RAW)
+            {
+                float fa[3], fb[3];
+                std::memcpy(fa, a, sizeof(fa));
+                std::memcpy(fb, b, sizeof(fb));
+                for (int c = 0; c < 3; c++)
+                {
+                    from[c * n] = fa[c];
+                    to[c * n]   = fb[c];
+                }
+                return;
+            }
+
+            uint16_t ka[3], kb[3];
+            std::memcpy(ka, a, PACKED_BYTES);
+            std::memcpy(kb, b, PACKED_BYTES);
+            for (int c = 0; c < 3; c++)
+            {
+                from[c * n] = data[c] + (float)ka[c] * data[3 + c];
+                to[c * n]   = data[c] + (float)kb[c] * data[3 + c];
+            }
+            data += 6;
+        }
+
+        // rotations are only copied as words here, decodeRotations unpacks them all at once
+        void rotation(float *from, float *to, int32_t *packedFrom, int32_t *packedTo, float& weight, uint32_t n)
+        {
+            const uint8_t *a, *b;
+            uint8_t trackMode = locate(a, b, weight, 4 * sizeof(float));
+            if (trackMode == TRACK_CONSTANT)
+            {
+                for (int c = 0; c < 4; c++)
+                    from[c * n] = to[c * n] = data[c];
+                data += 4;
+                packedFrom[0] = packedTo[0] = -1;
+                return;
+            }
+            if (trackMode == TRACK_RAW)
+            {
+                // already decoded, left out of decodeRotations like a constant
+                float fa[4], fb[4];
+                std::memcpy(fa, a, sizeof(fa));
+                std::memcpy(fb, b, sizeof(fb));
+                for (int c = 0; c < 4; c++)
+                {
+                    from[c * n] = fa[c];
+                    to[c * n]   = fb[c];
+                }
+                packedFrom[0] = packedTo[0] = -1;
+                return;
+            }
+
+            uint16_t ka[3], kb[3];
+            std::memcpy(ka, a, PACKED_BYTES);
+            std::memcpy(kb, b, PACKED_BYTES);
+            for (int c = 0; c < 3; c++)
+            {
+                packedFrom[c * n] = ka[c];
+                packedTo[c * n]   = kb[c];
+            }
+        }
+    };
+}
+
+void sampleClip(const CompressedClip& clip, float time, float *pose)
+{
+    uint32_t n        = clip.stride;
+    float    position = std::min(std::max(time * clip.sampleRate, 0.0f), (float)(clip.frameCount - 1));
+    uint32_t segment  = std::min((uint32_t)position / CompressedClip::SEGMENT_FRAMES, clip.segmentCount() - 1);
+    float    local    = position - (float)(segment * CompressedClip::SEGMENT_FRAMES);
+
+    // the sweep finds the two keys around the time of every track, decoding the rotations
+    // and the lerps are SIMD passes after it
+    scratchKeys.resize((size_t)POSE_CHANNELS * n * 2);
+    scratchWeights.assign((size_t)TRACK_KINDS * n, 0.0f);
+    scratchPacked.assign((size_t)6 * n, -1);
+    float   *from       = scratchKeys.data();
+    float   *to         = from + POSE_CHANNELS * n;
+    float   *weights    = scratchWeights.data();
+    int32_t *packedFrom = scratchPacked.data();
+    int32_t *packedTo   = packedFrom + 3 * n;
+
+    TrackCursor cursor = { clip.trackModes.data(), clip.trackData.data(), clip.keys.data() + clip.segments[segment], local };
+    for (uint32_t j = 0; j < clip.jointCount; j++)
+    {
+        cursor.vector(from + POSE_TX * n + j, to + POSE_TX * n + j, weights[TRACK_TRANSLATION * n + j], n);
+        cursor.rotation(from + POSE_QX * n + j, to + POSE_QX * n + j, packedFrom + j, packedTo + j, weights[TRACK_ROTATION * n + j], n);
+        cursor.vector(from + POSE_SX * n + j, to + POSE_SX * n + j, weights[TRACK_SCALE * n + j], n);
+    }
+
+    // padding joints lerp identity to identity
+    fillIdentity(from, n, clip.jointCount);
+    fillIdentity(to, n, clip.jointCount);
+
+    decodeRotations(packedFrom, from + POSE_QX * n, n);
+    decodeRotations(packedTo, to + POSE_QX * n, n);
+    blendTracks(from, to, weights, n, pose);
+}
@@ -0,0 +1,663 @@
+#include <BVH.hpp>
+#include <Simd.hpp>
+#include <Parallel.hpp>
+
+#include <istream>
+#include <ostream>
+#include <mutex>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <cassert>
+
+namespace
+{
+    const int      BIN_COUNT          = 16;
+    const uint32_t MAX_LEAF_SIZE      = 8;
+    const uint32_t PARALLEL_THRESHOLD = 32 * 1024;  // below this a subtree is built on one thread
+    const float    TRAVERSAL_COST     = 1.0f;       // relative to one triangle test
+
+    const uint32_t BVH_MAGIC          = 0x34485642; // "BVH4"
+    const uint32_t BVH_VERSION        = 1;
+
+    struct BuildNode
+    {
+        AABB     bounds;
+        int32_t  left  = -1;   // -1 for leaves
+        int32_t  right = -1;
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    struct Bin
+    {
+        AABB     bounds;
+        uint32_t count = 0;
+    };
+
+    typedef std::pmr::vector<BuildNode> BuildNodes;
+
+    // everything here lives only during build(), it comes from the caller's scratch resource
+    struct BuildContext
+    {
+        std::pmr::vector<AABB>      triBounds;
+        std::pmr::vector<glm::vec3> centroids;
+        std::pmr::vector<uint32_t>  prims;
+        int                         maxParallelDepth = 0;
+
+        explicit BuildContext(std::pmr::memory_resource *scratch)
+            : triBounds(scratch), centroids(scratch), prims(scratch) {}
+    };
+
+    float halfArea(const AABB& b)
+    {
+        if (!b.valid()) return 0.0f;
+        glm::vec3 d = b.max - b.min;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    void computeBounds(const BuildContext& ctx, uint32_t first, uint32_t count, AABB& bounds, AABB& centroidBounds)
+    {
+        if (count < PARALLEL_THRESHOLD)
+        {
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                bounds.expand(ctx.triBounds[ctx.prims[i]]);
+                centroidBounds.expand(ctx.centroids[ctx.prims[i]]);
+            }
+            return;
+        }
+
+        std::mutex lock;
+        parallelFor(count, PARALLEL_THRESHOLD / 4, [&](size_t begin, size_t end)
+        {
+            AABB b, cb;
+            for (size_t i = first + begin; i < first + end; i++)
+            {
+                b.expand(ctx.triBounds[ctx.prims[i]]);
+                cb.expand(ctx.centroids[ctx.prims[i]]);
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            bounds.expand(b);
+            centroidBounds.expand(cb);
+        });
+    }
+
+    void fillBins(const BuildContext& ctx, uint32_t first, uint32_t count, const AABB& cb, Bin bins[3][BIN_COUNT])
+    {
+        auto binRange = [&](size_t begin, size_t end, Bin local[3][BIN_COUNT])
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                uint32_t p = ctx.prims[i];
+                for (int a = 0; a < 3; a++)
+                {
+                    float extent = cb.max[a] - cb.min[a];
+                    if (extent <= 0.0f) continue;
+
+                    int b = (int)((ctx.centroids[p][a] - cb.min[a]) * (BIN_COUNT / extent));
+                    b = std::min(b, BIN_COUNT - 1);
+                    local[a][b].count++;
+                    local[a][b].bounds.expand(ctx.triBounds[p]);
+                }
+            }
+        };
+
+        if (count < PARALLEL_THRESHOLD)
+        {
+            binRange(first, first + count, bins);
+            return;
+        }
+
+        // big nodes near the root: every thread bins its own range and the results are merged
+        std::mutex lock;
+        parallelFor(count, PARALLEL_THRESHOLD / 4, [&](size_t begin, size_t end)
+        {
+            Bin local[3][BIN_COUNT];
+            binRange(first + begin, first + end, local);
+
+            std::lock_guard<std::mutex> guard(lock);
+            for (int a = 0; a < 3; a++)
+            {
+                for (int b = 0; b < BIN_COUNT; b++)
+                {
+                    bins[a][b].count += local[a][b].count;
+                    bins[a][b].bounds.expand(local[a][b].bounds);
+                }
+            }
+        });
+    }
+
+    int32_t buildRecursive(BuildContext& ctx, BuildNodes& nodes, uint32_t first, uint32_t count, int depth)
+    {
+        int32_t idx = (int32_t)nodes.size();
+        nodes.emplace_back();
+
+        AABB bounds, cb;
+        computeBounds(ctx, first, count, bounds, cb);
+
+        nodes[idx].bounds = bounds;
+        nodes[idx].first  = first;
+        nodes[idx].count  = count;
+
+        if (count <= 2)
+            return idx;
+
+        Bin bins[3][BIN_COUNT];
+        fillBins(ctx, first, count, cb, bins);
+
+        // sweep the split planes between bins on every axis
+        int   bestAxis  = -1;
+        int   bestSplit = -1;
+        float bestCost  = 1e30f;
+
+        for (int a = 0; a < 3; a++)
+        {
+            if (cb.max[a] - cb.min[a] <= 0.0f)
+                continue;
+
+            float    rightArea[BIN_COUNT];
+            uint32_t rightCount[BIN_COUNT];
+
+            AABB     acc;
+            uint32_t n = 0;
+            for (int b = BIN_COUNT - 1; b > 0; b--)
+            {
+                acc.expand(bins[a][b].bounds);
+                n += bins[a][b].count;
+                rightArea[b]  = halfArea(acc);
+                rightCount[b] = n;
+            }
+
+            acc = AABB();
+            n   = 0;
+            for (int b = 0; b < BIN_COUNT - 1; b++)
+            {
+                acc.expand(bins[a][b].bounds);
+                n += bins[a][b].count;
+
+                if (n == 0 || rightCount[b + 1] == 0)
+                    continue;
+
+                float cost = n * halfArea(acc) + rightCount[b + 1] * rightArea[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost  = cost;
+                    bestAxis  = a;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        uint32_t mid;
+        if (bestAxis == -1)
+        {
+            // all centroids in one spot, SAH can't help
+            if (count <= MAX_LEAF_SIZE)
+                return idx;
+            mid = first + count / 2;
+        }
+        else
+        {
+            float leafCost  = (float)count;
+            float splitCost = TRAVERSAL_COST + bestCost / halfArea(bounds);
+            if (count <= MAX_LEAF_SIZE && leafCost <= splitCost)
+                return idx;
+
+            float extent = cb.max[bestAxis] - cb.min[bestAxis];
+            float minC   = cb.min[bestAxis];
+
+            auto it = std::partition(ctx.prims.begin() + first, ctx.prims.begin() + first + count, [&](uint32_t p)
+            {
+                int b = (int)((ctx.centroids[p][bestAxis] - minC) * (BIN_COUNT / extent));
+                return std::min(b, BIN_COUNT - 1) <= bestSplit;
+            });
+            mid = (uint32_t)(it - ctx.prims.begin());
+
+            if (mid == first || mid == first + count)
+                mid = first + count / 2;
+        }
+
+        uint32_t leftCount  = mid - first;
+        uint32_t rightCount = count - leftCount;
+
+        int32_t left, right;
+        if (count >= PARALLEL_THRESHOLD && depth < ctx.maxParallelDepth)
+        {
+            // the right subtree goes into its own array and gets spliced in afterwards. That
+            // one is filled on another thread, it can't share the (unsynchronized) scratch
+            BuildNodes rightNodes(std::pmr::new_delete_resource());
+            int32_t rightLocal = 0;
+
+            parallelInvoke(
+                [&]() { left = buildRecursive(ctx, nodes, first, leftCount, depth + 1); },
+                [&]() { rightLocal = buildRecursive(ctx, rightNodes, mid, rightCount, depth + 1); });
+
+            int32_t offset = (int32_t)nodes.size();
+            for (BuildNode& n : rightNodes)
+            {
+                if (n.left >= 0)
+                {
+                    n.left  += offset;
+                    n.right += offset;
+                }
+                nodes.push_back(n);
+            }
+            right = rightLocal + offset;
+        }
+        else
+        {
+            left  = buildRecursive(ctx, nodes, first, leftCount, depth + 1);
+            right = buildRecursive(ctx, nodes, mid, rightCount, depth + 1);
+        }
+
+        nodes[idx].left  = left;
+        nodes[idx].right = right;
+        nodes[idx].count = 0;
+
+        return idx;
+    }
+
+    void setEmptySlot(BVHNode4& n, int i)
+    {
+        n.minX[i] = n.minY[i] = n.minZ[i] =  1e30f;
+        n.maxX[i] = n.maxY[i] = n.maxZ[i] = -1e30f;
+        n.child[i] = -1;
+        n.count[i] = 0;
+    }
+
+    // pulls up to 4 grandchildren into one wide node, always opening the child with the biggest area
+    int32_t collapse(const BuildNodes& bn, int32_t b, std::vector<BVHNode4>& out)
+    {
+        int32_t idx = (int32_t)out.size();
+        out.emplace_back();
+        for (int i = 0; i < 4; i++)
+            setEmptySlot(out[idx], i);
+
+        int32_t children[4];
+        int     childCount = 0;
+
+        if (bn[b].left < 0)
+        {
+            children[childCount++] = b;
+        }
+        else
+        {
+            children[childCount++] = bn[b].left;
+            children[childCount++] = bn[b].right;
+        }
+
+        while (childCount < 4)
+        {
+            int   best     = -1;
+            float bestArea = -1.0f;
+            for (int i = 0; i < childCount; i++)
+            {
+                const BuildNode& c = bn[children[i]];
+                if (c.left >= 0 && halfArea(c.bounds) > bestArea)
+                {
+                    bestArea = halfArea(c.bounds);
+                    best     = i;
+                }
+            }
+            if (best < 0)
+                break;
+
+            int32_t opened = children[best];
+            children[best]           = bn[opened].left;
+            children[childCount++]   = bn[opened].right;
+        }
+
+        for (int i = 0; i < childCount; i++)
+        {
+            const BuildNode& c = bn[children[i]];
+
+            int32_t  child;
+            uint32_t count;
+            if (c.left < 0)
+            {
+                child = (int32_t)c.first;
+                count = c.count;
+            }
+            else
+            {
+                child = collapse(bn, children[i], out);
+                count = 0;
+            }
+
+            BVHNode4& n = out[idx];
+            n.minX[i] = c.bounds.min.x; n.minY[i] = c.bounds.min.y; n.minZ[i] = c.bounds.min.z;
+            n.maxX[i] = c.bounds.max.x; n.maxY[i] = c.bounds.max.y; n.maxZ[i] = c.bounds.max.z;
+            n.child[i] = child;
+            n.count[i] = count;
+        }
+
+        return idx;
+    }
+
+    // deepest level of inner nodes, the root is level 0
+    uint32_t treeDepth(const std::vector<BVHNode4>& nodes)
+    {
+        if (nodes.empty())
+            return 0;
+
+        uint32_t deepest = 0;
+        std::vector<std::pair<int32_t, uint32_t>> open;
+        open.push_back(std::make_pair(0, 0u));
+        while (!open.empty())
+        {
+            std::pair<int32_t, uint32_t> node = open.back();
+            open.pop_back();
+            deepest = std::max(deepest, node.second);
+
+            const BVHNode4& n = nodes[node.first];
+            for (int i = 0; i < 4; i++)
+            {
+                if (n.child[i] >= 0 && n.count[i] == 0)
+                    open.push_back(std::make_pair(n.child[i], node.second + 1));
+            }
+        }
+        return deepest;
+    }
+
+    // two sided Moller-Trumbore
+    inline bool intersectTriangle(const BVHTriangle& tri, const glm::vec3& o, const glm::vec3& d, RayHit& hit)
+    {
+        glm::vec3 p   = glm::cross(d, tri.e2);
+        float     det = glm::dot(tri.e1, p);
+        if (std::abs(det) < 1e-12f)
+            return false;
+
+        float     inv = 1.0f / det;
+        glm::vec3 s   = o - tri.v0;
+        float     u   = glm::dot(s, p) * inv;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+
+        glm::vec3 q = glm::cross(s, tri.e1);
+        float     v = glm::dot(d, q) * inv;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+
+        float t = glm::dot(tri.e2, q) * inv;
+        if (t <= 0.0f || t >= hit.t)
+            return false;
+
+        hit.t        = t;
+        hit.u        = u;
+        hit.v        = v;
+        hit.triangle = tri.id;
+        return true;
+    }
+}
+
+size_t BVH::scratchBytes(size_t indexCount)
+{
+    size_t triCount = indexCount / 3;
+    size_t perTri   = sizeof(AABB) + sizeof(glm::vec3) + sizeof(uint32_t);
+    size_t nodes    = triCount * 2 / MAX_LEAF_SIZE + 1;
+
+    // a bit per array for alignment
+    return triCount * perTri + nodes * sizeof(BuildNode) + 4 * alignof(std::max_align_t);
+}
+
+void BVH::build(const glm::vec3 *positions, size_t positionStride, const uint32_t *indices, size_t indexCount,
+                std::pmr::memory_resource *scratch)
+{
+    nodes.clear();
+    triangles.clear();
+    bounds = AABB();
+    depth  = 0;
+
+    size_t triCount = indexCount / 3;
+    if (triCount == 0)
+        return;
+
+    auto pos = [&](uint32_t i) -> const glm::vec3&
+    {
+        return *(const glm::vec3 *)((const char *)positions + i * positionStride);
+    };
+
+    BuildContext ctx(scratch);
+    ctx.triBounds.resize(triCount);
+    ctx.centroids.resize(triCount);
+    ctx.prims.resize(triCount);
+
+    parallelFor(triCount, 64 * 1024, [&](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; t++)
+        {
+            AABB b;
+            b.expand(pos(indices[t * 3 + 0]));
+            b.expand(pos(indices[t * 3 + 1]));
+            b.expand(pos(indices[t * 3 + 2]));
+            ctx.triBounds[t] = b;
+            ctx.centroids[t] = b.center();
+            ctx.prims[t]     = (uint32_t)t;
+        }
+    });
+
+    unsigned workers = workerCount();
+    while (workers > 1)
+    {
+        ctx.maxParallelDepth++;
+        workers >>= 1;
+    }
+    ctx.maxParallelDepth += 2;  // a few extra levels so unbalanced splits still keep every core busy
+
+    BuildNodes buildNodes(scratch);
+    buildNodes.reserve(triCount * 2 / MAX_LEAF_SIZE + 1);
+    buildRecursive(ctx, buildNodes, 0, (uint32_t)triCount, 0);
+
+    bounds = buildNodes[0].bounds;
+
+    nodes.reserve(buildNodes.size() / 2 + 1);
+    collapse(buildNodes, 0, nodes);
+    depth = treeDepth(nodes);
+
+    // store triangles in leaf order so a leaf is one contiguous run
+    triangles.resize(triCount);
+    parallelFor(triCount, 64 * 1024, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            uint32_t t = ctx.prims[i];
+            const glm::vec3& a = pos(indices[t * 3 + 0]);
+            const glm::vec3& b = pos(indices[t * 3 + 1]);
+            const glm::vec3& c = pos(indices[t * 3 + 2]);
+
+            triangles[i].v0 = a;
+            triangles[i].e1 = b - a;
+            triangles[i].e2 = c - a;
+            triangles[i].id = t;
+        }
+    });
+}
+
+bool BVH::intersect(const glm::vec3& origin, const glm::vec3& dir, RayHit& hit) const
+{
+    if (nodes.empty())
+        return false;
+
+    // keep 1/d finite, a 0 component would turn 0 * inf into NaN in the slab test
+    glm::vec3 d = dir;
+    for (int a = 0; a < 3; a++)
+    {
+        if (std::abs(d[a]) < 1e-20f)
+            d[a] = d[a] < 0.0f ? -1e-20f : 1e-20f;
+    }
+    glm::vec3 invDir = 1.0f / d;
+
+    // every level above the node being visited leaves at most 3 of its children on the
+    // stack, only degenerate trees (many equal centroids) need more than the local array
+    int                  capacity = 3 * (int)depth + 1;
+    int32_t              local[64];
+    std::vector<int32_t> deep;
+    int32_t             *stack = local;
+    if (capacity > 64)
+    {
+        deep.resize(capacity);
+        stack = deep.data();
+    }
+
+    bool found = false;
+    int  sp    = 0;
+    stack[sp++] = 0;
+
+#if SIMD_X86
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 ix = _mm_set1_ps(invDir.x), iy = _mm_set1_ps(invDir.y), iz = _mm_set1_ps(invDir.z);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+
+    while (sp > 0)
+    {
+        const BVHNode4& n = nodes[stack[--sp]];
+
+        float tNear[4];
+        int   mask;
+
+#if SIMD_X86
+        __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.minX), ox), ix);
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.maxX), ox), ix);
+        __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.minY), oy), iy);
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.maxY), oy), iy);
+        __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.minZ), oz), iz);
+        __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.maxZ), oz), iz);
+
+        __m128 tmin = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_min_ps(tz0, tz1));
+        __m128 tmax = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_max_ps(tz0, tz1));
+
+        __m128 ok = _mm_and_ps(_mm_cmple_ps(tmin, tmax), _mm_cmpge_ps(tmax, zero));
+        ok        = _mm_and_ps(ok, _mm_cmplt_ps(tmin, _mm_set1_ps(hit.t)));
+
+        mask = _mm_movemask_ps(ok);
+        _mm_storeu_ps(tNear, tmin);
+#else
+        mask = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            float tx0 = (n.minX[i] - origin.x) * invDir.x, tx1 = (n.maxX[i] - origin.x) * invDir.x;
+            float ty0 = (n.minY[i] - origin.y) * invDir.y, ty1 = (n.maxY[i] - origin.y) * invDir.y;
+            float tz0 = (n.minZ[i] - origin.z) * invDir.z, tz1 = (n.maxZ[i] - origin.z) * invDir.z;
+
+            float tmin = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::min(tz0, tz1));
+            float tmax = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+
+            tNear[i] = tmin;
+            if (tmin <= tmax && tmax >= 0.0f && tmin < hit.t)
+                mask |= 1 << i;
+        }
+#endif
+
+        if (!mask)
+            continue;
+
+        // leaves are tested right away, inner nodes are pushed far to near so the nearest pops first
+        int   order[4];
+        int   inner = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if (!(mask & (1 << i)) || n.child[i] < 0)
+                continue;
+
+            if (n.count[i] > 0)
+            {
+                for (uint32_t t = 0; t < n.count[i]; t++)
+                    found |= intersectTriangle(triangles[n.child[i] + t], origin, dir, hit);
+            }
+            else
+            {
+                int j = inner++;
+                while (j > 0 && tNear[order[j - 1]] < tNear[i])
+                {
+                    order[j] = order[j - 1];
+                    j--;
+                }
+                order[j] = i;
+            }
+        }
+
+        assert(sp + inner <= capacity);
+        for (int i = 0; i < inner; i++)
+            stack[sp++] = n.child[order[i]];
+    }
+
+    return found;
+}
+
+bool BVH::write(std::ostream& out) const
+{
+    uint64_t nodeCount = nodes.size();
+    uint64_t triCount  = triangles.size();
+
+    out.write((const char *)&BVH_MAGIC,   sizeof(BVH_MAGIC));
+    out.write((const char *)&BVH_VERSION, sizeof(BVH_VERSION));
+    out.write((const char *)&sourceHash,  sizeof(sourceHash));
+    out.write((const char *)&bounds,      sizeof(bounds));
+    out.write((const char *)&nodeCount,   sizeof(nodeCount));
+    out.write((const char *)&triCount,    sizeof(triCount));
+    if (nodeCount)
+        out.write((const char *)nodes.data(), nodeCount * sizeof(BVHNode4));
+    if (triCount)
+        out.write((const char *)triangles.data(), triCount * sizeof(BVHTriangle));
+
+    return out.good();
+}
+
+bool BVH::read(std::istream& in)
+{
+    uint32_t magic = 0, version = 0;
+    uint64_t nodeCount = 0, triCount = 0;
+
+    in.read((char *)&magic,      sizeof(magic));
+    in.read((char *)&version,    sizeof(version));
+    if (!in || magic != BVH_MAGIC || version != BVH_VERSION)
+        return false;
+
+    in.read((char *)&sourceHash, sizeof(sourceHash));
+    in.read((char *)&bounds,     sizeof(bounds));
+    in.read((char *)&nodeCount,  sizeof(nodeCount));
+    in.read((char *)&triCount,   sizeof(triCount));
+    if (!in || nodeCount > (1ull << 32) || triCount > (1ull << 32))
+        return false;
+
+    nodes.resize((size_t)nodeCount);
+    triangles.resize((size_t)triCount);
+    if (nodeCount)
+        in.read((char *)nodes.data(), nodeCount * sizeof(BVHNode4));
+    if (triCount)
+        in.read((char *)triangles.data(), triCount * sizeof(BVHTriangle));
+
+    if (!in)
+    {
+        nodes.clear();
+        triangles.clear();
+        return false;
+    }
+    depth = treeDepth(nodes);
+    return true;
+}
+
+uint64_t hashGeometry(const glm::vec3 *positions, size_t positionStride, size_t vertexCount,
+                      const uint32_t *indices, size_t indexCount)
+{
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void *data, size_t size)
+    {
+        const unsigned char *p = (const unsigned char *)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+
+    mix(&vertexCount, sizeof(vertexCount));
+    mix(&indexCount,  sizeof(indexCount));
+    for (size_t i = 0; i < vertexCount; i++)
+        mix((const char *)positions + i * positionStride, sizeof(glm::vec3));
+    mix(indices, indexCount * sizeof(uint32_t));
+
+    return h;
+}
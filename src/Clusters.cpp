@@ -0,0 +1,209 @@
+#include <Clusters.hpp>
+
+#include <Parallel.hpp>
+#include <Profiler.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+ClusterGrid::ClusterGrid()
+    : zNear(0.1f), zFar(100.0f)
+{
+    grid.assign(2 * COUNT, 0);
+    sliceIndices.resize(SLICES);
+    cellOffsets.resize(COUNT);
+}
+
+float ClusterGrid::sliceScale() const
+{
+    return (float)SLICES / std::log(zFar / zNear);
+}
+
+float ClusterGrid::sliceBias() const
+{
+    return (float)SLICES * std::log(zNear) / std::log(zFar / zNear);
+}
+
+void ClusterGrid::build(const glm::mat4& view, const glm::mat4& proj, float n, float f,
+                        const glm::vec3 *positions, const float *radii, size_t count)
+{
+    PROFILE_ZONE("ClusterGrid::build");
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    zNear = n;
+    zFar  = f;
+
+    const float scale = sliceScale();
+    const float bias  = sliceBias();
+
+    // tile boundaries are planes through the eye, x = a * -z with a running over the ndc range
+    const float tanX = 1.0f / proj[0][0];
+    const float tanY = 1.0f / proj[1][1];
+
+    float ax[TILES_X + 1], nx[TILES_X + 1];
+    float ay[TILES_Y + 1], ny[TILES_Y + 1];
+    for (int i = 0; i <= TILES_X; i++)
+    {
+        ax[i] = (-1.0f + 2.0f * (float)i / (float)TILES_X) * tanX;
+        nx[i] = 1.0f / std::sqrt(1.0f + ax[i] * ax[i]);
+    }
+    for (int i = 0; i <= TILES_Y; i++)
+    {
+        ay[i] = (-1.0f + 2.0f * (float)i / (float)TILES_Y) * tanY;
+        ny[i] = 1.0f / std::sqrt(1.0f + ay[i] * ay[i]);
+    }
+
+    auto sliceOf = [&](float depth) {
+        int s = (int)std::floor(std::log(depth) * scale - bias);
+        return std::min(std::max(s, 0), SLICES - 1);
+    };
+
+    ranges.resize(count);
+
+    // cluster ranges of every light
+    parallelFor(count, 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            Range&    r = ranges[i];
+            glm::vec3 c = glm::vec3(view * glm::vec4(positions[i], 1.0f));
+            float     radius = radii[i];
+
+            r.x0 = 1; r.x1 = 0;
+
+            if (radius >= FLT_MAX)
+            {
+                r.x0 = 0; r.x1 = TILES_X - 1;
+                r.y0 = 0; r.y1 = TILES_Y - 1;
+                r.z0 = 0; r.z1 = SLICES - 1;
+                continue;
+            }
+
+            float depth = -c.z;
+            if (depth + radius < zNear || depth - radius > zFar)
+                continue;
+
+            r.z0 = (int16_t)sliceOf(std::max(depth - radius, zNear));
+            r.z1 = (int16_t)sliceOf(std::min(depth + radius, zFar));
+
+            // a column is touched if the sphere is not completely left of its left plane
+            // and not completely right of its right plane
+            int x0 = TILES_X, x1 = -1;
+            for (int t = 0; t < TILES_X; t++)
+            {
+                float left  = (c.x + ax[t]     * c.z) * nx[t];
+                float right = (c.x + ax[t + 1] * c.z) * nx[t + 1];
+                if (left >= -radius && right <= radius)
+                {
+                    x0 = std::min(x0, t);
+                    x1 = t;
+                }
+            }
+
+            int y0 = TILES_Y, y1 = -1;
+            for (int t = 0; t < TILES_Y; t++)
+            {
+                float bottom = (c.y + ay[t]     * c.z) * ny[t];
+                float top    = (c.y + ay[t + 1] * c.z) * ny[t + 1];
+                if (bottom >= -radius && top <= radius)
+                {
+                    y0 = std::min(y0, t);
+                    y1 = t;
+                }
+            }
+
+            if (x0 > x1 || y0 > y1)
+                continue;
+
+            r.x0 = (int16_t)x0; r.x1 = (int16_t)x1;
+            r.y0 = (int16_t)y0; r.y1 = (int16_t)y1;
+        }
+    });
+
+    // every slice builds its own lists, counting first so each list is written exactly once
+    const int cellsPerSlice = TILES_X * TILES_Y;
+
+    parallelFor(SLICES, 1, [&](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; z++)
+        {
+            uint32_t *offsets = &cellOffsets[z * cellsPerSlice];
+            std::fill(offsets, offsets + cellsPerSlice, 0u);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const Range& r = ranges[i];
+                if (r.x0 > r.x1 || (int)z < r.z0 || (int)z > r.z1)
+                    continue;
+                for (int y = r.y0; y <= r.y1; y++)
+                    for (int x = r.x0; x <= r.x1; x++)
+                        offsets[x + y * TILES_X]++;
+            }
+
+            uint32_t *cells = &grid[2 * z * cellsPerSlice];
+            uint32_t  total = 0;
+            for (int c = 0; c < cellsPerSlice; c++)
+            {
+                cells[2 * c]     = total;
+                cells[2 * c + 1] = offsets[c];
+                total           += offsets[c];
+                offsets[c]       = cells[2 * c];
+            }
+
+            std::vector<uint32_t>& list = sliceIndices[z];
+            list.resize(total);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const Range& r = ranges[i];
+                if (r.x0 > r.x1 || (int)z < r.z0 || (int)z > r.z1)
+                    continue;
+                for (int y = r.y0; y <= r.y1; y++)
+                    for (int x = r.x0; x <= r.x1; x++)
+                        list[offsets[x + y * TILES_X]++] = (uint32_t)i;
+            }
+        }
+    });
+
+    // glue the slices together
+    uint32_t base = 0;
+    maxPerCluster = 0;
+    for (int z = 0; z < SLICES; z++)
+    {
+        uint32_t *cells = &grid[2 * z * cellsPerSlice];
+        for (int c = 0; c < cellsPerSlice; c++)
+        {
+            cells[2 * c] += base;
+            maxPerCluster = std::max(maxPerCluster, cells[2 * c + 1]);
+        }
+        base += (uint32_t)sliceIndices[z].size();
+    }
+
+    indices.resize(base);
+    base = 0;
+    for (int z = 0; z < SLICES; z++)
+    {
+        std::copy(sliceIndices[z].begin(), sliceIndices[z].end(), indices.begin() + base);
+        base += (uint32_t)sliceIndices[z].size();
+    }
+
+    lightCount = (uint32_t)count;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    buildTime = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+float lightRadius(float constant, float linear, float quadratic, float intensity, float threshold)
+{
+    // solve c + l*d + q*d^2 = intensity / threshold for d
+    float target = intensity / threshold;
+    if (target <= constant)
+        return 0.0f;
+
+    if (quadratic > 0.0f)
+        return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * (constant - target))) / (2.0f * quadratic);
+    if (linear > 0.0f)
+        return (target - constant) / linear;
+    return FLT_MAX;
+}
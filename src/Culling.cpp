@@ -0,0 +1,394 @@
+#include <Culling.hpp>
+#include <Simd.hpp>
+#include <Parallel.hpp>
+
+#include <cmath>
+#include <atomic>
+
+AABB AABB::transformed(const glm::mat4& m) const
+{
+    glm::vec3 c = center();
+    glm::vec3 e = extents();
+
+    glm::vec3 wc = glm::vec3(m * glm::vec4(c, 1.0f));
+    glm::vec3 we;
+
+    // extent along each world axis is the sum of the abs of the rotated extents
+    we.x = std::abs(m[0][0]) * e.x + std::abs(m[1][0]) * e.y + std::abs(m[2][0]) * e.z;
+    we.y = std::abs(m[0][1]) * e.x + std::abs(m[1][1]) * e.y + std::abs(m[2][1]) * e.z;
+    we.z = std::abs(m[0][2]) * e.x + std::abs(m[1][2]) * e.y + std::abs(m[2][2]) * e.z;
+
+    return AABB(wc - we, wc + we);
+}
+
+BoundingSphere sphereFromAABB(const AABB& box)
+{
+    BoundingSphere s;
+    s.center = box.center();
+    s.radius = glm::length(box.extents());
+    return s;
+}
+
+void Frustum::extract(const glm::mat4& m)
+{
+    // glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;    // left
+    planes[1] = row3 - row0;    // right
+    planes[2] = row3 + row1;    // bottom
+    planes[3] = row3 - row1;    // top
+    planes[4] = row3 + row2;    // near
+    planes[5] = row3 - row2;    // far
+
+    for (int i = 0; i < 6; i++)
+    {
+        float len = glm::length(glm::vec3(planes[i]));
+        planes[i] /= len;
+    }
+}
+
+bool Frustum::testAABB(const AABB& box) const
+{
+    glm::vec3 c = box.center();
+    glm::vec3 e = box.extents();
+
+    for (int i = 0; i < 6; i++)
+    {
+        const glm::vec4& p = planes[i];
+        float d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+        float r = std::abs(p.x) * e.x + std::abs(p.y) * e.y + std::abs(p.z) * e.z;
+        if (d + r < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::testSphere(const glm::vec3& center, float radius) const
+{
+    for (int i = 0; i < 6; i++)
+    {
+        const glm::vec4& p = planes[i];
+        if (p.x * center.x + p.y * center.y + p.z * center.z + p.w + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void CullBatch::clear()
+{
+    cx.clear(); cy.clear(); cz.clear();
+    ex.clear(); ey.clear(); ez.clear();
+    visible.clear();
+}
+
+void CullBatch::reserve(size_t n)
+{
+    cx.reserve(n); cy.reserve(n); cz.reserve(n);
+    ex.reserve(n); ey.reserve(n); ez.reserve(n);
+    visible.reserve(n);
+}
+
+size_t CullBatch::addAABB(const AABB& box)
+{
+    glm::vec3 c = box.center();
+    glm::vec3 e = box.extents();
+
+    cx.push_back(c.x); cy.push_back(c.y); cz.push_back(c.z);
+    ex.push_back(e.x); ey.push_back(e.y); ez.push_back(e.z);
+    visible.push_back(1);
+
+    return cx.size() - 1;
+}
+
+size_t CullBatch::addSphere(const glm::vec3& center, float radius)
+{
+    cx.push_back(center.x); cy.push_back(center.y); cz.push_back(center.z);
+    ex.push_back(radius);   ey.push_back(0.0f);     ez.push_back(0.0f);
+    visible.push_back(1);
+
+    return cx.size() - 1;
+}
+
+/*------------------------------------- scalar -------------------------------------*/
+
+static size_t cullAABBsScalar(const Frustum& f, CullBatch& b, size_t begin, size_t end)
+{
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        uint8_t vis = 1;
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& pl = f.planes[p];
+            float d = pl.x * b.cx[i] + pl.y * b.cy[i] + pl.z * b.cz[i] + pl.w;
+            float r = std::abs(pl.x) * b.ex[i] + std::abs(pl.y) * b.ey[i] + std::abs(pl.z) * b.ez[i];
+            if (d + r < 0.0f) { vis = 0; break; }
+        }
+        b.visible[i] = vis;
+        count += vis;
+    }
+    return count;
+}
+
+static size_t cullSpheresScalar(const Frustum& f, CullBatch& b, size_t begin, size_t end)
+{
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        uint8_t vis = 1;
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& pl = f.planes[p];
+            if (pl.x * b.cx[i] + pl.y * b.cy[i] + pl.z * b.cz[i] + pl.w + b.ex[i] < 0.0f) { vis = 0; break; }
+        }
+        b.visible[i] = vis;
+        count += vis;
+    }
+    return count;
+}
+
+#if SIMD_X86
+
+/*------------------------------------- SSE (4 wide) -------------------------------------*/
+
+static size_t cullAABBsSSE(const Frustum& f, CullBatch& b, size_t begin, size_t end)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero     = _mm_setzero_ps();
+
+    size_t n     = begin + ((end - begin) & ~size_t(3));
+    size_t count = 0;
+
+    for (size_t i = begin; i < n; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&b.cx[i]);
+        __m128 cy = _mm_loadu_ps(&b.cy[i]);
+        __m128 cz = _mm_loadu_ps(&b.cz[i]);
+        __m128 ex = _mm_loadu_ps(&b.ex[i]);
+        __m128 ey = _mm_loadu_ps(&b.ey[i]);
+        __m128 ez = _mm_loadu_ps(&b.ez[i]);
+
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& pl = f.planes[p];
+            __m128 nx = _mm_set1_ps(pl.x);
+            __m128 ny = _mm_set1_ps(pl.y);
+            __m128 nz = _mm_set1_ps(pl.z);
+
+            // d = n.c + w
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+                                  _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(pl.w)));
+            // r = |n|.e
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex),
+                                             _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+                                  _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; k++)
+        {
+            uint8_t vis = (uint8_t)(((mask >> k) & 1) ^ 1);
+            b.visible[i + k] = vis;
+            count += vis;
+        }
+    }
+
+    return count + cullAABBsScalar(f, b, n, end);
+}
+
+static size_t cullSpheresSSE(const Frustum& f, CullBatch& b, size_t begin, size_t end)
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t n     = begin + ((end - begin) & ~size_t(3));
+    size_t count = 0;
+
+    for (size_t i = begin; i < n; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&b.cx[i]);
+        __m128 cy = _mm_loadu_ps(&b.cy[i]);
+        __m128 cz = _mm_loadu_ps(&b.cz[i]);
+        __m128 r  = _mm_loadu_ps(&b.ex[i]);
+
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& pl = f.planes[p];
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.x), cx), _mm_mul_ps(_mm_set1_ps(pl.y), cy)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.z), cz), _mm_set1_ps(pl.w)));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; k++)
+        {
+            uint8_t vis = (uint8_t)(((mask >> k) & 1) ^ 1);
+            b.visible[i + k] = vis;
+            count += vis;
+        }
+    }
+
+    return count + cullSpheresScalar(f, b, n, end);
+}
+
+/*------------------------------------- AVX2 (8 wide) -------------------------------------*/
+
+// a * b + c, kept as mul/add so we only depend on AVX2 and not FMA
+SIMD_TARGET_AVX2
+static inline __m256 madd8(__m256 a, __m256 b, __m256 c)
+{
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+
+SIMD_TARGET_AVX2
+static size_t cullAABBsAVX2(const Frustum& f, CullBatch& b, size_t begin, size_t end)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    size_t n     = begin + ((end - begin) & ~size_t(7));
+    size_t count = 0;
+
+    for (size_t i = begin; i < n; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(&b.cx[i]);
+        __m256 cy = _mm256_loadu_ps(&b.cy[i]);
+        __m256 cz = _mm256_loadu_ps(&b.cz[i]);
+        __m256 ex = _mm256_loadu_ps(&b.ex[i]);
+        __m256 ey = _mm256_loadu_ps(&b.ey[i]);
+        __m256 ez = _mm256_loadu_ps(&b.ez[i]);
+
+        __m256 outside = _mm256_setzero_ps();
+
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& pl = f.planes[p];
+            __m256 nx = _mm256_set1_ps(pl.x);
+            __m256 ny = _mm256_set1_ps(pl.y);
+            __m256 nz = _mm256_set1_ps(pl.z);
+
+            __m256 d = madd8(nx, cx, madd8(ny, cy, madd8(nz, cz, _mm256_set1_ps(pl.w))));
+            __m256 r = madd8(_mm256_andnot_ps(signMask, nx), ex,
+                       madd8(_mm256_andnot_ps(signMask, ny), ey,
+                       _mm256_mul_ps(_mm256_andnot_ps(signMask, nz), ez)));
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(outside);
+        for (int k = 0; k < 8; k++)
+        {
+            uint8_t vis = (uint8_t)(((mask >> k) & 1) ^ 1);
+            b.visible[i + k] = vis;
+            count += vis;
+        }
+    }
+
+    // GCC leaves out vzeroupper in target("avx2") functions, dirty upper halves slow down
+    // every SSE instruction after us (and threads started from here inherit them)
+    _mm256_zeroupper();
+    return count + cullAABBsScalar(f, b, n, end);
+}
+
+SIMD_TARGET_AVX2
+static size_t cullSpheresAVX2(const Frustum& f, CullBatch& b, size_t begin, size_t end)
+{
+    size_t n     = begin + ((end - begin) & ~size_t(7));
+    size_t count = 0;
+
+    for (size_t i = begin; i < n; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(&b.cx[i]);
+        __m256 cy = _mm256_loadu_ps(&b.cy[i]);
+        __m256 cz = _mm256_loadu_ps(&b.cz[i]);
+        __m256 r  = _mm256_loadu_ps(&b.ex[i]);
+
+        __m256 outside = _mm256_setzero_ps();
+
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4& pl = f.planes[p];
+            __m256 d = madd8(_mm256_set1_ps(pl.x), cx,
+                       madd8(_mm256_set1_ps(pl.y), cy,
+                       madd8(_mm256_set1_ps(pl.z), cz, _mm256_set1_ps(pl.w))));
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(outside);
+        for (int k = 0; k < 8; k++)
+        {
+            uint8_t vis = (uint8_t)(((mask >> k) & 1) ^ 1);
+            b.visible[i + k] = vis;
+            count += vis;
+        }
+    }
+
+    _mm256_zeroupper();
+    return count + cullSpheresScalar(f, b, n, end);
+}
+
+#endif // SIMD_X86
+
+static size_t cullAABBsRange(const Frustum& frustum, CullBatch& batch, size_t begin, size_t end)
+{
+#if SIMD_X86
+    if (cpuHasAVX2())
+        return cullAABBsAVX2(frustum, batch, begin, end);
+    return cullAABBsSSE(frustum, batch, begin, end);
+#else
+    return cullAABBsScalar(frustum, batch, begin, end);
+#endif
+}
+
+static size_t cullSpheresRange(const Frustum& frustum, CullBatch& batch, size_t begin, size_t end)
+{
+#if SIMD_X86
+    if (cpuHasAVX2())
+        return cullSpheresAVX2(frustum, batch, begin, end);
+    return cullSpheresSSE(frustum, batch, begin, end);
+#else
+    return cullSpheresScalar(frustum, batch, begin, end);
+#endif
+}
+
+// a few thousand boxes are a couple of microseconds, anything less isn't worth a job
+static const size_t CULL_GRAIN = 4096;
+
+size_t cullAABBs(const Frustum& frustum, CullBatch& batch)
+{
+    std::atomic<size_t> visible(0);
+    parallelFor(batch.size(), CULL_GRAIN, [&](size_t begin, size_t end)
+    {
+        visible.fetch_add(cullAABBsRange(frustum, batch, begin, end), std::memory_order_relaxed);
+    });
+    return visible.load();
+}
+
+size_t cullSpheres(const Frustum& frustum, CullBatch& batch)
+{
+    std::atomic<size_t> visible(0);
+    parallelFor(batch.size(), CULL_GRAIN, [&](size_t begin, size_t end)
+    {
+        visible.fetch_add(cullSpheresRange(frustum, batch, begin, end), std::memory_order_relaxed);
+    });
+    return visible.load();
+}
+
+const char *cullBackendName()
+{
+#if SIMD_X86
+    return cpuHasAVX2() ? "AVX2" : "SSE";
+#else
+    return "scalar";
+#endif
+}
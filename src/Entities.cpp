@@ -0,0 +1,352 @@
+#include <Entities.hpp>
+#include <Parallel.hpp>
+
+#include <cassert>
+#include <utility>
+
+namespace
+{
+    // moves the last element into slot and drops the last one, for every column
+    template<typename... Columns>
+    void swapRemove(uint32_t slot, Columns&... columns)
+    {
+        ((columns[slot] = std::move(columns.back()), columns.pop_back()), ...);
+    }
+
+    template<typename... Columns>
+    void reserveAll(size_t n, Columns&... columns)
+    {
+        (columns.reserve(n), ...);
+    }
+
+    // removes an entity from one table and patches the slot of the entity that took its place
+    template<typename Table, typename Remove>
+    void removeFrom(Table& table, std::vector<uint32_t>& slots, Entity e, Remove remove)
+    {
+        uint32_t slot = slots[e];
+        if (slot == NO_SLOT)
+            return;
+
+        Entity last = table.entity.back();
+        remove(slot);
+        if (last != e)
+            slots[last] = slot;
+        slots[e] = NO_SLOT;
+    }
+}
+
+Entity EntityStore::create(uint32_t l)
+{
+    if (!freeList.empty())
+    {
+        Entity e = freeList.back();
+        freeList.pop_back();
+        alive[e] = 1;
+        layer[e] = l;
+        return e;
+    }
+
+    Entity e = (Entity)alive.size();
+    alive.push_back(1);
+    layer.push_back(l);
+    transformSlot.push_back(NO_SLOT);
+    renderableSlot.push_back(NO_SLOT);
+    lightSlot.push_back(NO_SLOT);
+    boundsSlot.push_back(NO_SLOT);
+    return e;
+}
+
+void EntityStore::destroy(Entity e)
+{
+    assert(e < alive.size() && alive[e]);
+
+    TransformComponents& t = transforms;
+    removeFrom(t, transformSlot, e, [&](uint32_t s) {
+        swapRemove(s, t.entity, t.node, t.position, t.rotation, t.scale, t.changed);
+    });
+
+    RenderableComponents& r = renderables;
+    removeFrom(r, renderableSlot, e, [&](uint32_t s) {
+        swapRemove(s, r.entity, r.node, r.mesh, r.material, r.occluder, r.visible);
+    });
+
+    LightComponents& l = lights;
+    removeFrom(l, lightSlot, e, [&](uint32_t s) {
+        swapRemove(s, l.entity, l.node, l.type, l.position, l.direction, l.color, l.ambient, l.diffuse,
+                   l.specular, l.constant, l.linear, l.quadratic, l.cutoff, l.outerCutoff);
+    });
+
+    BoundsComponents& b = bounds;
+    removeFrom(b, boundsSlot, e, [&](uint32_t s) {
+        swapRemove(s, b.entity, b.node, b.local, b.stale,
+                   b.world.cx, b.world.cy, b.world.cz, b.world.ex, b.world.ey, b.world.ez, b.world.visible);
+    });
+
+    alive[e] = 0;
+    layer[e] = 0;
+    freeList.push_back(e);
+}
+
+void EntityStore::clear()
+{
+    *this = EntityStore();
+}
+
+void EntityStore::reserve(size_t n)
+{
+    reserveAll(n, alive, layer, transformSlot, renderableSlot, lightSlot, boundsSlot);
+
+    TransformComponents& t = transforms;
+    reserveAll(n, t.entity, t.node, t.position, t.rotation, t.scale, t.changed);
+
+    RenderableComponents& r = renderables;
+    reserveAll(n, r.entity, r.node, r.mesh, r.material, r.occluder, r.visible);
+
+    LightComponents& l = lights;
+    reserveAll(n, l.entity, l.node, l.type, l.position, l.direction, l.color, l.ambient, l.diffuse, l.specular);
+    reserveAll(n, l.constant, l.linear, l.quadratic, l.cutoff, l.outerCutoff);
+
+    BoundsComponents& b = bounds;
+    reserveAll(n, b.entity, b.node, b.local, b.stale);
+    b.world.reserve(n);
+}
+
+void EntityStore::addTransform(Entity e, int32_t node, const glm::vec3& p, const glm::quat& q, const glm::vec3& s)
+{
+    assert(transformSlot[e] == NO_SLOT);
+
+    transformSlot[e] = (uint32_t)transforms.size();
+    transforms.entity.push_back(e);
+    transforms.node.push_back(node);
+    transforms.position.push_back(p);
+    transforms.rotation.push_back(q);
+    transforms.scale.push_back(s);
+    transforms.changed.push_back(1);
+}
+
+void EntityStore::addRenderable(Entity e, int32_t node, uint32_t mesh, uint32_t material, bool occluder)
+{
+    assert(renderableSlot[e] == NO_SLOT);
+
+    renderableSlot[e] = (uint32_t)renderables.size();
+    renderables.entity.push_back(e);
+    renderables.node.push_back(node);
+    renderables.mesh.push_back(mesh);
+    renderables.material.push_back(material);
+    renderables.occluder.push_back(occluder);
+    renderables.visible.push_back(1);
+}
+
+void EntityStore::addLight(Entity e, LightType type, int32_t node)
+{
+    assert(lightSlot[e] == NO_SLOT);
+
+    lightSlot[e] = (uint32_t)lights.size();
+    lights.entity.push_back(e);
+    lights.node.push_back(node);
+    lights.type.push_back(type);
+    lights.position.push_back(glm::vec3(0.0f));
+    lights.direction.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+    lights.color.push_back(glm::vec3(1.0f));
+    lights.ambient.push_back(glm::vec3(0.2f));
+    lights.diffuse.push_back(glm::vec3(0.5f));
+    lights.specular.push_back(glm::vec3(0.5f));
+    lights.constant.push_back(1.0f);
+    lights.linear.push_back(0.09f);
+    lights.quadratic.push_back(0.032f);
+    lights.cutoff.push_back(glm::cos(glm::radians(12.5f)));
+    lights.outerCutoff.push_back(glm::cos(glm::radians(19.5f)));
+}
+
+void EntityStore::addBounds(Entity e, int32_t node, const AABB& local)
+{
+    assert(boundsSlot[e] == NO_SLOT);
+
+    boundsSlot[e] = (uint32_t)bounds.size();
+    bounds.entity.push_back(e);
+    bounds.node.push_back(node);
+    bounds.local.push_back(local);
+    bounds.stale.push_back(1);
+    bounds.world.addAABB(AABB(glm::vec3(0.0f), glm::vec3(0.0f)));
+}
+
+void EntityStore::setPosition(Entity e, const glm::vec3& p)
+{
+    uint32_t s = transformSlot[e];
+    if (transforms.position[s] != p)
+    {
+        transforms.position[s] = p;
+        transforms.changed[s]  = 1;
+    }
+}
+
+void EntityStore::setRotation(Entity e, const glm::quat& q)
+{
+    uint32_t s = transformSlot[e];
+    if (transforms.rotation[s] != q)
+    {
+        transforms.rotation[s] = q;
+        transforms.changed[s]  = 1;
+    }
+}
+
+void EntityStore::setScale(Entity e, const glm::vec3& v)
+{
+    uint32_t s = transformSlot[e];
+    if (transforms.scale[s] != v)
+    {
+        transforms.scale[s]   = v;
+        transforms.changed[s] = 1;
+    }
+}
+
+void EntityStore::setLightColor(Entity e, const glm::vec3& c)
+{
+    uint32_t s = lightSlot[e];
+    lights.color[s]   = c;
+    lights.diffuse[s] = c * glm::vec3(0.5f);
+    lights.ambient[s] = lights.diffuse[s] * glm::vec3(0.2f);
+}
+
+void EntityStore::writeTransforms(SceneGraph& graph)
+{
+    size_t n = transforms.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!transforms.changed[i])
+            continue;
+        transforms.changed[i] = 0;
+
+        // translate * rotate * scale without the generic matrix products
+        glm::mat3 r = glm::mat3_cast(transforms.rotation[i]);
+        glm::vec3 s = transforms.scale[i];
+        glm::mat4 m(glm::vec4(r[0] * s.x, 0.0f),
+                    glm::vec4(r[1] * s.y, 0.0f),
+                    glm::vec4(r[2] * s.z, 0.0f),
+                    glm::vec4(transforms.position[i], 1.0f));
+
+        graph.setLocal(transforms.node[i], m);
+    }
+}
+
+void EntityStore::updateBounds(const SceneGraph& graph)
+{
+    CullBatch& w = bounds.world;
+
+    // every box only reads its own node, thousands per job
+    parallelFor(bounds.size(), 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            int32_t node = bounds.node[i];
+            if (!bounds.stale[i] && !graph.changed[node])
+                continue;
+            bounds.stale[i] = 0;
+
+            AABB      box = bounds.local[i].transformed(graph.world[node]);
+            glm::vec3 c   = box.center();
+            glm::vec3 e   = box.extents();
+
+            w.cx[i] = c.x; w.cy[i] = c.y; w.cz[i] = c.z;
+            w.ex[i] = e.x; w.ey[i] = e.y; w.ez[i] = e.z;
+        }
+    });
+}
+
+void EntityStore::updateLights(const SceneGraph& graph)
+{
+    size_t n = lights.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        int32_t node = lights.node[i];
+        if (node >= 0)
+            lights.position[i] = glm::vec3(graph.world[node][3]);
+    }
+}
+
+size_t EntityStore::cull(const Frustum& frustum, uint32_t layers, const std::vector<uint8_t> *nodeVisible)
+{
+    candidates.clear();
+    batch.clear();
+
+    // only the layer bits and the boxes themselves are read here
+    size_t     n = bounds.size();
+    CullBatch& w = bounds.world;
+    for (size_t i = 0; i < n; i++)
+    {
+        w.visible[i] = 0;
+        if (!(layer[bounds.entity[i]] & layers))
+            continue;
+        if (nodeVisible && !(*nodeVisible)[bounds.node[i]])
+            continue;
+
+        candidates.push_back((uint32_t)i);
+        batch.cx.push_back(w.cx[i]); batch.cy.push_back(w.cy[i]); batch.cz.push_back(w.cz[i]);
+        batch.ex.push_back(w.ex[i]); batch.ey.push_back(w.ey[i]); batch.ez.push_back(w.ez[i]);
+        batch.visible.push_back(0);
+    }
+
+    size_t visible = cullAABBs(frustum, batch);
+
+    for (size_t k = 0; k < candidates.size(); k++)
+        w.visible[candidates[k]] = batch.visible[k];
+
+    return visible;
+}
+
+size_t EntityStore::markVisible(uint32_t layers)
+{
+    size_t visible = 0;
+    size_t n       = bounds.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        uint8_t v = (layer[bounds.entity[i]] & layers) ? 1 : 0;
+        bounds.world.visible[i] = v;
+        visible += v;
+    }
+    return visible;
+}
+
+void EntityStore::resolveVisibility(uint32_t layers)
+{
+    size_t n = renderables.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        Entity e = renderables.entity[i];
+        if (!(layer[e] & layers))
+        {
+            renderables.visible[i] = 0;
+            continue;
+        }
+
+        uint32_t b = boundsSlot[e];
+        renderables.visible[i] = b == NO_SLOT ? 1 : bounds.world.visible[b];
+    }
+}
+
+size_t EntityStore::gatherLights(LightType type, uint32_t layers, std::vector<uint32_t>& slots) const
+{
+    slots.clear();
+
+    size_t n = lights.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        if (lights.type[i] == type && (layer[lights.entity[i]] & layers))
+            slots.push_back((uint32_t)i);
+    }
+    return slots.size();
+}
+
+void EntityStore::copyDrawState(EntityStore& to) const
+{
+    to.alive          = alive;
+    to.layer          = layer;
+    to.transformSlot  = transformSlot;
+    to.renderableSlot = renderableSlot;
+    to.lightSlot      = lightSlot;
+    to.boundsSlot     = boundsSlot;
+
+    to.transforms     = transforms;
+    to.renderables    = renderables;
+    to.lights         = lights;
+}
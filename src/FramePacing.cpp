@@ -0,0 +1,182 @@
+#include <FramePacing.hpp>
+
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+const char *pacingModeName(PacingMode mode)
+{
+    switch (mode)
+    {
+        case PACING_VSYNC:    return "vsync";
+        case PACING_UNCAPPED: return "uncapped";
+        case PACING_CAPPED:   return "capped";
+        case PACING_ADAPTIVE: return "adaptive vsync";
+        default:              return "?";
+    }
+}
+
+int FixedTimestep::advance(double deltaTime)
+{
+    if (step <= 0.0)
+        return 0;
+
+    accumulator += std::max(deltaTime, 0.0);
+    int count = (int)(accumulator / step);
+    accumulator -= count * step;
+
+    if (count > maxSteps)
+    {
+        dropped += (uint64_t)(count - maxSteps);
+        count    = maxSteps;
+    }
+    steps += (uint64_t)count;
+    return count;
+}
+
+double FramePacer::pace()
+{
+    int64_t now  = clock.now();
+    double  late = 0.0;
+
+    if (mode == PACING_CAPPED && targetFps > 0.0)
+    {
+        int64_t period = (int64_t)(1e9 / targetFps);
+
+        // on the first frame, or a whole frame behind, start over from now instead of
+        // rushing the next ones out to catch up
+        if (deadline == 0 || now > deadline + period)
+        {
+            deadline = now;
+        }
+        else if (now < deadline)
+        {
+            wait(deadline);
+            now = clock.now();
+        }
+        late      = (double)(now - deadline) * 1e-6;
+        deadline += period;
+    }
+    else
+    {
+        deadline = 0;
+    }
+
+    // the time spent waiting for events is not an interval between frames
+    resumed = wasIdle;
+    wasIdle = false;
+
+    if (lastFrame >= 0 && !resumed)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        intervals[count % WINDOW] = (double)(now - lastFrame) * 1e-6;
+        lateness[count % WINDOW]  = late;
+        count++;
+    }
+    lastFrame = now;
+
+    if (pendingFrames.load(std::memory_order_relaxed) > 0)
+        pendingFrames.fetch_sub(1, std::memory_order_relaxed);
+
+    return (double)now * 1e-9;
+}
+
+int FramePacer::addRedrawSource(const char *name)
+{
+    sources.push_back({ name, false });
+    return (int)sources.size() - 1;
+}
+
+void FramePacer::setRedrawSource(int source, bool active)
+{
+    if (sources[source].active == active)
+        return;
+
+    sources[source].active = active;
+    activeSources += active ? 1 : -1;
+
+    // the frame after the last one that moved still has to show where it stopped
+    if (!active)
+        markDirty();
+}
+
+bool FramePacer::idle()
+{
+    if (!onDemand || activeSources > 0 || pendingFrames.load(std::memory_order_relaxed) > 0)
+        return false;
+
+    wasIdle = true;
+    idleWaits++;
+    return true;
+}
+
+void FramePacer::wait(int64_t until)
+{
+    for (;;)
+    {
+        int64_t now  = clock.now();
+        int64_t left = until - now;
+        if (left <= 0)
+            return;
+
+        // a sleep wakes up late by up to a scheduler tick (15.6 ms on Windows at the default
+        // timer resolution), the margin grows to the worst one seen and decays back slowly
+        int64_t margin = (int64_t)(std::max(spinMargin, sleepSlack) * 1e9);
+        if (left > margin)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(left - margin));
+            double overslept = (double)(clock.now() - now - (left - margin)) * 1e-9;
+            sleepSlack = std::max(sleepSlack * 0.99, overslept);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+int FramePacer::swapInterval() const
+{
+    switch (mode)
+    {
+        case PACING_UNCAPPED:
+        case PACING_CAPPED:   return 0;
+        case PACING_ADAPTIVE: return tearControl ? -1 : 1;
+        default:              return 1;
+    }
+}
+
+FramePacer::Stats FramePacer::stats() const
+{
+    Stats s;
+    if (mode == PACING_CAPPED && targetFps > 0.0)
+        s.targetMs = 1000.0 / targetFps;
+    else if ((mode == PACING_VSYNC || mode == PACING_ADAPTIVE) && refreshRate > 0)
+        s.targetMs = 1000.0 / refreshRate;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    int n = (int)std::min<uint64_t>(count, WINDOW);
+    s.frames = count;
+    if (n == 0)
+        return s;
+
+    double sum = 0.0, late = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum  += intervals[i];
+        late += lateness[i];
+    }
+    s.meanMs = sum / n;
+    s.lateMs = late / n;
+
+    double reference = s.targetMs > 0.0 ? s.targetMs : s.meanMs;
+    double variance  = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        variance  += (intervals[i] - s.meanMs) * (intervals[i] - s.meanMs);
+        s.worstMs  = std::max(s.worstMs, std::abs(intervals[i] - reference));
+    }
+    s.jitterMs = std::sqrt(variance / n);
+    return s;
+}
@@ -0,0 +1,229 @@
+#include <FrameStats.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+FrameStats::FrameStats()
+{
+    std::fill(times, times + WINDOW, 0.0f);
+    bins.assign(HISTOGRAM_BINS, 0);
+    sections.reserve(MAX_SECTIONS);
+    lastSections.reserve(MAX_SECTIONS);
+    hitches.resize(MAX_HITCHES);
+    sorted.reserve(WINDOW);
+}
+
+void FrameStats::frame()
+{
+    Clock::time_point now = Clock::now();
+    if (!started)
+    {
+        std::lock_guard<std::mutex> lock(sectionMutex);
+        started    = true;
+        frameStart = now;
+        sections.clear();
+        return;
+    }
+
+    float ms   = std::chrono::duration<float, std::milli>(now - frameStart).count();
+    frameStart = now;
+
+    std::lock_guard<std::mutex> lock(sectionMutex);
+
+    // the median the frame is judged against does not include the frame itself
+    bool hitch = frames >= (uint64_t)WARMUP && ms > hitchFactor * window.p50;
+    if (hitch)
+    {
+        Hitch& h   = hitches[hitchCount % MAX_HITCHES];
+        h.frame    = frames;
+        h.ms       = ms;
+        h.median   = window.p50;
+        h.sections = sections;
+        hitchCount++;
+    }
+
+    times[frames % WINDOW] = ms;
+    frames++;
+
+    updateWindow();
+    updateSession(ms);
+
+    lastSections.swap(sections);
+    sections.clear();
+}
+
+void FrameStats::resume()
+{
+    std::lock_guard<std::mutex> lock(sectionMutex);
+    started = false;
+    sections.clear();
+}
+
+void FrameStats::addSection(const char *name, float ms)
+{
+    std::lock_guard<std::mutex> lock(sectionMutex);
+
+    for (size_t i = 0; i < sections.size(); i++)
+    {
+        if (sections[i].name == name || std::strcmp(sections[i].name, name) == 0)
+        {
+            sections[i].ms += ms;
+            return;
+        }
+    }
+
+    if (sections.size() < (size_t)MAX_SECTIONS)
+        sections.push_back({ name, ms });
+}
+
+void FrameStats::updateWindow()
+{
+    size_t n = (size_t)std::min<uint64_t>(frames, WINDOW);
+
+    sorted.assign(times, times + n);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++)
+        sum += sorted[i];
+
+    // nearest rank
+    auto rank = [&](double p) { return sorted[std::min(n - 1, (size_t)(p * (double)n))]; };
+
+    window.frames = n;
+    window.mean   = (float)(sum / (double)n);
+    window.p50    = rank(0.50);
+    window.p95    = rank(0.95);
+    window.p99    = rank(0.99);
+    window.max    = sorted[n - 1];
+}
+
+void FrameStats::updateSession(float ms)
+{
+    int bin = std::min(HISTOGRAM_BINS - 1, (int)(ms / BIN_MS));
+    bins[bin]++;
+    sessionSum += ms;
+
+    session.frames = frames;
+    session.mean   = (float)(sessionSum / (double)frames);
+    session.p50    = sessionPercentile(0.50);
+    session.p95    = sessionPercentile(0.95);
+    session.p99    = sessionPercentile(0.99);
+    session.max    = std::max(session.max, ms);
+}
+
+// upper edge of the bin the percentile falls in, so it is never optimistic by more than a bin
+float FrameStats::sessionPercentile(double p) const
+{
+    uint64_t target = (uint64_t)(p * (double)frames);
+    uint64_t seen   = 0;
+    for (int i = 0; i < HISTOGRAM_BINS; i++)
+    {
+        seen += bins[i];
+        if (seen > target)
+            return (float)(i + 1) * BIN_MS;
+    }
+    return (float)HISTOGRAM_BINS * BIN_MS;
+}
+
+void FrameStats::history(std::vector<float>& out) const
+{
+    size_t n = (size_t)std::min<uint64_t>(frames, WINDOW);
+    out.resize(n);
+    for (size_t i = 0; i < n; i++)
+        out[i] = times[(frames - n + i) % WINDOW];
+}
+
+void FrameStats::histogram(std::vector<float>& out, int count, float range) const
+{
+    out.assign(count, 0.0f);
+
+    size_t n = (size_t)std::min<uint64_t>(frames, WINDOW);
+    for (size_t i = 0; i < n; i++)
+    {
+        int b = std::min(count - 1, (int)(times[i] / range * (float)count));
+        out[b] += 1.0f;
+    }
+}
+
+bool FrameStats::exportCsv(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::FRAME_STATS::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+
+    // one row per frame of the window, hitches carry their section breakdown
+    out << "frame,ms,hitch,sections\n";
+
+    size_t n = (size_t)std::min<uint64_t>(frames, WINDOW);
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t f = frames - n + i;
+        out << f << "," << times[f % WINDOW] << ",";
+
+        const Hitch *h = nullptr;
+        for (uint64_t k = hitchCount > MAX_HITCHES ? hitchCount - MAX_HITCHES : 0; k < hitchCount; k++)
+        {
+            if (hitch(k).frame == f)
+                h = &hitch(k);
+        }
+
+        out << (h ? 1 : 0) << ",";
+        if (h)
+        {
+            out << "\"";
+            for (size_t s = 0; s < h->sections.size(); s++)
+                out << (s ? ";" : "") << h->sections[s].name << "=" << h->sections[s].ms;
+            out << "\"";
+        }
+        out << "\n";
+    }
+
+    std::cout << "Wrote frame stats : " << path << std::endl;
+    return true;
+}
+
+static void writeSummary(std::ofstream& out, const char *name, const FrameStats::Summary& s)
+{
+    out << "  \"" << name << "\": {\"frames\": " << s.frames
+        << ", \"mean_ms\": " << s.mean
+        << ", \"p50_ms\": " << s.p50
+        << ", \"p95_ms\": " << s.p95
+        << ", \"p99_ms\": " << s.p99
+        << ", \"max_ms\": " << s.max << "},\n";
+}
+
+bool FrameStats::exportJson(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "ERROR::FRAME_STATS::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+
+    out << "{\n  \"build\": \"" << __DATE__ << " " << __TIME__ << "\",\n";
+    out << "  \"hitch_factor\": " << hitchFactor << ",\n";
+    writeSummary(out, "session", session);
+    writeSummary(out, "window", window);
+
+    out << "  \"hitch_count\": " << hitchCount << ",\n  \"hitches\": [\n";
+    uint64_t first = hitchCount > MAX_HITCHES ? hitchCount - MAX_HITCHES : 0;
+    for (uint64_t k = first; k < hitchCount; k++)
+    {
+        const Hitch& h = hitch(k);
+        out << "    {\"frame\": " << h.frame << ", \"ms\": " << h.ms << ", \"median_ms\": " << h.median << ", \"sections\": {";
+        for (size_t s = 0; s < h.sections.size(); s++)
+            out << (s ? ", " : "") << "\"" << h.sections[s].name << "\": " << h.sections[s].ms;
+        out << "}}" << (k + 1 < hitchCount ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+
+    std::cout << "Wrote frame stats : " << path << std::endl;
+    return true;
+}
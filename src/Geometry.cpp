@@ -0,0 +1,160 @@
+#include <Geometry.hpp>
+
+#include <cmath>
+
+namespace
+{
+    const double PI = 3.14159265358979323846;
+}
+
+void convertMesh(const aiMesh *mesh, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, AABB& bounds)
+{
+    // the loader triangulates, three indices per face
+    vertices.reserve(vertices.size() + mesh->mNumVertices);
+    indices.reserve(indices.size() + (size_t)mesh->mNumFaces * 3);
+
+    // for all mesh vertices
+    for(size_t i = 0; i < mesh->mNumVertices; i++)
+    {
+        Vertex vertex;
+        glm::vec3 vector; 
+
+        // process vertex positions
+        vector.x = mesh->mVertices[i].x;
+        vector.y = mesh->mVertices[i].y;
+        vector.z = mesh->mVertices[i].z; 
+        vertex.Position = vector;
+        bounds.expand(vector);
+
+        // process vertex normals 
+        if(mesh->HasNormals())
+        {
+            vector.x = mesh->mNormals[i].x;
+            vector.y = mesh->mNormals[i].y;
+            vector.z = mesh->mNormals[i].z;
+            vertex.Normal = vector; 
+        }
+
+        // process vertex texture coordinates
+        if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+        {
+            glm::vec2 vec;
+            // a vertex can contain up to 8 different texture coordinates.
+            // We thus make the assumption that we won't use models where a vertex 
+            // can have multiple texture coordinates so we always take the first set (0).
+            vec.x = mesh->mTextureCoords[0][i].x; 
+            vec.y = mesh->mTextureCoords[0][i].y;
+            vertex.TexCoords = vec;
+            // tangent
+            vector.x = mesh->mTangents[i].x;
+            vector.y = mesh->mTangents[i].y;
+            vector.z = mesh->mTangents[i].z;
+            vertex.Tangent = vector;
+            // bitangent
+            vector.x = mesh->mBitangents[i].x;
+            vector.y = mesh->mBitangents[i].y;
+            vector.z = mesh->mBitangents[i].z;
+            vertex.Bitangent = vector;
+        }
+        else
+        {
+            vertex.TexCoords = glm::vec2(0.0f, 0.0f); 
+        }
+
+        // no influences, convertBoneWeights fills them for skinned meshes
+        for(int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            vertex.m_BoneIDs[k] = 0;
+            vertex.m_Weights[k] = 0.0f;
+        }
+
+        vertices.push_back(vertex);
+    }
+
+    // process indices
+    // for each of the mesh's faces (a face is a mesh its triangle), retrieve the corresponding vertex indices.
+    for(size_t i = 0; i < mesh->mNumFaces; i++)
+    {
+        // by reference, copying an aiFace allocates a copy of its index array
+        const aiFace& face = mesh->mFaces[i];
+
+        // retrieve all face indices
+        for(size_t j = 0; j < face.mNumIndices; j++){
+            indices.push_back(face.mIndices[j]);
+        }
+    } 
+}
+
+void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, int sectorCount, int stackCount)
+{
+    float x, y, z, xy;                              // vertex position
+    float nx, ny, nz, lengthInv = 1.0f / radius;    // vertex normal
+    float s, t;                                     // vertex texCoord
+
+    float sectorStep = (float)(2 * PI / sectorCount);
+    float stackStep = (float)(PI / stackCount);
+    float sectorAngle, stackAngle;
+
+    for (int i = 0; i <= stackCount; ++i)
+    {
+        stackAngle = (float)(PI / 2 - i * stackStep);      // starting from pi/2 to -pi/2
+        xy = radius * cosf(stackAngle);             // r * cos(u)
+        z = radius * sinf(stackAngle);              // r * sin(u)
+
+        // add (sectorCount+1) vertices per stack
+        // the first and last vertices have same position and normal, but different tex coords
+        for (int j = 0; j <= sectorCount; ++j)
+        {
+            sectorAngle = j * sectorStep;           // starting from 0 to 2pi
+
+            // vertex position (x, y, z)
+            x = xy * cosf(sectorAngle);             // r * cos(u) * cos(v)
+            y = xy * sinf(sectorAngle);             // r * cos(u) * sin(v)
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
+
+            // normalized vertex normal (nx, ny, nz)
+            nx = x * lengthInv;
+            ny = y * lengthInv;
+            nz = z * lengthInv;
+            vertices.push_back(nx);
+            vertices.push_back(ny);
+            vertices.push_back(nz);
+
+            // vertex tex coord (s, t) range between [0, 1]
+            s = (float)j / sectorCount;
+            t = (float)i / stackCount;
+            vertices.push_back(s);
+            vertices.push_back(t);
+        }
+    }
+
+    // generate CCW index list of sphere triangles
+    int k1, k2;
+    for (int i = 0; i < stackCount; ++i)
+    {
+        k1 = i * (sectorCount + 1);     // beginning of current stack
+        k2 = k1 + sectorCount + 1;      // beginning of next stack
+
+        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
+        {
+            // 2 triangles per sector excluding first and last stacks
+            // k1 => k2 => k1+1
+            if (i != 0)
+            {
+                indices.push_back(k1);
+                indices.push_back(k2);
+                indices.push_back(k1 + 1);
+            }
+
+            // k1+1 => k2 => k2+1
+            if (i != (stackCount - 1))
+            {
+                indices.push_back(k1 + 1);
+                indices.push_back(k2);
+                indices.push_back(k2 + 1);
+            }
+        }
+    }
+}
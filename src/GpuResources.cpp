@@ -0,0 +1,207 @@
+#include <GpuResources.hpp>
+
+namespace
+{
+    const int      GENERATION_BITS = 32 - GpuResources::INDEX_BITS;
+    const uint16_t MAX_GENERATION  = (1u << GENERATION_BITS) - 1;
+}
+
+BufferHandle GpuResources::createBuffer()
+{
+    GLuint name;
+    if (!spareBuffers.empty())
+    {
+        name = spareBuffers.back();
+        spareBuffers.pop_back();
+        counters.reused++;
+    }
+    else
+    {
+        glGenBuffers(1, &name);
+    }
+
+    BufferHandle handle;
+    handle.value = allocate(GpuResource::BUFFER, name);
+    return handle;
+}
+
+TextureHandle GpuResources::createTexture()
+{
+    GLuint name;
+    glGenTextures(1, &name);
+
+    TextureHandle handle;
+    handle.value = allocate(GpuResource::TEXTURE, name);
+    return handle;
+}
+
+VertexArrayHandle GpuResources::createVertexArray()
+{
+    GLuint name;
+    glGenVertexArrays(1, &name);
+
+    VertexArrayHandle handle;
+    handle.value = allocate(GpuResource::VERTEX_ARRAY, name);
+    return handle;
+}
+
+uint32_t GpuResources::allocate(GpuResource type, GLuint name)
+{
+    Pool& pool = pools[(int)type];
+
+    uint32_t index;
+    if (!pool.freeSlots.empty())
+    {
+        index = pool.freeSlots.back();
+        pool.freeSlots.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)pool.names.size();
+        pool.names.push_back(0);
+        pool.generations.push_back(1);
+    }
+
+    pool.names[index] = name;
+    counters.live[(int)type]++;
+
+    return (uint32_t)pool.generations[index] << INDEX_BITS | index;
+}
+
+GLuint GpuResources::lookup(GpuResource type, uint32_t handle) const
+{
+    const Pool& pool  = pools[(int)type];
+    uint32_t    index = handle & INDEX_MASK;
+
+    if (index >= pool.names.size() || pool.generations[index] != handle >> INDEX_BITS)
+        return 0;
+    return pool.names[index];
+}
+
+void GpuResources::release(GpuResource type, uint32_t handle)
+{
+    GLuint name = lookup(type, handle);
+    if (!name)
+        return;
+
+    Pool&    pool  = pools[(int)type];
+    uint32_t index = handle & INDEX_MASK;
+
+    // generation 0 is skipped so no handle is ever 0
+    pool.generations[index] = pool.generations[index] == MAX_GENERATION ? 1 : pool.generations[index] + 1;
+    pool.names[index]       = 0;
+    pool.freeSlots.push_back(index);
+    counters.live[(int)type]--;
+
+    retire(type, name);
+}
+
+void GpuResources::retire(GpuResource type, GLuint name)
+{
+    if (!name)
+        return;
+
+    Retired object = { type, name };
+    pending.push_back(object);
+    counters.pending++;
+}
+
+void GpuResources::endFrame()
+{
+    if (!pending.empty())
+    {
+        Batch batch;
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        batch.objects.swap(pending);
+        batches.push_back(std::move(batch));
+    }
+
+    // fences pass in order, stop at the first one that has not
+    while (!batches.empty())
+    {
+        Batch& batch  = batches.front();
+        GLenum status = glClientWaitSync(batch.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(batch.fence);
+        for (const Retired& object : batch.objects)
+            free(object);
+        batches.pop_front();
+    }
+
+    counters.spares = (uint32_t)spareBuffers.size();
+}
+
+void GpuResources::free(const Retired& object)
+{
+    counters.pending--;
+
+    switch (object.type)
+    {
+        case GpuResource::BUFFER:
+            if (spareBuffers.size() < MAX_SPARES)
+            {
+                // drop the storage, the name stays valid and goes to the next createBuffer
+                glBindBuffer(GL_COPY_WRITE_BUFFER, object.name);
+                glBufferData(GL_COPY_WRITE_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+                spareBuffers.push_back(object.name);
+            }
+            else
+            {
+                glDeleteBuffers(1, &object.name);
+            }
+            break;
+        case GpuResource::TEXTURE:
+            glDeleteTextures(1, &object.name);
+            break;
+        case GpuResource::VERTEX_ARRAY:
+            glDeleteVertexArrays(1, &object.name);
+            break;
+        case GpuResource::PROGRAM:
+            glDeleteProgram(object.name);
+            break;
+        default:
+            break;
+    }
+}
+
+void GpuResources::shutdown()
+{
+    glFinish();
+
+    for (Batch& batch : batches)
+    {
+        glDeleteSync(batch.fence);
+        for (const Retired& object : batch.objects)
+            free(object);
+    }
+    batches.clear();
+
+    for (const Retired& object : pending)
+        free(object);
+    pending.clear();
+
+    // whatever is still alive goes too, the owners may outlive the context
+    for (int t = 0; t < (int)GpuResource::COUNT; t++)
+    {
+        Pool& pool = pools[t];
+        for (GLuint name : pool.names)
+        {
+            Retired object = { (GpuResource)t, name };
+            if (name)
+            {
+                counters.pending++;
+                free(object);
+            }
+        }
+        pool = Pool();
+        counters.live[t] = 0;
+    }
+
+    if (!spareBuffers.empty())
+        glDeleteBuffers((GLsizei)spareBuffers.size(), spareBuffers.data());
+    spareBuffers.clear();
+    counters.spares = 0;
+}
@@ -0,0 +1,141 @@
+#include <GpuTimer.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+void GpuTimers::init()
+{
+    GLint bits = 0;
+    if (glQueryCounter && glGetQueryObjectui64v)
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+
+    supported = bits > 0;
+    if (!supported)
+        return;
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        glGenQueries(2 * MAX_ZONES, frames[i].queries);
+        frames[i].zones.reserve(MAX_ZONES);
+    }
+}
+
+void GpuTimers::shutdown()
+{
+    if (!supported)
+        return;
+
+    for (int i = 0; i < FRAMES; i++)
+        glDeleteQueries(2 * MAX_ZONES, frames[i].queries);
+    supported = false;
+}
+
+void GpuTimers::beginFrame()
+{
+    if (!supported)
+        return;
+
+    frameIndex++;
+    Frame& frame = frames[frameIndex % FRAMES];
+
+    if (!frame.zones.empty() && frame.last)
+        resolve(frame);
+
+    frame.zones.clear();
+    frame.last = 0;
+    depth = 0;
+}
+
+int GpuTimers::begin(const char *name)
+{
+    if (!supported)
+        return -1;
+
+    Frame& frame = frames[frameIndex % FRAMES];
+    int    idx   = (int)frame.zones.size();
+    if (idx >= MAX_ZONES)
+        return -1;
+
+    Zone zone;
+    zone.stat       = findStats(name);
+    zone.depth      = depth++;
+    zone.queries[0] = frame.queries[2 * idx];
+    zone.queries[1] = frame.queries[2 * idx + 1];
+    frame.zones.push_back(zone);
+
+    glQueryCounter(zone.queries[0], GL_TIMESTAMP);
+    return idx;
+}
+
+void GpuTimers::end(int zone)
+{
+    if (zone < 0)
+        return;
+
+    Frame& frame = frames[frameIndex % FRAMES];
+    frame.last   = frame.zones[zone].queries[1];
+    glQueryCounter(frame.last, GL_TIMESTAMP);
+    depth--;
+}
+
+int GpuTimers::findStats(const char *name)
+{
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        if (stats[i].name == name || std::strcmp(stats[i].name, name) == 0)
+            return (int)i;
+    }
+
+    stats.emplace_back();
+    stats.back().name = name;
+    return (int)stats.size() - 1;
+}
+
+void GpuTimers::resolve(Frame& frame)
+{
+    // queries complete in order, if the last one issued is there so is everything before it
+    GLuint available = 0;
+    glGetQueryObjectuiv(frame.last, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        dropped++;
+        return;
+    }
+
+    // a zone that ran several times in the frame counts once with its summed time
+    frameTotals.assign(stats.size(), -1.0);
+    for (size_t i = 0; i < frame.zones.size(); i++)
+    {
+        const Zone& zone = frame.zones[i];
+
+        GLuint64 t0 = 0, t1 = 0;
+        glGetQueryObjectui64v(zone.queries[0], GL_QUERY_RESULT, &t0);
+        glGetQueryObjectui64v(zone.queries[1], GL_QUERY_RESULT, &t1);
+
+        double& total = frameTotals[zone.stat];
+        total = std::max(total, 0.0) + (double)(t1 - t0) * 1e-6;
+        stats[zone.stat].depth = zone.depth;
+    }
+
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        if (frameTotals[i] < 0.0)
+            continue;
+
+        Stats& s = stats[i];
+        s.last = frameTotals[i];
+
+        s.history[s.next] = s.last;
+        s.next            = (s.next + 1) % HISTORY;
+        s.samples         = std::min(s.samples + 1, HISTORY);
+
+        double sum = 0.0;
+        s.max      = 0.0;
+        for (int k = 0; k < s.samples; k++)
+        {
+            sum  += s.history[k];
+            s.max = std::max(s.max, s.history[k]);
+        }
+        s.average = sum / s.samples;
+    }
+}
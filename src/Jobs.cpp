@@ -0,0 +1,276 @@
+#include <Jobs.hpp>
+
+JobSystem jobs;
+
+static thread_local int workerIndex = -1;
+
+void JobDeque::Slot::store(const Job& job)
+{
+    function.store(job.function, std::memory_order_relaxed);
+    data.store(job.data, std::memory_order_relaxed);
+    begin.store(job.begin, std::memory_order_relaxed);
+    end.store(job.end, std::memory_order_relaxed);
+    counter.store(job.counter, std::memory_order_relaxed);
+}
+
+void JobDeque::Slot::load(Job& job) const
+{
+    job.function = function.load(std::memory_order_relaxed);
+    job.data     = data.load(std::memory_order_relaxed);
+    job.begin    = begin.load(std::memory_order_relaxed);
+    job.end      = end.load(std::memory_order_relaxed);
+    job.counter  = counter.load(std::memory_order_relaxed);
+}
+
+bool JobDeque::push(const Job& job)
+{
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= CAPACITY)
+        return false;
+
+    jobs[b & (CAPACITY - 1)].store(job);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobDeque::pop(Job& out)
+{
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        // was empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    jobs[b & (CAPACITY - 1)].load(out);
+    bool taken = true;
+    if (t == b)
+    {
+        // the last one, a thief may be after it too
+        taken = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return taken;
+}
+
+bool JobDeque::steal(Job& out)
+{
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b)
+        return false;
+
+    // only ours once the exchange succeeds, until then the owner may be reusing the slot
+    jobs[t & (CAPACITY - 1)].load(out);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return false;       // lost against the owner or another thief
+    return true;
+}
+
+void JobSystem::start(unsigned threads)
+{
+    stop();
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    quit.store(false);
+    setMainThread();
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(new Worker());
+
+    workerIndex = 0;
+    for (unsigned i = 1; i < threads; i++)
+        workers[i]->thread = std::thread(&JobSystem::workerLoop, this, (int)i);
+}
+
+void JobSystem::stop()
+{
+    if (workers.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        quit.store(true);
+    }
+    wake.notify_all();
+
+    for (size_t i = 1; i < workers.size(); i++)
+        workers[i]->thread.join();
+
+    workers.clear();
+    queued.store(0);
+    workerIndex = -1;
+}
+
+int JobSystem::currentWorker() const
+{
+    return running() ? workerIndex : -1;
+}
+
+void JobSystem::submit(const Job& job)
+{
+    int self = currentWorker();
+    if (self < 0)
+    {
+        if (job.counter)
+            job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+        execute(job);
+        return;
+    }
+
+    if (job.counter)
+        job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    if (!workers[self]->deque.push(job))
+    {
+        execute(job);
+        return;
+    }
+
+    queued.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+bool JobSystem::find(int self, Job& out)
+{
+    bool found = workers[self]->deque.pop(out);
+    if (!found)
+    {
+        // start with the next worker, not always with worker 0
+        size_t n = workers.size();
+        for (size_t k = 1; k < n && !found; k++)
+            found = workers[(self + k) % n]->deque.steal(out);
+        if (found)
+            counters.stolen.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!found)
+        return false;
+
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void JobSystem::execute(const Job& job)
+{
+    job.function(job.data, job.begin, job.end);
+
+    counters.executed.fetch_add(1, std::memory_order_relaxed);
+    if (job.counter)
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    bool main = isMainThread();
+    int  self = currentWorker();
+    if (self < 0)
+    {
+        // only inline jobs here, and main jobs queued from the workers
+        while (!counter.done())
+        {
+            if (main)
+                runMainJobs();
+            std::this_thread::yield();
+        }
+        return;
+    }
+
+    while (!counter.done())
+    {
+        if (main)
+            runMainJobs();
+
+        Job job;
+        if (find(self, job))
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::runOnMain(std::function<void()> fn, JobCounter *counter)
+{
+    if (isMainThread() || !running())
+    {
+        fn();
+        return;
+    }
+
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mainMutex);
+    mainJobs.emplace_back(std::move(fn), counter);
+}
+
+void JobSystem::runMainJobs()
+{
+    // a main job may wait on something itself and end up back in here
+    std::vector<std::pair<std::function<void()>, JobCounter*>> running;
+    {
+        std::lock_guard<std::mutex> lock(mainMutex);
+        if (mainJobs.empty())
+            return;
+        running.swap(mainJobs);
+    }
+
+    PROFILE_ZONE("JobSystem::runMainJobs");
+
+    for (auto& job : running)
+    {
+        job.first();
+        if (job.second)
+            job.second->pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void JobSystem::workerLoop(int index)
+{
+    workerIndex = index;
+    PROFILE_THREAD_NAME("Worker");
+
+    int idle = 0;
+    while (!quit.load(std::memory_order_relaxed))
+    {
+        Job job;
+        if (find(index, job))
+        {
+            PROFILE_ZONE("Job");
+            execute(job);
+            idle = 0;
+            continue;
+        }
+
+        // spin a little, jobs tend to come in bursts
+        if (++idle < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // sleeping before checking queued again, a submit either sees us sleeping or we see its job
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.fetch_add(1, std::memory_order_seq_cst);
+        wake.wait(lock, [this]()
+        {
+            return quit.load(std::memory_order_relaxed) || queued.load(std::memory_order_seq_cst) > 0;
+        });
+        sleeping.fetch_sub(1, std::memory_order_seq_cst);
+        idle = 0;
+    }
+}
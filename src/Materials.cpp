@@ -0,0 +1,98 @@
+#include <Materials.hpp>
+#include <MemoryTracker.hpp>
+#include <Renderer.hpp>
+
+#include <iostream>
+#include <string>
+
+static_assert(sizeof(GpuMaterial) == 80, "GpuMaterial has to match the std140 layout of the Materials block");
+
+static bool sameMaterial(const Material& a, const Material& b)
+{
+    for (int s = 0; s < TEXTURE_SLOTS; s++)
+    {
+        if (a.textures.texture[s] != b.textures.texture[s])
+            return false;
+    }
+    return a.shininess == b.shininess && a.flags == b.flags;
+}
+
+uint32_t MaterialTable::intern(const Material& material)
+{
+    Material m = material;
+    m.flags    = 0;
+    for (int s = 0; s < TEXTURE_SLOTS; s++)
+    {
+        if (m.textures.page[s].x >= 0)
+            m.flags |= 1u << s;
+    }
+
+    // a model has a few dozen materials at most, a linear search is all it takes
+    for (size_t i = 0; i < materials.size(); i++)
+    {
+        if (sameMaterial(materials[i], m))
+            return (uint32_t)i;
+    }
+
+    if (materials.size() >= MAX_MATERIALS)
+    {
+        std::cerr << "ERROR::MATERIALS::TABLE_FULL " << MAX_MATERIALS << " materials, using the first one" << std::endl;
+        return 0;
+    }
+
+    materials.push_back(m);
+    return (uint32_t)materials.size() - 1;
+}
+
+void MaterialTable::upload(const char *asset)
+{
+    // the block is declared with MAX_MATERIALS entries, the buffer always has all of them
+    std::vector<GpuMaterial> table(MAX_MATERIALS, GpuMaterial());
+    for (size_t i = 0; i < materials.size(); i++)
+    {
+        const Material& m = materials[i];
+        GpuMaterial&    g = table[i];
+
+        for (int s = 0; s < TEXTURE_SLOTS; s++)
+        {
+            const glm::ivec2& page = m.textures.page[s];
+
+            g.rect[s] = m.textures.rect[s];
+            g.page[s] = page.x < 0 ? 0 : page.y * 4 + page.x;
+        }
+        g.page.w = (int)m.flags;
+        g.params = glm::vec4(m.shininess, 0.0f, 0.0f, 0.0f);
+    }
+
+    if (!buffer)
+        buffer = gpuResources.createBuffer();
+    GLuint ubo = gpuResources.get(buffer);
+
+    size_t bytes = table.size() * sizeof(GpuMaterial);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, bytes, table.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    memoryTracker.track(MemoryKind::BUFFER, ubo, bytes, MemoryTag::TEXTURE, std::string(asset) + " materials");
+}
+
+void MaterialTable::bind() const
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BINDING, gpuResources.get(buffer));
+}
+
+void MaterialTable::bindBlock(GLuint program)
+{
+    GLuint block = glGetUniformBlockIndex(program, "Materials");
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, block, MATERIAL_BINDING);
+}
+
+void MaterialTable::release()
+{
+    if (!buffer)
+        return;
+
+    memoryTracker.release(MemoryKind::BUFFER, gpuResources.get(buffer));
+    gpuResources.destroy(buffer);
+}
@@ -0,0 +1,248 @@
+#include <MemoryTracker.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // a slot per thread (threads past SLOTS share), written by its thread only as long as
+    // there are no more threads than slots
+    struct alignas(64) AllocationSlot
+    {
+        std::atomic<uint64_t> count{0};
+    };
+
+    const int        SLOTS = 64;
+    AllocationSlot   slots[SLOTS];
+    std::atomic<int> nextSlot{0};
+    std::atomic<int> openScopes{0};
+
+    thread_local int threadSlot = -1;
+
+    uint64_t countedAllocations()
+    {
+        uint64_t sum = 0;
+        for (const AllocationSlot& s : slots)
+            sum += s.count.load(std::memory_order_relaxed);
+        return sum;
+    }
+}
+
+// the array and nothrow forms end up here too
+void *operator new(size_t size)
+{
+    if (openScopes.load(std::memory_order_relaxed) > 0)
+    {
+        if (threadSlot < 0)
+            threadSlot = nextSlot.fetch_add(1, std::memory_order_relaxed) % SLOTS;
+        slots[threadSlot].count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+AllocationScope::AllocationScope()
+{
+    openScopes.fetch_add(1, std::memory_order_seq_cst);
+    start = countedAllocations();
+}
+
+AllocationScope::~AllocationScope()
+{
+    openScopes.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+uint64_t AllocationScope::allocations() const
+{
+    return countedAllocations() - start;
+}
+
+const char *memoryTagName(MemoryTag tag)
+{
+    switch (tag)
+    {
+        case MemoryTag::MESH:          return "Mesh";
+        case MemoryTag::TEXTURE:       return "Texture";
+        case MemoryTag::RENDER_TARGET: return "Render target";
+        case MemoryTag::LIGHTING:      return "Lighting";
+        case MemoryTag::UI:            return "UI";
+        case MemoryTag::DEBUG:         return "Debug";
+        default:                       return "?";
+    }
+}
+
+size_t texelBytes(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_RED:
+        case GL_R8:
+            return 1;
+        case GL_RG:
+        case GL_RG8:
+        case GL_R16F:
+        case GL_DEPTH_COMPONENT16:
+            return 2;
+        case GL_RGB:
+        case GL_RGB8:
+        case GL_SRGB8:
+        case GL_RGBA:
+        case GL_RGBA8:
+        case GL_SRGB8_ALPHA8:
+        case GL_RG16F:
+        case GL_R32F:
+        case GL_R32UI:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32F:
+        case GL_DEPTH24_STENCIL8:
+            return 4;
+        case GL_RGB16F:
+        case GL_RGBA16F:
+        case GL_RG32F:
+        case GL_RG32UI:
+            return 8;
+        case GL_RGB32F:
+        case GL_RGBA32F:
+        case GL_RGBA32UI:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+size_t textureBytes(GLenum internalFormat, int width, int height, bool mipmapped)
+{
+    size_t texel = texelBytes(internalFormat);
+    size_t bytes = (size_t)width * (size_t)height * texel;
+
+    while (mipmapped && (width > 1 || height > 1))
+    {
+        width  = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        bytes += (size_t)width * (size_t)height * texel;
+    }
+    return bytes;
+}
+
+static int heapOf(MemoryKind kind)
+{
+    return kind == MemoryKind::HOST ? 1 : 0;
+}
+
+void MemoryTracker::add(int heap, MemoryTag tag, uint64_t bytes)
+{
+    Totals& t = tags[heap][(int)tag];
+    t.live += bytes;
+    t.peak  = std::max(t.peak, t.live);
+    t.count++;
+
+    Totals& h = heaps[heap];
+    h.live += bytes;
+    h.peak  = std::max(h.peak, h.live);
+    h.count++;
+
+    // once per crossing, not for every allocation past it
+    if (overBudget(heap) && !warned[heap])
+    {
+        std::cerr << "WARNING::MEMORY::OVER_BUDGET " << (heap == 0 ? "GPU " : "CPU ")
+                  << h.live / (1024 * 1024) << " MB of " << budget[heap] / (1024 * 1024) << " MB" << std::endl;
+        warned[heap] = true;
+    }
+}
+
+void MemoryTracker::remove(int heap, MemoryTag tag, uint64_t bytes)
+{
+    Totals& t = tags[heap][(int)tag];
+    t.live -= bytes;
+    t.count--;
+
+    Totals& h = heaps[heap];
+    h.live -= bytes;
+    h.count--;
+
+    if (!overBudget(heap))
+        warned[heap] = false;
+}
+
+void MemoryTracker::track(MemoryKind kind, uint64_t id, size_t bytes, MemoryTag tag, const std::string& asset)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int heap = heapOf(kind);
+
+    std::unordered_map<uint64_t, Allocation>& map = live[(int)kind];
+    auto it = map.find(id);
+    if (it != map.end())
+    {
+        remove(heap, it->second.tag, it->second.bytes);
+        it->second.bytes = bytes;
+        it->second.tag   = tag;
+        it->second.asset = asset;
+    }
+    else
+    {
+        Allocation a = { bytes, tag, asset };
+        map.emplace(id, a);
+    }
+
+    add(heap, tag, bytes);
+}
+
+void MemoryTracker::release(MemoryKind kind, uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<uint64_t, Allocation>& map = live[(int)kind];
+    auto it = map.find(id);
+    if (it == map.end())
+        return;
+
+    remove(heapOf(kind), it->second.tag, it->second.bytes);
+    map.erase(it);
+}
+
+void MemoryTracker::breakdown(std::vector<Asset>& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    out.clear();
+
+    std::unordered_map<std::string, size_t> index;
+    for (int k = 0; k < (int)MemoryKind::COUNT; k++)
+    {
+        int heap = heapOf((MemoryKind)k);
+        for (const auto& entry : live[k])
+        {
+            const Allocation& a = entry.second;
+
+            auto it = index.find(a.asset);
+            if (it == index.end())
+            {
+                Asset asset = { a.asset, a.tag, { 0, 0 }, 0 };
+                it = index.emplace(a.asset, out.size()).first;
+                out.push_back(asset);
+            }
+
+            Asset& asset = out[it->second];
+            asset.bytes[heap] += a.bytes;
+            asset.allocations++;
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const Asset& a, const Asset& b)
+    {
+        return a.bytes[0] + a.bytes[1] > b.bytes[0] + b.bytes[1];
+    });
+}
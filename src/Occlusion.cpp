@@ -0,0 +1,446 @@
+#include <Occlusion.hpp>
+#include <Simd.hpp>
+#include <Parallel.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <cmath>
+
+namespace
+{
+    inline float edge(const glm::vec3& a, const glm::vec3& b, float px, float py)
+    {
+        return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    }
+
+    // everything one triangle needs to walk its pixels, edges are evaluated at pixel centers
+    struct TriangleSetup
+    {
+        int   minX, minY, maxX, maxY;   // clamped to the tile
+        float e[3];                     // edge values at (minX + 0.5, minY + 0.5)
+        float dx[3], dy[3];             // edge steps per pixel
+        float z, dzdx, dzdy;            // depth plane at the same start pixel
+    };
+
+    bool setupTriangle(const OcclusionBuffer::ScreenTriangle& tri, int tileX0, int tileY0, int tileX1, int tileY1, TriangleSetup& s)
+    {
+        glm::vec3 v0 = tri.v[0], v1 = tri.v[1], v2 = tri.v[2];
+
+        float area = edge(v0, v1, v2.x, v2.y);
+        if (area == 0.0f)
+            return false;
+        if (area < 0.0f)
+        {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        s.minX = std::max(tileX0, (int)std::floor(std::min(v0.x, std::min(v1.x, v2.x))));
+        s.minY = std::max(tileY0, (int)std::floor(std::min(v0.y, std::min(v1.y, v2.y))));
+        s.maxX = std::min(tileX1 - 1, (int)std::ceil(std::max(v0.x, std::max(v1.x, v2.x))));
+        s.maxY = std::min(tileY1 - 1, (int)std::ceil(std::max(v0.y, std::max(v1.y, v2.y))));
+        if (s.minX > s.maxX || s.minY > s.maxY)
+            return false;
+
+        // start at a multiple of 8 so the SIMD loops never need a partial head, tiles are 8 aligned
+        s.minX &= ~7;
+
+        float px = s.minX + 0.5f;
+        float py = s.minY + 0.5f;
+
+        const glm::vec3 *a[3] = { &v1, &v2, &v0 };
+        const glm::vec3 *b[3] = { &v2, &v0, &v1 };
+        for (int i = 0; i < 3; i++)
+        {
+            s.e[i]  = edge(*a[i], *b[i], px, py);
+            s.dx[i] = -(b[i]->y - a[i]->y);
+            s.dy[i] =  (b[i]->x - a[i]->x);
+        }
+
+        // z = v0.z + w1 * (v1.z - v0.z) + w2 * (v2.z - v0.z), w1 = e1 / area, w2 = e2 / area
+        float invArea = 1.0f / area;
+        float z10 = (v1.z - v0.z) * invArea;
+        float z20 = (v2.z - v0.z) * invArea;
+        s.z    = v0.z + s.e[1] * z10 + s.e[2] * z20;
+        s.dzdx = s.dx[1] * z10 + s.dx[2] * z20;
+        s.dzdy = s.dy[1] * z10 + s.dy[2] * z20;
+
+        return true;
+    }
+
+#if !SIMD_X86
+    // x86 always has SSE, this is only for the other targets
+    void rasterScalar(const TriangleSetup& s, float *depth)
+    {
+        float e0 = s.e[0], e1 = s.e[1], e2 = s.e[2], z = s.z;
+        for (int y = s.minY; y <= s.maxY; y++)
+        {
+            float *row = depth + y * OcclusionBuffer::WIDTH;
+            float w0 = e0, w1 = e1, w2 = e2, zx = z;
+            for (int x = s.minX; x <= s.maxX; x++)
+            {
+                if (w0 > 0.0f && w1 > 0.0f && w2 > 0.0f)
+                    row[x] = std::min(row[x], zx);
+                w0 += s.dx[0]; w1 += s.dx[1]; w2 += s.dx[2]; zx += s.dzdx;
+            }
+            e0 += s.dy[0]; e1 += s.dy[1]; e2 += s.dy[2]; z += s.dzdy;
+        }
+    }
+#endif
+
+#if SIMD_X86
+    void rasterSSE(const TriangleSetup& s, float *depth)
+    {
+        const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        __m128 dx0 = _mm_set1_ps(s.dx[0] * 4.0f), dx1 = _mm_set1_ps(s.dx[1] * 4.0f), dx2 = _mm_set1_ps(s.dx[2] * 4.0f);
+        __m128 dz  = _mm_set1_ps(s.dzdx * 4.0f);
+
+        float e0 = s.e[0], e1 = s.e[1], e2 = s.e[2], z = s.z;
+        for (int y = s.minY; y <= s.maxY; y++)
+        {
+            float *row = depth + y * OcclusionBuffer::WIDTH;
+
+            __m128 w0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(lane, _mm_set1_ps(s.dx[0])));
+            __m128 w1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(lane, _mm_set1_ps(s.dx[1])));
+            __m128 w2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(lane, _mm_set1_ps(s.dx[2])));
+            __m128 zx = _mm_add_ps(_mm_set1_ps(z),  _mm_mul_ps(lane, _mm_set1_ps(s.dzdx)));
+
+            for (int x = s.minX; x <= s.maxX; x += 4)
+            {
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(w0, zero), _mm_cmpgt_ps(w1, zero)), _mm_cmpgt_ps(w2, zero));
+                if (_mm_movemask_ps(inside))
+                {
+                    __m128 old = _mm_loadu_ps(row + x);
+                    __m128 nz  = _mm_min_ps(old, zx);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nz), _mm_andnot_ps(inside, old)));
+                }
+                w0 = _mm_add_ps(w0, dx0); w1 = _mm_add_ps(w1, dx1); w2 = _mm_add_ps(w2, dx2); zx = _mm_add_ps(zx, dz);
+            }
+            e0 += s.dy[0]; e1 += s.dy[1]; e2 += s.dy[2]; z += s.dzdy;
+        }
+    }
+
+    SIMD_TARGET_AVX2
+    void rasterAVX2(const TriangleSetup& s, float *depth)
+    {
+        const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        const __m256 zero = _mm256_setzero_ps();
+
+        __m256 dx0 = _mm256_set1_ps(s.dx[0] * 8.0f), dx1 = _mm256_set1_ps(s.dx[1] * 8.0f), dx2 = _mm256_set1_ps(s.dx[2] * 8.0f);
+        __m256 dz  = _mm256_set1_ps(s.dzdx * 8.0f);
+
+        float e0 = s.e[0], e1 = s.e[1], e2 = s.e[2], z = s.z;
+        for (int y = s.minY; y <= s.maxY; y++)
+        {
+            float *row = depth + y * OcclusionBuffer::WIDTH;
+
+            __m256 w0 = _mm256_add_ps(_mm256_set1_ps(e0), _mm256_mul_ps(lane, _mm256_set1_ps(s.dx[0])));
+            __m256 w1 = _mm256_add_ps(_mm256_set1_ps(e1), _mm256_mul_ps(lane, _mm256_set1_ps(s.dx[1])));
+            __m256 w2 = _mm256_add_ps(_mm256_set1_ps(e2), _mm256_mul_ps(lane, _mm256_set1_ps(s.dx[2])));
+            __m256 zx = _mm256_add_ps(_mm256_set1_ps(z),  _mm256_mul_ps(lane, _mm256_set1_ps(s.dzdx)));
+
+            for (int x = s.minX; x <= s.maxX; x += 8)
+            {
+                __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GT_OQ),
+                                                            _mm256_cmp_ps(w1, zero, _CMP_GT_OQ)),
+                                              _mm256_cmp_ps(w2, zero, _CMP_GT_OQ));
+                if (_mm256_movemask_ps(inside))
+                {
+                    __m256 old = _mm256_loadu_ps(row + x);
+                    _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, zx), inside));
+                }
+                w0 = _mm256_add_ps(w0, dx0); w1 = _mm256_add_ps(w1, dx1); w2 = _mm256_add_ps(w2, dx2); zx = _mm256_add_ps(zx, dz);
+            }
+            e0 += s.dy[0]; e1 += s.dy[1]; e2 += s.dy[2]; z += s.dzdy;
+        }
+        _mm256_zeroupper();     // not emitted for target("avx2") functions, see Culling.cpp
+    }
+#endif
+}
+
+OcclusionBuffer::OcclusionBuffer()
+    : viewProj(1.0f)
+{
+    depth.assign(WIDTH * HEIGHT, 1.0f);
+    bins.resize(TILES_X * TILES_Y);
+
+    int w = WIDTH, h = HEIGHT;
+    while (true)
+    {
+        Level level;
+        level.width  = w;
+        level.height = h;
+        level.minDepth.assign(w * h, 1.0f);
+        level.maxDepth.assign(w * h, 1.0f);
+        pyramid.push_back(std::move(level));
+
+        if (w == 1 && h == 1)
+            break;
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+}
+
+void OcclusionBuffer::beginFrame(const glm::mat4& vp)
+{
+    viewProj = vp;
+    triangles.clear();
+    for (auto& bin : bins)
+        bin.clear();
+    rasterTime = 0.0;
+}
+
+void OcclusionBuffer::clipAndAdd(const glm::vec4 clip[3])
+{
+    // trivially reject triangles completely outside one of the side planes
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (clip[0][axis] >  clip[0].w && clip[1][axis] >  clip[1].w && clip[2][axis] >  clip[2].w) return;
+        if (clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w) return;
+    }
+    if (clip[0].z > clip[0].w && clip[1].z > clip[1].w && clip[2].z > clip[2].w)
+        return;
+
+    // clip against the near plane (z >= -w), a triangle becomes at most a quad
+    glm::vec4 poly[4];
+    int       count = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const glm::vec4& a = clip[i];
+        const glm::vec4& b = clip[(i + 1) % 3];
+        float da = a.z + a.w;
+        float db = b.z + b.w;
+
+        if (da >= 0.0f)
+            poly[count++] = a;
+        if ((da >= 0.0f) != (db >= 0.0f))
+            poly[count++] = a + (b - a) * (da / (da - db));
+    }
+    if (count < 3)
+        return;
+
+    glm::vec3 screen[4];
+    for (int i = 0; i < count; i++)
+    {
+        float invW = 1.0f / std::max(poly[i].w, 1e-6f);
+        screen[i].x = (poly[i].x * invW * 0.5f + 0.5f) * WIDTH;
+        screen[i].y = (poly[i].y * invW * 0.5f + 0.5f) * HEIGHT;
+        screen[i].z =  poly[i].z * invW * 0.5f + 0.5f;
+    }
+
+    for (int i = 1; i + 1 < count; i++)
+    {
+        ScreenTriangle t;
+        t.v[0] = screen[0];
+        t.v[1] = screen[i];
+        t.v[2] = screen[i + 1];
+        triangles.push_back(t);
+    }
+}
+
+void OcclusionBuffer::addOccluder(const glm::vec3 *positions, size_t positionStride,
+                                  const uint32_t *indices, size_t indexCount, const glm::mat4& model)
+{
+    glm::mat4 mvp = viewProj * model;
+
+    auto pos = [&](uint32_t i) -> const glm::vec3&
+    {
+        return *(const glm::vec3 *)((const char *)positions + i * positionStride);
+    };
+
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        glm::vec4 clip[3] =
+        {
+            mvp * glm::vec4(pos(indices[i + 0]), 1.0f),
+            mvp * glm::vec4(pos(indices[i + 1]), 1.0f),
+            mvp * glm::vec4(pos(indices[i + 2]), 1.0f)
+        };
+        clipAndAdd(clip);
+    }
+}
+
+void OcclusionBuffer::rasterizeTile(int tile)
+{
+    int tx = tile % TILES_X;
+    int ty = tile / TILES_X;
+    int x0 = tx * TILE_WIDTH,  x1 = x0 + TILE_WIDTH;
+    int y0 = ty * TILE_HEIGHT, y1 = y0 + TILE_HEIGHT;
+
+    for (int y = y0; y < y1; y++)
+        std::fill(depth.begin() + y * WIDTH + x0, depth.begin() + y * WIDTH + x1, 1.0f);
+
+#if SIMD_X86
+    bool avx2 = cpuHasAVX2();
+#endif
+
+    for (uint32_t t : bins[tile])
+    {
+        TriangleSetup s;
+        if (!setupTriangle(triangles[t], x0, y0, x1, y1, s))
+            continue;
+
+#if SIMD_X86
+        if (avx2)
+            rasterAVX2(s, depth.data());
+        else
+            rasterSSE(s, depth.data());
+#else
+        rasterScalar(s, depth.data());
+#endif
+    }
+}
+
+void OcclusionBuffer::buildPyramid()
+{
+    Level& base = pyramid[0];
+    base.minDepth = depth;
+    base.maxDepth = depth;
+
+    for (size_t l = 1; l < pyramid.size(); l++)
+    {
+        const Level& src = pyramid[l - 1];
+        Level&       dst = pyramid[l];
+
+        for (int y = 0; y < dst.height; y++)
+        {
+            int sy0 = std::min(y * 2,     src.height - 1);
+            int sy1 = std::min(y * 2 + 1, src.height - 1);
+            for (int x = 0; x < dst.width; x++)
+            {
+                int sx0 = std::min(x * 2,     src.width - 1);
+                int sx1 = std::min(x * 2 + 1, src.width - 1);
+
+                int a = sy0 * src.width + sx0, b = sy0 * src.width + sx1;
+                int c = sy1 * src.width + sx0, d = sy1 * src.width + sx1;
+
+                dst.minDepth[y * dst.width + x] = std::min(std::min(src.minDepth[a], src.minDepth[b]),
+                                                           std::min(src.minDepth[c], src.minDepth[d]));
+                dst.maxDepth[y * dst.width + x] = std::max(std::max(src.maxDepth[a], src.maxDepth[b]),
+                                                           std::max(src.maxDepth[c], src.maxDepth[d]));
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::rasterize()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    occluderTriangles = (uint32_t)triangles.size();
+
+    // bin every triangle into the tiles its bounding box touches
+    for (uint32_t i = 0; i < (uint32_t)triangles.size(); i++)
+    {
+        const ScreenTriangle& t = triangles[i];
+        float minX = std::min(t.v[0].x, std::min(t.v[1].x, t.v[2].x));
+        float maxX = std::max(t.v[0].x, std::max(t.v[1].x, t.v[2].x));
+        float minY = std::min(t.v[0].y, std::min(t.v[1].y, t.v[2].y));
+        float maxY = std::max(t.v[0].y, std::max(t.v[1].y, t.v[2].y));
+
+        if (maxX < 0.0f || maxY < 0.0f || minX >= WIDTH || minY >= HEIGHT)
+            continue;
+
+        int tx0 = std::max(0, (int)minX / TILE_WIDTH),  tx1 = std::min(TILES_X - 1, (int)maxX / TILE_WIDTH);
+        int ty0 = std::max(0, (int)minY / TILE_HEIGHT), ty1 = std::min(TILES_Y - 1, (int)maxY / TILE_HEIGHT);
+
+        for (int ty = ty0; ty <= ty1; ty++)
+            for (int tx = tx0; tx <= tx1; tx++)
+                bins[ty * TILES_X + tx].push_back(i);
+    }
+
+    // tiles own disjoint parts of the depth buffer so they need no synchronization
+    parallelFor(TILES_X * TILES_Y, 4, [this](size_t begin, size_t end)
+    {
+        for (size_t tile = begin; tile < end; tile++)
+            rasterizeTile((int)tile);
+    });
+
+    buildPyramid();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    rasterTime = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+bool OcclusionBuffer::testAABB(const AABB& box) const
+{
+    float minX =  FLT_MAX, minY =  FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 corner((i & 1) ? box.max.x : box.min.x,
+                         (i & 2) ? box.max.y : box.min.y,
+                         (i & 4) ? box.max.z : box.min.z);
+
+        glm::vec4 clip = viewProj * glm::vec4(corner, 1.0f);
+
+        // the box reaches behind the near plane, can't say anything about it
+        if (clip.w <= 1e-5f || clip.z < -clip.w)
+            return true;
+
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW * 0.5f + 0.5f) * WIDTH;
+        float y = (clip.y * invW * 0.5f + 0.5f) * HEIGHT;
+        float z =  clip.z * invW * 0.5f + 0.5f;
+
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+        minZ = std::min(minZ, z);
+    }
+
+    // off screen boxes are the frustum culler's business
+    if (maxX < 0.0f || maxY < 0.0f || minX >= WIDTH || minY >= HEIGHT)
+        return true;
+
+    int x0 = std::max(0, (int)minX), x1 = std::min(WIDTH - 1,  (int)maxX);
+    int y0 = std::max(0, (int)minY), y1 = std::min(HEIGHT - 1, (int)maxY);
+
+    // start at the level where the box covers about 2x2 texels
+    int    level = 0;
+    int    size  = std::max(x1 - x0, y1 - y0);
+    while (size > 1 && level + 1 < (int)pyramid.size())
+    {
+        size >>= 1;
+        level++;
+    }
+
+    // the min pyramid tells when a box is in front of everything, otherwise refine a couple of levels
+    int lastLevel = std::max(0, level - 2);
+    for (; level >= lastLevel; level--)
+    {
+        const Level& l = pyramid[level];
+        int shift = level;
+        int lx0 = std::min(x0 >> shift, l.width - 1),  lx1 = std::min(x1 >> shift, l.width - 1);
+        int ly0 = std::min(y0 >> shift, l.height - 1), ly1 = std::min(y1 >> shift, l.height - 1);
+
+        float farthest = 0.0f;
+        float nearest  = 1.0f;
+        for (int y = ly0; y <= ly1; y++)
+        {
+            for (int x = lx0; x <= lx1; x++)
+            {
+                farthest = std::max(farthest, l.maxDepth[y * l.width + x]);
+                nearest  = std::min(nearest,  l.minDepth[y * l.width + x]);
+            }
+        }
+
+        if (minZ > farthest)
+            return false;
+        if (minZ <= nearest)
+            return true;
+    }
+
+    return true;
+}
+
+const char *occlusionBackendName()
+{
+#if SIMD_X86
+    return cpuHasAVX2() ? "AVX2" : "SSE";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,228 @@
+#include <Profiler.hpp>
+
+#if PROFILER_ENABLED
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+    struct Event
+    {
+        const char *name;
+        uint64_t    begin;
+        uint64_t    end;
+    };
+
+    /*
+        One per thread. Only the owning thread writes, head is published with release
+        so a reader that loads it with acquire sees every event before it. Threads that
+        exit hand their buffer back and the next new thread continues in it, so restarting
+        the job system (or any short lived thread) doesn't pile them up.
+    */
+    struct ThreadBuffer
+    {
+        static const uint64_t CAPACITY = 1 << 16;
+        static const uint64_t MASK     = CAPACITY - 1;
+
+        Event                 events[CAPACITY];
+        std::atomic<uint64_t> head{0};
+        std::atomic<bool>     owned{false};
+        uint32_t              id   = 0;
+        const char           *name = "Thread";
+    };
+
+    // buffers are never freed, the list only grows up to the number of concurrent threads
+    std::mutex                 buffersMutex;
+    std::vector<ThreadBuffer*> buffers;
+
+    ThreadBuffer *acquireBuffer()
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            bool expected = false;
+            if (buffers[i]->owned.compare_exchange_strong(expected, true))
+                return buffers[i];
+        }
+
+        ThreadBuffer *buffer = new ThreadBuffer();
+        buffer->id = (uint32_t)buffers.size();
+        buffer->owned.store(true);
+        buffers.push_back(buffer);
+        return buffer;
+    }
+
+    struct ThreadSlot
+    {
+        ThreadBuffer *buffer = nullptr;
+
+        ThreadBuffer *get()
+        {
+            if (!buffer)
+                buffer = acquireBuffer();
+            return buffer;
+        }
+
+        ~ThreadSlot()
+        {
+            if (buffer)
+                buffer->owned.store(false, std::memory_order_release);
+        }
+    };
+
+    thread_local ThreadSlot threadSlot;
+
+    // ticks -> microseconds, measured against steady_clock over the lifetime of the program
+    struct Clock
+    {
+        uint64_t                              ticks0;
+        std::chrono::steady_clock::time_point time0;
+
+        Clock() : ticks0(Profiler::now()), time0(std::chrono::steady_clock::now()) {}
+
+        double ticksPerUs() const
+        {
+#if SIMD_X86
+            uint64_t ticks = Profiler::now();
+            double   us    = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - time0).count();
+            // right at startup the interval is too short to tell, assume a few GHz
+            if (us < 1000.0)
+                return 3000.0;
+            return (double)(ticks - ticks0) / us;
+#else
+            return (double)std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num / 1e6;
+#endif
+        }
+    };
+    Clock tickClock;
+
+    // frame starts, main thread only
+    const int FRAME_HISTORY = 256;
+    uint64_t  frameStarts[FRAME_HISTORY];
+    uint64_t  frameCount = 0;
+    float     frameTime  = 0.0f;
+
+    bool writeTrace(const std::string& path, uint64_t from)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            std::cerr << "ERROR::PROFILER::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+
+        double scale = 1.0 / tickClock.ticksPerUs();
+
+        std::vector<ThreadBuffer*> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            snapshot = buffers;
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+
+        for (size_t b = 0; b < snapshot.size(); b++)
+        {
+            ThreadBuffer *buffer = snapshot[b];
+
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"args\":{\"name\":\"" << buffer->name << " " << buffer->id << "\"}}";
+            first = false;
+
+            // the writer keeps going while this runs, stay clear of the slots it is about to reuse
+            uint64_t head  = buffer->head.load(std::memory_order_acquire);
+            uint64_t slack = ThreadBuffer::CAPACITY / 8;
+            uint64_t tail  = head > ThreadBuffer::CAPACITY - slack ? head - (ThreadBuffer::CAPACITY - slack) : 0;
+
+            for (uint64_t i = tail; i < head; i++)
+            {
+                const Event& e = buffer->events[i & ThreadBuffer::MASK];
+                if (e.begin < from || e.begin < tickClock.ticks0)
+                    continue;
+
+                out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                    << ",\"ts\":" << (double)(e.begin - tickClock.ticks0) * scale
+                    << ",\"dur\":" << (double)(e.end - e.begin) * scale << "}";
+            }
+        }
+
+        out << "\n]}\n";
+        std::cout << "Wrote trace : " << path << std::endl;
+        return true;
+    }
+}
+
+namespace Profiler
+{
+    float hitchThreshold = 0.0f;
+    int   hitchFrames    = 10;
+    int   hitchCaptures  = 0;
+
+    void record(const char *name, uint64_t begin, uint64_t end)
+    {
+        ThreadBuffer *buffer = threadSlot.get();
+
+        uint64_t h = buffer->head.load(std::memory_order_relaxed);
+        Event&   e = buffer->events[h & ThreadBuffer::MASK];
+        e.name  = name;
+        e.begin = begin;
+        e.end   = end;
+        buffer->head.store(h + 1, std::memory_order_release);
+    }
+
+    void setThreadName(const char *name)
+    {
+        threadSlot.get()->name = name;
+    }
+
+    void frame()
+    {
+        uint64_t t = now();
+
+        if (frameCount > 0)
+        {
+            uint64_t last = frameStarts[(frameCount - 1) % FRAME_HISTORY];
+            frameTime     = (float)((double)(t - last) / tickClock.ticksPerUs() * 1e-3);
+
+            if (hitchThreshold > 0.0f && frameTime > hitchThreshold)
+            {
+                // the slow frame is the one that just ended, the new one has nothing yet
+                exportFrames("hitch_" + std::to_string(frameCount) + ".json", hitchFrames);
+                hitchCaptures++;
+            }
+        }
+
+        frameStarts[frameCount % FRAME_HISTORY] = t;
+        frameCount++;
+    }
+
+    bool exportTrace(const std::string& path)
+    {
+        return writeTrace(path, 0);
+    }
+
+    bool exportFrames(const std::string& path, int frames)
+    {
+        if (frameCount == 0)
+            return writeTrace(path, 0);
+
+        frames = std::max(1, std::min(frames, std::min(FRAME_HISTORY, (int)frameCount)));
+        return writeTrace(path, frameStarts[(frameCount - frames) % FRAME_HISTORY]);
+    }
+
+    float lastFrameTime()
+    {
+        return frameTime;
+    }
+}
+
+#endif
@@ -0,0 +1,209 @@
+#include <Recording.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+namespace
+{
+    const char MAGIC[4] = { 'B', 'G', 'L', 'R' };
+
+    // which optional fields follow the time and deltaTime of a frame
+    enum FrameFlags : uint8_t
+    {
+        HAS_KEYS     = 1 << 0,  // keys differ from the previous frame
+        HAS_SETTINGS = 1 << 1,  // settings differ from the previous frame
+        HAS_SCROLL   = 1 << 2,
+        HAS_CLICK    = 1 << 3,
+        HAS_CAMERA   = 1 << 4,
+    };
+
+    template<typename T>
+    void put(std::ofstream& out, const T& value)
+    {
+        out.write((const char*)&value, sizeof(T));
+    }
+
+    template<typename T>
+    bool get(std::ifstream& in, T& value)
+    {
+        return (bool)in.read((char*)&value, sizeof(T));
+    }
+
+    void putCamera(std::ofstream& out, const CameraState& c)
+    {
+        put(out, c.pos.x);
+        put(out, c.pos.y);
+        put(out, c.pos.z);
+        put(out, c.yaw);
+        put(out, c.pitch);
+        put(out, c.zoom);
+    }
+
+    bool getCamera(std::ifstream& in, CameraState& c)
+    {
+        return get(in, c.pos.x) && get(in, c.pos.y) && get(in, c.pos.z) && get(in, c.yaw) && get(in, c.pitch) && get(in, c.zoom);
+    }
+}
+
+bool InputRecording::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "ERROR::RECORDING::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+
+    out.write(MAGIC, sizeof(MAGIC));
+    put(out, (uint32_t)VERSION);
+    put(out, (int32_t)width);
+    put(out, (int32_t)height);
+    put(out, (uint32_t)frames.size());
+    put(out, lastFrame);
+    putCamera(out, start);
+
+    uint32_t keys     = 0;
+    uint32_t settings = 0;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        const InputFrame& f = frames[i];
+
+        uint8_t flags = 0;
+        if (f.keys != keys)                   flags |= HAS_KEYS;
+        if (i == 0 || f.settings != settings) flags |= HAS_SETTINGS;
+        if (f.scroll != 0.0f)                 flags |= HAS_SCROLL;
+        if (f.click)                          flags |= HAS_CLICK;
+        if (f.keyframe)                       flags |= HAS_CAMERA;
+
+        put(out, flags);
+        put(out, f.time);
+        put(out, f.deltaTime);
+        if (flags & HAS_KEYS)     put(out, (uint16_t)f.keys);
+        if (flags & HAS_SETTINGS) put(out, f.settings);
+        if (flags & HAS_SCROLL)   put(out, f.scroll);
+        if (flags & HAS_CLICK)
+        {
+            put(out, f.clickX);
+            put(out, f.clickY);
+        }
+        if (flags & HAS_CAMERA)   putCamera(out, f.camera);
+
+        keys     = f.keys;
+        settings = f.settings;
+    }
+
+    std::cout << "Wrote recording : " << path << " (" << frames.size() << " frames, " << out.tellp() << " bytes)" << std::endl;
+    return true;
+}
+
+bool InputRecording::load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "ERROR::RECORDING::CANNOT_READ " << path << std::endl;
+        return false;
+    }
+
+    char     magic[4];
+    uint32_t version = 0;
+    int32_t  w = 0, h = 0;
+    uint32_t count = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || !get(in, version) || version != VERSION)
+    {
+        std::cerr << "ERROR::RECORDING::NOT_A_RECORDING " << path << std::endl;
+        return false;
+    }
+
+    if (!get(in, w) || !get(in, h) || !get(in, count) || !get(in, lastFrame) || !getCamera(in, start))
+    {
+        std::cerr << "ERROR::RECORDING::TRUNCATED " << path << std::endl;
+        return false;
+    }
+
+    width  = w;
+    height = h;
+    frames.clear();
+    frames.reserve(count);
+
+    uint32_t keys     = 0;
+    uint32_t settings = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        InputFrame f;
+        uint8_t    flags = 0;
+        bool       ok    = get(in, flags) && get(in, f.time) && get(in, f.deltaTime);
+
+        if (ok && (flags & HAS_KEYS))
+        {
+            uint16_t k = 0;
+            ok   = get(in, k);
+            keys = k;
+        }
+        if (ok && (flags & HAS_SETTINGS))
+            ok = get(in, settings);
+        if (ok && (flags & HAS_SCROLL))
+            ok = get(in, f.scroll);
+        if (ok && (flags & HAS_CLICK))
+        {
+            f.click = true;
+            ok = get(in, f.clickX) && get(in, f.clickY);
+        }
+        if (ok && (flags & HAS_CAMERA))
+        {
+            f.keyframe = true;
+            ok = getCamera(in, f.camera);
+        }
+
+        if (!ok)
+        {
+            std::cerr << "ERROR::RECORDING::TRUNCATED " << path << " at frame " << i << std::endl;
+            return false;
+        }
+
+        f.keys     = keys;
+        f.settings = settings;
+        frames.push_back(f);
+    }
+
+    return true;
+}
+
+bool InputReplay::start(const std::string& path, Mode m)
+{
+    cursor     = 0;
+    clockStart = -1.0;
+    maxDrift   = 0.0f;
+    resyncs    = 0;
+    mode       = m;
+
+    return recording.load(path);
+}
+
+size_t InputReplay::advance(double now, size_t& first)
+{
+    first = cursor;
+    if (finished())
+        return 0;
+
+    if (mode == FIXED_STEP)
+    {
+        cursor++;
+        return 1;
+    }
+
+    // the clock starts with the first rendered frame, which shows the first recorded one
+    if (clockStart < 0.0)
+        clockStart = now;
+
+    double elapsed = now - clockStart;
+    double t0      = recording.frames.front().time;
+
+    size_t end = cursor;
+    while (end < recording.frames.size() && recording.frames[end].time - t0 <= elapsed)
+        end++;
+
+    cursor = end;
+    return end - first;
+}
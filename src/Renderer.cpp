@@ -0,0 +1,4888 @@
+#include <IMGUI/imgui.h>
+#include <IMGUI/imgui_impl_glfw.h>
+#include <IMGUI/imgui_impl_opengl3.h>
+
+#include <GLAD/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/type_ptr.hpp>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory_resource>
+
+#include <Renderer.hpp>
+#include <Shaders.hpp>
+#include <Culling.hpp>
+#include <BVH.hpp>
+#include <Occlusion.hpp>
+#include <SceneGraph.hpp>
+#include <Entities.hpp>
+#include <Clusters.hpp>
+#include <GpuTimer.hpp>
+#include <Profiler.hpp>
+#include <FrameStats.hpp>
+#include <Recording.hpp>
+#include <Camera.hpp>
+#include <Geometry.hpp>
+#include <MemoryTracker.hpp>
+#include <GpuResources.hpp>
+#include <TextureAtlas.hpp>
+#include <Materials.hpp>
+#include <Jobs.hpp>
+#include <Parallel.hpp>
+#include <TripleBuffer.hpp>
+#include <Animation.hpp>
+
+#define M_PI            3.14159265358979323846
+
+struct Vec4
+{
+    float x;
+    float y;
+    float z;
+    float w;
+};
+
+struct Color4
+{
+    float r;
+    float g;
+    float b;
+    float a;
+};
+
+global_context gc;
+GpuTimers      gpuTimers;
+FrameStats     frameStats;
+MemoryTracker  memoryTracker;
+GpuResources   gpuResources;
+FramePacer     framePacer;
+
+/*
+    Textures and meshes own their GL objects. They can be moved but not copied, the
+    destructor destroys what the object still owns, a moved from object owns nothing.
+    The objects come from the pools in GpuResources.hpp, the handle is what others keep
+    and the GL name is cached for the owner's own draw calls.
+*/
+struct Texture 
+{
+    TextureHandle handle;
+    GLuint id = 0;
+    std::string type;
+    std::string path;
+    std::string uniform;
+    int width, height, nrChannels;
+
+    Texture(const std::string& texturePath, const std::string& uniform) 
+        : uniform(uniform), width(0), height(0), nrChannels(0)
+    {
+        (void)textureFromFile(texturePath.c_str());
+    }    
+
+    explicit Texture(const char *texturePath) 
+        : width(0), height(0), nrChannels(0)
+    {
+        (void)textureFromFile(texturePath);
+    }
+
+    Texture(const Texture&)            = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    Texture(Texture&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    Texture& operator=(Texture&& other) noexcept
+    {
+        if(this != &other)
+        {
+            release();
+            handle     = other.handle;
+            id         = other.id;
+            type       = std::move(other.type);
+            path       = std::move(other.path);
+            uniform    = std::move(other.uniform);
+            width      = other.width;
+            height     = other.height;
+            nrChannels = other.nrChannels;
+            other.handle = TextureHandle();
+            other.id     = 0;
+        }
+        return *this;
+    }
+
+    ~Texture() 
+    {
+        release();
+    }
+
+    void release()
+    {
+        if(!id)
+            return;
+
+        memoryTracker.release(MemoryKind::TEXTURE, id);
+        gpuResources.destroy(handle);
+        id = 0;
+    }
+
+    GLuint textureFromFile(const char *texturePath)
+    {
+        PROFILE_ZONE("Texture::textureFromFile");
+
+        std::cout << "Loading texture from : " << texturePath << std::endl;
+
+        // Generate texture ID
+        handle = gpuResources.createTexture();
+        id     = gpuResources.get(handle);
+
+        // Load image
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char* data = stbi_load(texturePath, &width, &height, &nrChannels, 0);
+
+        if (data) 
+        {
+            GLenum format;
+            switch (nrChannels) {
+                case 1: format = GL_RED; break;
+                case 2: format = GL_RG; break;
+                case 3: format = GL_RGB; break;
+                case 4: format = GL_RGBA; break;
+                default: format = GL_RGB; // Fallback to RGB if unknown
+            }
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+            memoryTracker.track(MemoryKind::TEXTURE, id, textureBytes(format, width, height, true), MemoryTag::TEXTURE, texturePath);
+
+            // Set texture wrapping and filtering options
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            // Filtering
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // scaling down
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // scaling up
+        } 
+        else 
+        {
+            std::cerr << "Failed to load texture: " << texturePath << std::endl;
+        }
+        stbi_image_free(data);
+
+        return id;
+    }
+
+    void bind(GLenum textureUnit = GL_TEXTURE0) const 
+    {
+        glActiveTexture(textureUnit);
+        glBindTexture(GL_TEXTURE_2D, id);
+    }
+
+    void useTextures(GLuint shaderProgram,  unsigned int textureUnit = 0)
+    {
+        // pass textures to the shader
+        setInt(shaderProgram, uniform.c_str(), textureUnit);
+
+        GLenum glTextureUnit = GL_TEXTURE0 + textureUnit;
+        bind(glTextureUnit);
+    }
+};
+
+struct Mesh
+{
+    VertexArrayHandle vertexArray;
+    BufferHandle      vertexBuffer, indexBuffer;
+    GLuint            VAO = 0, VBO = 0, EBO = 0;
+
+    // mesh data
+    std::vector<Vertex>         vertices;
+    std::vector<unsigned int>   indices;
+    uint32_t                    material = 0;   // into the model's MaterialTable, see Materials.hpp
+
+    // object space bounds, filled by the loader
+    AABB                        bounds;
+    BoundingSphere              sphere;
+    bool                        occluder = false;   // rasterized into the CPU occlusion buffer
+    bool                        skinned  = false;   // drawn with the bone palette of its model, in model space
+
+    // scene graph node of the aiNode this mesh hangs off, its world matrix is the mesh's model matrix
+    int32_t                     node     = -1;
+
+    // triangle BVH for ray queries, built (or loaded from the cache) by the Model
+    BVH                         bvh;
+
+    // what the memory of this mesh is reported under, see MemoryTracker.hpp
+    std::string                 name;
+
+    Mesh(std::vector<Vertex>&& vertices, std::vector<unsigned int>&& indices, const std::string& name = "mesh")
+        : vertices(std::move(vertices))
+        , indices(std::move(indices))
+        , name(name)
+    {
+        setupMesh();
+    }
+
+    Mesh(const Mesh&)            = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    Mesh(Mesh&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    Mesh& operator=(Mesh&& other) noexcept
+    {
+        if(this != &other)
+        {
+            release();
+            vertexArray  = other.vertexArray;
+            vertexBuffer = other.vertexBuffer;
+            indexBuffer  = other.indexBuffer;
+            VAO      = other.VAO;
+            VBO      = other.VBO;
+            EBO      = other.EBO;
+            vertices = std::move(other.vertices);
+            indices  = std::move(other.indices);
+            material = other.material;
+            bounds   = other.bounds;
+            sphere   = other.sphere;
+            occluder = other.occluder;
+            skinned  = other.skinned;
+            node     = other.node;
+            bvh      = std::move(other.bvh);
+            name     = std::move(other.name);
+
+            other.vertexArray  = VertexArrayHandle();
+            other.vertexBuffer = other.indexBuffer = BufferHandle();
+            other.VAO = other.VBO = other.EBO = 0;
+        }
+        return *this;
+    }
+
+    ~Mesh()
+    {
+        release();
+    }
+
+    void release()
+    {
+        if(!VAO)
+            return;
+
+        memoryTracker.release(MemoryKind::BUFFER, VBO);
+        memoryTracker.release(MemoryKind::BUFFER, EBO);
+        memoryTracker.release(MemoryKind::HOST, VBO);
+
+        gpuResources.destroy(vertexArray);
+        gpuResources.destroy(vertexBuffer);
+        gpuResources.destroy(indexBuffer);
+        VAO = VBO = EBO = 0;
+    }
+
+    void setupMesh()
+    {
+        vertexArray  = gpuResources.createVertexArray();
+        vertexBuffer = gpuResources.createBuffer();
+        indexBuffer  = gpuResources.createBuffer();
+        VAO = gpuResources.get(vertexArray);
+        VBO = gpuResources.get(vertexBuffer);
+        EBO = gpuResources.get(indexBuffer);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), 
+                     &vertices[0], GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), 
+                     &indices[0], GL_STATIC_DRAW);
+
+        size_t vertexBytes = vertices.size() * sizeof(Vertex);
+        size_t indexBytes  = indices.size() * sizeof(unsigned int);
+        memoryTracker.track(MemoryKind::BUFFER, VBO, vertexBytes, MemoryTag::MESH, name);
+        memoryTracker.track(MemoryKind::BUFFER, EBO, indexBytes, MemoryTag::MESH, name);
+        // the CPU copies stay around for picking and the BVH
+        memoryTracker.track(MemoryKind::HOST, VBO, vertexBytes + indexBytes, MemoryTag::MESH, name);
+
+        // vertex positions
+        glEnableVertexAttribArray(0);   
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+
+        // vertex normals
+        glEnableVertexAttribArray(1);   
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 
+                             (void*)offsetof(Vertex, Normal));
+
+        // vertex texture coords
+        glEnableVertexAttribArray(2);   
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), 
+                             (void*)offsetof(Vertex, TexCoords));
+
+        // vertex tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 
+                             (void*)offsetof(Vertex, Tangent));
+        // vertex bitangent
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                             (void*)offsetof(Vertex, Bitangent));
+        // ids
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex),
+                              (void*)offsetof(Vertex, m_BoneIDs));
+
+        // weights
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 
+                             (void*)offsetof(Vertex, m_Weights));
+
+        glBindVertexArray(0);
+    }
+
+    // the model's texture arrays and material table are already bound, the material index is set by the model
+    void render()
+    {
+        PROFILE_ZONE("Mesh::render");
+
+        // draw mesh
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, (unsigned int)(indices.size()), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
+    // geometry only, for passes that don't read any material
+    void renderDepth()
+    {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, (unsigned int)(indices.size()), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+};
+
+Camera camera;
+
+// transforms of every object in the scene, see SceneGraph.hpp
+SceneGraph sceneGraph;
+
+// per object state (transform, renderable, light, bounds), see Entities.hpp
+EntityStore entities;
+
+// skinned instances and their bone palettes, see Animation.hpp
+Animator animator;
+
+// the Ui's draw lists copied out of ImGui, which starts overwriting its own with the next NewFrame
+struct UiDrawLists
+{
+    ImDrawData               data;      // what ImGui_ImplOpenGL3_RenderDrawData gets, points into lists
+    std::vector<ImDrawList*> lists;     // reused frame to frame, only ever grows
+
+    UiDrawLists() = default;
+    UiDrawLists(const UiDrawLists&)            = delete;
+    UiDrawLists& operator=(const UiDrawLists&) = delete;
+
+    ~UiDrawLists()
+    {
+        for(size_t i = 0; i < lists.size(); i++)
+            IM_DELETE(lists[i]);
+    }
+
+    // resize + memcpy instead of ImVector's operator=, which frees and allocates every time
+    template<typename T>
+    static void copyVector(ImVector<T>& to, const ImVector<T>& from)
+    {
+        to.resize(from.Size);
+        if(from.Size)
+            memcpy(to.Data, from.Data, (size_t)from.Size * sizeof(T));
+    }
+
+    void copy(const ImDrawData *src)
+    {
+        data.Clear();
+        if(!src || !src->Valid)
+            return;
+
+        while(lists.size() < (size_t)src->CmdListsCount)
+            lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+
+        for(int i = 0; i < src->CmdListsCount; i++)
+        {
+            const ImDrawList *from = src->CmdLists[i];
+            ImDrawList       *to   = lists[i];
+
+            copyVector(to->CmdBuffer, from->CmdBuffer);
+            copyVector(to->IdxBuffer, from->IdxBuffer);
+            copyVector(to->VtxBuffer, from->VtxBuffer);
+            to->Flags = from->Flags;
+            data.CmdLists.push_back(to);
+        }
+
+        data.Valid            = true;
+        data.CmdListsCount    = src->CmdListsCount;
+        data.TotalIdxCount    = src->TotalIdxCount;
+        data.TotalVtxCount    = src->TotalVtxCount;
+        data.DisplayPos       = src->DisplayPos;
+        data.DisplaySize      = src->DisplaySize;
+        data.FramebufferScale = src->FramebufferScale;
+    }
+};
+
+/*
+    Everything drawing a frame reads, copied out of the scene at the end of updateScene().
+
+    The scene (camera, sceneGraph, entities, gc) belongs to the update thread, the drawing
+    code only reads the snapshot it was handed through frame. That is what lets the render
+    thread draw one frame while the update thread animates, culls and builds the Ui of the
+    next, see startRenderThread(). Snapshots go from one thread to the other through a
+    TripleBuffer, the vectors in the three of them keep their storage so a steady scene
+    copies without allocating.
+*/
+struct FrameSnapshot
+{
+    uint64_t               index = 0;           // update frames before this one
+
+    global_context         gc;                  // time, size, toggles and the target framebuffer
+    Camera                 camera;
+    std::vector<glm::mat4> world;               // sceneGraph.world
+    std::vector<BoneMatrix> bonePalette;        // animator.palette
+    EntityStore            entities;            // see EntityStore::copyDrawState, visibility is culled already
+    ClusterGrid            clusters;            // point lights of forward frames, see assignLights
+    std::vector<glm::vec4> clusterLights;       // 4 texels per light in clusters
+
+    float                  background[3]   = { 0.0f, 0.0f, 0.0f };
+    float                  cubeShininess   = 32.0f;
+    float                  sphereShininess = 32.0f;
+    bool                   reloadShaders   = false;
+
+    bool                   ui = false;          // uiDraw holds this frame's Ui
+    UiDrawLists            uiDraw;
+    std::vector<float>     occlusionDepth;      // only while the Ui shows the occlusion buffer
+
+    int                    swapInterval = 1;    // framePacer.swapInterval(), set where the context is
+};
+
+// the snapshot being drawn, only valid on the thread that draws
+FrameSnapshot *frame = nullptr;
+
+/*
+    What the Ui shows about drawing, handed back the other way after every frame that was
+    drawn. The Ui builds on the update thread and reads these instead of the objects the
+    render thread is busy with.
+*/
+struct RenderStats
+{
+    uint64_t                      index = 0;            // of the snapshot drawn
+
+    bool                          gpuTimersAvailable = false;
+    std::vector<GpuTimers::Stats> gpuZones;
+    uint64_t                      gpuDropped = 0;
+
+    float                         overdrawAverage  = 0.0f;
+    float                         overdrawMax      = 0.0f;
+    unsigned int                  shadedFragments  = 0;
+    unsigned int                  coveredPixels    = 0;
+
+    uint32_t                      clusterLights    = 0;
+    size_t                        clusterIndices   = 0;
+    uint32_t                      maxPerCluster    = 0;
+    double                        lightAssignment  = 0.0;  // ms
+
+    unsigned int                  lightVolumes     = 0;
+    unsigned int                  fullscreenPasses = 0;
+
+    GpuResources::Stats           pools;
+    GLuint                        occlusionTexture = 0;   // 0 until the buffer was shown once
+    uint64_t                      droppedSnapshots = 0;   // published but replaced before they were drawn
+};
+
+TripleBuffer<FrameSnapshot> snapshots;
+TripleBuffer<RenderStats>   renderStats;
+
+// entity layers, every display mode shows a couple of them
+enum SceneLayer : uint32_t
+{
+    LAYER_CUBES        = 1 << 0,
+    LAYER_SPHERES      = 1 << 1,
+    LAYER_MODEL        = 1 << 2,
+    LAYER_POINT_LIGHTS = 1 << 3,
+    LAYER_LIGHT        = 1 << 4,    // the single light of the sphere scene
+    LAYER_ALL          = 0xFFFFFFFF
+};
+
+uint32_t activeLayers()
+{
+    if(gc.model)
+        return LAYER_MODEL | LAYER_POINT_LIGHTS;
+    if(gc.sphere)
+        return LAYER_SPHERES | LAYER_LIGHT;
+    return LAYER_CUBES | LAYER_POINT_LIGHTS;
+}
+
+// renderable mesh handles: which renderer draws it in the top byte, its mesh index below
+enum MeshKind : uint32_t
+{
+    MESH_CUBE,
+    MESH_SPHERE,
+    MESH_MODEL,
+    MESH_LIGHT
+};
+
+inline uint32_t meshHandle(MeshKind kind, uint32_t index) { return (uint32_t)kind << 24 | index; }
+inline MeshKind meshKind(uint32_t handle)  { return (MeshKind)(handle >> 24); }
+inline uint32_t meshIndex(uint32_t handle) { return handle & 0xFFFFFF; }
+
+struct Coordinates
+{
+    VertexArrayHandle vertexArray;
+    BufferHandle      vertexBuffer;
+    GLuint VAO;
+    GLuint VBO;
+
+    GLuint shaderProgram;
+
+    glm::mat4 model;
+
+    Coordinates() : model(glm::mat4(1.0f))
+    {
+        setupAxes();
+        initShaders();
+    }
+
+    ~Coordinates()
+    {
+        memoryTracker.release(MemoryKind::BUFFER, VBO);
+        gpuResources.destroy(vertexArray);
+        gpuResources.destroy(vertexBuffer);
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+    }
+
+    // owns its GL objects, a copy would destroy them under the original
+    Coordinates(const Coordinates&)            = delete;
+    Coordinates& operator=(const Coordinates&) = delete;
+
+    void setupAxes()
+    {
+       const float axesVertices[] = 
+       {
+            // X axis (Red)
+            0.0f, 0.0f, 0.0f,       1.0f, 0.0f, 0.0f, // Origin
+            5.0f, 0.0f, 0.0f,       1.0f, 0.0f, 0.0f, // X direction
+
+            // Y axis (Green)
+            0.0f, 0.0f, 0.0f,       0.0f, 1.0f, 0.0f, // Origin
+            0.0f, 5.0f, 0.0f,       0.0f, 1.0f, 0.0f, // Y direction
+
+            // Z axis (Blue)
+            0.0f, 0.0f, 0.0f,       0.0f, 0.0f, 1.0f, // Origin
+            0.0f, 0.0f, 5.0f,       0.0f, 0.0f, 1.0f  // Z direction
+        };
+
+        vertexArray  = gpuResources.createVertexArray();
+        vertexBuffer = gpuResources.createBuffer();
+        VAO = gpuResources.get(vertexArray);
+        VBO = gpuResources.get(vertexBuffer);
+
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(axesVertices), axesVertices, GL_STATIC_DRAW);
+        memoryTracker.track(MemoryKind::BUFFER, VBO, sizeof(axesVertices), MemoryTag::DEBUG, "axes");
+
+        // Position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // Color attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0); 
+    }
+
+    void initShaders()
+    {
+        std::string vertexSource    = readShaderSource("../shaders/axes_vs.glsl");
+        std::string fragmentSource  = readShaderSource("../shaders/axes_fs.glsl");
+        shaderProgram   = createShaderProgram(vertexSource, fragmentSource);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+        initShaders();
+    }
+
+    void render()
+    {
+        GpuZone zone(gpuTimers, "Axes");
+
+        glUseProgram(shaderProgram);
+
+        setMat4(shaderProgram, "model", model);
+        setMat4(shaderProgram, "view", frame->camera.getViewMatrix());
+        setMat4(shaderProgram, "projection", frame->camera.getProjectionMatrix());
+
+        glLineWidth(2.0f);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_LINES, 0, 6); // 6 vertices for 3 lines (X, Y, Z)
+        glBindVertexArray(0);
+        glLineWidth(1.0f); // Reset to default
+    }
+};
+Coordinates *world_axes;
+
+struct Grid
+{
+    VertexArrayHandle vertexArray;
+    BufferHandle      vertexBuffer;
+    GLuint VAO;
+    GLuint VBO;
+
+    GLuint shaderProgram;
+
+    glm::mat4 model;
+
+    Grid(): model(glm::mat4(1.0f)) 
+    {
+        setupGrid();
+        initShader();
+    }
+
+    ~Grid() 
+    {
+        memoryTracker.release(MemoryKind::BUFFER, VBO);
+        gpuResources.destroy(vertexArray);
+        gpuResources.destroy(vertexBuffer);
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+    }
+
+    void setupGrid()
+    {
+        // A large quad for the grid (XZ plane)
+        const float vertices[] = {
+            // Positions                 // UVs
+            -50.0f, 0.0f, -50.0f,        0.0f, 0.0f,
+             50.0f, 0.0f, -50.0f,       50.0f, 0.0f,
+             50.0f, 0.0f,  50.0f,       50.0f, 50.0f,
+            -50.0f, 0.0f,  50.0f,        0.0f, 50.0f
+        };
+
+        vertexArray  = gpuResources.createVertexArray();
+        vertexBuffer = gpuResources.createBuffer();
+        VAO = gpuResources.get(vertexArray);
+        VBO = gpuResources.get(vertexBuffer);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        memoryTracker.track(MemoryKind::BUFFER, VBO, sizeof(vertices), MemoryTag::DEBUG, "grid");
+
+        // Position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // UV attribute
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+    }
+
+    void initShader() 
+    {
+        std::string vertexSource = readShaderSource("../shaders/grid_vs.glsl");
+        std::string fragmentSource = readShaderSource("../shaders/grid_fs.glsl");
+        shaderProgram = createShaderProgram(vertexSource, fragmentSource);
+    }
+
+    void updateShader()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+        initShader();
+    }
+
+    void render() 
+    {
+        PROFILE_ZONE("Grid::render");
+
+        glUseProgram(shaderProgram);
+        
+        setFloat(shaderProgram, "time", (float)frame->gc.currentTime);
+
+        setMat4(shaderProgram, "model", model);
+        setMat4(shaderProgram, "view", frame->camera.getViewMatrix());
+        setMat4(shaderProgram, "projection", frame->camera.getProjectionMatrix());
+
+        setVec3(shaderProgram, "cameraPos", frame->camera.pos);
+
+        GLboolean cullingEnabled;
+        glGetBooleanv(GL_CULL_FACE, &cullingEnabled);
+        GLint cullFaceMode;
+        glGetIntegerv(GL_CULL_FACE_MODE, &cullFaceMode);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_CULL_FACE);  // So we see it from both sides
+        
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+        glBindVertexArray(0);
+
+        // Restore culling state
+        if (cullingEnabled) {
+            glEnable(GL_CULL_FACE);
+            glCullFace(cullFaceMode);
+        }
+    }
+};
+Grid *grid;
+
+/*
+    Draws the small cubes that show where the point lights are. The lights themselves
+    are entities, see createPointLight().
+*/
+struct LightGizmo
+{
+    VertexArrayHandle vertexArray;
+    GLuint VAO;
+
+    // the cube's, the gizmo stops drawing once the cube lets go of them
+    BufferHandle VBO;
+    BufferHandle EBO;
+
+    GLuint shaderProgram;
+
+    glm::mat4 model;
+
+    Coordinates axes;
+
+    LightGizmo(BufferHandle VBO, BufferHandle EBO) 
+        : VBO(VBO),
+          EBO(EBO)
+    {
+        setupDebugCube();
+        initShaders();
+    }
+
+    ~LightGizmo() 
+    {
+        gpuResources.destroy(vertexArray);
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+    }
+
+    void initShaders()
+    {
+        std::string vertexSource    = readShaderSource("../shaders/light_vs.glsl");
+        std::string fragmentSource  = readShaderSource("../shaders/light_fs.glsl");
+        shaderProgram   = createShaderProgram(vertexSource, fragmentSource);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+        initShaders();
+    }
+
+    void setupDebugCube()
+    {
+        vertexArray = gpuResources.createVertexArray();
+        VAO         = gpuResources.get(vertexArray);
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, gpuResources.get(VBO));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpuResources.get(EBO));
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)0);
+        // glEnableVertexAttribArray(3);
+
+        glBindVertexArray(0);
+    }
+
+    // every visible light gizmo renderable
+    void render() 
+    {   
+        PROFILE_ZONE("LightGizmo::render");
+
+        // the VAO would still point at the old names, which may already hold something else
+        if(!gpuResources.valid(VBO) || !gpuResources.valid(EBO))
+            return;
+
+        const RenderableComponents& r = frame->entities.renderables;
+
+        if(frame->gc.debug)
+        {
+            for(size_t i = 0; i < r.size(); i++)
+            {
+                if(r.visible[i] && meshKind(r.mesh[i]) == MESH_LIGHT)
+                {
+                    model = frame->world[r.node[i]];
+                    renderDebugAxes();
+                }
+            }
+        }
+
+        glUseProgram(shaderProgram);
+
+        setMat4(shaderProgram, "view", frame->camera.getViewMatrix());
+        setMat4(shaderProgram, "projection", frame->camera.getProjectionMatrix()); 
+
+        glBindVertexArray(VAO);
+        for(size_t i = 0; i < r.size(); i++)
+        {
+            if(!r.visible[i] || meshKind(r.mesh[i]) != MESH_LIGHT)
+                continue;
+
+            model = frame->world[r.node[i]];
+
+            setVec3(shaderProgram, "lightColor", frame->entities.lights.color[frame->entities.lightSlot[r.entity[i]]]);
+            setMat4(shaderProgram, "model", model);
+
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0); // Use EBO
+        }
+        glBindVertexArray(0);
+    }
+
+    void renderDebugAxes()
+    {
+        axes.model = model;
+        axes.render();
+    }
+};
+LightGizmo *lightGizmo;
+
+Entity light;
+Entity dirLight;
+Entity pointLight[4];
+Entity spotLight;
+
+// point light with a gizmo cube scaled down to 0.2
+Entity createPointLight(const glm::vec3& pos, uint32_t layer)
+{
+    AABB unitCube(glm::vec3(-0.5f), glm::vec3(0.5f));
+
+    Entity  e    = entities.create(layer);
+    int32_t node = sceneGraph.addNode(-1, glm::mat4(1.0f), unitCube);
+
+    entities.addTransform(e, node, pos, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.2f));
+    entities.addLight(e, LightType::POINT, node);
+    entities.addBounds(e, node, unitCube);
+    entities.addRenderable(e, node, meshHandle(MESH_LIGHT, 0), 0);
+    return e;
+}
+
+Entity createLight(LightType type)
+{
+    Entity e = entities.create(LAYER_ALL);
+    entities.addLight(e, type);
+    return e;
+}
+
+// distance where a point or spot light stops contributing, driven by its brightest channel
+float lightRange(const LightComponents& l, uint32_t slot)
+{
+    glm::vec3 brightest = glm::max(l.diffuse[slot], glm::max(l.specular[slot], l.ambient[slot]));
+    float     intensity = std::max(brightest.r, std::max(brightest.g, brightest.b));
+    return lightRadius(l.constant[slot], l.linear[slot], l.quadratic[slot], intensity);
+}
+
+// assigns the point lights to clusters on the update side, where the build runs on the job
+// workers, drawing only uploads what ends up in the snapshot
+void assignLights(FrameSnapshot& s)
+{
+    PROFILE_ZONE("assignLights");
+
+    static std::vector<uint32_t>  slots;
+    static std::vector<glm::vec3> positions;
+    static std::vector<float>     radii;
+
+    const LightComponents& l = entities.lights;
+    entities.gatherLights(LightType::POINT, LAYER_POINT_LIGHTS, slots);
+
+    positions.resize(slots.size());
+    radii.resize(slots.size());
+    s.clusterLights.resize(std::max<size_t>(slots.size(), 1) * 4);
+
+    for(size_t i = 0; i < slots.size(); i++)
+    {
+        uint32_t p = slots[i];
+
+        positions[i] = l.position[p];
+        radii[i]     = lightRange(l, p);
+
+        s.clusterLights[4 * i]     = glm::vec4(l.position[p], radii[i]);
+        s.clusterLights[4 * i + 1] = glm::vec4(l.diffuse[p],  l.constant[p]);
+        s.clusterLights[4 * i + 2] = glm::vec4(l.specular[p], l.linear[p]);
+        s.clusterLights[4 * i + 3] = glm::vec4(l.ambient[p],  l.quadratic[p]);
+    }
+
+    s.clusters.build(camera.getViewMatrix(), camera.getProjectionMatrix(), camera.zNear, camera.zFar,
+                     positions.data(), radii.data(), slots.size());
+
+    // an empty buffer can not back a texture, keep at least one element around
+    if(s.clusters.indices.empty())
+        s.clusters.indices.push_back(0);
+}
+
+/*
+    GPU side of the clustered point lights. Light data, the cluster table and the per cluster
+    light lists go into texture buffers that model_fs/cube_fs walk, see Clusters.hpp. They are
+    built with the snapshot (assignLights), this only uploads them.
+*/
+struct ClusteredLights
+{
+    // texture units, well above what the materials use
+    static const int LIGHT_UNIT = 10;
+    static const int GRID_UNIT  = 11;
+    static const int INDEX_UNIT = 12;
+
+    BufferHandle           lightBuffer, gridBuffer, indexBuffer;
+    TextureHandle          lightTexture, gridTexture, indexTexture;
+
+    ClusteredLights()
+    {
+        lightBuffer = gpuResources.createBuffer();
+        gridBuffer  = gpuResources.createBuffer();
+        indexBuffer = gpuResources.createBuffer();
+
+        lightTexture = gpuResources.createTexture();
+        gridTexture  = gpuResources.createTexture();
+        indexTexture = gpuResources.createTexture();
+    }
+
+    ~ClusteredLights()
+    {
+        BufferHandle *buffers[] = { &lightBuffer, &gridBuffer, &indexBuffer };
+        for(BufferHandle *buffer : buffers)
+        {
+            memoryTracker.release(MemoryKind::BUFFER, gpuResources.get(*buffer));
+            gpuResources.destroy(*buffer);
+        }
+        gpuResources.destroy(lightTexture);
+        gpuResources.destroy(gridTexture);
+        gpuResources.destroy(indexTexture);
+    }
+
+    // uploads the lists of the frame being drawn
+    void update()
+    {
+        PROFILE_ZONE("ClusteredLights::update");
+
+        const ClusterGrid& grid = frame->clusters;
+
+        upload(lightBuffer, lightTexture, GL_RGBA32F, frame->clusterLights.size() * sizeof(glm::vec4), frame->clusterLights.data());
+        upload(gridBuffer, gridTexture, GL_RG32UI, grid.grid.size() * sizeof(uint32_t), grid.grid.data());
+        upload(indexBuffer, indexTexture, GL_R32UI, grid.indices.size() * sizeof(uint32_t), grid.indices.data());
+    }
+
+    void upload(BufferHandle bufferHandle, TextureHandle textureHandle, GLenum format, size_t size, const void *data)
+    {
+        GLuint buffer  = gpuResources.get(bufferHandle);
+        GLuint texture = gpuResources.get(textureHandle);
+
+        // orphan the old storage so the driver does not wait for last frame's draws
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+        memoryTracker.track(MemoryKind::BUFFER, buffer, size, MemoryTag::LIGHTING, "light clusters");
+
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void bind(GLuint shaderProgram)
+    {
+        glActiveTexture(GL_TEXTURE0 + LIGHT_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, gpuResources.get(lightTexture));
+        glActiveTexture(GL_TEXTURE0 + GRID_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, gpuResources.get(gridTexture));
+        glActiveTexture(GL_TEXTURE0 + INDEX_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, gpuResources.get(indexTexture));
+        glActiveTexture(GL_TEXTURE0);
+
+        setInt(shaderProgram, "clusterLights",  LIGHT_UNIT);
+        setInt(shaderProgram, "clusterGrid",    GRID_UNIT);
+        setInt(shaderProgram, "clusterIndices", INDEX_UNIT);
+
+        glUniform3i(glGetUniformLocation(shaderProgram, "clusterDims"),
+                    ClusterGrid::TILES_X, ClusterGrid::TILES_Y, ClusterGrid::SLICES);
+        setFloat(shaderProgram, "clusterScale", frame->clusters.sliceScale());
+        setFloat(shaderProgram, "clusterBias",  frame->clusters.sliceBias());
+        setMat4(shaderProgram, "view", frame->camera.getViewMatrix());
+    }
+};
+ClusteredLights *clusters;
+
+/*
+    GPU side of the skinning. The bone palettes of every animated instance go into one
+    texture buffer each frame, model_vs/depth_vs fetch the 3 rows of a bone's matrix from
+    it, see Animation.hpp.
+*/
+struct SkinningBuffer
+{
+    // next to the cluster buffers
+    static const int BONE_UNIT = 13;
+
+    BufferHandle  bufferHandle;
+    TextureHandle textureHandle;
+    GLuint        buffer  = 0;
+    GLuint        texture = 0;
+
+    SkinningBuffer()
+    {
+        bufferHandle  = gpuResources.createBuffer();
+        textureHandle = gpuResources.createTexture();
+        buffer        = gpuResources.get(bufferHandle);
+        texture       = gpuResources.get(textureHandle);
+    }
+
+    ~SkinningBuffer()
+    {
+        memoryTracker.release(MemoryKind::BUFFER, buffer);
+        gpuResources.destroy(bufferHandle);
+        gpuResources.destroy(textureHandle);
+    }
+
+    void upload(const std::vector<BoneMatrix>& palette)
+    {
+        PROFILE_ZONE("SkinningBuffer::upload");
+
+        size_t size = palette.size() * sizeof(BoneMatrix);
+
+        // orphaned like the cluster buffers, last frame's draws may still read the old palette
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        glBufferData(GL_TEXTURE_BUFFER, size, palette.data(), GL_STREAM_DRAW);
+        memoryTracker.track(MemoryKind::BUFFER, buffer, size, MemoryTag::MESH, "bone palettes");
+
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void bind(GLuint shaderProgram)
+    {
+        glActiveTexture(GL_TEXTURE0 + BONE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glActiveTexture(GL_TEXTURE0);
+
+        setInt(shaderProgram, "bonePalette", BONE_UNIT);
+    }
+};
+SkinningBuffer *skinning;
+
+// random short range point lights (no gizmo) to stress the clustered lighting
+std::vector<Entity> testLights;
+
+void spawnTestLights(int count)
+{
+    for(size_t i = 0; i < testLights.size(); i++)
+        entities.destroy(testLights[i]);
+    testLights.clear();
+
+    for(int i = 0; i < count; i++)
+    {
+        auto random = [](float lo, float hi) {
+            return lo + (hi - lo) * (static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
+        };
+
+        Entity e = entities.create(LAYER_POINT_LIGHTS);
+        entities.addLight(e, LightType::POINT);
+
+        uint32_t l = entities.lightSlot[e];
+        entities.lights.position[l]  = glm::vec3(random(-10.0f, 10.0f), random(-5.0f, 5.0f), random(-15.0f, 5.0f));
+        entities.lights.linear[l]    = 0.7f;
+        entities.lights.quadratic[l] = 1.8f;
+        entities.setLightColor(e, glm::vec3(random(0.2f, 1.0f), random(0.2f, 1.0f), random(0.2f, 1.0f)));
+
+        testLights.push_back(e);
+    }
+}
+
+// directional and spot light uniforms plus the clustered point lights, shared by the cube and model shaders
+void setLightUniforms(GLuint shaderProgram)
+{
+    static std::vector<uint32_t> slots;
+    const LightComponents& l = frame->entities.lights;
+
+    if(frame->entities.gatherLights(LightType::DIRECTIONAL, LAYER_ALL, slots))
+    {
+        uint32_t d = slots[0];
+        setVec3(shaderProgram, "dirLight.direction",    l.direction[d]);
+        setVec3(shaderProgram, "dirLight.ambient",      l.ambient[d]);
+        setVec3(shaderProgram, "dirLight.diffuse",      l.diffuse[d]);
+        setVec3(shaderProgram, "dirLight.specular",     l.specular[d]);
+    }
+
+    clusters->bind(shaderProgram);
+
+    if(frame->entities.gatherLights(LightType::SPOT, LAYER_ALL, slots))
+    {
+        uint32_t sp = slots[0];
+        setVec3(shaderProgram, "spotLight.position",    l.position[sp]);
+        setVec3(shaderProgram, "spotLight.direction",   l.direction[sp]);
+        setVec3(shaderProgram, "spotLight.diffuse",     l.diffuse[sp]);
+        setVec3(shaderProgram, "spotLight.ambient",     l.ambient[sp]);
+        setVec3(shaderProgram, "spotLight.specular",    l.specular[sp]);
+
+        setFloat(shaderProgram, "spotLight.constant",   l.constant[sp]);
+        setFloat(shaderProgram, "spotLight.linear",     l.linear[sp]);
+        setFloat(shaderProgram, "spotLight.quadratic",  l.quadratic[sp]);
+
+        setFloat(shaderProgram, "spotLight.cutoff",      l.cutoff[sp]);
+        setFloat(shaderProgram, "spotLight.outerCutoff", l.outerCutoff[sp]);
+    }
+}
+
+struct PickResult
+{
+    bool      hit      = false;
+    int       mesh     = -1;
+    uint32_t  triangle = 0;
+    glm::vec3 barycentric;      // weights of the triangle's 3 vertices
+    glm::vec3 position;         // world space
+    float     distance = 0.0f;
+    double    time     = 0.0;   // us
+};
+PickResult pick;
+
+// input recording and replay, at most one of the two is active
+InputRecording *recording = nullptr;
+InputReplay    *replay    = nullptr;
+
+// scroll and clicks that arrived through the callbacks since the last processInput
+InputFrame      pendingInput;
+
+double          previousFrame = 0.0;    // gc.lastFrame before the current frame started
+bool            resumeClock   = false;
+
+// framePacer's redraw sources of what the scene update knows is moving, see FramePacing.hpp
+int             animationSource = -1;
+int             replaySource    = -1;
+int             uiSource        = -1;
+
+// asked for by the input, done by whoever draws the next snapshot
+bool            reloadShaders = false;
+
+// a texture file of a model, path relative to the model
+struct ModelTexture
+{
+    std::string path;
+};
+
+// an assimp mesh converted on a worker, waiting for processNode to turn it into a Mesh
+struct ConvertedMesh
+{
+    std::vector<Vertex>       vertices;
+    std::vector<unsigned int> indices;
+    AABB                      bounds;
+    int32_t                   mesh = -1;        // the Mesh it was moved into, later nodes using it copy that one
+};
+
+struct Model
+{
+    std::vector<ModelTexture> textures_loaded;
+    TextureArrays            textureArrays;     // every texture of textures_loaded, packed
+    MaterialTable            materials;         // what the meshes' material indices point at
+    std::vector<Mesh>        meshes;
+    std::string              directory;         // use this to fetch textures an other stuff assuming they are in the same folder
+
+    GLuint                   shaderProgram;
+    GLuint                   gbufferProgram;
+    bool                     gammaCorrection;
+
+    glm::vec3                modelPos;
+
+    glm::mat4                model;
+    int32_t                  rootNode;
+    Entity                   entity;            // owns the root transform, every mesh is an entity of its own
+
+    // only for files with bones: the skinned meshes are drawn with the palette of one animator instance
+    Skeleton                 skeleton;
+    std::vector<CompressedClip> clips;
+    int32_t                  animation  = -1;      // into animator.instances
+    uint32_t                 boneOffset = 0;       // its first bone in the palette
+    int                      clip       = 0;       // the one playing
+
+    Coordinates              axes;
+
+    // heap allocations made by the last loadModel, see loadModel
+    uint64_t loadAllocations = 0;
+
+    // meshes whose bounding sphere is at least this fraction of the model's become occluders
+    bool  useOccluders      = true;
+    float occluderThreshold = 0.25f;
+
+    Model(std::string const &path, bool gamma = false) 
+        : gammaCorrection(gamma), modelPos(glm::vec3(0.0f, 0.0f, 0.0f))
+    {
+        // the assimp hierarchy is added below this node
+        rootNode = sceneGraph.addNode(-1);
+        loadModel(path);
+        markOccluders();
+        createEntities();
+        initShaders();
+    }
+
+    void createEntities()
+    {
+        entity = entities.create(LAYER_MODEL);
+        entities.addTransform(entity, rootNode, modelPos);
+
+        for(size_t i = 0; i < meshes.size(); i++)
+        {
+            // skinning takes the vertices to model space, the node a skinned mesh hangs off doesn't move it
+            int32_t node   = meshes[i].skinned ? rootNode : meshes[i].node;
+            AABB    bounds = meshes[i].skinned ? skinnedBounds(meshes[i]) : meshes[i].bounds;
+
+            Entity e = entities.create(LAYER_MODEL);
+            entities.addRenderable(e, node, meshHandle(MESH_MODEL, (uint32_t)i), meshes[i].material, meshes[i].occluder);
+            entities.addBounds(e, node, bounds);
+        }
+    }
+
+    // model space box around every pose of every clip, the bind pose bounds would cull swinging limbs
+    AABB skinnedBounds(const Mesh& mesh)
+    {
+        std::vector<uint8_t> used(skeleton.boneCount(), 0);
+        for(const Vertex& v : mesh.vertices)
+        {
+            for(int k = 0; k < MAX_BONE_INFLUENCE; k++)
+            {
+                if(v.m_Weights[k] > 0.0f)
+                    used[v.m_BoneIDs[k]] = 1;
+            }
+        }
+
+        AABB bounds = animatedBounds(skeleton, (const CompressedClip *)nullptr, mesh.bounds, used.data());
+        for(const CompressedClip& c : clips)
+            bounds.expand(animatedBounds(skeleton, &c, mesh.bounds, used.data()));
+        return bounds;
+    }
+
+    void play(int index)
+    {
+        if(animation < 0 || index < 0 || index >= (int)clips.size())
+            return;
+
+        clip = index;
+        animator.instances[animation].compressed = &clips[index];
+        animator.instances[animation].time = 0.0f;
+    }
+
+    void markOccluders()
+    {
+        AABB modelBounds;
+        for(size_t i = 0; i < meshes.size(); i++)
+            modelBounds.expand(meshes[i].bounds);
+
+        float modelRadius = sphereFromAABB(modelBounds).radius;
+        for(size_t i = 0; i < meshes.size(); i++)
+            meshes[i].occluder = meshes[i].sphere.radius >= occluderThreshold * modelRadius;
+    }
+
+    void render()
+    {
+        PROFILE_ZONE("Model::render");
+
+        model = frame->world[rootNode];
+
+        if(frame->gc.debug && !frame->gc.depthPrepass)
+        {
+            renderDebugAxes();
+        }
+
+        glUseProgram(shaderProgram);
+
+        // Pass uniform variables to the shader
+        setFloat(shaderProgram, "iTime", (float)frame->gc.currentTime);
+        setFloat2(shaderProgram,"iResolution", (float)frame->gc.width, (float)frame->gc.height);
+
+        setVec3(shaderProgram, "viewPos", frame->camera.pos);
+
+        setLightUniforms(shaderProgram);
+
+        // view/projection transformations
+        setMat4(shaderProgram, "projection", frame->camera.getProjectionMatrix());
+        setMat4(shaderProgram, "view", frame->camera.getViewMatrix());
+
+        drawMeshes(shaderProgram);
+    }
+
+    // G-buffer pass of the deferred renderer, no lighting at all
+    void renderGeometry()
+    {
+        model = frame->world[rootNode];
+
+        glUseProgram(gbufferProgram);
+
+        setMat4(gbufferProgram, "projection", frame->camera.getProjectionMatrix());
+        setMat4(gbufferProgram, "view", frame->camera.getViewMatrix());
+
+        drawMeshes(gbufferProgram);
+    }
+
+    // Just draw all the meshes that survived culling, each with the transform of its node
+    // and the index of its material, nothing else changes between the draws
+    void drawMeshes(GLuint program)
+    {
+        textureArrays.bind(0);
+        materials.bind();
+        skinning->bind(program);
+        setInt(program, "boneOffset", (int)boneOffset);
+
+        GLint modelLocation    = glGetUniformLocation(program, "model");
+        GLint materialLocation = glGetUniformLocation(program, "materialIndex");
+        GLint skinnedLocation  = glGetUniformLocation(program, "skinned");
+
+        const RenderableComponents& r = frame->entities.renderables;
+        for(size_t i = 0; i < r.size(); i++){
+            if(r.visible[i] && meshKind(r.mesh[i]) == MESH_MODEL)
+            {
+                Mesh& mesh = meshes[meshIndex(r.mesh[i])];
+                glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(frame->world[r.node[i]]));
+                glUniform1i(materialLocation, (GLint)r.material[i]);
+                glUniform1i(skinnedLocation, mesh.skinned);
+                mesh.render();
+            }
+        }
+    }
+
+    // same meshes without binding any textures
+    void drawDepth(GLuint program)
+    {
+        skinning->bind(program);
+        setInt(program, "boneOffset", (int)boneOffset);
+
+        const RenderableComponents& r = frame->entities.renderables;
+        for(size_t i = 0; i < r.size(); i++){
+            if(r.visible[i] && meshKind(r.mesh[i]) == MESH_MODEL)
+            {
+                Mesh& mesh = meshes[meshIndex(r.mesh[i])];
+                setMat4(program, "model", frame->world[r.node[i]]);
+                setInt(program, "skinned", mesh.skinned);
+                mesh.renderDepth();
+            }
+        }
+
+        // the cubes and spheres draw with the same program
+        setInt(program, "skinned", 0);
+    }
+
+    void renderDebugAxes()
+    {
+        axes.model = model;
+        axes.render(); 
+    }
+
+    // the transform is only rewritten when the model actually moved
+    void positionModel()
+    {
+        entities.setPosition(entity, modelPos);
+    }
+
+    void initShaders()
+    {
+        // Load and compile shaders
+        std::string vertexSource   = readShaderSource("../shaders/model_vs.glsl");
+        std::string fragmentSource = readShaderSource("../shaders/model_fs.glsl");
+        shaderProgram              = createShaderProgram(vertexSource, fragmentSource);
+
+        std::string gbufferSource  = readShaderSource("../shaders/gbuffer_model_fs.glsl");
+        gbufferProgram             = createShaderProgram(vertexSource, gbufferSource);
+
+        // texture units and the material block binding never change, set them once per program
+        for(GLuint program : { shaderProgram, gbufferProgram })
+        {
+            glUseProgram(program);
+            setInt(program, "textureAtlas", 0);
+            for(int i = 0; i < TextureArrays::LAYER_ARRAYS; i++)
+                setInt(program, "textureLayers[" + std::to_string(i) + "]", 1 + i);
+            MaterialTable::bindBlock(program);
+        }
+        glUseProgram(0);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+        gpuResources.retire(GpuResource::PROGRAM, gbufferProgram);
+        initShaders();
+    }
+
+    void loadModel(std::string const &path)
+    {
+        PROFILE_ZONE("Model::loadModel");
+
+        // read file
+        Assimp::Importer importer;
+        const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals| aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+
+        // check errors
+        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) 
+        {
+            std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+            return;
+        }
+
+        // everything below allocates what it keeps up front, sized from the assimp counts.
+        // Temporaries (paths, names, BVH build arrays) come from this arena and go away
+        // with it at the end of the load. Every heap allocation of the load is counted, the
+        // ones of the jobs it runs included, see AllocationScope
+        AllocationScope heap;
+        auto            start = std::chrono::high_resolution_clock::now();
+
+        std::pmr::monotonic_buffer_resource arena(64 * 1024);
+
+        // get the directory of the filepath and assuming everything exist there
+        // directory = path.substr(0, path.find_last_of('\\')); 
+        directory = std::filesystem::path(path).parent_path().string();
+
+        meshes.reserve(scene->mNumMeshes);
+        textures_loaded.reserve(scene->mNumMaterials * TEXTURE_SLOTS);
+
+        // bones and clips before the meshes, the vertices get their bone ids from the skeleton
+        loadAnimations(scene);
+
+        // the materials some mesh uses, in assimp's order. The meshes hold assimp's material
+        // index until buildMaterials swaps it for the one in the table
+        std::pmr::vector<Material> sceneMaterials(scene->mNumMaterials, Material(), &arena);
+        std::pmr::vector<uint8_t>  usedMaterials(scene->mNumMaterials, 0, &arena);
+        for(unsigned int i = 0; i < scene->mNumMeshes; i++)
+        {
+            unsigned int m = scene->mMeshes[i]->mMaterialIndex;
+            if(m < scene->mNumMaterials && !usedMaterials[m])
+            {
+                usedMaterials[m]  = 1;
+                sceneMaterials[m] = convertMaterial(scene->mMaterials[m]);
+            }
+        }
+
+        // the vertex conversion doesn't touch GL, every mesh is a job of its own
+        std::pmr::vector<ConvertedMesh> converted(scene->mNumMeshes, &arena);
+        jobs.parallelFor(scene->mNumMeshes, 1, [&](size_t begin, size_t end)
+        {
+            PROFILE_ZONE("Model::convertMeshes");
+            for(size_t i = begin; i < end; i++)
+            {
+                convertMesh(scene->mMeshes[i], converted[i].vertices, converted[i].indices, converted[i].bounds);
+                if(scene->mMeshes[i]->HasBones() && skeleton.boneCount())
+                    convertBoneWeights(scene->mMeshes[i], skeleton, converted[i].vertices.data());
+            }
+        });
+
+        // process root node recursively
+        processNode(scene->mRootNode, scene, rootNode, converted, &arena);
+        buildTextureArrays(&arena);
+        buildMaterials(sceneMaterials, usedMaterials);
+
+        std::pmr::string cachePath(path.c_str(), &arena);
+        cachePath += ".bvh";
+        buildBVHs(cachePath.c_str(), &arena);
+
+        arena.release();
+
+        loadAllocations = heap.allocations();
+        double ms       = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "Loaded model : " << path << ", " << meshes.size() << " meshes, " << textures_loaded.size()
+                  << " textures, " << materials.materials.size() << " materials, " << loadAllocations << " allocations, " << ms << " ms" << std::endl;
+        if(animation >= 0)
+            std::cout << "Skeleton : " << skeleton.jointCount() << " joints, " << skeleton.boneCount() << " bones, "
+                      << clips.size() << " clips" << std::endl;
+    }
+
+    // the skeleton and every clip, resampled for it and compressed, the resampled frames
+    // are dropped. The model plays the first clip (or holds the bind pose) as one animator instance
+    void loadAnimations(const aiScene *scene)
+    {
+        PROFILE_ZONE("Model::loadAnimations");
+
+        if(!importSkeleton(scene, skeleton))
+            return;
+
+        std::vector<size_t> rawBytes(scene->mNumAnimations);
+        clips.resize(scene->mNumAnimations);
+        jobs.parallelFor(scene->mNumAnimations, 1, [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                AnimationClip raw;
+                importClip(scene->mAnimations[i], skeleton, raw);
+                compressClip(skeleton, raw, clips[i]);
+                rawBytes[i] = raw.samples.size() * sizeof(float);
+            }
+        });
+
+        size_t source = 0, resampled = 0, compressed = 0;
+        for(size_t i = 0; i < clips.size(); i++)
+        {
+            if(clips[i].name.empty())
+                clips[i].name = "clip " + std::to_string(i);
+            source     += clips[i].sourceBytes;
+            resampled  += rawBytes[i];
+            compressed += clips[i].bytes();
+        }
+        if(!clips.empty())
+            std::cout << "Animation : " << source / 1024 << " KB of keys, " << resampled / 1024 << " KB resampled, "
+                      << compressed / 1024 << " KB compressed (" << (double)resampled / std::max<size_t>(compressed, 1)
+                      << "x)" << std::endl;
+
+        animation  = (int32_t)animator.add(&skeleton, clips.empty() ? nullptr : &clips[0]);
+        boneOffset = animator.instances[animation].paletteOffset;
+    }
+
+    // BVHs of big models take a while to build so they are cached next to the asset,
+    // a cache entry is only used if the hash of the mesh geometry still matches
+    void buildBVHs(const char *cachePath, std::pmr::memory_resource *arena)
+    {
+        PROFILE_ZONE("Model::buildBVHs");
+
+        std::ifstream in(cachePath, std::ios::binary);
+        bool   useCache = in.good();
+        size_t loaded   = 0;
+        size_t built    = 0;    // meshes with triangles, the ones the cache holds an entry for
+
+        // one block big enough for the largest mesh, every build starts over at its beginning
+        void   *scratch      = nullptr;
+        size_t  scratchBytes = 0;
+
+        for(size_t i = 0; i < meshes.size(); i++)
+        {
+            Mesh& mesh = meshes[i];
+            if(mesh.vertices.empty() || mesh.indices.size() < 3)
+                continue;
+            built++;
+
+            uint64_t hash = hashGeometry(&mesh.vertices[0].Position, sizeof(Vertex), mesh.vertices.size(),
+                                         mesh.indices.data(), mesh.indices.size());
+
+            if(useCache && mesh.bvh.read(in) && mesh.bvh.sourceHash == hash)
+            {
+                loaded++;
+                continue;
+            }
+            // entries are stored in mesh order, after the first miss the rest can't be trusted
+            useCache = false;
+
+            if(!scratch)
+            {
+                for(const Mesh& m : meshes)
+                    scratchBytes = std::max(scratchBytes, BVH::scratchBytes(m.indices.size()));
+                scratch = arena->allocate(scratchBytes, alignof(std::max_align_t));
+            }
+            std::pmr::monotonic_buffer_resource buildScratch(scratch, scratchBytes, arena);
+
+            mesh.bvh.build(&mesh.vertices[0].Position, sizeof(Vertex), mesh.indices.data(), mesh.indices.size(), &buildScratch);
+            mesh.bvh.sourceHash = hash;
+        }
+        in.close();
+
+        if(loaded == built)
+        {
+            std::cout << "Loaded BVH cache : " << cachePath << std::endl;
+            return;
+        }
+
+        std::ofstream out(cachePath, std::ios::binary);
+        for(size_t i = 0; i < meshes.size(); i++)
+        {
+            if(!meshes[i].bvh.empty())
+                meshes[i].bvh.write(out);
+        }
+        if(!out)
+            std::cerr << "Failed to write BVH cache: " << cachePath << std::endl;
+    }
+
+    // closest hit of a world space ray against all meshes
+    bool raycast(const glm::vec3& origin, const glm::vec3& dir, PickResult& result)
+    {
+        RayHit hit;
+        int    hitMesh = -1;
+        for(size_t i = 0; i < meshes.size(); i++)
+        {
+            // intersect in object space, t stays the same since the transform is affine
+            glm::mat4 invModel = glm::inverse(sceneGraph.world[meshes[i].node]);
+            glm::vec3 o = glm::vec3(invModel * glm::vec4(origin, 1.0f));
+            glm::vec3 d = glm::vec3(invModel * glm::vec4(dir, 0.0f));
+
+            if(meshes[i].bvh.intersect(o, d, hit))
+                hitMesh = (int)i;
+        }
+
+        result.hit = hitMesh >= 0;
+        if(!result.hit)
+            return false;
+
+        result.mesh        = hitMesh;
+        result.triangle    = hit.triangle;
+        result.barycentric = glm::vec3(1.0f - hit.u - hit.v, hit.u, hit.v);
+        result.distance    = hit.t;
+        result.position    = origin + dir * hit.t;
+        return true;
+    }
+
+    // Process each mesh located at the nodes and all of its children,
+    // every aiNode becomes a scene graph node with its own local transform
+    void processNode(aiNode *node, const aiScene *scene, int32_t parentNode, std::pmr::vector<ConvertedMesh>& converted,
+                     std::pmr::memory_resource *arena)
+    {
+        // aiMatrix4x4 is row major
+        glm::mat4 local = glm::transpose(glm::make_mat4(&node->mTransformation.a1));
+        int32_t   idx   = sceneGraph.addNode(parentNode, local);
+
+        // process all the node's meshes (if any)
+        AABB bounds;
+        for(size_t i = 0; i < node->mNumMeshes; i++)
+        {
+            meshes.push_back(processMesh(node->mMeshes[i], scene, converted, arena));
+            meshes.back().node = idx;
+            bounds.expand(meshes.back().bounds);
+        }
+        sceneGraph.setLocalBounds(idx, bounds);
+
+        // then do the same for each of its children
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        {
+            processNode(node->mChildren[i], scene, idx, converted, arena);
+        }
+    }
+
+    Mesh processMesh(unsigned int meshIndex, const aiScene *scene, std::pmr::vector<ConvertedMesh>& converted,
+                     std::pmr::memory_resource *arena)
+    {
+        PROFILE_ZONE("Model::processMesh");
+
+        aiMesh        *mesh = scene->mMeshes[meshIndex];
+        ConvertedMesh& data = converted[meshIndex];
+
+        // the vectors end up in the mesh, convertMesh sized them exactly. Only a mesh that
+        // hangs off more than one node is copied
+        std::vector<Vertex>         vertices;
+        std::vector<unsigned int>   indices;
+        AABB                        bounds = data.bounds;
+        if(data.mesh < 0)
+        {
+            vertices  = std::move(data.vertices);
+            indices   = std::move(data.indices);
+            data.mesh = (int32_t)meshes.size();     // processNode appends the result right away
+        }
+        else
+        {
+            vertices = meshes[data.mesh].vertices;
+            indices  = meshes[data.mesh].indices;
+        }
+
+        // asset folder and mesh name, npos + 1 is the whole string
+        std::pmr::string name(directory.c_str() + directory.find_last_of("/\\") + 1, arena);
+        name += '/';
+        name += mesh->mName.C_Str();
+
+        Mesh result(std::move(vertices), std::move(indices), std::string(name.data(), name.size()));
+        result.bounds = bounds;
+        result.sphere = sphereFromAABB(bounds);
+
+        // assimp's index for now, see loadModel
+        result.material = mesh->mMaterialIndex < scene->mNumMaterials ? mesh->mMaterialIndex : 0;
+        result.skinned  = mesh->HasBones() && animation >= 0;
+
+        return result;
+    }
+
+    Material convertMaterial(aiMaterial *material)
+    {
+        Material result;
+
+        // obj files put normal maps under bump (HEIGHT)
+        result.textures.texture[SLOT_DIFFUSE]  = findMaterialTexture(material, aiTextureType_DIFFUSE);
+        result.textures.texture[SLOT_NORMAL]   = findMaterialTexture(material, aiTextureType_HEIGHT);
+        result.textures.texture[SLOT_SPECULAR] = findMaterialTexture(material, aiTextureType_SPECULAR);
+
+        // exporters write 0 when there is no highlight at all, keep the old default for those
+        float shininess = 0.0f;
+        if(material->Get(AI_MATKEY_SHININESS, shininess) == AI_SUCCESS && shininess > 0.0f)
+            result.shininess = shininess;
+
+        return result;
+    }
+
+    // resolves the materials against the texture arrays and interns them into the table
+    void buildMaterials(std::pmr::vector<Material>& sceneMaterials, const std::pmr::vector<uint8_t>& used)
+    {
+        std::pmr::vector<uint32_t> remap(sceneMaterials.size(), 0, sceneMaterials.get_allocator().resource());
+        for(size_t m = 0; m < sceneMaterials.size(); m++)
+        {
+            if(!used[m])
+                continue;
+
+            textureArrays.resolve(sceneMaterials[m].textures);
+            remap[m] = materials.intern(sceneMaterials[m]);
+        }
+
+        for(Mesh& mesh : meshes)
+            mesh.material = remap[mesh.material];
+
+        materials.upload(directory.c_str() + directory.find_last_of("/\\") + 1);
+    }
+
+    // the first texture of a given type, added to textures_loaded if it isn't in there yet. The
+    // pixels are only read once every mesh is processed, see buildTextureArrays
+    int32_t findMaterialTexture(aiMaterial *mat, aiTextureType type)
+    {
+        if(mat->GetTextureCount(type) == 0)
+            return -1;
+
+        aiString str;
+        mat->GetTexture(type, 0, &str);
+
+        // a texture with the same filepath has already been loaded,
+        // continue to next one. (optimization)
+        int loaded = findTexture(textures_loaded, str.C_Str());
+        if(loaded < 0)
+        {
+            ModelTexture texture;
+            texture.path = str.C_Str();
+            textures_loaded.push_back(std::move(texture));
+            loaded = (int)textures_loaded.size() - 1;
+        }
+        return loaded;
+    }
+
+    // packs every texture of the model into the layer and atlas arrays. The sizes are read
+    // first, then the images are decoded on the workers and uploaded on the main thread as
+    // they come in, so only the ones between decode and upload are in memory
+    void buildTextureArrays(std::pmr::memory_resource *arena)
+    {
+        PROFILE_ZONE("Model::buildTextureArrays");
+
+        std::pmr::vector<std::pmr::string> files(arena);
+        std::vector<glm::ivec2>            sizes(textures_loaded.size(), glm::ivec2(0));
+        files.reserve(textures_loaded.size());
+
+        for(size_t i = 0; i < textures_loaded.size(); i++)
+        {
+            // material paths are relative to the model, exporters on Windows write them with
+            // backslashes which only Windows takes as separators. A forward slash works everywhere
+            std::string file = textures_loaded[i].path;
+            std::replace(file.begin(), file.end(), '\\', '/');
+            files.emplace_back((std::filesystem::path(directory) / file).string().c_str());
+
+            int channels;
+            if(!stbi_info(files.back().c_str(), &sizes[i].x, &sizes[i].y, &channels))
+            {
+                std::cerr << "Failed to load texture: " << files.back() << std::endl;
+                sizes[i] = glm::ivec2(0);
+            }
+        }
+
+        textureArrays.pack(sizes);
+        textureArrays.create(directory.c_str() + directory.find_last_of("/\\") + 1);
+
+        // set before any decode job runs, stb_image keeps it in a global
+        stbi_set_flip_vertically_on_load(true);
+
+        JobCounter uploads;
+        jobs.parallelFor(files.size(), 1, [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                if(sizes[i].x == 0)
+                    continue;
+
+                PROFILE_ZONE("Model::decodeTexture");
+
+                int w, h, channels;
+                unsigned char *data = stbi_load(files[i].c_str(), &w, &h, &channels, 4);
+                bool           fits = data && w == sizes[i].x && h == sizes[i].y;
+
+                const char *file = files[i].c_str();
+                jobs.runOnMain([this, data, fits, file, i]()
+                {
+                    std::cout << "Loading texture from : " << file << std::endl;
+                    if(fits)
+                        textureArrays.upload(i, data);
+                    stbi_image_free(data);
+                }, &uploads);
+            }
+        });
+        jobs.wait(uploads);
+
+        textureArrays.generateMipmaps();
+
+        std::cout << "Texture arrays : " << textureArrays.pageCount[TextureArrays::ATLAS] << " atlas pages of "
+                  << textureArrays.pageSize[TextureArrays::ATLAS];
+        for(int a = TextureArrays::LAYERS; a < TextureArrays::ARRAYS; a++)
+        {
+            if(textureArrays.pageCount[a])
+                std::cout << ", " << textureArrays.pageCount[a] << " layers of " << textureArrays.pageSize[a];
+        }
+        std::cout << ", " << textureArrays.wastedBytes / 1024 << " KB of layers unused" << std::endl;
+    }
+};
+Model *model;
+
+struct Cube
+{
+    VertexArrayHandle vertexArray;
+    BufferHandle      vertexBuffer, indexBuffer;    // shared with the light gizmos
+    GLuint     VAO;
+    GLuint     VBO;
+    GLuint     EBO;
+
+    GLuint     shaderProgram;
+    GLuint     gbufferProgram;
+
+    glm::mat4  model;
+
+    Coordinates axes;
+
+    glm::vec3  cubePositions[10];
+    glm::vec3  cubeColors[10];
+
+    // corners of the cube for the CPU occlusion rasterizer
+    glm::vec3    occluderVertices[8];
+    unsigned int occluderIndices[36];
+
+    int32_t             rootNode;
+    std::vector<Entity> instances;
+    double              animatedTime = -1.0;
+    int                 redrawSource;       // on while the cubes are shown, they never stop moving
+
+    Texture* diffuseMap  = nullptr;
+    Texture* specularMap = nullptr;
+    Texture* emissionMap = nullptr;
+
+    glm::vec3 materialAmbient;
+    glm::vec3 materialDiffuse;
+    glm::vec3 materialSpecular;
+
+    float shininess = 32.0f;
+    
+    Cube()
+    {
+        setupCube();
+        initShaders();
+        redrawSource = framePacer.addRedrawSource("cubes");
+    }
+
+    ~Cube()
+    {
+        memoryTracker.release(MemoryKind::BUFFER, EBO);
+        memoryTracker.release(MemoryKind::BUFFER, VBO);
+        gpuResources.destroy(vertexArray);
+        gpuResources.destroy(indexBuffer);
+        gpuResources.destroy(vertexBuffer);
+
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+        gpuResources.retire(GpuResource::PROGRAM, gbufferProgram);
+
+        delete diffuseMap;
+        delete specularMap;
+        delete emissionMap;
+    }
+
+    void setupCube()
+    {
+        // materialAmbient  = glm::vec3(1.0f, 0.5f, 0.31f);
+        // materialDiffuse  = glm::vec3(1.0f, 0.5f, 0.31f);
+        // materialSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
+
+        for(int i = 0; i < 10; i++)
+        {
+            cubeColors[i] = getRandomCubeColor();
+        }
+
+        cubePositions[0] = glm::vec3( 0.0f,  0.0f,  0.0f);
+        cubePositions[1] = glm::vec3( 2.0f,  5.0f, -15.0f);
+        cubePositions[2] = glm::vec3(-1.5f, -2.2f, -2.5f);
+        cubePositions[3] = glm::vec3(-3.8f, -2.0f, -12.3f);
+        cubePositions[4] = glm::vec3( 2.4f, -0.4f, -3.5f);
+        cubePositions[5] = glm::vec3(-1.7f,  3.0f, -7.5f);
+        cubePositions[6] = glm::vec3( 1.3f, -2.0f, -2.5f);
+        cubePositions[7] = glm::vec3( 1.5f,  2.0f, -2.5f);
+        cubePositions[8] = glm::vec3( 1.5f,  0.2f, -1.5f);
+        cubePositions[9] = glm::vec3(-1.3f,  1.0f, -1.5f);
+
+        for(int i = 0; i < 8; i++)
+        {
+            occluderVertices[i] = glm::vec3((i & 1) ? 0.5f : -0.5f,
+                                            (i & 2) ? 0.5f : -0.5f,
+                                            (i & 4) ? 0.5f : -0.5f);
+        }
+        const unsigned int faces[36] = 
+        {
+            0, 2, 3,  3, 1, 0,      // -z
+            4, 5, 7,  7, 6, 4,      // +z
+            0, 4, 6,  6, 2, 0,      // -x
+            1, 3, 7,  7, 5, 1,      // +x
+            0, 1, 5,  5, 4, 0,      // -y
+            2, 6, 7,  7, 3, 2       // +y
+        };
+        std::copy(faces, faces + 36, occluderIndices);
+
+        rootNode = sceneGraph.addNode(-1);
+        for(int i = 0; i < 10; i++)
+        {
+            AABB    box(glm::vec3(-0.5f), glm::vec3(0.5f));
+            int32_t node = sceneGraph.addNode(rootNode, glm::translate(glm::mat4(1.0f), cubePositions[i]), box);
+
+            Entity e = entities.create(LAYER_CUBES);
+            entities.addTransform(e, node, cubePositions[i]);
+            entities.addRenderable(e, node, meshHandle(MESH_CUBE, 0), (uint32_t)i, true);
+            entities.addBounds(e, node, box);
+            instances.push_back(e);
+        }
+
+        /*------------------------- setup vertex data and buffers and configure attributes -------------------------*/
+        const float vertices[] = 
+        {
+            // Front face (Z+)
+            // Pos                 Color               Texture coord     Normal
+            -0.5f, -0.5f,  0.5f,   1.0f, 0.0f, 0.0f,   0.0f, 0.0f,      0.0f, 0.0f, 1.0f,
+             0.5f, -0.5f,  0.5f,   1.0f, 0.0f, 0.0f,   1.0f, 0.0f,      0.0f, 0.0f, 1.0f, 
+             0.5f,  0.5f,  0.5f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,      0.0f, 0.0f, 1.0f,
+            -0.5f,  0.5f,  0.5f,   1.0f, 0.0f, 0.0f,   0.0f, 1.0f,      0.0f, 0.0f, 1.0f,
+            
+            // Back face (Z-)
+            -0.5f, -0.5f, -0.5f,   0.0f, 1.0f, 0.0f,   0.0f, 0.0f,      0.0f, 0.0f, -1.0f,
+             0.5f, -0.5f, -0.5f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,      0.0f, 0.0f, -1.0f,
+             0.5f,  0.5f, -0.5f,   0.0f, 1.0f, 0.0f,   1.0f, 1.0f,      0.0f, 0.0f, -1.0f,
+            -0.5f,  0.5f, -0.5f,   0.0f, 1.0f, 0.0f,   0.0f, 1.0f,      0.0f, 0.0f, -1.0f,
+            
+            // Left face (X-)
+            -0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,      -1.0f, 0.0f, 0.0f,
+            -0.5f, -0.5f,  0.5f,   0.0f, 0.0f, 1.0f,   1.0f, 0.0f,      -1.0f, 0.0f, 0.0f,
+            -0.5f,  0.5f,  0.5f,   0.0f, 0.0f, 1.0f,   1.0f, 1.0f,      -1.0f, 0.0f, 0.0f,
+            -0.5f,  0.5f, -0.5f,   0.0f, 0.0f, 1.0f,   0.0f, 1.0f,      -1.0f, 0.0f, 0.0f,
+            
+            // Right face (X+)
+             0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 0.0f,   0.0f, 0.0f,      1.0f, 0.0f, 0.0f,
+             0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 0.0f,   1.0f, 0.0f,      1.0f, 0.0f, 0.0f,
+             0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 0.0f,   1.0f, 1.0f,      1.0f, 0.0f, 0.0f,
+             0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f,      1.0f, 0.0f, 0.0f,
+            
+            // Bottom face (Y-)
+            -0.5f, -0.5f, -0.5f,   0.0f, 1.0f, 1.0f,   0.0f, 0.0f,      0.0f, -1.0f, 0.0f,
+             0.5f, -0.5f, -0.5f,   0.0f, 1.0f, 1.0f,   1.0f, 0.0f,      0.0f, -1.0f, 0.0f,
+             0.5f, -0.5f,  0.5f,   0.0f, 1.0f, 1.0f,   1.0f, 1.0f,      0.0f, -1.0f, 0.0f,
+            -0.5f, -0.5f,  0.5f,   0.0f, 1.0f, 1.0f,   0.0f, 1.0f,      0.0f, -1.0f, 0.0f,
+            
+            // Top face (Y+)
+            -0.5f,  0.5f, -0.5f,   1.0f, 0.0f, 1.0f,   0.0f, 0.0f,      0.0f, 1.0f, 0.0f,
+             0.5f,  0.5f, -0.5f,   1.0f, 0.0f, 1.0f,   1.0f, 0.0f,      0.0f, 1.0f, 0.0f,
+             0.5f,  0.5f,  0.5f,   1.0f, 0.0f, 1.0f,   1.0f, 1.0f,      0.0f, 1.0f, 0.0f,
+            -0.5f,  0.5f,  0.5f,   1.0f, 0.0f, 1.0f,   0.0f, 1.0f,      0.0f, 1.0f, 0.0f
+        };
+
+        // To avoid duplicating vertices, indices are used to define 
+        // how the vertices are connected to form triangles.
+        const unsigned int indices[] = 
+        {
+            // Front
+            0, 1, 2,
+            2, 3, 0,
+            // Back
+            4, 5, 6,
+            6, 7, 4,
+            // Left
+            8, 9, 10,
+            10, 11, 8,
+            // Right
+            12, 13, 14,
+            14, 15, 12,
+            // Bottom
+            16, 17, 18,
+            18, 19, 16,
+            // Top
+            20, 21, 22,
+            22, 23, 20
+        };
+
+        // vertex array object: any subsequent vertex attribute calls from 
+        // that point on will be stored inside the VAO.
+        // configuring vertex attribute pointers only needed once
+        vertexArray = gpuResources.createVertexArray();
+        VAO         = gpuResources.get(vertexArray);
+        glBindVertexArray(VAO);
+        /*----------------------------------------------------------------------*/
+        // Element buffer object
+        indexBuffer = gpuResources.createBuffer();
+        EBO         = gpuResources.get(indexBuffer);
+        // copy index array into element buffer for opengl to use
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW); // copy them to GPU
+        memoryTracker.track(MemoryKind::BUFFER, EBO, sizeof(indices), MemoryTag::MESH, "cube");
+        /*----------------------------------------------------------------------*/
+        // vertex buffer object : memory on the GPU where we store the vertex data
+        vertexBuffer = gpuResources.createBuffer(); // Generate a buffer object with unique ID
+        VBO          = gpuResources.get(vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+        /*----------------------------------------------------------------------*/
+        // copies the previously defined vertex data into the buffer's memory
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        memoryTracker.track(MemoryKind::BUFFER, VBO, sizeof(vertices), MemoryTag::MESH, "cube");
+
+        /*----------------------------------------------------------------------*/
+        // Tell OpenGL how it should interpret the vertex data (position attribute)
+        // Position attribute (location = 0)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)0);
+        // Enable the vertex attribute, giving the vertex attribute location as its argument
+        glEnableVertexAttribArray(0);
+
+        // Color attribute (location = 1)
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(3*sizeof(float)));
+        // Enable the vertex attribute, giving the vertex attribute location as its argument
+        glEnableVertexAttribArray(1);
+
+        // Texture coordinate attribute (location = 2)
+        // 2D texture
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2); 
+
+        // Normal attribute (location = 3)
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(8*sizeof(float)));
+        glEnableVertexAttribArray(3);
+
+        // UNBIND
+        glBindVertexArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); 
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // the cubes wobble with time, so their nodes are the only ones that change every frame
+    void animate()
+    {
+        if(animatedTime == gc.currentTime)
+            return;
+        animatedTime = gc.currentTime;
+
+        glm::quat q = glm::angleAxis((float)sin(gc.currentTime), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+        for(size_t i = 0; i < instances.size(); i++)
+        {
+            entities.setRotation(instances[i], q);
+        }
+    }
+
+    void positionCube(int idx)
+    {
+        model = frame->world[frame->entities.transforms.node[frame->entities.transformSlot[instances[idx]]]];
+    }
+
+    void initShaders()
+    {
+        // Load and compile shaders
+        std::string vertexSource   = readShaderSource("../shaders/cube_vs.glsl");
+        std::string fragmentSource = readShaderSource("../shaders/cube_fs.glsl");
+        shaderProgram              = createShaderProgram(vertexSource, fragmentSource);
+
+        std::string gbufferSource  = readShaderSource("../shaders/gbuffer_cube_fs.glsl");
+        gbufferProgram             = createShaderProgram(vertexSource, gbufferSource);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+        gpuResources.retire(GpuResource::PROGRAM, gbufferProgram);
+        initShaders();
+    }
+
+    glm::vec3 getRandomCubeColor()
+    {
+        // Generate random float values between 0.0 and 1.0 for r, g, b components
+        float r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+        float g = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+        float b = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+        
+        // Return color as vec3
+        return glm::vec3(r, g, b);
+    }
+
+    void updateCubeColor(int idx)
+    {
+        materialDiffuse = cubeColors[idx] * glm::vec3(0.5f); 
+        materialAmbient = materialDiffuse * glm::vec3(0.2f); 
+    }
+
+    void render()
+    {
+        PROFILE_ZONE("Cube::render");
+
+        if(frame->gc.debug && !frame->gc.depthPrepass)
+        {
+            renderDebugAxes();
+        }
+
+        // Activate shader program
+        glUseProgram(shaderProgram);
+
+        // Pass uniform variables to the shader
+        setFloat(shaderProgram, "iTime", (float)frame->gc.currentTime);
+        setFloat2(shaderProgram,"iResolution", (float)frame->gc.width, (float)frame->gc.height);
+
+        setVec3(shaderProgram, "viewPos", frame->camera.pos);
+
+        setLightUniforms(shaderProgram);
+
+        // setVec3(shaderProgram, "material.specular", materialSpecular);
+        // setVec3(shaderProgram, "material.ambient", materialAmbient);
+        // setVec3(shaderProgram, "material.diffuse", materialDiffuse);
+        setFloat(shaderProgram, "material.shininess", frame->cubeShininess);
+
+        diffuseMap->useTextures(shaderProgram, 0);
+        specularMap->useTextures(shaderProgram, 1);
+        emissionMap->useTextures(shaderProgram, 2);
+
+        glm::mat4 view = frame->camera.getViewMatrix();
+        glm::mat4 projection = frame->camera.getProjectionMatrix();
+
+        setMat4(shaderProgram, "view", view);
+        setMat4(shaderProgram, "projection", projection);        
+
+        drawCubes(shaderProgram);
+    }
+
+    // G-buffer pass of the deferred renderer, the emission map is not part of it
+    void renderGeometry()
+    {
+        glUseProgram(gbufferProgram);
+
+        setFloat(gbufferProgram, "material.shininess", frame->cubeShininess);
+
+        diffuseMap->useTextures(gbufferProgram, 0);
+        specularMap->useTextures(gbufferProgram, 1);
+
+        setMat4(gbufferProgram, "view", frame->camera.getViewMatrix());
+        setMat4(gbufferProgram, "projection", frame->camera.getProjectionMatrix());
+
+        drawCubes(gbufferProgram);
+    }
+
+    void drawCubes(GLuint program)
+    {
+        // to render only the VAO is required to be bound
+        glBindVertexArray(VAO);
+
+        const RenderableComponents& r = frame->entities.renderables;
+        for(size_t i = 0; i < r.size(); i++)
+        {
+            if(!r.visible[i] || meshKind(r.mesh[i]) != MESH_CUBE)
+                continue;
+
+            model = frame->world[r.node[i]];
+            // updateCubeColor(r.material[i]);
+
+            setMat4(program, "model", model); 
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        }
+
+        glBindVertexArray(0);
+    }
+
+    void renderDebugAxes()
+    {
+        positionCube(3);
+        axes.model = model;
+        axes.render(); 
+    }
+};
+Cube *cube;
+
+struct Sphere
+{
+    VertexArrayHandle vertexArray;
+    BufferHandle      vertexBuffer, indexBuffer;
+    GLuint VAO;
+    GLuint VBO;
+    GLuint EBO;
+
+    GLuint shaderProgram;
+
+    Coordinates axes;
+
+    glm::vec3 spherePositions[10];
+    glm::vec3 sphereColors[10];
+
+    glm::mat4 model;
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    float radius = 0.5f;
+    int sectorCount = 36;
+    int stackCount = 18;
+
+    float shininess = 32.0f;
+
+    glm::vec3 materialAmbient;
+    glm::vec3 materialDiffuse;
+    glm::vec3 materialSpecular;
+
+    int32_t             rootNode;
+    std::vector<Entity> instances;
+
+    Sphere()
+    {
+        setupSphere();
+        initShaders();
+    }
+
+    ~Sphere()
+    {
+        memoryTracker.release(MemoryKind::BUFFER, EBO);
+        memoryTracker.release(MemoryKind::BUFFER, VBO);
+        gpuResources.destroy(vertexArray);
+        gpuResources.destroy(indexBuffer);
+        gpuResources.destroy(vertexBuffer);
+
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+    }
+
+    void setupSphere()
+    {
+        materialAmbient  = glm::vec3(1.0f, 0.5f, 0.31f);
+        materialDiffuse  = glm::vec3(1.0f, 0.5f, 0.31f);
+        materialSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
+
+        for (int i = 0; i < 10; i++)
+        {
+            sphereColors[i] = getRandomSphereColor();
+        }
+
+        spherePositions[0] = glm::vec3(0.0f, 0.0f, 0.0f);
+        spherePositions[1] = glm::vec3(2.0f, 5.0f, -15.0f);
+        spherePositions[2] = glm::vec3(-1.5f, -2.2f, -2.5f);
+        spherePositions[3] = glm::vec3(-3.8f, -2.0f, -12.3f);
+        spherePositions[4] = glm::vec3(2.4f, -0.4f, -3.5f);
+        spherePositions[5] = glm::vec3(-1.7f, 3.0f, -7.5f);
+        spherePositions[6] = glm::vec3(1.3f, -2.0f, -2.5f);
+        spherePositions[7] = glm::vec3(1.5f, 2.0f, -2.5f);
+        spherePositions[8] = glm::vec3(1.5f, 0.2f, -1.5f);
+        spherePositions[9] = glm::vec3(-1.3f, 1.0f, -1.5f);
+
+        rootNode = sceneGraph.addNode(-1);
+        for (int i = 0; i < 10; i++)
+        {
+            AABB    box(glm::vec3(-radius), glm::vec3(radius));
+            int32_t node = sceneGraph.addNode(rootNode, glm::translate(glm::mat4(1.0f), spherePositions[i]), box);
+
+            // the color of the sphere is its material
+            Entity e = entities.create(LAYER_SPHERES);
+            entities.addTransform(e, node, spherePositions[i]);
+            entities.addRenderable(e, node, meshHandle(MESH_SPHERE, 0), (uint32_t)i, true);
+            entities.addBounds(e, node, box);
+            instances.push_back(e);
+        }
+
+        /*------------------------- setup vertex data and buffers and configure attributes -------------------------*/
+
+        generateSphere(vertices, indices, radius, sectorCount, stackCount);
+
+        // vertex array object: any subsequent vertex attribute calls from 
+        // that point on will be stored inside the VAO.
+        // configuring vertex attribute pointers only needed once
+        vertexArray = gpuResources.createVertexArray();
+        VAO         = gpuResources.get(vertexArray);
+        glBindVertexArray(VAO);
+        /*----------------------------------------------------------------------*/
+        // Element buffer object
+        indexBuffer = gpuResources.createBuffer();
+        EBO         = gpuResources.get(indexBuffer);
+        // copy index array into element buffer for opengl to use
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW); // copy them to GPU
+        memoryTracker.track(MemoryKind::BUFFER, EBO, indices.size() * sizeof(unsigned int), MemoryTag::MESH, "sphere");
+        /*----------------------------------------------------------------------*/
+        // vertex buffer object : memory on the GPU where we store the vertex data
+        vertexBuffer = gpuResources.createBuffer(); // Generate a buffer object with unique ID
+        VBO          = gpuResources.get(vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+        /*----------------------------------------------------------------------*/
+        // copies the previously defined vertex data into the buffer's memory
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+        memoryTracker.track(MemoryKind::BUFFER, VBO, vertices.size() * sizeof(float), MemoryTag::MESH, "sphere");
+
+        /*----------------------------------------------------------------------*/
+        // Tell OpenGL how it should interpret the vertex data (position attribute)
+        // Position attribute (location = 0)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        // Enable the vertex attribute, giving the vertex attribute location as its argument
+        glEnableVertexAttribArray(0);
+
+        // Normal attribute (location = 1)
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        // Texture coordinate attribute (location = 2)
+        // 2D texture
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        // UNBIND
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void positionSphere(int idx)
+    {
+        model = frame->world[frame->entities.transforms.node[frame->entities.transformSlot[instances[idx]]]];
+    }
+
+    void initShaders()
+    {
+        // Load and compile shaders
+        std::string vertexSource = readShaderSource("../shaders/sphere_vs.glsl");
+        std::string fragmentSource = readShaderSource("../shaders/sphere_fs.glsl");
+        shaderProgram = createShaderProgram(vertexSource, fragmentSource);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, shaderProgram);
+        initShaders();
+    }
+
+    glm::vec3 getRandomSphereColor()
+    {
+        // Generate random float values between 0.0 and 1.0 for r, g, b components
+        float r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+        float g = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+        float b = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+
+        // Return color as vec3
+        return glm::vec3(r, g, b);
+    }
+
+    void updateSphereColor(int idx)
+    {
+        materialDiffuse = sphereColors[idx] * glm::vec3(0.5f); 
+        materialAmbient = materialDiffuse * glm::vec3(0.2f); 
+    }
+
+    void render()
+    {
+        PROFILE_ZONE("Sphere::render");
+
+        if (frame->gc.debug && !frame->gc.depthPrepass)
+        {
+            renderDebugAxes();
+        }
+
+        // Activate shader program
+        glUseProgram(shaderProgram);
+
+        // Pass uniform variables to the shader
+        setFloat(shaderProgram, "iTime", (float)frame->gc.currentTime);
+        setFloat2(shaderProgram, "iResolution", (float)frame->gc.width, (float)frame->gc.height);
+
+        setVec3(shaderProgram, "viewPos", frame->camera.pos);
+
+        uint32_t l = frame->entities.lightSlot[light];
+        setVec3(shaderProgram, "light.position", frame->entities.lights.position[l]);
+        setVec3(shaderProgram, "light.diffuse", frame->entities.lights.diffuse[l]);
+        setVec3(shaderProgram, "light.ambient", frame->entities.lights.ambient[l]);
+        setVec3(shaderProgram, "light.specular", frame->entities.lights.specular[l]);
+
+        setVec3(shaderProgram, "material.specular",materialSpecular);
+        setFloat(shaderProgram, "material.shininess", frame->sphereShininess);
+
+        glm::mat4 view = frame->camera.getViewMatrix();
+        glm::mat4 projection = frame->camera.getProjectionMatrix();
+
+        setMat4(shaderProgram, "view", view);
+        setMat4(shaderProgram, "projection", projection);
+
+        // to render only the VAO is required to be bound
+        glBindVertexArray(VAO);
+
+        const RenderableComponents& r = frame->entities.renderables;
+        for (size_t i = 0; i < r.size(); i++)
+        {
+            if (!r.visible[i] || meshKind(r.mesh[i]) != MESH_SPHERE)
+                continue;
+
+            // camera.updateOrbitPosition(gc.currentTime, 10.0f);
+            model = frame->world[r.node[i]];
+            updateSphereColor(r.material[i]);
+
+            setVec3(shaderProgram, "material.ambient", materialAmbient);
+            setVec3(shaderProgram, "material.diffuse", materialDiffuse);
+            
+            setMat4(shaderProgram, "model", model);
+            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        glBindVertexArray(0);
+    }
+
+    void drawDepth(GLuint program)
+    {
+        glBindVertexArray(VAO);
+
+        const RenderableComponents& r = frame->entities.renderables;
+        for (size_t i = 0; i < r.size(); i++)
+        {
+            if (!r.visible[i] || meshKind(r.mesh[i]) != MESH_SPHERE)
+                continue;
+
+            setMat4(program, "model", frame->world[r.node[i]]);
+            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        glBindVertexArray(0);
+    }
+
+    void renderDebugAxes()
+    {
+        positionSphere(3);
+        axes.model = model;
+        axes.render();
+    }
+};
+Sphere *sphere;
+
+/*
+    Deferred shading for the cube and model scenes.
+
+    The geometry pass writes albedo + specular, normal + shininess and depth/stencil into a
+    G-buffer. Depth and stencil are then blitted to the window and the lights are added on
+    top: the directional light as one fullscreen triangle, point lights as spheres and the
+    spot light as a cone, sized from where their attenuation falls off (lightRange()).
+
+    A volume only shades the pixels whose geometry is inside it. Per light, the stencil pass
+    draws both faces with depth testing, back faces behind the geometry increment and front
+    faces behind it decrement, so only the pixels in between stay non zero. The light pass
+    draws the back faces without depth testing where the stencil is set and clears it on the
+    way, the next light starts from a clean stencil without an extra glClear. Unlike the
+    forward shaders, the spot light's (attenuated) ambient term stops at the cone.
+
+    The sphere scene stays forward.
+*/
+struct Deferred
+{
+    static const int SPHERE_SECTORS = 16;
+    static const int SPHERE_STACKS  = 8;
+    static const int CONE_SIDES     = 24;
+
+    GLuint fbo = 0;
+    TextureHandle albedoSpecTarget, normalTarget, depthTarget;
+    GLuint albedoSpecTexture = 0;
+    GLuint normalTexture     = 0;
+    GLuint depthTexture      = 0;
+    int    width  = 0;
+    int    height = 0;
+
+    GLuint lightProgram;
+    GLuint stencilProgram;
+
+    VertexArrayHandle emptyArray, sphereArray, coneArray;
+    BufferHandle      sphereVertices, sphereIndices, coneVertices, coneIndices;
+    GLuint emptyVAO;
+    GLuint sphereVAO;
+    GLuint coneVAO;
+    GLsizei sphereIndexCount;
+    GLsizei coneIndexCount;
+
+    // stats of the last frame
+    unsigned int volumes          = 0;
+    unsigned int fullscreenPasses = 0;
+
+    std::vector<uint32_t> slots;
+
+    Deferred()
+    {
+        initShaders();
+
+        emptyArray = gpuResources.createVertexArray();
+        emptyVAO   = gpuResources.get(emptyArray);
+
+        // unit sphere, radius 1 at the vertices, 8 floats per vertex
+        std::vector<float>        vertices;
+        std::vector<unsigned int> indices;
+        generateSphere(vertices, indices, 1.0f, SPHERE_SECTORS, SPHERE_STACKS);
+        sphereIndexCount = (GLsizei)indices.size();
+        sphereVAO = setupVolume(sphereArray, sphereVertices, sphereIndices, vertices, indices, 8);
+
+        vertices.clear();
+        indices.clear();
+        generateCone(vertices, indices);
+        coneIndexCount = (GLsizei)indices.size();
+        coneVAO = setupVolume(coneArray, coneVertices, coneIndices, vertices, indices, 3);
+    }
+
+    ~Deferred()
+    {
+        destroyTargets();
+
+        BufferHandle *buffers[] = { &sphereVertices, &sphereIndices, &coneVertices, &coneIndices };
+        for(BufferHandle *buffer : buffers)
+        {
+            memoryTracker.release(MemoryKind::BUFFER, gpuResources.get(*buffer));
+            gpuResources.destroy(*buffer);
+        }
+        gpuResources.destroy(emptyArray);
+        gpuResources.destroy(sphereArray);
+        gpuResources.destroy(coneArray);
+
+        gpuResources.retire(GpuResource::PROGRAM, lightProgram);
+        gpuResources.retire(GpuResource::PROGRAM, stencilProgram);
+    }
+
+    void initShaders()
+    {
+        std::string vertexSource   = readShaderSource("../shaders/deferred_light_vs.glsl");
+        std::string fragmentSource = readShaderSource("../shaders/deferred_light_fs.glsl");
+        lightProgram               = createShaderProgram(vertexSource, fragmentSource);
+
+        // the stencil pass writes no color, any position only program does
+        vertexSource   = readShaderSource("../shaders/light_vs.glsl");
+        fragmentSource = readShaderSource("../shaders/light_fs.glsl");
+        stencilProgram = createShaderProgram(vertexSource, fragmentSource);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, lightProgram);
+        gpuResources.retire(GpuResource::PROGRAM, stencilProgram);
+        initShaders();
+    }
+
+    // returns the vertex array's name
+    GLuint setupVolume(VertexArrayHandle& vertexArray, BufferHandle& vertexBuffer, BufferHandle& indexBuffer,
+                       const std::vector<float>& vertices, const std::vector<unsigned int>& indices, int stride)
+    {
+        vertexArray  = gpuResources.createVertexArray();
+        vertexBuffer = gpuResources.createBuffer();
+        indexBuffer  = gpuResources.createBuffer();
+        GLuint VAO = gpuResources.get(vertexArray);
+        GLuint VBO = gpuResources.get(vertexBuffer);
+        GLuint EBO = gpuResources.get(indexBuffer);
+
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        memoryTracker.track(MemoryKind::BUFFER, VBO, vertices.size() * sizeof(float), MemoryTag::LIGHTING, "light volumes");
+        memoryTracker.track(MemoryKind::BUFFER, EBO, indices.size() * sizeof(unsigned int), MemoryTag::LIGHTING, "light volumes");
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        glBindVertexArray(0);
+        return VAO;
+    }
+
+    // apex at the origin, opening towards -z, base of radius 1 at z = -1
+    void generateCone(std::vector<float>& vertices, std::vector<unsigned int>& indices)
+    {
+        // the base polygon has to contain the unit circle, not be inscribed in it
+        float r = 1.0f / cosf((float)M_PI / CONE_SIDES);
+
+        vertices.insert(vertices.end(), { 0.0f, 0.0f,  0.0f });    // apex
+        vertices.insert(vertices.end(), { 0.0f, 0.0f, -1.0f });    // base center
+        for (int i = 0; i < CONE_SIDES; ++i)
+        {
+            float a = (float)(2 * M_PI * i / CONE_SIDES);
+            vertices.insert(vertices.end(), { r * cosf(a), r * sinf(a), -1.0f });
+        }
+
+        // CCW seen from outside
+        for (int i = 0; i < CONE_SIDES; ++i)
+        {
+            unsigned int k1 = 2 + i;
+            unsigned int k2 = 2 + (i + 1) % CONE_SIDES;
+            indices.insert(indices.end(), { 0, k1, k2 });
+            indices.insert(indices.end(), { 1, k2, k1 });
+        }
+    }
+
+    void createTargets(int w, int h)
+    {
+        destroyTargets();
+        width  = w;
+        height = h;
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+        albedoSpecTexture = createTarget(albedoSpecTarget, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        normalTexture     = createTarget(normalTarget, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+        depthTexture      = createTarget(depthTarget, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoSpecTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+        GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, drawBuffers);
+
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ERROR::DEFERRED::GBUFFER_INCOMPLETE" << std::endl;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, frame->gc.framebuffer);
+    }
+
+    GLuint createTarget(TextureHandle& handle, GLint internalFormat, GLenum format, GLenum type)
+    {
+        handle         = gpuResources.createTexture();
+        GLuint texture = gpuResources.get(handle);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        memoryTracker.track(MemoryKind::TEXTURE, texture, textureBytes(internalFormat, width, height, false), MemoryTag::RENDER_TARGET, "gbuffer");
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+
+    void destroyTargets()
+    {
+        if(!fbo)
+            return;
+
+        TextureHandle *targets[] = { &albedoSpecTarget, &normalTarget, &depthTarget };
+        // a resize can come in while the GPU still reads last frame's gbuffer
+        for(TextureHandle *target : targets)
+        {
+            memoryTracker.release(MemoryKind::TEXTURE, gpuResources.get(*target));
+            gpuResources.destroy(*target);
+        }
+        albedoSpecTexture = normalTexture = depthTexture = 0;
+        glDeleteFramebuffers(1, &fbo);
+        fbo = 0;
+    }
+
+    void render()
+    {
+        PROFILE_ZONE("Deferred::render");
+
+        volumes          = 0;
+        fullscreenPasses = 0;
+
+        if(frame->gc.width <= 0 || frame->gc.height <= 0)
+            return;
+        if(frame->gc.width != width || frame->gc.height != height)
+            createTargets(frame->gc.width, frame->gc.height);
+
+        // geometry pass
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        glDisable(GL_BLEND);
+
+        if(frame->gc.model)
+            model->renderGeometry();
+        else
+            cube->renderGeometry();
+
+        // the volumes and everything drawn after this frame depth test against the scene
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frame->gc.framebuffer);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                          GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, frame->gc.framebuffer);
+
+        // lighting pass
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glDepthMask(GL_FALSE);
+
+        glm::mat4 view       = frame->camera.getViewMatrix();
+        glm::mat4 projection = frame->camera.getProjectionMatrix();
+
+        glUseProgram(lightProgram);
+        bindTexture(0, albedoSpecTexture, "gAlbedoSpec");
+        bindTexture(1, normalTexture,     "gNormal");
+        bindTexture(2, depthTexture,      "gDepth");
+        setMat4(lightProgram, "invViewProj", glm::inverse(projection * view));
+        setMat4(lightProgram, "view", view);
+        setMat4(lightProgram, "projection", projection);
+        setFloat2(lightProgram, "iResolution", (float)width, (float)height);
+        setVec3(lightProgram, "viewPos", frame->camera.pos);
+
+        glUseProgram(stencilProgram);
+        setMat4(stencilProgram, "view", view);
+        setMat4(stencilProgram, "projection", projection);
+
+        // the directional light replaces the background wherever there is geometry
+        glDisable(GL_DEPTH_TEST);
+        if(frame->entities.gatherLights(LightType::DIRECTIONAL, LAYER_ALL, slots))
+            renderFullscreen(slots[0], 0);
+
+        // everything else adds up, volumes that reach past the far plane still count
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glEnable(GL_DEPTH_CLAMP);
+
+        const LightComponents& l = frame->entities.lights;
+
+        frame->entities.gatherLights(LightType::POINT, LAYER_POINT_LIGHTS, slots);
+        for(size_t i = 0; i < slots.size(); i++)
+        {
+            uint32_t s     = slots[i];
+            float    range = lightRange(l, s);
+            if(range == FLT_MAX)
+            {
+                renderFullscreen(s, 1);
+                continue;
+            }
+
+            // the sphere's faces are inside the unit sphere by up to 1 - cos(pi / 16)^2
+            glm::mat4 m = glm::translate(glm::mat4(1.0f), l.position[s]);
+            m = glm::scale(m, glm::vec3(range * 1.08f));
+            renderVolume(s, 1, m, sphereVAO, sphereIndexCount);
+        }
+
+        frame->entities.gatherLights(LightType::SPOT, LAYER_ALL, slots);
+        for(size_t i = 0; i < slots.size(); i++)
+        {
+            uint32_t s     = slots[i];
+            float    range = lightRange(l, s);
+            float    angle = acosf(l.outerCutoff[s]);
+            if(range == FLT_MAX || angle > glm::radians(80.0f))
+            {
+                renderFullscreen(s, 2);
+                continue;
+            }
+
+            renderVolume(s, 2, coneTransform(l.position[s], l.direction[s], range, angle), coneVAO, coneIndexCount);
+        }
+
+        // back to what the rest of the frame expects
+        glDisable(GL_DEPTH_CLAMP);
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        glActiveTexture(GL_TEXTURE0);
+
+        if(frame->gc.wireframe)
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+
+    // the cone starts a bit behind the light so a light sitting in the camera (the flashlight)
+    // does not give a volume that collapses to a point on screen
+    glm::mat4 coneTransform(const glm::vec3& position, const glm::vec3& direction, float range, float angle)
+    {
+        const float pullBack = 0.2f;
+
+        glm::vec3 f     = glm::normalize(direction);
+        glm::vec3 up    = fabsf(f.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 right = glm::normalize(glm::cross(f, up));
+        up              = glm::cross(right, f);
+
+        float length = range + pullBack;
+        float radius = length * tanf(angle);
+
+        // -z of the cone goes along the light direction
+        glm::mat4 m(glm::vec4(right * radius, 0.0f),
+                    glm::vec4(up * radius, 0.0f),
+                    glm::vec4(-f * length, 0.0f),
+                    glm::vec4(position - f * pullBack, 1.0f));
+        return m;
+    }
+
+    void bindTexture(int unit, GLuint texture, const char *name)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        setInt(lightProgram, name, unit);
+    }
+
+    void setLight(uint32_t s, int type)
+    {
+        const LightComponents& l = frame->entities.lights;
+
+        setInt(lightProgram, "lightType", type);
+        setVec3(lightProgram, "light.position",     l.position[s]);
+        setVec3(lightProgram, "light.direction",    l.direction[s]);
+        setVec3(lightProgram, "light.ambient",      l.ambient[s]);
+        setVec3(lightProgram, "light.diffuse",      l.diffuse[s]);
+        setVec3(lightProgram, "light.specular",     l.specular[s]);
+        setFloat(lightProgram, "light.constant",    l.constant[s]);
+        setFloat(lightProgram, "light.linear",      l.linear[s]);
+        setFloat(lightProgram, "light.quadratic",   l.quadratic[s]);
+        setFloat(lightProgram, "light.cutoff",      l.cutoff[s]);
+        setFloat(lightProgram, "light.outerCutoff", l.outerCutoff[s]);
+    }
+
+    void renderFullscreen(uint32_t s, int type)
+    {
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+
+        glUseProgram(lightProgram);
+        setLight(s, type);
+        setBool(lightProgram, "fullscreen", true);
+
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+
+        fullscreenPasses++;
+    }
+
+    void renderVolume(uint32_t s, int type, const glm::mat4& m, GLuint VAO, GLsizei indexCount)
+    {
+        glBindVertexArray(VAO);
+        glEnable(GL_STENCIL_TEST);
+
+        // stencil pass, marks the pixels whose geometry is inside the volume
+        glUseProgram(stencilProgram);
+        setMat4(stencilProgram, "model", m);
+
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+        glStencilOpSeparate(GL_BACK,  GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+        glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+
+        // light pass, back faces still cover the volume when the camera is inside it
+        glUseProgram(lightProgram);
+        setLight(s, type);
+        setBool(lightProgram, "fullscreen", false);
+        setMat4(lightProgram, "model", m);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+        glStencilOp(GL_KEEP, GL_ZERO, GL_ZERO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+
+        glBindVertexArray(0);
+        volumes++;
+    }
+};
+Deferred *deferred;
+
+// positions of whatever the current scene draws, for the passes that only need coverage
+void drawSceneDepth(GLuint program)
+{
+    glUseProgram(program);
+    setMat4(program, "view", frame->camera.getViewMatrix());
+    setMat4(program, "projection", frame->camera.getProjectionMatrix());
+
+    if(frame->gc.model)
+        model->drawDepth(program);
+    else if(frame->gc.sphere)
+        sphere->drawDepth(program);
+    else
+        cube->drawCubes(program);
+}
+
+/*
+    Optional depth only pre-pass for the forward path. Everything is drawn once with a
+    position only program, then the lit pass runs with GL_EQUAL and depth writes off so
+    model_fs/cube_fs only run for the front most fragment of every pixel. Whether that
+    pays for the second geometry pass depends on the scene, see OverdrawView.
+*/
+struct DepthPrepass
+{
+    GLuint program;
+
+    DepthPrepass()
+    {
+        initShaders();
+    }
+
+    ~DepthPrepass()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, program);
+    }
+
+    void initShaders()
+    {
+        std::string vertexSource   = readShaderSource("../shaders/depth_vs.glsl");
+        std::string fragmentSource = readShaderSource("../shaders/depth_fs.glsl");
+        program                    = createShaderProgram(vertexSource, fragmentSource);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, program);
+        initShaders();
+    }
+
+    // lays down the depth and leaves the depth test at GL_EQUAL without writes
+    void begin()
+    {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+
+        drawSceneDepth(program);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    void end()
+    {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+};
+DepthPrepass *prepass;
+
+/*
+    Overdraw view. The scene is drawn into an offscreen counter with additive blending,
+    every fragment that passes the depth test adds one, with the same depth setup the lit
+    pass would use (pre-pass or not). The counter is shown as a heat map instead of the
+    scene and read back for the average/max, which stalls, so it is a debug mode only.
+*/
+struct OverdrawView
+{
+    // counts at or above this are drawn red
+    static constexpr float HOT = 8.0f;
+
+    GLuint        fbo            = 0;
+    TextureHandle counterTarget;
+    GLuint        counterTexture = 0;
+    GLuint        depthBuffer    = 0;
+    int           width  = 0;
+    int           height = 0;
+
+    GLuint            countProgram;
+    GLuint            viewProgram;
+    VertexArrayHandle emptyArray;
+    GLuint            emptyVAO;
+
+    // stats of the last frame
+    unsigned int coveredPixels   = 0;
+    unsigned int shadedFragments = 0;
+    float        maxCount        = 0.0f;
+
+    std::vector<float> readback;
+
+    OverdrawView()
+    {
+        initShaders();
+        emptyArray = gpuResources.createVertexArray();
+        emptyVAO   = gpuResources.get(emptyArray);
+    }
+
+    ~OverdrawView()
+    {
+        destroyTargets();
+        gpuResources.destroy(emptyArray);
+        gpuResources.retire(GpuResource::PROGRAM, countProgram);
+        gpuResources.retire(GpuResource::PROGRAM, viewProgram);
+    }
+
+    void initShaders()
+    {
+        std::string vertexSource   = readShaderSource("../shaders/depth_vs.glsl");
+        std::string fragmentSource = readShaderSource("../shaders/overdraw_fs.glsl");
+        countProgram               = createShaderProgram(vertexSource, fragmentSource);
+
+        vertexSource   = readShaderSource("../shaders/fullscreen_vs.glsl");
+        fragmentSource = readShaderSource("../shaders/overdraw_view_fs.glsl");
+        viewProgram    = createShaderProgram(vertexSource, fragmentSource);
+    }
+
+    void updateShaders()
+    {
+        gpuResources.retire(GpuResource::PROGRAM, countProgram);
+        gpuResources.retire(GpuResource::PROGRAM, viewProgram);
+        initShaders();
+    }
+
+    void createTargets(int w, int h)
+    {
+        destroyTargets();
+        width  = w;
+        height = h;
+
+        // half floats count exactly up to 2048, plenty
+        counterTarget  = gpuResources.createTexture();
+        counterTexture = gpuResources.get(counterTarget);
+        glBindTexture(GL_TEXTURE_2D, counterTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+        memoryTracker.track(MemoryKind::TEXTURE, counterTexture, textureBytes(GL_R16F, width, height, false), MemoryTag::RENDER_TARGET, "overdraw");
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        memoryTracker.track(MemoryKind::RENDERBUFFER, depthBuffer, textureBytes(GL_DEPTH_COMPONENT24, width, height, false), MemoryTag::RENDER_TARGET, "overdraw");
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, counterTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ERROR::OVERDRAW::FRAMEBUFFER_INCOMPLETE" << std::endl;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, frame->gc.framebuffer);
+
+        readback.resize((size_t)width * height);
+        memoryTracker.track(MemoryKind::HOST, counterTexture, readback.capacity() * sizeof(readback[0]), MemoryTag::RENDER_TARGET, "overdraw");
+    }
+
+    void destroyTargets()
+    {
+        if(!fbo)
+            return;
+
+        memoryTracker.release(MemoryKind::TEXTURE, counterTexture);
+        memoryTracker.release(MemoryKind::RENDERBUFFER, depthBuffer);
+        memoryTracker.release(MemoryKind::HOST, counterTexture);
+
+        glDeleteFramebuffers(1, &fbo);
+        gpuResources.destroy(counterTarget);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        fbo = counterTexture = 0;
+    }
+
+    void render(bool usePrepass)
+    {
+        if(frame->gc.width <= 0 || frame->gc.height <= 0)
+            return;
+        if(frame->gc.width != width || frame->gc.height != height)
+            createTargets(frame->gc.width, frame->gc.height);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if(usePrepass)
+            prepass->begin();
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        drawSceneDepth(countProgram);
+
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if(usePrepass)
+            prepass->end();
+
+        glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, readback.data());
+        glBindFramebuffer(GL_FRAMEBUFFER, frame->gc.framebuffer);
+
+        coveredPixels   = 0;
+        shadedFragments = 0;
+        maxCount        = 0.0f;
+        for(size_t i = 0; i < readback.size(); i++)
+        {
+            float c = readback[i];
+            if(c > 0.5f)
+            {
+                coveredPixels++;
+                shadedFragments += (unsigned int)(c + 0.5f);
+                maxCount = std::max(maxCount, c);
+            }
+        }
+
+        // heat map on top of the background
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glDisable(GL_DEPTH_TEST);
+
+        glUseProgram(viewProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, counterTexture);
+        setInt(viewProgram, "counter", 0);
+        setFloat(viewProgram, "maxCount", HOT);
+
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+
+        glEnable(GL_DEPTH_TEST);
+        if(frame->gc.wireframe)
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+
+    // fragments shaded per pixel that has any geometry
+    float average() const
+    {
+        return coveredPixels ? (float)shadedFragments / (float)coveredPixels : 0.0f;
+    }
+};
+OverdrawView *overdraw;
+
+/*
+    Frustum and occlusion culling of every entity with bounds in the active layers,
+    the result ends up in entities.renderables.visible.
+*/
+struct SceneCuller
+{
+    Frustum              frustum;
+    std::vector<uint8_t> nodeVisible;   // hierarchical pass over the scene graph
+
+    OcclusionBuffer occlusion;
+    TextureHandle   occlusionHandle;
+    GLuint          occlusionTexture = 0;   // only created when the buffer is shown in the ui, render thread
+
+    uint32_t        total         = 0;
+    uint32_t        visible       = 0;
+    uint32_t        occluded      = 0;
+    double          cullTime      = 0.0;    // ms, frustum + occlusion
+    double          occlusionTest = 0.0;    // ms
+
+    void cull()
+    {
+        PROFILE_ZONE("SceneCuller::cull");
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        uint32_t layers = activeLayers();
+
+        frustum.extract(camera.getProjectionMatrix() * camera.getViewMatrix());
+
+        total = 0;
+        for(size_t i = 0; i < entities.bounds.size(); i++)
+            total += (entities.layer[entities.bounds.entity[i]] & layers) != 0;
+
+        occluded = 0;
+
+        if(gc.culling)
+        {
+            // whole subtrees of the model hierarchy are rejected first, only meshes
+            // whose node survived go through the SIMD test
+            const std::vector<uint8_t> *nodes = nullptr;
+            if(gc.model)
+            {
+                sceneGraph.cull(frustum, nodeVisible);
+                nodes = &nodeVisible;
+            }
+
+            visible = (uint32_t)entities.cull(frustum, layers, nodes);
+
+            if(gc.occlusion)
+            {
+                occlusionCull();
+                visible -= occluded;
+            }
+        }
+        else
+        {
+            visible = (uint32_t)entities.markVisible(layers);
+        }
+
+        entities.resolveVisibility(layers);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        cullTime = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // rasterizes the occluders that survived frustum culling, then tests what is left against them
+    void occlusionCull()
+    {
+        occlusion.beginFrame(camera.getProjectionMatrix() * camera.getViewMatrix());
+
+        const RenderableComponents& r = entities.renderables;
+        CullBatch&                  w = entities.bounds.world;
+
+        for(size_t i = 0; i < r.size(); i++)
+        {
+            if(!r.occluder[i])
+                continue;
+
+            // boxes outside the active layers were marked invisible by the frustum pass
+            uint32_t b = entities.boundsSlot[r.entity[i]];
+            if(b == NO_SLOT || !w.visible[b])
+                continue;
+
+            const glm::mat4& world = sceneGraph.world[r.node[i]];
+            switch(meshKind(r.mesh[i]))
+            {
+                case MESH_CUBE:
+                    occlusion.addOccluder(cube->occluderVertices, sizeof(glm::vec3),
+                                          cube->occluderIndices, 36, world);
+                    break;
+                case MESH_SPHERE:
+                    occlusion.addOccluder((const glm::vec3 *)sphere->vertices.data(), 8 * sizeof(float),
+                                          sphere->indices.data(), sphere->indices.size(), world);
+                    break;
+                case MESH_MODEL:
+                {
+                    const Mesh& mesh = model->meshes[meshIndex(r.mesh[i])];
+                    if(model->useOccluders && !mesh.vertices.empty())
+                        occlusion.addOccluder(&mesh.vertices[0].Position, sizeof(Vertex),
+                                              mesh.indices.data(), mesh.indices.size(), world);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        occlusion.rasterize();
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // the buffer is only read from here on, each box is tested on its own
+        std::atomic<uint32_t> hidden(0);
+        parallelFor(w.size(), 256, [&](size_t begin, size_t end)
+        {
+            uint32_t count = 0;
+            for(size_t i = begin; i < end; i++)
+            {
+                if(!w.visible[i])
+                    continue;
+                glm::vec3 c(w.cx[i], w.cy[i], w.cz[i]);
+                glm::vec3 e(w.ex[i], w.ey[i], w.ez[i]);
+                if(!occlusion.testAABB(AABB(c - e, c + e)))
+                {
+                    w.visible[i] = 0;
+                    count++;
+                }
+            }
+            hidden.fetch_add(count, std::memory_order_relaxed);
+        });
+        occluded = hidden.load();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        occlusionTest = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // uploads a copy of the occlusion depth buffer (FrameSnapshot::occlusionDepth) so the
+    // Ui can show it with ImGui::Image. Culling runs on the update thread, this on the render thread
+    GLuint occlusionDebugTexture(const std::vector<float>& depth)
+    {
+        if(!occlusionTexture)
+        {
+            occlusionHandle  = gpuResources.createTexture();
+            occlusionTexture = gpuResources.get(occlusionHandle);
+            glBindTexture(GL_TEXTURE_2D, occlusionTexture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            // show the single depth channel as gray
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+
+            memoryTracker.track(MemoryKind::TEXTURE, occlusionTexture,
+                                textureBytes(GL_R32F, OcclusionBuffer::WIDTH, OcclusionBuffer::HEIGHT, false),
+                                MemoryTag::DEBUG, "occlusion buffer");
+        }
+
+        glBindTexture(GL_TEXTURE_2D, occlusionTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, OcclusionBuffer::WIDTH, OcclusionBuffer::HEIGHT, 0,
+                     GL_RED, GL_FLOAT, depth.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        return occlusionTexture;
+    }
+};
+SceneCuller *culler;
+
+struct Ui
+{
+    float rotation = 0.0f;
+
+    float vec3a[3] = { 1.0f, 1.0f, 1.0f};
+    float col1[3] = { 1.0f, 1.0f, 1.0f };
+
+    float dircol[3] = { 1.0f, 1.0f, 1.0f };
+
+    float pcol[4][3] = {{ 1.0f, 1.0f, 1.0f},
+                        { 1.0f, 1.0f, 1.0f},
+                        { 1.0f, 1.0f, 1.0f},
+                        { 1.0f, 1.0f, 1.0f}};    
+    float ppos[4][3] = {{ 1.0f, 1.0f, 1.0f},
+                        { 1.0f, 1.0f, 1.0f},
+                        { 1.0f, 1.0f, 1.0f},
+                        { 1.0f, 1.0f, 1.0f}};
+
+    float bgcol[3] = { 0.0f, 0.0f, 0.0f };
+    float shininess = 32.0f;
+    char str0[128];
+
+    bool showOcclusionBuffer = false;
+    bool fontTracked         = false;
+    int  testLightCount      = 0;
+
+    Ui(GLFWwindow *window)
+    {
+        /* IMGUI Stuff */
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+
+        ImGuiIO &io = ImGui::GetIO(); (void) io;
+
+        // io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
+        // io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+        // io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
+        // io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
+
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init("#version 330");
+
+        // the backend would create its shaders and the font texture on the first NewFrame,
+        // which runs on the update thread once drawing moved to the render thread
+        ImGui_ImplOpenGL3_CreateDeviceObjects();
+
+        //ImGui::StyleColorsDark();
+        DarkTheme();
+    }
+
+    void DarkTheme()
+    {
+        ImVec4 *colors = ImGui::GetStyle().Colors;
+        colors[ImGuiCol_Text] = ImVec4(1.00f, 1.00f, 1.00f, 1.00f);
+        colors[ImGuiCol_TextDisabled] = ImVec4(0.50f, 0.50f, 0.50f, 1.00f);
+        colors[ImGuiCol_WindowBg] = ImVec4(0.10f, 0.10f, 0.10f, 1.00f);
+        colors[ImGuiCol_ChildBg] = ImVec4(0.00f, 0.00f, 0.00f, 0.00f);
+        colors[ImGuiCol_PopupBg] = ImVec4(0.19f, 0.19f, 0.19f, 0.92f);
+        colors[ImGuiCol_Border] = ImVec4(0.19f, 0.19f, 0.19f, 0.29f);
+        colors[ImGuiCol_BorderShadow] = ImVec4(0.00f, 0.00f, 0.00f, 0.24f);
+        colors[ImGuiCol_FrameBg] = ImVec4(0.05f, 0.05f, 0.05f, 0.54f);
+        colors[ImGuiCol_FrameBgHovered] = ImVec4(0.19f, 0.19f, 0.19f, 0.54f);
+        colors[ImGuiCol_FrameBgActive] = ImVec4(0.20f, 0.22f, 0.23f, 1.00f);
+        colors[ImGuiCol_TitleBg] = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_TitleBgActive] = ImVec4(0.06f, 0.06f, 0.06f, 1.00f);
+        colors[ImGuiCol_TitleBgCollapsed] = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_MenuBarBg] = ImVec4(0.14f, 0.14f, 0.14f, 1.00f);
+        colors[ImGuiCol_ScrollbarBg] = ImVec4(0.05f, 0.05f, 0.05f, 0.54f);
+        colors[ImGuiCol_ScrollbarGrab] = ImVec4(0.34f, 0.34f, 0.34f, 0.54f);
+        colors[ImGuiCol_ScrollbarGrabHovered] = ImVec4(0.40f, 0.40f, 0.40f, 0.54f);
+        colors[ImGuiCol_ScrollbarGrabActive] = ImVec4(0.56f, 0.56f, 0.56f, 0.54f);
+        colors[ImGuiCol_CheckMark] = ImVec4(0.33f, 0.67f, 0.86f, 1.00f);
+        colors[ImGuiCol_SliderGrab] = ImVec4(0.34f, 0.34f, 0.34f, 0.54f);
+        colors[ImGuiCol_SliderGrabActive] = ImVec4(0.56f, 0.56f, 0.56f, 0.54f);
+        colors[ImGuiCol_Button] = ImVec4(0.05f, 0.05f, 0.05f, 0.54f);
+        colors[ImGuiCol_ButtonHovered] = ImVec4(0.19f, 0.19f, 0.19f, 0.54f);
+        colors[ImGuiCol_ButtonActive] = ImVec4(0.20f, 0.22f, 0.23f, 1.00f);
+        colors[ImGuiCol_Header] = ImVec4(0.00f, 0.00f, 0.00f, 0.52f);
+        colors[ImGuiCol_HeaderHovered] = ImVec4(0.00f, 0.00f, 0.00f, 0.36f);
+        colors[ImGuiCol_HeaderActive] = ImVec4(0.20f, 0.22f, 0.23f, 0.33f);
+        colors[ImGuiCol_Separator] = ImVec4(0.28f, 0.28f, 0.28f, 0.29f);
+        colors[ImGuiCol_SeparatorHovered] = ImVec4(0.44f, 0.44f, 0.44f, 0.29f);
+        colors[ImGuiCol_SeparatorActive] = ImVec4(0.40f, 0.44f, 0.47f, 1.00f);
+        colors[ImGuiCol_ResizeGrip] = ImVec4(0.28f, 0.28f, 0.28f, 0.29f);
+        colors[ImGuiCol_ResizeGripHovered] = ImVec4(0.44f, 0.44f, 0.44f, 0.29f);
+        colors[ImGuiCol_ResizeGripActive] = ImVec4(0.40f, 0.44f, 0.47f, 1.00f);
+        colors[ImGuiCol_Tab] = ImVec4(0.00f, 0.00f, 0.00f, 0.52f);
+        colors[ImGuiCol_TabHovered] = ImVec4(0.14f, 0.14f, 0.14f, 1.00f);
+        colors[ImGuiCol_TabActive] = ImVec4(0.20f, 0.20f, 0.20f, 0.36f);
+        colors[ImGuiCol_TabUnfocused] = ImVec4(0.00f, 0.00f, 0.00f, 0.52f);
+        colors[ImGuiCol_TabUnfocusedActive] = ImVec4(0.14f, 0.14f, 0.14f, 1.00f);
+        // colors[ImGuiCol_DockingPreview] = ImVec4(0.33f, 0.67f, 0.86f, 1.00f);
+        // colors[ImGuiCol_DockingEmptyBg] = ImVec4(1.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_PlotLines] = ImVec4(1.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_PlotLinesHovered] = ImVec4(1.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_PlotHistogram] = ImVec4(1.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_PlotHistogramHovered] = ImVec4(1.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_TableHeaderBg] = ImVec4(0.00f, 0.00f, 0.00f, 0.52f);
+        colors[ImGuiCol_TableBorderStrong] = ImVec4(0.00f, 0.00f, 0.00f, 0.52f);
+        colors[ImGuiCol_TableBorderLight] = ImVec4(0.28f, 0.28f, 0.28f, 0.29f);
+        colors[ImGuiCol_TableRowBg] = ImVec4(0.00f, 0.00f, 0.00f, 0.00f);
+        colors[ImGuiCol_TableRowBgAlt] = ImVec4(1.00f, 1.00f, 1.00f, 0.06f);
+        colors[ImGuiCol_TextSelectedBg] = ImVec4(0.20f, 0.22f, 0.23f, 1.00f);
+        colors[ImGuiCol_DragDropTarget] = ImVec4(0.33f, 0.67f, 0.86f, 1.00f);
+        colors[ImGuiCol_NavHighlight] = ImVec4(1.00f, 0.00f, 0.00f, 1.00f);
+        colors[ImGuiCol_NavWindowingHighlight] = ImVec4(1.00f, 0.00f, 0.00f, 0.70f);
+        colors[ImGuiCol_NavWindowingDimBg] = ImVec4(1.00f, 0.00f, 0.00f, 0.20f);
+        colors[ImGuiCol_ModalWindowDimBg] = ImVec4(1.00f, 0.00f, 0.00f, 0.35f);
+
+        ImGuiStyle &style = ImGui::GetStyle();
+        style.WindowPadding = ImVec2(8.00f, 8.00f);
+        style.FramePadding = ImVec2(5.00f, 2.00f);
+        style.CellPadding = ImVec2(6.00f, 6.00f);
+        style.ItemSpacing = ImVec2(6.00f, 6.00f);
+        style.ItemInnerSpacing = ImVec2(6.00f, 6.00f);
+        style.TouchExtraPadding = ImVec2(0.00f, 0.00f);
+        style.IndentSpacing = 25;
+        style.ScrollbarSize = 15;
+        style.GrabMinSize = 10;
+        style.WindowBorderSize = 1;
+        style.ChildBorderSize = 1;
+        style.PopupBorderSize = 1;
+        style.FrameBorderSize = 1;
+        style.TabBorderSize = 1;
+        style.WindowRounding = 7;
+        style.ChildRounding = 4;
+        style.FrameRounding = 3;
+        style.PopupRounding = 4;
+        style.ScrollbarRounding = 9;
+        style.GrabRounding = 3;
+        style.LogSliderDeadzone = 4;
+        style.TabRounding = 4;
+    }
+
+    void beginFrame() 
+    {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        // the font atlas was built by the backend in the constructor
+        ImFontAtlas *fonts = ImGui::GetIO().Fonts;
+        if(!fontTracked && fonts->TexID)
+        {
+            memoryTracker.track(MemoryKind::TEXTURE, (uint64_t)fonts->TexID,
+                                textureBytes(GL_RGBA8, fonts->TexWidth, fonts->TexHeight, false), MemoryTag::UI, "imgui fonts");
+            fontTracked = true;
+        }
+    }
+
+    void debugWindow(const RenderStats& drawn)
+    {
+        PROFILE_ZONE("Ui::debugWindow");
+
+        ImGui::Begin("Debug");
+            ImGui::SliderFloat("rotation", &rotation, 0, 360); 
+            ImGui::ColorEdit3("Background Color", bgcol);
+
+            ImGui::SliderFloat3("lightPos", vec3a, -15.0f, 15.0f);
+            ImGui::ColorEdit3("lightCol", col1);
+            ImGui::ColorEdit3("dirCol", dircol);
+
+            for (int i = 0; i < 4; i++){
+                ImGui::ColorEdit3(("PointCol" + std::to_string(i)).c_str(), pcol[i]);
+                ImGui::SliderFloat3(("PointPos" + std::to_string(i)).c_str(), ppos[i], -15.0f, 15.0f);
+            } 
+
+            const char* items[] = { "7", "13", "20", "32", "50", "65", "100", "160", "200", "325", "600", "3250"};
+            static int item_selected_idx = 6;
+
+            const char* combo_preview_value = items[item_selected_idx];
+
+            uint32_t ls        = entities.lightSlot[light];
+            float&   linear    = entities.lights.linear[ls];
+            float&   quadratic = entities.lights.quadratic[ls];
+
+            if (ImGui::BeginCombo("lightAttenuation", combo_preview_value, 0))
+            {
+                for (int n = 0; n < IM_ARRAYSIZE(items); n++)
+                {
+                    const bool is_selected = (item_selected_idx == n);
+                    if (ImGui::Selectable(items[n], is_selected))
+                        item_selected_idx = n;
+                    switch(item_selected_idx)
+                    {
+                        case 0:
+                            linear = 0.7f;
+                            quadratic = 1.8f;
+                            break;
+                        case 1:
+                            linear = 0.35f;
+                            quadratic = 0.44f;
+                            break;
+                        case 2:
+                            linear = 0.22f;
+                            quadratic = 0.20f;
+                            break;
+                        case 3:
+                            linear = 0.14f;
+                            quadratic = 0.07f;
+                            break;
+                        case 4:
+                            linear = 0.09f;
+                            quadratic = 0.032f;
+                            break;
+                        case 5:
+                            linear = 0.07f;
+                            quadratic = 0.017f;
+                            break;
+                        case 6:
+                            linear = 0.045f;
+                            quadratic = 0.0075f;
+                            break;
+                        case 7:
+                            linear = 0.027f;
+                            quadratic = 0.0028f;
+                            break;
+                        case 8:
+                            linear = 0.022f;
+                            quadratic = 0.0019f;
+                            break;    
+                        case 9:
+                            linear = 0.014f;
+                            quadratic = 0.0007f;
+                            break;   
+                        case 10:
+                            linear = 0.007f;
+                            quadratic = 0.0002f; 
+                            break;
+                        case 11:
+                            linear = 0.0014f;
+                            quadratic = 0.000007f; 
+                            break;
+                        default:
+                            break;                                        
+                    }
+                    if (is_selected)
+                        ImGui::SetItemDefaultFocus();
+                }
+                ImGui::EndCombo();
+            }
+
+            if(!gc.model)
+            {
+                if(gc.sphere){
+                    ImGui::SliderFloat("shininess", &sphere->shininess, 1.0, 64.0);
+                }else{
+                    ImGui::SliderFloat("shininess", &cube->shininess, 1.0, 64.0);
+                }
+            }
+            else if(model->animation >= 0)
+            {
+                AnimationInstance& instance = animator.instances[model->animation];
+                const char *playing = instance.compressed ? instance.compressed->name.c_str() : "bind pose";
+                if(ImGui::BeginCombo("Animation", playing))
+                {
+                    for(int i = 0; i < (int)model->clips.size(); i++)
+                    {
+                        // clip names don't have to be unique
+                        ImGui::PushID(i);
+                        if(ImGui::Selectable(model->clips[i].name.c_str(), i == model->clip))
+                            model->play(i);
+                        ImGui::PopID();
+                    }
+                    ImGui::EndCombo();
+                }
+                ImGui::SliderFloat("Animation speed", &instance.speed, 0.0f, 4.0f);
+                ImGui::Text("Skinning: %u bones in %zu instances, %.4f ms (%s)", animator.bonesEvaluated,
+                            animator.instances.size(), animator.evaluateTime, animationBackendName());
+            }
+
+            ImGui::Checkbox("Sphere", &gc.sphere);
+            ImGui::Checkbox("Model", &gc.model);
+            ImGui::Checkbox("Debug", &gc.debug);
+            ImGui::Checkbox("Wireframe", &gc.wireframe);
+            ImGui::Checkbox("Frustum Culling", &gc.culling);
+            ImGui::Checkbox("Occlusion Culling", &gc.occlusion);
+            ImGui::Checkbox("Show Occlusion Buffer", &showOcclusionBuffer);
+            ImGui::Checkbox("Deferred Shading", &gc.deferred);
+            ImGui::Checkbox("Depth Pre-pass", &gc.depthPrepass);
+            ImGui::Checkbox("Overdraw", &gc.overdraw);
+            if(gc.overdraw)
+            {
+                ImGui::Text("Overdraw: %.2f fragments per covered pixel, max %.0f",
+                            drawn.overdrawAverage, drawn.overdrawMax);
+                ImGui::Text("Shaded: %u fragments, %u pixels covered",
+                            drawn.shadedFragments, drawn.coveredPixels);
+            }
+
+            ImGui::Text("Visible: %u/%u objects", culler->visible, culler->total);
+            ImGui::Text("Transforms: %u/%u nodes updated", sceneGraph.updatedNodes, (unsigned)sceneGraph.size());
+            ImGui::Text("Entities: %zu (%zu renderables, %zu lights)",
+                        entities.count(), entities.renderables.size(), entities.lights.size());
+
+            if(ImGui::SliderInt("Test Lights", &testLightCount, 0, 4096))
+                spawnTestLights(testLightCount);
+            ImGui::Text("Clusters: %dx%dx%d, %u lights, %zu indices, max %u per cluster",
+                        ClusterGrid::TILES_X, ClusterGrid::TILES_Y, ClusterGrid::SLICES,
+                        drawn.clusterLights, drawn.clusterIndices, drawn.maxPerCluster);
+            if(gc.deferred && (gc.model || !gc.sphere))
+                ImGui::Text("Deferred: %u light volumes, %u fullscreen passes", drawn.lightVolumes, drawn.fullscreenPasses);
+            else
+                ImGui::Text("Light assignment: %.4f ms", drawn.lightAssignment);
+            ImGui::Text("Culling: %.4f ms (%s)", culler->cullTime, cullBackendName());
+            if(gc.culling && gc.occlusion)
+            {
+                ImGui::Text("Occluded: %u, %u occluder triangles", culler->occluded, culler->occlusion.occluderTriangles);
+                ImGui::Text("Occlusion raster: %.4f ms, test: %.4f ms (%s)",
+                            culler->occlusion.rasterTime, culler->occlusionTest, occlusionBackendName());
+            }
+            if(showOcclusionBuffer && drawn.occlusionTexture)
+            {
+                // row 0 of the buffer is the bottom of the screen
+                ImGui::Image((ImTextureID)(intptr_t)drawn.occlusionTexture,
+                             ImVec2((float)OcclusionBuffer::WIDTH, (float)OcclusionBuffer::HEIGHT),
+                             ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
+            }
+
+            if(gc.model)
+            {
+                if(pick.hit)
+                {
+                    ImGui::Text("Pick: mesh %d, triangle %u (%.1f us)", pick.mesh, pick.triangle, pick.time);
+                    ImGui::Text("Barycentric: %.3f %.3f %.3f", pick.barycentric.x, pick.barycentric.y, pick.barycentric.z);
+                    ImGui::Text("Position: %.3f %.3f %.3f", pick.position.x, pick.position.y, pick.position.z);
+                }
+                else
+                {
+                    ImGui::Text("Pick: nothing under the cursor");
+                }
+            }
+
+            sprintf_s(str0, "Time: %f ms/frame", gc.deltaTime*1000.0f);
+            ImGui::Text(str0);
+            if(renderThreadRunning())
+                ImGui::Text("Render thread: drawing frame %llu, %llu snapshots dropped",
+                            (unsigned long long)drawn.index, (unsigned long long)drawn.droppedSnapshots);
+
+            recordingUi();
+
+#if PROFILER_ENABLED
+            if(ImGui::Button("Export CPU trace"))
+                Profiler::exportTrace("trace.json");
+            ImGui::SliderFloat("Hitch threshold (ms)", &Profiler::hitchThreshold, 0.0f, 100.0f);
+            ImGui::SliderInt("Frames per hitch trace", &Profiler::hitchFrames, 1, 120);
+            ImGui::Text("Hitch traces written: %d", Profiler::hitchCaptures);
+#endif
+        ImGui::End();
+    }
+
+    // camera and input recording, everything goes through input.rec in the working directory
+    void recordingUi()
+    {
+        const InputRecording *rec = activeRecording();
+        const InputReplay    *rep = activeReplay();
+
+        if(rec)
+        {
+            ImGui::Text("Recording: %zu frames", rec->frames.size());
+            if(ImGui::Button("Stop recording"))
+                stopRecording("input.rec");
+        }
+        else if(rep)
+        {
+            ImGui::Text("Replaying: %zu / %zu (%s), drift %g, %d resyncs", rep->cursor, rep->recording.frames.size(),
+                        rep->mode == InputReplay::FIXED_STEP ? "fixed step" : "real time", rep->maxDrift, rep->resyncs);
+            if(ImGui::Button("Stop replay"))
+                stopReplay();
+        }
+        else
+        {
+            if(ImGui::Button("Record input"))
+                startRecording();
+            ImGui::SameLine();
+            if(ImGui::Button("Replay fixed step"))
+                startReplay("input.rec", InputReplay::FIXED_STEP);
+            ImGui::SameLine();
+            if(ImGui::Button("Replay real time"))
+                startReplay("input.rec", InputReplay::REAL_TIME);
+        }
+    }
+
+    // GPU time of every pass, a few frames old so reading it never stalls
+    void timingsWindow(const RenderStats& drawn)
+    {
+        ImGui::Begin("GPU Timings");
+
+        if(!drawn.gpuTimersAvailable)
+        {
+            ImGui::Text("Timer queries are not supported by this driver");
+            ImGui::End();
+            return;
+        }
+
+        if(ImGui::BeginTable("passes", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+        {
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("Last ms");
+            ImGui::TableSetupColumn("Avg ms");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+
+            for(size_t i = 0; i < drawn.gpuZones.size(); i++)
+            {
+                const GpuTimers::Stats& s = drawn.gpuZones[i];
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                // nested zones are indented under their parent
+                ImGui::Text("%*s%s", 2 * s.depth, "", s.name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", s.last);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", s.average);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", s.max);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::Text("Averages over %d frames, %d frames of latency, %llu dropped",
+                    GpuTimers::HISTORY, GpuTimers::FRAMES, (unsigned long long)drawn.gpuDropped);
+        ImGui::End();
+    }
+
+    // frame time distribution and the hitches of this session
+    void frameStatsWindow()
+    {
+        static std::vector<float> history;
+        static std::vector<float> bins;
+
+        ImGui::Begin("Frame Stats");
+
+        const FrameStats::Summary& w = frameStats.window;
+        const FrameStats::Summary& s = frameStats.session;
+        ImGui::Text("Last %llu frames: p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+                    (unsigned long long)w.frames, w.p50, w.p95, w.p99, w.max);
+        ImGui::Text("Session (%llu):   p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+                    (unsigned long long)s.frames, s.p50, s.p95, s.p99, s.max);
+
+        // a bit of headroom over p99 keeps the graph readable, the spikes still show up clipped
+        float range = std::max(w.p99 * 1.5f, 1.0f);
+
+        frameStats.history(history);
+        if(!history.empty())
+            ImGui::PlotLines("Frame ms", history.data(), (int)history.size(), 0, nullptr, 0.0f, range, ImVec2(0.0f, 80.0f));
+
+        frameStats.histogram(bins, 64, range);
+        ImGui::PlotHistogram("Histogram", bins.data(), (int)bins.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+        ImGui::Text("0 .. %.2f ms, the last bin holds everything slower", range);
+
+        ImGui::SliderFloat("Hitch factor (x median)", &frameStats.hitchFactor, 1.2f, 10.0f);
+
+        if(ImGui::TreeNode("Pacing"))
+        {
+            if(ImGui::BeginCombo("Mode", pacingModeName(framePacer.mode)))
+            {
+                for(int m = 0; m < PACING_MODES; m++)
+                {
+                    if(ImGui::Selectable(pacingModeName((PacingMode)m), m == framePacer.mode))
+                        framePacer.mode = (PacingMode)m;
+                }
+                ImGui::EndCombo();
+            }
+            if(framePacer.mode == PACING_ADAPTIVE && !framePacer.tearControl)
+                ImGui::Text("no swap_control_tear, this is plain vsync");
+
+            if(framePacer.mode == PACING_CAPPED)
+            {
+                float fps    = (float)framePacer.targetFps;
+                float margin = (float)framePacer.spinMargin * 1000.0f;
+                if(ImGui::SliderFloat("FPS cap", &fps, 10.0f, 500.0f))
+                    framePacer.targetFps = fps;
+                if(ImGui::SliderFloat("Spin margin (ms)", &margin, 0.0f, 5.0f))
+                    framePacer.spinMargin = margin / 1000.0f;
+            }
+
+            FramePacer::Stats pacing = framePacer.stats();
+            ImGui::Text("Interval %.3f ms (target %.3f), jitter %.3f ms, worst %.3f ms off",
+                        pacing.meanMs, pacing.targetMs, pacing.jitterMs, pacing.worstMs);
+            if(framePacer.mode == PACING_CAPPED)
+                ImGui::Text("Late past the deadline: %.3f ms on average", pacing.lateMs);
+
+            FixedTimestep& simulation = framePacer.simulation;
+            float hz = (float)(1.0 / simulation.step);
+            ImGui::Checkbox("Fixed timestep", &simulation.enabled);
+            if(ImGui::SliderFloat("Steps per second", &hz, 10.0f, 240.0f))
+                simulation.step = 1.0 / hz;
+            ImGui::Text("%llu steps, %llu dropped", (unsigned long long)simulation.steps, (unsigned long long)simulation.dropped);
+
+            ImGui::Checkbox("On demand", &framePacer.onDemand);
+            if(framePacer.onDemand)
+            {
+                for(size_t i = 0; i < framePacer.redrawSources(); i++)
+                    ImGui::Text("%-16s %s", framePacer.redrawSourceName(i), framePacer.redrawSourceActive(i) ? "redrawing" : "-");
+                ImGui::Text("%llu waits for events", (unsigned long long)framePacer.idleWaits);
+            }
+
+            ImGui::TreePop();
+        }
+
+        if(ImGui::TreeNode("Last frame"))
+        {
+            for(size_t i = 0; i < frameStats.lastSections.size(); i++)
+                ImGui::Text("%-16s %.3f ms", frameStats.lastSections[i].name, frameStats.lastSections[i].ms);
+            ImGui::TreePop();
+        }
+
+        ImGui::Text("Hitches: %llu", (unsigned long long)frameStats.hitchCount);
+        uint64_t shown = std::min<uint64_t>(frameStats.hitchCount, 8);
+        for(uint64_t k = 0; k < shown; k++)
+        {
+            const FrameStats::Hitch& h = frameStats.hitch(frameStats.hitchCount - 1 - k);
+            ImGui::PushID((int)k);
+            if(ImGui::TreeNode("hitch", "frame %llu: %.2f ms (median %.2f)", (unsigned long long)h.frame, h.ms, h.median))
+            {
+                for(size_t i = 0; i < h.sections.size(); i++)
+                    ImGui::Text("%-16s %.3f ms", h.sections[i].name, h.sections[i].ms);
+                ImGui::TreePop();
+            }
+            ImGui::PopID();
+        }
+
+        if(ImGui::Button("Export CSV"))
+            frameStats.exportCsv("frame_stats.csv");
+        ImGui::SameLine();
+        if(ImGui::Button("Export JSON"))
+            frameStats.exportJson("frame_stats.json");
+
+        ImGui::End();
+    }
+
+    // live and peak bytes per subsystem, the budgets and the biggest assets
+    void memoryWindow(const RenderStats& drawn)
+    {
+        static std::vector<MemoryTracker::Asset> assets;
+        static float budgetMB[MemoryTracker::HEAPS] = { 0.0f, 0.0f };
+
+        const float MB = 1024.0f * 1024.0f;
+
+        ImGui::Begin("Memory");
+
+        // the render thread tracks and releases GL objects while this reads
+        std::unique_lock<std::mutex> lock(memoryTracker.mutex);
+
+        if(ImGui::BeginTable("tags", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+        {
+            ImGui::TableSetupColumn("Subsystem");
+            ImGui::TableSetupColumn("GPU MB");
+            ImGui::TableSetupColumn("GPU peak");
+            ImGui::TableSetupColumn("CPU MB");
+            ImGui::TableSetupColumn("CPU peak");
+            ImGui::TableHeadersRow();
+
+            for(int t = 0; t <= MemoryTracker::TAGS; t++)
+            {
+                // the last row is the total
+                bool total = t == MemoryTracker::TAGS;
+                const MemoryTracker::Totals& gpu = total ? memoryTracker.heaps[0] : memoryTracker.tags[0][t];
+                const MemoryTracker::Totals& cpu = total ? memoryTracker.heaps[1] : memoryTracker.tags[1][t];
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", total ? "Total" : memoryTagName((MemoryTag)t));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f (%u)", gpu.live / MB, gpu.count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", gpu.peak / MB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f (%u)", cpu.live / MB, cpu.count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", cpu.peak / MB);
+            }
+            ImGui::EndTable();
+        }
+
+        const char *heapNames[] = { "GPU budget MB", "CPU budget MB" };
+        for(int h = 0; h < MemoryTracker::HEAPS; h++)
+        {
+            if(ImGui::InputFloat(heapNames[h], &budgetMB[h], 16.0f, 256.0f, "%.0f"))
+            {
+                budgetMB[h]             = std::max(budgetMB[h], 0.0f);
+                memoryTracker.budget[h] = (uint64_t)(budgetMB[h] * MB);
+            }
+
+            if(memoryTracker.overBudget(h))
+                ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s over budget by %.2f MB", h == 0 ? "GPU" : "CPU",
+                                   (memoryTracker.heaps[h].live - memoryTracker.budget[h]) / MB);
+        }
+
+        // breakdown() locks on its own
+        lock.unlock();
+
+        if(ImGui::TreeNode("Assets"))
+        {
+            memoryTracker.breakdown(assets);
+            for(size_t i = 0; i < assets.size(); i++)
+            {
+                const MemoryTracker::Asset& a = assets[i];
+                ImGui::Text("%-32s %-13s GPU %8.2f  CPU %8.2f MB  (%u)", a.name.c_str(), memoryTagName(a.tag),
+                            a.bytes[0] / MB, a.bytes[1] / MB, a.allocations);
+            }
+            ImGui::TreePop();
+        }
+
+        if(model)
+            ImGui::Text("Model load: %llu allocations", (unsigned long long)model->loadAllocations);
+        const GpuResources::Stats& pools = drawn.pools;
+        ImGui::Text("GL objects: %u buffers, %u textures, %u vertex arrays",
+                    pools.live[(int)GpuResource::BUFFER], pools.live[(int)GpuResource::TEXTURE],
+                    pools.live[(int)GpuResource::VERTEX_ARRAY]);
+        ImGui::Text("%u waiting for the GPU, %u spare buffer names, %llu reused",
+                    pools.pending, pools.spares, (unsigned long long)pools.reused);
+        ImGui::Text("GPU sizes are estimates, drivers add padding");
+        ImGui::End();
+    }
+
+    void demoWindow()
+    {
+        ImGui::ShowDemoWindow();
+    }
+
+    // ends the frame and copies what it drew into the snapshot, update thread
+    void endFrame(UiDrawLists& out)
+    {
+        PROFILE_ZONE("Ui::endFrame");
+
+        ImGui::Render();
+        out.copy(ImGui::GetDrawData());
+    }
+
+    void render(UiDrawLists& lists)
+    {
+        PROFILE_ZONE("Ui::render");
+
+        ImGui_ImplOpenGL3_RenderDrawData(&lists.data);
+    }
+};
+Ui *ui;
+
+// every callback is input of some kind, on demand each one asks for a frame
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    (void)window;
+    resizeRenderer(width, height);
+    framePacer.markDirty();
+}
+
+void window_refresh_callback(GLFWwindow* window)
+{
+    framePacer.markDirty();
+
+    // the render thread owns the context and presents on its own
+    if(!renderThreadRunning())
+        glfwSwapBuffers(window);
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    (void)window;
+    (void)key;
+    (void)scancode;
+    (void)action;
+    (void)mods;
+
+    // the keys themselves are polled in processInput
+    framePacer.markDirty();
+}
+
+void getMouseDelta(float *xoffset, float *yoffset)
+{
+    if (gc.firstMouse)
+    {
+        gc.mouseLastX = (float)gc.mouseX;
+        gc.mouseLastY = (float)gc.mouseY;
+        gc.firstMouse = false;
+    }
+
+    *xoffset = (float)gc.mouseX - gc.mouseLastX;
+    *yoffset = gc.mouseLastY - (float)gc.mouseY; // reversed since y-coordinates range from bottom to top
+
+    gc.mouseLastX = (float)gc.mouseX;
+    gc.mouseLastY = (float)gc.mouseY;
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    (void)window;
+
+    gc.mouseX = (float)xpos;
+    gc.mouseY = (float)ypos;
+    framePacer.markDirty();
+
+    float xoffset, yoffset;
+    getMouseDelta(&xoffset, &yoffset);
+
+    // gc.camera.updateAngle(xoffset, yoffset);
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    (void)window;
+    (void)mods;
+
+    framePacer.markDirty();
+
+    // clicks on the ui are not meant for the scene
+    if(ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureMouse)
+        return;
+
+    // picked in processInput, so recordings see the click
+    if(button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+    {
+        pendingInput.click  = true;
+        pendingInput.clickX = gc.mouseX;
+        pendingInput.clickY = gc.mouseY;
+    }
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) 
+{
+    (void)window;
+    (void)xoffset;
+    pendingInput.scroll += (float)yoffset;
+    framePacer.markDirty();
+}
+
+uint32_t pollKeys(GLFWwindow *window)
+{
+    static const struct { int key; uint32_t bit; } bindings[] = {
+        { GLFW_KEY_W, KEY_FORWARD },        { GLFW_KEY_S, KEY_BACKWARD },
+        { GLFW_KEY_A, KEY_LEFT },           { GLFW_KEY_D, KEY_RIGHT },
+        { GLFW_KEY_U, KEY_TILT_UP },        { GLFW_KEY_J, KEY_TILT_DOWN },
+        { GLFW_KEY_H, KEY_TILT_LEFT },      { GLFW_KEY_K, KEY_TILT_RIGHT },
+        { GLFW_KEY_1, KEY_VIEW_XY },        { GLFW_KEY_2, KEY_VIEW_YZ },
+        { GLFW_KEY_3, KEY_VIEW_XZ },        { GLFW_KEY_4, KEY_VIEW_ISOMETRIC },
+        { GLFW_KEY_5, KEY_VIEW_TOP },       { GLFW_KEY_6, KEY_VIEW_FRONT },
+        { GLFW_KEY_7, KEY_VIEW_SIDE },      { GLFW_KEY_R, KEY_RELOAD_SHADERS },
+    };
+
+    // typing into the ui does not move the camera
+    if(ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureKeyboard)
+        return 0;
+
+    uint32_t keys = 0;
+    for(size_t i = 0; i < sizeof(bindings) / sizeof(bindings[0]); i++)
+    {
+        if(glfwGetKey(window, bindings[i].key) == GLFW_PRESS)
+            keys |= bindings[i].bit;
+    }
+    return keys;
+}
+
+// the toggles a recording carries, in InputFrame::settings
+uint32_t packSettings()
+{
+    return (gc.debug        ? 1u << 0 : 0) |
+           (gc.wireframe    ? 1u << 1 : 0) |
+           (gc.sphere       ? 1u << 2 : 0) |
+           (gc.model        ? 1u << 3 : 0) |
+           (gc.culling      ? 1u << 4 : 0) |
+           (gc.occlusion    ? 1u << 5 : 0) |
+           (gc.deferred     ? 1u << 6 : 0) |
+           (gc.depthPrepass ? 1u << 7 : 0) |
+           (gc.overdraw     ? 1u << 8 : 0);
+}
+
+void unpackSettings(uint32_t settings)
+{
+    gc.debug        = (settings & (1u << 0)) != 0;
+    gc.wireframe    = (settings & (1u << 1)) != 0;
+    gc.sphere       = (settings & (1u << 2)) != 0;
+    gc.model        = (settings & (1u << 3)) != 0;
+    gc.culling      = (settings & (1u << 4)) != 0;
+    gc.occlusion    = (settings & (1u << 5)) != 0;
+    gc.deferred     = (settings & (1u << 6)) != 0;
+    gc.depthPrepass = (settings & (1u << 7)) != 0;
+    gc.overdraw     = (settings & (1u << 8)) != 0;
+}
+
+void applyInput(const InputFrame& input)
+{
+    // GL work, the snapshot carries it over to the render thread
+    if(input.keys & KEY_RELOAD_SHADERS)
+        reloadShaders = true;
+
+    camera.inputPoll(input.keys);
+
+    if(input.scroll != 0.0f)
+        camera.Zoom(input.scroll);
+
+    if(input.click && gc.model)
+    {
+        glm::vec3 origin, dir;
+        camera.screenRay(input.clickX, input.clickY, origin, dir);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        model->raycast(origin, dir, pick);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        pick.time = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+}
+
+void replayFrame(const InputFrame& input)
+{
+    gc.currentTime = input.time;
+    gc.deltaTime   = input.deltaTime;
+    gc.lastFrame   = input.time;
+
+    unpackSettings(input.settings);
+    applyInput(input);
+
+    if(input.keyframe)
+    {
+        CameraState c = camera.state();
+        float drift = glm::length(c.pos - input.camera.pos) +
+                      std::abs(c.yaw - input.camera.yaw) + std::abs(c.pitch - input.camera.pitch) + std::abs(c.zoom - input.camera.zoom);
+
+        replay->maxDrift = std::max(replay->maxDrift, drift);
+        if(drift > 0.0f)
+        {
+            camera.setState(input.camera);
+            replay->resyncs++;
+        }
+    }
+}
+
+void processInput(GLFWwindow *window)
+{
+    PROFILE_ZONE("processInput");
+
+    // the time and the input come from the recording, anything live is dropped
+    if(replay)
+    {
+        double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        size_t first;
+        size_t count = replay->advance(now, first);
+
+        // a real time replay that renders faster than it was recorded shows the same step again
+        gc.deltaTime = 0.0f;
+        for(size_t i = 0; i < count; i++)
+            replayFrame(replay->recording.frames[first + i]);
+
+        pendingInput = InputFrame();
+
+        if(replay->finished())
+        {
+            std::cout << "Replay finished : " << replay->recording.frames.size() << " frames, max drift "
+                      << replay->maxDrift << ", " << replay->resyncs << " resyncs" << std::endl;
+            stopReplay();
+        }
+        return;
+    }
+
+    InputFrame input = pendingInput;
+    pendingInput = InputFrame();
+
+    input.time      = gc.currentTime;
+    input.deltaTime = gc.deltaTime;
+    input.keys      = window ? pollKeys(window) : 0;
+    input.settings  = packSettings();
+
+    if(recording && recording->frames.empty())
+    {
+        recording->width     = gc.width;
+        recording->height    = gc.height;
+        recording->lastFrame = previousFrame;
+        recording->start     = camera.state();
+    }
+
+    applyInput(input);
+
+    if(recording)
+    {
+        if(recording->frames.size() % InputRecording::KEYFRAME_INTERVAL == InputRecording::KEYFRAME_INTERVAL - 1)
+        {
+            input.keyframe = true;
+            input.camera   = camera.state();
+        }
+        recording->frames.push_back(input);
+    }
+}
+
+void startRecording()
+{
+    stopReplay();
+    delete recording;
+    recording = new InputRecording();
+}
+
+bool stopRecording(const std::string& path)
+{
+    if(!recording)
+        return false;
+
+    bool saved = recording->save(path);
+    delete recording;
+    recording = nullptr;
+    return saved;
+}
+
+bool startReplay(const std::string& path, InputReplay::Mode mode)
+{
+    delete recording;
+    recording = nullptr;
+
+    InputReplay *r = new InputReplay();
+    if(!r->start(path, mode) || r->recording.frames.empty())
+    {
+        delete r;
+        return false;
+    }
+
+    stopReplay();
+    replay = r;
+
+    camera.setState(replay->recording.start);
+    gc.lastFrame = replay->recording.lastFrame;
+    return true;
+}
+
+void stopReplay()
+{
+    if(!replay)
+        return;
+
+    delete replay;
+    replay = nullptr;
+
+    // live time picks up from the next beginFrame without a jump
+    resumeClock = true;
+}
+
+const InputRecording *activeRecording()
+{
+    return recording;
+}
+
+const InputReplay *activeReplay()
+{
+    return replay;
+}
+
+void clearBackground(float r, float g, float b, float a)
+{
+    glClearColor(r, g, b, a);
+    // only clear the color buffer
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// pushes this frame's changes into the scene graph and propagates them
+void updateTransforms()
+{
+    PROFILE_ZONE("updateTransforms");
+
+    model->positionModel();
+
+    bool cubes = !gc.model && !gc.sphere;
+    framePacer.setRedrawSource(cube->redrawSource, cubes);
+    if(cubes)
+        cube->animate();
+
+    // the spot light is attached to the camera
+    uint32_t spot = entities.lightSlot[spotLight];
+    entities.lights.position[spot]  = camera.pos;
+    entities.lights.direction[spot] = camera.front;
+
+    entities.writeTransforms(sceneGraph);
+    sceneGraph.update();
+    entities.updateBounds(sceneGraph);
+    entities.updateLights(sceneGraph);
+}
+
+void renderSceneDebugAxes()
+{
+    if(frame->gc.model)
+        model->renderDebugAxes();
+    else if(frame->gc.sphere)
+        sphere->renderDebugAxes();
+    else
+        cube->renderDebugAxes();
+}
+
+/*
+    The thread that draws, when there is one.
+
+    The main thread keeps the window: GLFW wants its events polled there, and input, the
+    Ui and updating the scene go with them. The render thread takes the GL context and
+    draws the snapshots the main thread publishes, so a frame costs about the longer of
+    the two halves instead of both. The update side waits until its last snapshot was
+    picked up before it goes on, it is never more than one frame ahead of the screen.
+*/
+struct RenderThread
+{
+    std::thread             thread;
+    GLFWwindow             *window = nullptr;
+    std::atomic<bool>       quit{false};
+
+    std::mutex              mutex;
+    std::condition_variable published;  // a snapshot is waiting, or quit
+    std::condition_variable picked;     // the render thread took it
+
+    void notify(std::condition_variable& condition)
+    {
+        // through the mutex, a waiter between checking and sleeping would miss it otherwise
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        condition.notify_one();
+    }
+};
+RenderThread renderThread;
+
+bool renderThreadRunning()
+{
+    return renderThread.thread.joinable();
+}
+
+void publishSnapshot();
+
+// the update half of a frame: the Ui, the transforms and culling, then a snapshot for drawing
+void updateScene()
+{
+    PROFILE_ZONE("updateScene");
+
+    FrameSnapshot& snapshot = snapshots.write();
+
+    // headless there is no ui, the lights keep where they were created
+    if(ui)
+    {
+        FrameSection section(frameStats, "Ui");
+
+        // the newest numbers the render side reported, this frame's draw is not done yet
+        renderStats.acquire();
+        const RenderStats& drawn = renderStats.read();
+
+        ui->beginFrame();
+    
+        // ui->demoWindow();
+        ui->debugWindow(drawn);
+        ui->timingsWindow(drawn);
+        ui->frameStatsWindow();
+        ui->memoryWindow(drawn);
+
+        ui->endFrame(snapshot.uiDraw);
+
+        // a blinking text cursor needs frames without any input
+        framePacer.setRedrawSource(uiSource, ImGui::GetIO().WantTextInput);
+
+        entities.setPosition(light, glm::make_vec3(ui->vec3a));
+        entities.setLightColor(light, glm::make_vec3(ui->col1));
+
+        for (int i = 0; i < 4; i++) 
+        {
+            entities.setLightColor(pointLight[i], glm::make_vec3(ui->pcol[i]));
+            entities.setPosition(pointLight[i], glm::make_vec3(ui->ppos[i]));
+        }
+
+        entities.setLightColor(dirLight, glm::make_vec3(ui->dircol));
+    }
+
+    // camera.updateOrbitPosition(gc.currentTime, 10.0f);
+
+    {
+        FrameSection section(frameStats, "Animation");
+
+        // with a fixed timestep the clips move in whole steps, the same on every machine
+        FixedTimestep& simulation = framePacer.simulation;
+        if(simulation.enabled)
+        {
+            int steps = simulation.advance(gc.deltaTime);
+            for(int i = 0; i < steps; i++)
+                animator.advance((float)simulation.step);
+        }
+        else
+        {
+            animator.advance(gc.deltaTime);
+        }
+        animator.evaluate();
+    }
+    framePacer.setRedrawSource(animationSource, gc.model && animator.playing());
+    framePacer.setRedrawSource(replaySource, replay != nullptr);
+    {
+        FrameSection section(frameStats, "Transforms");
+        updateTransforms();
+    }
+
+    // on demand, whatever moved in the scene or the view is drawn, the frames after it too
+    static glm::mat4 lastViewProjection;
+    glm::mat4 viewProjection = camera.getProjectionMatrix() * camera.getViewMatrix();
+    if(sceneGraph.updatedNodes > 0 || viewProjection != lastViewProjection)
+        framePacer.markDirty();
+    lastViewProjection = viewProjection;
+    {
+        FrameSection section(frameStats, "Culling");
+        culler->cull();
+    }
+
+    // only the forward path walks clusters, see drawFrame
+    bool deferredFrame = gc.deferred && (gc.model || !gc.sphere);
+    if(!gc.overdraw && !deferredFrame)
+    {
+        FrameSection section(frameStats, "Lights");
+        assignLights(snapshot);
+    }
+
+    publishSnapshot();
+}
+
+// copies what drawing reads out of the scene and hands it over, see FrameSnapshot
+void publishSnapshot()
+{
+    PROFILE_ZONE("publishSnapshot");
+
+    static uint64_t published = 0;
+
+    {
+        FrameSection section(frameStats, "Snapshot");
+
+        FrameSnapshot& s = snapshots.write();
+        s.index  = published++;
+        s.gc     = gc;
+        s.camera = camera;
+        s.world  = sceneGraph.world;
+        s.bonePalette = animator.palette;
+        entities.copyDrawState(s.entities);
+
+        s.cubeShininess   = cube->shininess;
+        s.sphereShininess = sphere->shininess;
+        s.reloadShaders   = reloadShaders;
+        reloadShaders     = false;
+        s.swapInterval    = framePacer.swapInterval();
+
+        s.ui = ui != nullptr;
+        for(int i = 0; i < 3; i++)
+            s.background[i] = ui ? ui->bgcol[i] : 0.0f;
+
+        if(ui && ui->showOcclusionBuffer)
+            s.occlusionDepth = culler->occlusion.depth;
+        else
+            s.occlusionDepth.clear();
+
+        snapshots.publish();
+    }
+
+    if(!renderThreadRunning())
+        return;
+
+    renderThread.notify(renderThread.published);
+
+    // at most one frame ahead of what is being drawn, more would only add latency
+    FrameSection section(frameStats, "Wait for render");
+    std::unique_lock<std::mutex> lock(renderThread.mutex);
+    renderThread.picked.wait(lock, []() { return !snapshots.pending(); });
+}
+
+// the render half of a frame: draws the snapshot in frame, on the thread that owns the context
+void drawFrame()
+{
+    PROFILE_ZONE("drawFrame");
+
+    // GL work jobs handed over since the last frame
+    jobs.runMainJobs();
+
+    if(frame->reloadShaders)
+    {
+        // cube->updateShaders();
+        // sphere->updateShaders();
+        // lightGizmo->updateShaders();
+        // grid->updateShader();
+        model->updateShaders();
+        deferred->updateShaders();
+        prepass->updateShaders();
+        overdraw->updateShaders();
+    }
+
+    // the swap interval belongs to the context too
+    static int swapInterval = -2;
+    if(frame->gc.window && frame->swapInterval != swapInterval)
+    {
+        swapInterval = frame->swapInterval;
+        glfwSwapInterval(swapInterval);
+    }
+
+    // resizes arrive with the snapshot, the viewport follows them here where the context is
+    static int viewportWidth = -1, viewportHeight = -1;
+    if(frame->gc.width != viewportWidth || frame->gc.height != viewportHeight)
+    {
+        viewportWidth  = frame->gc.width;
+        viewportHeight = frame->gc.height;
+        glViewport(0, 0, viewportWidth, viewportHeight);
+    }
+
+    if(!frame->bonePalette.empty())
+        skinning->upload(frame->bonePalette);
+
+    // everything below is timed on the GPU, the results show up a few frames later
+    gpuTimers.beginFrame();
+    GpuZone frameZone(gpuTimers, "Frame");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, frame->gc.framebuffer);
+    clearBackground(frame->background[0], frame->background[1], frame->background[2], 1.0f);
+
+    bool deferredFrame = frame->gc.deferred && (frame->gc.model || !frame->gc.sphere);
+
+    // deferred frames draw these once the depth buffer holds the scene
+    if(frame->gc.debug && !deferredFrame)
+    {
+        FrameSection section(frameStats, "Grid");
+        world_axes->render();
+        GpuZone zone(gpuTimers, "Grid");
+        grid->render();
+    }
+
+    static bool set = false;
+    if(frame->gc.wireframe)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        set = false;
+    }
+    else
+    {
+        if(!set)
+        {
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            set = true;
+        }
+    }
+
+    if(frame->gc.overdraw)
+    {
+        // the pre-pass setting of the forward path decides what counts as shaded
+        FrameSection section(frameStats, "Overdraw");
+        GpuZone zone(gpuTimers, "Overdraw");
+        overdraw->render(frame->gc.depthPrepass && !deferredFrame);
+    }
+    else if(deferredFrame)
+    {
+        {
+            FrameSection section(frameStats, "Deferred");
+            GpuZone zone(gpuTimers, "Deferred");
+            deferred->render();
+        }
+
+        if(frame->gc.debug)
+        {
+            FrameSection section(frameStats, "Grid");
+            world_axes->render();
+            {
+                GpuZone zone(gpuTimers, "Grid");
+                grid->render();
+            }
+            renderSceneDebugAxes();
+        }
+    }
+    else
+    {
+        {
+            FrameSection section(frameStats, "Light upload");
+            clusters->update();
+        }
+
+        if(frame->gc.depthPrepass)
+        {
+            FrameSection section(frameStats, "Depth pre-pass");
+            GpuZone zone(gpuTimers, "Depth pre-pass");
+            prepass->begin();
+        }
+
+        if(frame->gc.model)
+        {
+            FrameSection section(frameStats, "Model");
+            GpuZone zone(gpuTimers, "Model");
+            model->render();
+        }else{
+            if(frame->gc.sphere){
+                FrameSection section(frameStats, "Spheres");
+                GpuZone zone(gpuTimers, "Spheres");
+                sphere->render();
+            }else{
+                FrameSection section(frameStats, "Cubes");
+                GpuZone zone(gpuTimers, "Cubes");
+                cube->render();
+            }
+        }
+
+        if(frame->gc.depthPrepass)
+        {
+            prepass->end();
+
+            // the scenes skip their axes while the depth test is GL_EQUAL
+            if(frame->gc.debug)
+                renderSceneDebugAxes();
+        }
+    }
+
+    // the culler only left the gizmos of the lights this scene uses visible
+    {
+        FrameSection section(frameStats, "Light gizmos");
+        GpuZone zone(gpuTimers, "Light gizmos");
+        lightGizmo->render();
+    }
+
+    // the culler's depth buffer as the update side saw it, shown by the debug window
+    if(!frame->occlusionDepth.empty())
+        culler->occlusionDebugTexture(frame->occlusionDepth);
+
+    if(frame->ui && ui)
+    {
+        FrameSection section(frameStats, "ImGui");
+        GpuZone zone(gpuTimers, "ImGui");
+        ui->render(frame->uiDraw);
+    }
+
+    // objects destroyed this frame wait for its fence, older ones whose fence passed go
+    gpuResources.endFrame();
+}
+
+// the numbers the Ui shows about the frame just drawn, see RenderStats
+void publishRenderStats()
+{
+    RenderStats& r = renderStats.write();
+    r.index = frame->index;
+
+    r.gpuTimersAvailable = gpuTimers.available();
+    r.gpuZones           = gpuTimers.stats;
+    r.gpuDropped         = gpuTimers.dropped;
+
+    r.overdrawAverage = overdraw->average();
+    r.overdrawMax     = overdraw->maxCount;
+    r.shadedFragments = overdraw->shadedFragments;
+    r.coveredPixels   = overdraw->coveredPixels;
+
+    r.clusterLights   = frame->clusters.lightCount;
+    r.clusterIndices  = frame->clusters.indices.size();
+    r.maxPerCluster   = frame->clusters.maxPerCluster;
+    r.lightAssignment = frame->clusters.buildTime;
+
+    r.lightVolumes     = deferred->volumes;
+    r.fullscreenPasses = deferred->fullscreenPasses;
+
+    r.pools            = gpuResources.stats();
+    r.occlusionTexture = culler->occlusionTexture;
+    r.droppedSnapshots = snapshots.droppedCount();
+
+    renderStats.publish();
+}
+
+// update and draw one after the other on the calling thread, for headless runs and --no-render-thread
+void renderScene()
+{
+    updateScene();
+
+    snapshots.acquire();
+    frame = &snapshots.read();
+
+    drawFrame();
+    publishRenderStats();
+}
+
+void renderLoop()
+{
+    PROFILE_THREAD_NAME("Render");
+
+    glfwMakeContextCurrent(renderThread.window);
+
+    // runOnMain() work needs the context, it comes here now
+    jobs.setMainThread();
+
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(renderThread.mutex);
+            renderThread.published.wait(lock, []()
+            {
+                return renderThread.quit.load() || snapshots.pending();
+            });
+            if(renderThread.quit.load())
+                break;
+        }
+
+        snapshots.acquire();
+        renderThread.notify(renderThread.picked);
+
+        frame = &snapshots.read();
+        drawFrame();
+
+        {
+            PROFILE_ZONE("glfwSwapBuffers");
+            FrameSection section(frameStats, "Swap");
+            glfwSwapBuffers(renderThread.window);
+        }
+
+        publishRenderStats();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+void startRenderThread()
+{
+    if(!gc.window || renderThreadRunning())
+        return;
+
+    // a context is current on one thread at a time
+    glfwMakeContextCurrent(nullptr);
+
+    renderThread.window = gc.window;
+    renderThread.quit.store(false);
+    renderThread.thread = std::thread(renderLoop);
+}
+
+void stopRenderThread()
+{
+    if(!renderThreadRunning())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(renderThread.mutex);
+        renderThread.quit.store(true);
+    }
+    renderThread.published.notify_one();
+    renderThread.thread.join();
+
+    glfwMakeContextCurrent(renderThread.window);
+    jobs.setMainThread();
+}
+
+void initRenderer(const RendererOptions& options)
+{
+    jobs.start(options.workers);
+
+    gc.window = options.window;
+    gc.width  = options.width;
+    gc.height = options.height;
+
+    /* 
+       OpenGL data and coordinates with respect to the window.
+       Note that processed coordinates in OpenGL are between -1 and 1 
+       so we effectively map from the range (-1 to 1) to (0, 800) and (0, 600).
+    */
+    glViewport(0, 0, gc.width, gc.height);
+    camera.updateProjectionMatrix();
+
+    if(gc.window)
+    {
+        // glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);  
+
+        // Register window resize callback
+        glfwSetFramebufferSizeCallback(gc.window, framebuffer_size_callback);
+        glfwSetWindowRefreshCallback(gc.window, window_refresh_callback);
+        glfwSetCursorPosCallback(gc.window, mouse_callback);
+        glfwSetScrollCallback(gc.window, scroll_callback);
+        glfwSetMouseButtonCallback(gc.window, mouse_button_callback);
+        glfwSetKeyCallback(gc.window, key_callback);
+
+        // what the pacer measures vsync against, and whether adaptive vsync can tear
+        const GLFWvidmode *videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        framePacer.refreshRate = videoMode ? videoMode->refreshRate : 0;
+        framePacer.tearControl = glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+                                 glfwExtensionSupported("GLX_EXT_swap_control_tear");
+    }
+
+    animationSource = framePacer.addRedrawSource("animation");
+    replaySource    = framePacer.addRedrawSource("replay");
+    uiSource        = framePacer.addRedrawSource("ui text input");
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glEnable(GL_DEPTH_TEST);
+
+    gpuTimers.init();
+
+    if(gc.window)
+        ui = new Ui(gc.window);
+
+    world_axes  = new Coordinates();
+    grid        = new Grid();
+
+    cube     = new Cube();
+    sphere   = new Sphere();
+
+    // other models that ship in assets/ : nanosuit/nanosuit.obj, cyborg/cyborg.obj, planet/planet.obj
+    std::string modelPath = options.modelPath.empty() ? options.assetDir + "backpack/backpack.obj" : options.modelPath;
+    model    = new Model(modelPath);
+
+    lightGizmo = new LightGizmo(cube->vertexBuffer, cube->indexBuffer);
+
+    light    = createPointLight(glm::vec3(1.2f, 1.0f, 2.0f), LAYER_LIGHT);
+
+    dirLight = createLight(LightType::DIRECTIONAL);
+    entities.lights.direction[entities.lightSlot[dirLight]] = glm::vec3(-0.2f, -1.0f, -0.3f); 
+
+    glm::vec3 pointLightPositions[] = {
+        glm::vec3( 0.7f,  0.2f,  2.0f),
+        glm::vec3( 2.3f, -3.3f, -4.0f),
+        glm::vec3(-4.0f,  2.0f, -12.0f),
+        glm::vec3( 0.0f,  0.0f, -3.0f)
+    };
+
+    for(size_t i = 0; i < 4 ; i++)
+    {
+        pointLight[i] = createPointLight(pointLightPositions[i], LAYER_POINT_LIGHTS);
+    }
+
+    spotLight  = createLight(LightType::SPOT);
+
+    culler     = new SceneCuller();
+    clusters   = new ClusteredLights();
+    skinning   = new SkinningBuffer();
+    deferred   = new Deferred();
+    prepass    = new DepthPrepass();
+    overdraw   = new OverdrawView();
+
+    cube->diffuseMap  = new Texture(options.assetDir + "metallic_texture.jpg", "material.diffuse");
+    cube->specularMap = new Texture(options.assetDir + "specular-map.png", "material.specular");
+    cube->emissionMap = new Texture(options.assetDir + "emission-map.jpg", "material.emission");
+}
+
+void shutdownRenderer()
+{
+    jobs.stop();
+    gpuTimers.shutdown();
+    gpuResources.shutdown();
+}
+
+void resizeRenderer(int width, int height)
+{
+    // the viewport follows in drawFrame(), on whichever thread holds the context
+    gc.width = width;
+    gc.height = height;
+    camera.updateProjectionMatrix();
+}
+
+void beginFrame(double time)
+{
+    // replays take the time from the recording in processInput
+    if(replay)
+        return;
+
+    // after a replay, or a wait for events on demand, the time in between didn't happen
+    if(resumeClock || framePacer.resumed)
+    {
+        gc.lastFrame = time;
+        resumeClock  = false;
+    }
+
+    previousFrame  = gc.lastFrame;
+    gc.currentTime = time;
+    gc.deltaTime   = (float)(gc.currentTime - gc.lastFrame);
+    gc.lastFrame   = gc.currentTime;
+}
+
+void requestRedraw()
+{
+    framePacer.markDirty();
+    if(gc.window)
+        glfwPostEmptyEvent();
+}
+
+void setCameraPose(const glm::vec3& position, float yaw, float pitch)
+{
+    camera.pos   = position;
+    camera.yaw   = yaw;
+    camera.pitch = pitch;
+
+    camera.updateVectors();
+}
@@ -0,0 +1,186 @@
+#include <SceneGraph.hpp>
+
+#include <Parallel.hpp>
+
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+
+int32_t SceneGraph::addNode(int32_t p, const glm::mat4& m, const AABB& bounds)
+{
+    int32_t idx = (int32_t)parent.size();
+
+    // depth first: the parent's subtree has to end right here
+    assert(p < 0 || subtreeEnd[p] == (uint32_t)idx);
+
+    parent.push_back(p);
+    subtreeEnd.push_back(idx + 1);
+    local.push_back(m);
+    world.push_back(m);
+    dirty.push_back(1);
+    localBounds.push_back(bounds);
+    worldBounds.push_back(AABB());
+
+    changed.push_back(0);
+    boundsDirty.push_back(0);
+    childBounds.push_back(AABB());
+
+    dirtyCount++;
+
+    for (int32_t a = p; a >= 0; a = parent[a])
+        subtreeEnd[a] = idx + 1;
+
+    return idx;
+}
+
+void SceneGraph::setLocal(int32_t node, const glm::mat4& m)
+{
+    local[node] = m;
+    if (!dirty[node])
+    {
+        dirty[node] = 1;
+        dirtyCount++;
+    }
+}
+
+void SceneGraph::setLocalBounds(int32_t node, const AABB& bounds)
+{
+    localBounds[node] = bounds;
+    if (!dirty[node])
+    {
+        dirty[node] = 1;
+        dirtyCount++;
+    }
+}
+
+void SceneGraph::update()
+{
+    if (dirtyCount == 0)
+    {
+        // nothing moved this time, but the flags of the previous update must not stick around
+        if (updatedNodes)
+            std::fill(changed.begin(), changed.end(), (uint8_t)0);
+        updatedNodes = 0;
+        return;
+    }
+    updatedNodes = 0;
+
+    size_t n = parent.size();
+    if (plannedNodes != n)
+        planUpdate();
+
+    // parents come first, so a forward pass sees every parent before its children. The
+    // spine is everything the runs hang off, once it is done the runs are independent
+    for (uint32_t i : spine)
+        updatedNodes += updateNode(i);
+
+    std::atomic<uint32_t> updated(0);
+    parallelFor(runs.size() / 2, 4, [&](size_t begin, size_t end)
+    {
+        uint32_t count = 0;
+        for (size_t r = begin; r < end; r++)
+        {
+            for (uint32_t i = runs[2 * r]; i < runs[2 * r + 1]; i++)
+                count += updateNode(i);
+        }
+        updated.fetch_add(count, std::memory_order_relaxed);
+    });
+    updatedNodes += updated.load();
+
+    // anything above a changed node needs its subtree bounds refreshed too
+    for (size_t i = n; i-- > 0;)
+    {
+        int32_t p = parent[i];
+        if (boundsDirty[i] && p >= 0 && !boundsDirty[p])
+        {
+            boundsDirty[p] = 1;
+            childBounds[p] = AABB();
+        }
+    }
+
+    // children come after their parent, walking backwards finishes a subtree before its root
+    for (size_t i = n; i-- > 0;)
+    {
+        if (boundsDirty[i])
+        {
+            AABB b = localBounds[i].valid() ? localBounds[i].transformed(world[i]) : AABB();
+            b.expand(childBounds[i]);
+            worldBounds[i] = b;
+        }
+
+        int32_t p = parent[i];
+        if (p >= 0 && boundsDirty[p] && worldBounds[i].valid())
+            childBounds[p].expand(worldBounds[i]);
+    }
+
+    dirtyCount = 0;
+}
+
+bool SceneGraph::updateNode(size_t i)
+{
+    int32_t p = parent[i];
+    bool    c = dirty[i] || (p >= 0 && changed[p]);
+
+    changed[i]     = c;
+    boundsDirty[i] = c;
+    if (!c)
+        return false;
+
+    world[i] = p >= 0 ? world[p] * local[i] : local[i];
+    dirty[i] = 0;
+    childBounds[i] = AABB();
+    return true;
+}
+
+void SceneGraph::planUpdate()
+{
+    spine.clear();
+    runs.clear();
+
+    size_t n = parent.size();
+    size_t i = 0;
+    while (i < n)
+    {
+        uint32_t end = subtreeEnd[i];
+        if (end - i > UPDATE_GRAIN)
+        {
+            // too big for one job, its children are looked at next
+            spine.push_back((uint32_t)i);
+            i++;
+            continue;
+        }
+
+        // subtrees right after each other share a run as long as it stays small
+        if (!runs.empty() && runs.back() == i && end - runs[runs.size() - 2] <= UPDATE_GRAIN)
+        {
+            runs.back() = end;
+        }
+        else
+        {
+            runs.push_back((uint32_t)i);
+            runs.push_back(end);
+        }
+        i = end;
+    }
+
+    plannedNodes = n;
+}
+
+void SceneGraph::cull(const Frustum& frustum, std::vector<uint8_t>& visible) const
+{
+    size_t n = parent.size();
+    visible.assign(n, 0);
+
+    size_t i = 0;
+    while (i < n)
+    {
+        // empty subtrees have nothing to draw, but keep walking in case bounds are not set up yet
+        if (worldBounds[i].valid() && !frustum.testAABB(worldBounds[i]))
+        {
+            i = subtreeEnd[i];
+            continue;
+        }
+        visible[i] = 1;
+        i++;
+    }
+}
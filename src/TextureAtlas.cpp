@@ -0,0 +1,296 @@
+#include <TextureAtlas.hpp>
+#include <MemoryTracker.hpp>
+#include <Renderer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <string>
+
+// ImGui compiles its copy static as well, the two don't see each other
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <IMGUI/imstb_rectpack.h>
+
+// the big textures of one layer size
+struct LayerGroup
+{
+    int                 size;
+    std::vector<size_t> textures;
+};
+
+// what the textures of group take, mips included, in layers of size
+static size_t layerBytes(const LayerGroup& group, const std::vector<glm::ivec2>& sizes, int size)
+{
+    size_t bytes = 0;
+    for (size_t t : group.textures)
+        bytes += textureBytes(GL_RGBA8, size, size, true) - textureBytes(GL_RGBA8, sizes[t].x, sizes[t].y, true);
+    return bytes;
+}
+
+void TextureArrays::pack(const std::vector<glm::ivec2>& sizes)
+{
+    placements.assign(sizes.size(), TexturePlacement());
+    std::fill(pageSize, pageSize + ARRAYS, 0);
+    std::fill(pageCount, pageCount + ARRAYS, 0);
+    wastedBytes = 0;
+
+    std::vector<stbrp_rect> small;
+    std::vector<LayerGroup> groups;     // smallest size first
+    size_t smallArea = 0;
+    int    largest   = 0;
+
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        glm::ivec2 s = sizes[i];
+        if (s.x <= 0 || s.y <= 0)
+            continue;
+
+        TexturePlacement& p = placements[i];
+        p.width  = s.x;
+        p.height = s.y;
+
+        if (s.x > MAX_ATLAS_ITEM || s.y > MAX_ATLAS_ITEM)
+        {
+            int size = std::max(s.x, s.y);
+            auto g   = std::lower_bound(groups.begin(), groups.end(), size, [](const LayerGroup& a, int b) { return a.size < b; });
+            if (g == groups.end() || g->size != size)
+                g = groups.insert(g, LayerGroup{ size, {} });
+            g->textures.push_back(i);
+            continue;
+        }
+
+        stbrp_rect r = {};
+        r.id = (int)i;
+        r.w  = s.x + 2 * PADDING;
+        r.h  = s.y + 2 * PADDING;
+        small.push_back(r);
+
+        smallArea += (size_t)r.w * r.h;
+        largest    = std::max(largest, std::max(r.w, r.h));
+    }
+
+    // too many sizes for the samplers: the group that grows cheapest into the next bigger one goes into it
+    while (groups.size() > (size_t)LAYER_ARRAYS)
+    {
+        size_t cheapest = 0;
+        size_t cost     = SIZE_MAX;
+        for (size_t g = 0; g + 1 < groups.size(); g++)
+        {
+            size_t c = layerBytes(groups[g], sizes, groups[g + 1].size) - layerBytes(groups[g], sizes, groups[g].size);
+            if (c < cost)
+            {
+                cheapest = g;
+                cost     = c;
+            }
+        }
+        std::vector<size_t>& into = groups[cheapest + 1].textures;
+        into.insert(into.end(), groups[cheapest].textures.begin(), groups[cheapest].textures.end());
+        groups.erase(groups.begin() + cheapest);
+    }
+
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        int array       = LAYERS + (int)g;
+        pageSize[array] = groups[g].size;
+        for (size_t t : groups[g].textures)
+        {
+            placements[t].array = array;
+            placements[t].layer = pageCount[array]++;
+        }
+        wastedBytes += layerBytes(groups[g], sizes, groups[g].size);
+    }
+
+    if (small.empty())
+        return;
+
+    // smallest power of two page that could hold everything with some slack, up to the maximum
+    int size = 256;
+    while (size < MAX_ATLAS_SIZE && ((size_t)size * size < smallArea + smallArea / 4 || size < largest))
+        size *= 2;
+    pageSize[ATLAS] = size;
+
+    // big ones first packs tighter
+    std::sort(small.begin(), small.end(), [](const stbrp_rect& a, const stbrp_rect& b)
+    {
+        return a.h != b.h ? a.h > b.h : a.w > b.w;
+    });
+
+    std::vector<stbrp_node> nodes(size);
+    while (!small.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, size, size, nodes.data(), (int)nodes.size());
+        stbrp_pack_rects(&context, small.data(), (int)small.size());
+
+        int layer = pageCount[ATLAS]++;
+        for (const stbrp_rect& r : small)
+        {
+            if (!r.was_packed)
+                continue;
+
+            TexturePlacement& p = placements[r.id];
+            p.array = ATLAS;
+            p.layer = layer;
+            p.x     = r.x + PADDING;
+            p.y     = r.y + PADDING;
+        }
+
+        // what did not fit goes onto the next page
+        small.erase(std::remove_if(small.begin(), small.end(), [](const stbrp_rect& r) { return r.was_packed != 0; }), small.end());
+    }
+}
+
+void TextureArrays::create(const char *asset)
+{
+    release();
+
+    for (int a = 0; a < ARRAYS; a++)
+    {
+        if (!pageCount[a])
+            continue;
+
+        handles[a] = gpuResources.createTexture();
+        GLuint id  = gpuResources.get(handles[a]);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, pageSize[a], pageSize[a], pageCount[a], 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        // wrapping is done in the shader, inside the rect
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        size_t bytes;
+        if (a == ATLAS)
+        {
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, ATLAS_MAX_LEVEL);
+
+            bytes = 0;
+            for (int level = 0; level <= ATLAS_MAX_LEVEL; level++)
+            {
+                int s  = std::max(pageSize[a] >> level, 1);
+                bytes += textureBytes(GL_RGBA8, s, s, false);
+            }
+        }
+        else
+        {
+            bytes = textureBytes(GL_RGBA8, pageSize[a], pageSize[a], true);
+        }
+
+        std::string name = std::string(asset) + (a == ATLAS ? " atlas" : " layers " + std::to_string(pageSize[a]));
+        memoryTracker.track(MemoryKind::TEXTURE, id, bytes * pageCount[a], MemoryTag::TEXTURE, name);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArrays::upload(size_t index, const unsigned char *pixels)
+{
+    const TexturePlacement& p = placements[index];
+    if (p.array < 0 || !pixels)
+        return;
+
+    // atlas items get PADDING texels of their own edge around them. A layer holds only one
+    // texture, its edges are stretched over whatever the layer has left so no mip sees black
+    int size = pageSize[p.array];
+    int x0, y0, x1, y1;
+    if (p.array == ATLAS)
+    {
+        x0 = p.x - PADDING;
+        y0 = p.y - PADDING;
+        x1 = p.x + p.width + PADDING;
+        y1 = p.y + p.height + PADDING;
+    }
+    else
+    {
+        x0 = y0 = 0;
+        x1 = y1 = size;
+    }
+
+    int w = x1 - x0;
+    int h = y1 - y0;
+
+    const unsigned char *source = pixels;
+    if (w != p.width || h != p.height)
+    {
+        scratch.resize((size_t)w * h * 4);
+        for (int y = 0; y < h; y++)
+        {
+            int sy = std::min(std::max(y0 + y - p.y, 0), p.height - 1);
+            const unsigned char *row = pixels + (size_t)sy * p.width * 4;
+            unsigned char       *out = scratch.data() + (size_t)y * w * 4;
+
+            int left = p.x - x0;
+            for (int x = 0; x < left; x++)
+                std::memcpy(out + x * 4, row, 4);
+            std::memcpy(out + left * 4, row, (size_t)p.width * 4);
+            for (int x = left + p.width; x < w; x++)
+                std::memcpy(out + x * 4, row + (size_t)(p.width - 1) * 4, 4);
+        }
+        source = scratch.data();
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, gpuResources.get(handles[p.array]));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x0, y0, p.layer, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, source);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArrays::generateMipmaps()
+{
+    for (int a = 0; a < ARRAYS; a++)
+    {
+        if (!handles[a])
+            continue;
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, gpuResources.get(handles[a]));
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // the scratch is only needed while loading
+    std::vector<unsigned char>().swap(scratch);
+}
+
+void TextureArrays::resolve(MaterialTextures& material) const
+{
+    for (int s = 0; s < TEXTURE_SLOTS; s++)
+    {
+        int t = material.texture[s];
+        if (t < 0 || t >= (int)placements.size() || placements[t].array < 0)
+        {
+            material.rect[s] = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+            material.page[s] = glm::ivec2(-1, 0);
+            continue;
+        }
+
+        const TexturePlacement& p = placements[t];
+        material.rect[s] = p.rect(pageSize[p.array]);
+        material.page[s] = glm::ivec2(p.array, p.layer);
+    }
+}
+
+void TextureArrays::bind(int firstUnit) const
+{
+    for (int a = 0; a < ARRAYS; a++)
+    {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + a);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, gpuResources.get(handles[a]));
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void TextureArrays::release()
+{
+    for (int a = 0; a < ARRAYS; a++)
+    {
+        if (!handles[a])
+            continue;
+
+        memoryTracker.release(MemoryKind::TEXTURE, gpuResources.get(handles[a]));
+        gpuResources.destroy(handles[a]);
+    }
+}